@@ -110,6 +110,12 @@ set_property(DIRECTORY APPEND PROPERTY
 #### Option for building tests
 option(CODYCO_BUILD_TESTS "Compile tests" FALSE)
 
+#### Option for building benchmarks
+option(CODYCO_BUILD_BENCHMARKS "Compile benchmarks" FALSE)
+
+#### Option for building offline tools
+option(CODYCO_BUILD_TOOLS "Compile offline tools (such as wholeBodyDynamicsReplay)" FALSE)
+
 #### Option for build wholeBodyReach module
 option(CODYCO_BUILD_WHOLEBODYREACH "Compile the wholeBodyReach module" FALSE)
 
@@ -11,9 +11,14 @@
 #include <yarp/os/Log.h>
 #include <yarp/os/LogStream.h>
 #include <yarp/os/LockGuard.h>
+#include <yarp/dev/IAnalogSensor.h>
 
 
-const int GS_ANALOG_TIMEOUT=100; //ms
+const double GS_ANALOG_TIMEOUT=0.1; //s
+
+// Bit of GSInputPortProcessor::middleIndex set when the middle buffer contains a new sample
+const int GS_NEW_SAMPLE_FLAG=4;
+const int GS_INDEX_MASK=3;
 
 using namespace yarp::os;
 
@@ -21,7 +26,6 @@ inline void GSInputPortProcessor::resetStat()
 {
     yarp::os::LockGuard guard(mutex);
 
-    dataAvailable = false;
     count=0;
     deltaT=0;
     deltaTMax=0;
@@ -30,68 +34,104 @@ inline void GSInputPortProcessor::resetStat()
     prev=now;
 }
 
-GSInputPortProcessor::GSInputPortProcessor()
+GSInputPortProcessor::GSInputPortProcessor(): backIndex(0),
+                                              frontIndex(2),
+                                              middleIndex(1),
+                                              channels(0),
+                                              dataReceived(false),
+                                              status(yarp::dev::IAnalogSensor::AS_TIMEOUT),
+                                              nrOfOverwrittenSamples(0),
+                                              timeoutInSeconds(GS_ANALOG_TIMEOUT)
 {
+    for(int i=0; i < 3; i++)
+    {
+        samples[i].arrivalTime = -1.0;
+    }
+
     resetStat();
 }
 
-void GSInputPortProcessor::onRead(yarp::sig::Vector &v)
+void GSInputPortProcessor::setTimeout(double timeout)
 {
-    now=Time::now();
+    timeoutInSeconds = timeout;
+}
 
-    yarp::os::LockGuard guard(mutex);
+void GSInputPortProcessor::onRead(yarp::sig::Vector &v)
+{
+    double arrivalTime=Time::now();
 
-    if (count>0)
     {
-        double tmpDT=now-prev;
+        yarp::os::LockGuard guard(mutex);
 
-        deltaT+=tmpDT;
+        now=arrivalTime;
 
-        if (tmpDT>deltaTMax)
+        if (count>0)
         {
-            deltaTMax=tmpDT;
-        }
+            double tmpDT=now-prev;
 
-        if (tmpDT<deltaTMin)
-        {
-            deltaTMin=tmpDT;
-        }
+            deltaT+=tmpDT;
 
-        //compare network time
-        if (tmpDT*1000<GS_ANALOG_TIMEOUT)
-        {
-            dataAvailable=true;
-        }
-        else
-        {
-            dataAvailable=false;
+            if (tmpDT>deltaTMax)
+            {
+                deltaTMax=tmpDT;
+            }
+
+            if (tmpDT<deltaTMin)
+            {
+                deltaTMin=tmpDT;
+            }
         }
+
+        prev=now;
+        count++;
     }
 
-    if( count == 0 )
+    // Write the sample in the back buffer (the vector is reallocated only if its size changed)
+    Sample & back = samples[backIndex];
+    back.data=v;
+    back.arrivalTime=arrivalTime;
+
+    // Use the timestamp of the sender, if available
+    if( !getEnvelope(back.stamp) || !back.stamp.isValid() )
     {
-        dataAvailable = true;
+        localStamp.update(arrivalTime);
+        back.stamp=localStamp;
     }
 
-    prev=now;
-    count++;
-
-    lastVector=v;
-    lastStamp.update();
+    channels.store((int)v.size());
+    dataReceived.store(true);
 
+    // Publish the sample, and take the old middle buffer as the new back buffer
+    int oldMiddle = middleIndex.exchange(backIndex | GS_NEW_SAMPLE_FLAG, std::memory_order_acq_rel);
+    if( oldMiddle & GS_NEW_SAMPLE_FLAG )
+    {
+        nrOfOverwrittenSamples++;
+    }
+    backIndex = oldMiddle & GS_INDEX_MASK;
 }
 
 inline bool GSInputPortProcessor::getLast(yarp::sig::Vector &data, Stamp &stmp)
 {
-    yarp::os::LockGuard guard(mutex);
+    // If a new sample is available, take the middle buffer as the new front buffer
+    if( middleIndex.load(std::memory_order_acquire) & GS_NEW_SAMPLE_FLAG )
+    {
+        int oldMiddle = middleIndex.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = oldMiddle & GS_INDEX_MASK;
+    }
 
-    if (dataAvailable)
+    const Sample & front = samples[frontIndex];
+
+    if( front.arrivalTime < 0.0 || Time::now()-front.arrivalTime > timeoutInSeconds )
     {
-        data=lastVector;
-        stmp = lastStamp;
+        status.store(yarp::dev::IAnalogSensor::AS_TIMEOUT);
+        return false;
     }
 
-    return dataAvailable;
+    data=front.data;
+    stmp=front.stamp;
+    status.store(yarp::dev::IAnalogSensor::AS_OK);
+
+    return true;
 }
 
 inline int GSInputPortProcessor::getIterations()
@@ -123,12 +163,22 @@ void GSInputPortProcessor::getEstFrequency(int &ite, double &av, double &min, do
 
 bool GSInputPortProcessor::getState()
 {
-    return dataAvailable;
+    return dataReceived.load();
+}
+
+int GSInputPortProcessor::getStatus()
+{
+    return status.load();
+}
+
+unsigned long GSInputPortProcessor::getNrOfOverwrittenSamples()
+{
+    return nrOfOverwrittenSamples.load();
 }
 
 int GSInputPortProcessor::getChannels()
 {
-    return (int)lastVector.size();
+    return channels.load();
 }
 
 
@@ -153,6 +203,14 @@ bool yarp::dev::GenericSensorClient::open(yarp::os::Searchable &config)
         return false;
     }
 
+    double timeout = config.check("timeout", Value(GS_ANALOG_TIMEOUT), "maximum age of the last sample returned by read (in seconds)").asDouble();
+    if (timeout <= 0.0)
+    {
+        yError("GenericSensorClient::open() error timeout should be positive");
+        return false;
+    }
+    inputPort.setTimeout(timeout);
+
     if (!inputPort.open(local.c_str()))
     {
         yError("GenericSensorClient::open() error could not open port %s, check network", local.c_str());
@@ -198,4 +256,14 @@ bool yarp::dev::GenericSensorClient::getChannels(int* nc)
 Stamp yarp::dev::GenericSensorClient::getLastInputStamp()
 {
     return lastTs;
+}
+
+int yarp::dev::GenericSensorClient::getSensorStatus()
+{
+    return inputPort.getStatus();
+}
+
+unsigned long yarp::dev::GenericSensorClient::getNrOfOverwrittenSamples()
+{
+    return inputPort.getNrOfOverwrittenSamples();
 }
\ No newline at end of file
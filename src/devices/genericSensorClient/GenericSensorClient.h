@@ -17,23 +17,55 @@
 #include <yarp/os/Time.h>
 #include <yarp/dev/PolyDriver.h>
 
+#include <atomic>
+
 /**
  * Class copied from the InputPortProcessor class in AnalogSensorClient.
  * Once we port this in YARP we can merge this two classes.
+ *
+ * The last sample received is exchanged between the port callback and the reader
+ * through a triple buffer, so neither the callback nor the reader ever wait for each other:
+ * the callback writes the new sample in the back buffer and swaps it with the middle one,
+ * while the reader swaps the front buffer with the middle one only if it contains a new sample.
+ * Only one thread at the time should call getLast.
+ *
+ * Each sample is stored with its arrival time, and getLast fails (reporting a timeout)
+ * if the last sample is older than the configured timeout.
  */
 class GSInputPortProcessor : public yarp::os::BufferedPort<yarp::sig::Vector>
 {
+    struct Sample
+    {
+        yarp::sig::Vector data;
+        yarp::os::Stamp stamp;
+        double arrivalTime;
+    };
+
+    Sample samples[3];
+    int backIndex;  // used only by the callback
+    int frontIndex; // used only by the reader
+
+    /**
+     * Index of the middle buffer, with the GS_NEW_SAMPLE_FLAG bit set
+     * if it contains a sample that was not read yet.
+     */
+    std::atomic<int> middleIndex;
+    std::atomic<int> channels;
+    std::atomic<bool> dataReceived;
+    std::atomic<int> status;
+    std::atomic<unsigned long> nrOfOverwrittenSamples;
+
+    double timeoutInSeconds;
+    yarp::os::Stamp localStamp;
+
+    // Statistics on the period of the received samples, not used by getLast
     yarp::os::Mutex mutex;
-    yarp::sig::Vector lastVector;
-    yarp::os::Stamp lastStamp;
     double deltaT;
     double deltaTMax;
     double deltaTMin;
     double prev;
     double now;
 
-    bool dataAvailable;
-
     int count;
 
 public:
@@ -41,6 +73,11 @@ public:
 
     GSInputPortProcessor();
 
+    /**
+     * Set the maximum age of the last sample that is considered valid.
+     */
+    void setTimeout(double timeoutInSeconds);
+
     using yarp::os::BufferedPort<yarp::sig::Vector>::onRead;
     virtual void onRead(yarp::sig::Vector &v);
 
@@ -51,8 +88,22 @@ public:
     // time is in ms
     void getEstFrequency(int &ite, double &av, double &min, double &max);
 
+    /**
+     * True if at least one sample was received, independently of its age.
+     */
     bool getState();
 
+    /**
+     * Status of the sensor at the last getLast call, as a yarp::dev::IAnalogSensor::AS_* code
+     * (AS_OK or AS_TIMEOUT).
+     */
+    int getStatus();
+
+    /**
+     * Number of samples received and overwritten by a newer one before being read.
+     */
+    unsigned long getNrOfOverwrittenSamples();
+
     int getChannels();
 };
 
@@ -74,10 +125,17 @@ namespace dev {
 * | local          | string |       |               | Yes       | full name if the port opened by the device  | must start with a '/' character |
 * | remote         | string |       |               | Yes       | full name of the port the device need to connect to | must start with a '/' character |
 * | carrier        | string |       | udp           | No        | type of carrier to use, like tcp, udp and so on ...  | - |
+* | timeout        | double | s     | 0.1           | No        | maximum age of the last received sample for it to be returned by read | - |
 *
 *  The device will create a port with name <local> and will connect to a port colled <remote> at startup,
 * ex: <b> /myModule/linertial </b>, and will connect to a port called <b> /icub/inertial<b>.
 *
+* The read method never blocks, and it returns false if no sample was received in the last timeout seconds,
+* so that the user can detect stale data instead of using an old sample. The status of the sensor is returned
+* also by getSensorStatus, and the timestamp of the last read sample (the one of the sender, if available)
+* by getLastInputStamp. getChannels succeeds as soon as the first sample is received, independently of the timeout.
+* The samples that were overwritten by a newer one before being read are counted by getNrOfOverwrittenSamples.
+*
 **/
 class GenericSensorClient: public yarp::dev::DeviceDriver,
                                       public yarp::dev::IPreciselyTimed,
@@ -108,6 +166,18 @@ public:
 
     /* IPreciselyTimed methods */
     yarp::os::Stamp getLastInputStamp();
+
+    /**
+     * Status of the sensor at the last read, as a yarp::dev::IAnalogSensor::AS_* code
+     * (AS_OK or AS_TIMEOUT).
+     */
+    int getSensorStatus();
+
+    /**
+     * Number of samples received and overwritten by a newer one before being read,
+     * i.e. samples lost because read is called at a lower rate than the sensor publishes.
+     */
+    unsigned long getNrOfOverwrittenSamples();
 };
 
 }
@@ -12,7 +12,7 @@ using namespace yarp::dev;
 using namespace yarp::os;
 using namespace yarp::sig;
 
-VirtualAnalogClient::VirtualAnalogClient()
+VirtualAnalogClient::VirtualAnalogClient(): m_useVectorFormat(false)
 {
 
 }
@@ -107,11 +107,26 @@ bool VirtualAnalogClient::open(Searchable& config)
 
     m_virtualAnalogSensorInteger = prop.find("virtualAnalogSensorInteger").isInt();
 
+    m_useVectorFormat = false;
+    if( prop.check("dataFormat") )
+    {
+        ConstString dataFormat = prop.find("dataFormat").asString();
+        if( dataFormat == "vector" )
+        {
+            m_useVectorFormat = true;
+        }
+        else if( dataFormat != "bottle" )
+        {
+            yError() << "VirtualAnalogClient: unknown dataFormat " << dataFormat << ", possible values are bottle and vector";
+            return false;
+        }
+    }
+
     // Resize buffer
     measureBuffer.resize(m_axisName.size(),0.0);
 
     // Open the port
-    bool ok = m_outputPort.open(m_local);
+    bool ok = outputPort().open(m_local);
 
     if( !ok )
     {
@@ -150,10 +165,20 @@ bool VirtualAnalogClient::open(Searchable& config)
 bool VirtualAnalogClient::close()
 {
     bool ok = Network::disconnect(m_local,m_remote);
-    m_outputPort.close();
+    outputPort().close();
     return ok;
 }
 
+Contactable& VirtualAnalogClient::outputPort()
+{
+    if( m_useVectorFormat )
+    {
+        return m_outputVectorPort;
+    }
+
+    return m_outputPort;
+}
+
 bool VirtualAnalogClient::updateVirtualAnalogSensorMeasure(Vector& measure)
 {
     if( (int) measure.size() != this->getVirtualAnalogSensorChannels() )
@@ -185,6 +210,20 @@ bool VirtualAnalogClient::updateVirtualAnalogSensorMeasure(int ch, double& measu
 
 void VirtualAnalogClient::sendData()
 {
+    if( m_useVectorFormat )
+    {
+        // Header and measures in a single contiguous buffer, serialized without per-element tags
+        Vector & v = m_outputVectorPort.prepare();
+        v.resize(measureBuffer.size()+1);
+        v[0] = m_virtualAnalogSensorInteger;
+        for(size_t i=0;i<measureBuffer.size();i++)
+        {
+            v[i+1] = measureBuffer[i];
+        }
+        m_outputVectorPort.write();
+        return;
+    }
+
     Bottle & a = m_outputPort.prepare();
     a.clear();
     a.addInt(m_virtualAnalogSensorInteger);
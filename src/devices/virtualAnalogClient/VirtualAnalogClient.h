@@ -42,6 +42,7 @@ namespace dev {
 * | AxisType       | vector of strings | - |revolute| No        | type of the axies in which the torque estimate is published | - |
 * | virtualAnalogSensorInteger | int | - | -        | Yes       | A virtualAnalogServer specific integer, check the VirtualAnalogServer for more info.  | - |
 * | autoconnect    |   bool    |   -   |    true  | No        | Specify if port should be connected or not | - |
+* | dataFormat     |   string  |   -   |  bottle  | No        | Format of the messages, bottle or vector (see below) | - |
 *
 *  The device will create a port with name <local> and will connect to a port colled <remote> at startup,
 * ex: <b> /wholeBodyDynamics/left_leg/Torques:o  </b>, and will connect to a port called <b> /icub/joint_vsens/left_leg:i <b>.
@@ -51,6 +52,13 @@ namespace dev {
 *
 * For the single axis updateMeasure, the value sent for the not-update axis will be the one stored in a buffer, that is initialized to zero.
 *
+* With the default bottle dataFormat, each message is a Bottle containing the virtualAnalogSensorInteger (as an int)
+* followed by one double for each axis. With the vector dataFormat, each message is a yarp::sig::Vector, i.e. a single
+* contiguous array of doubles containing the virtualAnalogSensorInteger followed by the measures of the axes:
+* it is serialized with a single memory copy and it is smaller on the wire, as the elements are not tagged one by one.
+* On the wire the vector is a list of doubles, so it can be read also by a server that parses the message as a Bottle
+* (the header is read by asInt()). The vector format is recommended for high-rate torque streams.
+*
 **/
 class VirtualAnalogClient:    public DeviceDriver,
                               public IVirtualAnalogSensor,
@@ -66,8 +74,19 @@ protected:
 
     yarp::os::BufferedPort<yarp::os::Bottle> m_outputPort;
 
+    /**
+     * Port used instead of m_outputPort with the vector dataFormat.
+     */
+    yarp::os::BufferedPort<yarp::sig::Vector> m_outputVectorPort;
+    bool m_useVectorFormat;
+
     yarp::sig::Vector measureBuffer;
 
+    /**
+     * Port used to publish the data (the one of the configured dataFormat).
+     */
+    yarp::os::Contactable & outputPort();
+
     /**
      * Publish the data contained in the measureBuffer on the port.
      */
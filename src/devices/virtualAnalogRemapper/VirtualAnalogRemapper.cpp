@@ -8,6 +8,7 @@
 #include <yarp/os/Log.h>
 #include <yarp/os/LogStream.h>
 
+#include <cstring>
 #include <map>
 
 using namespace yarp::dev;
@@ -111,6 +112,8 @@ bool VirtualAnalogRemapper::attachAll(const PolyDriverList& p)
             remappedAxes[axis].dev = 0;
             remappedAxes[axis].devInfo = 0;
             remappedAxes[axis].localAxis = 0;
+            remappedAxes[axis].devIdx = -1;
+            remappedAxes[axis].useVectorUpdateMeasure = false;
 
 
             // we support not publishing the information for some axis
@@ -121,6 +124,8 @@ bool VirtualAnalogRemapper::attachAll(const PolyDriverList& p)
             remappedAxes[axis].dev = axisName2virtualAnalogSensorPtr[jointName];
             remappedAxes[axis].devInfo = axisName2IAxisInfoPtr[jointName];
             remappedAxes[axis].localAxis = axisName2localAxis[jointName];
+            remappedAxes[axis].devIdx = -1;
+            remappedAxes[axis].useVectorUpdateMeasure = false;
         }
     }
 
@@ -153,6 +158,7 @@ bool VirtualAnalogRemapper::attachAll(const PolyDriverList& p)
         }
 
         // If all the axes of the subdevice are remapped, we can use the vector updateMeasure
+        remappedSubdevices[subdev].spans.clear();
         if( axesOfSubDeviceThatAreRemapped == remappedSubdevices[subdev].dev->getVirtualAnalogSensorChannels() )
         {
             remappedSubdevices[subdev].useVectorUpdateMeasure = true;
@@ -160,6 +166,23 @@ bool VirtualAnalogRemapper::attachAll(const PolyDriverList& p)
             {
                 int globalIdx = remappedSubdevices[subdev].local2globalIdx[localIndex];
                 remappedAxes[globalIdx].useVectorUpdateMeasure = true;
+
+                // Extend the last span if the axis is contiguous to it, otherwise start a new one
+                std::vector<virtualAnalogSensorRemappedSpan> & spans = remappedSubdevices[subdev].spans;
+                if( !spans.empty() &&
+                    spans.back().localStart+spans.back().length == (int)localIndex &&
+                    spans.back().globalStart+spans.back().length == globalIdx )
+                {
+                    spans.back().length++;
+                }
+                else
+                {
+                    virtualAnalogSensorRemappedSpan span;
+                    span.localStart = localIndex;
+                    span.globalStart = globalIdx;
+                    span.length = 1;
+                    spans.push_back(span);
+                }
             }
         }
         else
@@ -169,7 +192,7 @@ bool VirtualAnalogRemapper::attachAll(const PolyDriverList& p)
             {
                 int globalIdx = remappedSubdevices[subdev].local2globalIdx[localIndex];
 
-                if( globalIdx > 0 )
+                if( globalIdx >= 0 )
                 {
                     remappedAxes[globalIdx].useVectorUpdateMeasure = false;
                 }
@@ -177,6 +200,16 @@ bool VirtualAnalogRemapper::attachAll(const PolyDriverList& p)
         }
     }
 
+    // Axes that are remapped, but not updated with the vector updateMeasure
+    singleAxisUpdateMeasureAxes.clear();
+    for(size_t axis = 0; axis < remappedAxes.size(); axis++)
+    {
+        if( remappedAxes[axis].dev && !remappedAxes[axis].useVectorUpdateMeasure )
+        {
+            singleAxisUpdateMeasureAxes.push_back(axis);
+        }
+    }
+
     return true;
 }
 
@@ -185,6 +218,7 @@ bool VirtualAnalogRemapper::detachAll()
 {
     remappedAxes.resize(0);
     remappedSubdevices.resize(0);
+    singleAxisUpdateMeasureAxes.resize(0);
 
     return true;
 }
@@ -212,34 +246,27 @@ bool VirtualAnalogRemapper::updateVirtualAnalogSensorMeasure(Vector& measure)
     {
         if( this->remappedSubdevices[subdevIdx].useVectorUpdateMeasure )
         {
-            IVirtualAnalogSensor * dev = this->remappedSubdevices[subdevIdx].dev;
+            virtualAnalogSensorRemappedSubdevice & subdev = this->remappedSubdevices[subdevIdx];
 
-            // Update the measure buffer
-            for(size_t localIndex = 0; localIndex < this->remappedSubdevices[subdevIdx].measureBuffer.size(); localIndex++)
+            // Update the measure buffer, with a copy for each span of contiguous axes
+            for(size_t span = 0; span < subdev.spans.size(); span++)
             {
-                int globalIndex = this->remappedSubdevices[subdevIdx].local2globalIdx[localIndex];
-                this->remappedSubdevices[subdevIdx].measureBuffer[localIndex] = measure[globalIndex];
+                memcpy(subdev.measureBuffer.data()+subdev.spans[span].localStart,
+                       measure.data()+subdev.spans[span].globalStart,
+                       subdev.spans[span].length*sizeof(double));
             }
 
-            bool ok = dev->updateVirtualAnalogSensorMeasure(this->remappedSubdevices[subdevIdx].measureBuffer);
+            bool ok = subdev.dev->updateVirtualAnalogSensorMeasure(subdev.measureBuffer);
             ret = ok && ret;
         }
     }
 
     // use single axis method (for axis that are not already updated)
-    for(int jnt=0; jnt < this->getVirtualAnalogSensorChannels(); jnt++)
+    for(size_t i=0; i < singleAxisUpdateMeasureAxes.size(); i++)
     {
-        if( !(this->remappedAxes[jnt].useVectorUpdateMeasure) )
-        {
-            IVirtualAnalogSensor * dev = this->remappedAxes[jnt].dev;
-            int localAxis = this->remappedAxes[jnt].localAxis;
-
-            if( dev )
-            {
-                bool ok = dev->updateVirtualAnalogSensorMeasure(localAxis,measure[jnt]);
-                ret = ok && ret;
-            }
-        }
+        int jnt = singleAxisUpdateMeasureAxes[i];
+        bool ok = this->remappedAxes[jnt].dev->updateVirtualAnalogSensorMeasure(this->remappedAxes[jnt].localAxis,measure[jnt]);
+        ret = ok && ret;
     }
 
     return ret;
@@ -29,6 +29,17 @@ struct virtualAnalogSensorRemappedAxis
     bool useVectorUpdateMeasure;
 };
 
+/**
+ * Span of contiguous axes of a subdevice that are
+ * mapped to contiguous axes of the remapper.
+ */
+struct virtualAnalogSensorRemappedSpan
+{
+    int localStart;
+    int globalStart;
+    int length;
+};
+
 /**
  * Structure of information relative to a remapped subdevice.
  */
@@ -38,6 +49,12 @@ struct virtualAnalogSensorRemappedSubdevice
     yarp::sig::Vector measureBuffer;
     std::vector<int> local2globalIdx;
     bool useVectorUpdateMeasure;
+
+    /**
+     * Remapping plan of the subdevice: if useVectorUpdateMeasure is true, the spans cover
+     * all the axes of the subdevice, and the measureBuffer is filled with a copy for each span.
+     */
+    std::vector<virtualAnalogSensorRemappedSpan> spans;
 };
 
 
@@ -63,6 +80,11 @@ struct virtualAnalogSensorRemappedSubdevice
 *  Consequently if the VirtualAnalogRemapper detects that all channels in a subdevice are part
 *  of the remapped device, the vector-value updateMeasure method will be used.
 *
+*  The remapping plan is computed once in attachAll: the axes of each subdevice are grouped in spans
+*  of axes that are contiguous both in the subdevice and in the remapper, so that the measure buffer
+*  of a subdevice is filled with a copy for each span (tipically a single one), and the list of the
+*  axes that need the single-axis updateMeasure is precomputed.
+*
 *
 *  Parameters required by this device are:
 * | Parameter name | SubParameter   | Type    | Units          | Default Value | Required                    | Description                                                       | Notes |
@@ -105,6 +127,12 @@ protected:
      */
     std::vector<virtualAnalogSensorRemappedSubdevice> remappedSubdevices;
 
+    /**
+     * Axes of the remapper that are updated with the single-axis updateMeasure method,
+     * i.e. the axes of the subdevices that are only partially remapped.
+     */
+    std::vector<int> singleAxisUpdateMeasureAxes;
+
     /**
      * Get the number of remapped devices. 
      */
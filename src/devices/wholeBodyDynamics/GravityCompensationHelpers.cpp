@@ -15,6 +15,7 @@ namespace wholeBodyDynamics
 GravityCompensationHelper::GravityCompensationHelper(): m_model(),
                                                         m_isModelValid(false),
                                                         m_isKinematicsUpdated(false),
+                                                        m_kinematicsMethod(FULL_VEL_ACC_KINEMATICS),
                                                         m_dynamicTraversal(),
                                                         m_kinematicTraversals(),
                                                         m_jointPos(),
@@ -74,6 +75,12 @@ bool GravityCompensationHelper::loadModel(const Model& _model, const std::string
     m_jointDofsZero.zero();
     m_linkVels.resize(m_model);
     m_linkProperAccs.resize(m_model);
+
+    // The ORIENTATION_ONLY_KINEMATICS method never writes the link velocities, that are always zero
+    for(size_t link=0; link < m_model.getNrOfLinks(); link++)
+    {
+        m_linkVels(link).zero();
+    }
     m_linkIntWrenches.resize(m_model);
     m_linkNetExternalWrenchesZero.resize(m_model);
     m_generalizedTorques.resize(m_model);
@@ -85,6 +92,16 @@ bool GravityCompensationHelper::loadModel(const Model& _model, const std::string
 }
 
 
+void GravityCompensationHelper::setKinematicsMethod(const GravityCompensationKinematicsMethod method)
+{
+    m_kinematicsMethod = method;
+}
+
+GravityCompensationKinematicsMethod GravityCompensationHelper::getKinematicsMethod() const
+{
+    return m_kinematicsMethod;
+}
+
 bool GravityCompensationHelper::updateKinematicsFromGravity(const JointPosDoubleArray& jointPos,
                                                             const FrameIndex& fixedFrame,
                                                             const Vector3& gravity)
@@ -157,12 +174,22 @@ bool GravityCompensationHelper::updateKinematicsFromProperAcceleration(const Joi
     base_classical_acc_link.fromSpatial(base_acc_link,base_vel_link);
 
     // Propagate the kinematics information
-    bool ok = dynamicsEstimationForwardVelAccKinematics(m_model,*(m_kinematicTraversals[floatingLinkIndex]),
-                                                     base_classical_acc_link.getLinearVec3(),
-                                                     base_vel_link.getAngularVec3(),
-                                                     base_classical_acc_link.getAngularVec3(),
-                                                     jointPos,m_jointDofsZero,m_jointDofsZero,
-                                                     m_linkVels,m_linkProperAccs);
+    bool ok;
+    if( m_kinematicsMethod == ORIENTATION_ONLY_KINEMATICS )
+    {
+        ok = propagateOrientationOnlyKinematics(*(m_kinematicTraversals[floatingLinkIndex]),
+                                                jointPos,
+                                                base_classical_acc_link.getLinearVec3());
+    }
+    else
+    {
+        ok = dynamicsEstimationForwardVelAccKinematics(m_model,*(m_kinematicTraversals[floatingLinkIndex]),
+                                                       base_classical_acc_link.getLinearVec3(),
+                                                       base_vel_link.getAngularVec3(),
+                                                       base_classical_acc_link.getAngularVec3(),
+                                                       jointPos,m_jointDofsZero,m_jointDofsZero,
+                                                       m_linkVels,m_linkProperAccs);
+    }
 
     // Store joint positions
     m_jointPos = jointPos;
@@ -178,6 +205,43 @@ bool GravityCompensationHelper::updateKinematicsFromProperAcceleration(const Joi
     }
 }
 
+bool GravityCompensationHelper::propagateOrientationOnlyKinematics(const Traversal& traversal,
+                                                                   const JointPosDoubleArray& jointPos,
+                                                                   const Vector3& floatingLinkProperAcc)
+{
+    Vector3 zero3;
+    zero3.zero();
+
+    for(unsigned int traversalEl = 0; traversalEl < traversal.getNrOfVisitedLinks(); traversalEl++)
+    {
+        LinkConstPtr visitedLink = traversal.getLink(traversalEl);
+        LinkIndex    visitedLinkIndex = visitedLink->getIndex();
+        LinkConstPtr parentLink  = traversal.getParentLink(traversalEl);
+        IJointConstPtr toParentJoint = traversal.getParentJoint(traversalEl);
+
+        m_linkProperAccs(visitedLinkIndex).setAngularVec3(zero3);
+
+        if( parentLink == 0 )
+        {
+            // Floating link
+            m_linkProperAccs(visitedLinkIndex).setLinearVec3(floatingLinkProperAcc);
+        }
+        else
+        {
+            // With no velocities and no angular accelerations, all the links
+            // have the same linear proper acceleration, just expressed in a different frame
+            LinkIndex parentLinkIndex = parentLink->getIndex();
+            Rotation visited_R_parent = toParentJoint->getTransform(jointPos,visitedLinkIndex,parentLinkIndex).getRotation();
+
+            Vector3 visitedLinkProperAcc;
+            toEigen(visitedLinkProperAcc) = toEigen(visited_R_parent)*toEigen(m_linkProperAccs(parentLinkIndex).getLinearVec3());
+            m_linkProperAccs(visitedLinkIndex).setLinearVec3(visitedLinkProperAcc);
+        }
+    }
+
+    return true;
+}
+
 bool GravityCompensationHelper::getGravityCompensationTorques(JointDOFsDoubleArray & jointTrqs)
 {
     if( !m_isModelValid )
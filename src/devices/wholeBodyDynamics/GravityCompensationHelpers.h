@@ -10,6 +10,28 @@
 namespace wholeBodyDynamics
 {
 
+/**
+ * Method used by GravityCompensationHelper to compute
+ * the kinematic quantities used by the RNEA.
+ */
+enum GravityCompensationKinematicsMethod
+{
+    /**
+     * Full forward velocity and acceleration propagation, using the
+     * dynamicsEstimationForwardVelAccKinematics function also used by the estimator.
+     */
+    FULL_VEL_ACC_KINEMATICS,
+
+    /**
+     * As the gravity compensation torques are computed with zero velocities and
+     * zero joint accelerations, the proper acceleration of each link is just the
+     * proper acceleration of the floating frame rotated in the link frame: only the
+     * orientations of the links are propagated along the traversal.
+     * The result is the same of FULL_VEL_ACC_KINEMATICS, at a lower cost.
+     */
+    ORIENTATION_ONLY_KINEMATICS
+};
+
 /**
  * Class computing the gravity compensation torques
  * using the same accelerometers measurement used by
@@ -26,6 +48,7 @@ private:
     iDynTree::Model m_model;
     bool m_isModelValid;
     bool m_isKinematicsUpdated;
+    GravityCompensationKinematicsMethod m_kinematicsMethod;
 
     /**< Traveral used for the dynamics computations */
     iDynTree::Traversal m_dynamicTraversal;
@@ -42,6 +65,14 @@ private:
     void allocKinematicTraversals(const size_t nrOfLinks);
     void freeKinematicTraversals();
 
+    /**
+     * Propagate the proper acceleration of the floating link (expressed in the link frame)
+     * to all the links, using the ORIENTATION_ONLY_KINEMATICS method.
+     */
+    bool propagateOrientationOnlyKinematics(const iDynTree::Traversal & traversal,
+                                            const iDynTree::JointPosDoubleArray & jointPos,
+                                            const iDynTree::Vector3 & floatingLinkProperAcc);
+
     iDynTree::JointPosDoubleArray m_jointPos;
     iDynTree::JointDOFsDoubleArray m_jointDofsZero;
     iDynTree::LinkVelArray m_linkVels;
@@ -63,6 +94,14 @@ public:
      */
     bool loadModel(const iDynTree::Model & _model , const std::string dynamicBase);
 
+    /**
+     * Set the method used to compute the kinematics (default: FULL_VEL_ACC_KINEMATICS).
+     * The new method is used starting from the next kinematics update.
+     */
+    void setKinematicsMethod(const GravityCompensationKinematicsMethod method);
+
+    GravityCompensationKinematicsMethod getKinematicsMethod() const;
+
     /**
      * Set the kinematic information necessary for the gravity torques estimation using the
      * proper acceleration coming from an acceleromter.
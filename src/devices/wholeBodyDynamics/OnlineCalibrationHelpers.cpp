@@ -0,0 +1,154 @@
+#include "OnlineCalibrationHelpers.h"
+
+#include <iDynTree/Core/EigenHelpers.h>
+
+#include <cmath>
+
+namespace wholeBodyDynamics
+{
+
+StillnessDetector::StillnessDetector(): m_isReferenceValid(false),
+                                        m_jointPosThresholdInRad(0.0),
+                                        m_imuAngularVelThresholdInRadPerSec(0.0)
+{
+}
+
+void StillnessDetector::resize(const iDynTree::Model& model)
+{
+    m_referenceJointPos.resize(model);
+    m_isReferenceValid = false;
+}
+
+void StillnessDetector::setThresholds(const double jointPosThresholdInRad, const double imuAngularVelThresholdInRadPerSec)
+{
+    m_jointPosThresholdInRad = jointPosThresholdInRad;
+    m_imuAngularVelThresholdInRadPerSec = imuAngularVelThresholdInRadPerSec;
+}
+
+void StillnessDetector::reset()
+{
+    m_isReferenceValid = false;
+}
+
+bool StillnessDetector::update(const iDynTree::JointPosDoubleArray& jointPos, const iDynTree::Vector3& imuAngularVel)
+{
+    bool isStill = m_isReferenceValid;
+
+    if( iDynTree::toEigen(imuAngularVel).norm() > m_imuAngularVelThresholdInRadPerSec )
+    {
+        isStill = false;
+    }
+
+    if( isStill &&
+        (iDynTree::toEigen(jointPos)-iDynTree::toEigen(m_referenceJointPos)).cwiseAbs().maxCoeff() > m_jointPosThresholdInRad )
+    {
+        isStill = false;
+    }
+
+    // If the robot moved, the stillness interval starts again from the current position
+    if( !isStill )
+    {
+        m_referenceJointPos = jointPos;
+        m_isReferenceValid = true;
+    }
+
+    return isStill;
+}
+
+OnlineFTOffsetEstimator::OnlineFTOffsetEstimator(): m_nrOfSamples(0),
+                                                    m_nrOfSamplesPerUpdate(100),
+                                                    m_offsetUpdateGain(0.1),
+                                                    m_maxForceStdDevInNewton(1.0),
+                                                    m_maxOffsetCorrectionInNewton(5.0)
+{
+}
+
+void OnlineFTOffsetEstimator::resize(const size_t nrOfFTSensors)
+{
+    m_mean.resize(nrOfFTSensors);
+    m_m2.resize(nrOfFTSensors);
+    reset();
+}
+
+void OnlineFTOffsetEstimator::setParameters(const size_t nrOfSamplesPerUpdate,
+                                            const double offsetUpdateGain,
+                                            const double maxForceStdDevInNewton,
+                                            const double maxOffsetCorrectionInNewton)
+{
+    m_nrOfSamplesPerUpdate = nrOfSamplesPerUpdate;
+    m_offsetUpdateGain = offsetUpdateGain;
+    m_maxForceStdDevInNewton = maxForceStdDevInNewton;
+    m_maxOffsetCorrectionInNewton = maxOffsetCorrectionInNewton;
+    reset();
+}
+
+void OnlineFTOffsetEstimator::reset()
+{
+    m_nrOfSamples = 0;
+    for(size_t ft=0; ft < m_mean.size(); ft++)
+    {
+        m_mean[ft].zero();
+        m_m2[ft].zero();
+    }
+}
+
+void OnlineFTOffsetEstimator::addResidual(const size_t ft, const iDynTree::Wrench& residual)
+{
+    // Welford update, m_nrOfSamples is incremented only in completeSample
+    double n = static_cast<double>(m_nrOfSamples+1);
+    Eigen::Matrix<double,6,1> delta = iDynTree::toEigen(residual.asVector())-iDynTree::toEigen(m_mean[ft]);
+    iDynTree::toEigen(m_mean[ft]) += delta/n;
+    iDynTree::toEigen(m_m2[ft]) += delta.cwiseProduct(iDynTree::toEigen(residual.asVector())-iDynTree::toEigen(m_mean[ft]));
+}
+
+bool OnlineFTOffsetEstimator::completeSample()
+{
+    m_nrOfSamples++;
+    return m_nrOfSamples >= m_nrOfSamplesPerUpdate;
+}
+
+bool OnlineFTOffsetEstimator::isWindowConsistent() const
+{
+    if( m_nrOfSamples < 2 )
+    {
+        return false;
+    }
+
+    double maxForceVariance = m_maxForceStdDevInNewton*m_maxForceStdDevInNewton;
+    for(size_t ft=0; ft < m_m2.size(); ft++)
+    {
+        for(unsigned int i=0; i < 3; i++)
+        {
+            if( m_m2[ft](i)/(m_nrOfSamples-1) > maxForceVariance )
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+double OnlineFTOffsetEstimator::getForceCorrectionNorm(const size_t ft, const iDynTree::Wrench& offset) const
+{
+    return (iDynTree::toEigen(m_mean[ft]).head<3>()-iDynTree::toEigen(offset.asVector()).head<3>()).norm();
+}
+
+bool OnlineFTOffsetEstimator::isCorrectionBounded(const size_t ft, const iDynTree::Wrench& offset) const
+{
+    return getForceCorrectionNorm(ft,offset) <= m_maxOffsetCorrectionInNewton;
+}
+
+void OnlineFTOffsetEstimator::updateOffset(const size_t ft, iDynTree::Wrench& offset) const
+{
+    Eigen::Matrix<double,6,1> newOffset = iDynTree::toEigen(offset.asVector())
+                                          + m_offsetUpdateGain*(iDynTree::toEigen(m_mean[ft])-iDynTree::toEigen(offset.asVector()));
+
+    iDynTree::Vector3 force, torque;
+    iDynTree::toEigen(force)  = newOffset.head<3>();
+    iDynTree::toEigen(torque) = newOffset.tail<3>();
+    offset.setLinearVec3(force);
+    offset.setAngularVec3(torque);
+}
+
+}
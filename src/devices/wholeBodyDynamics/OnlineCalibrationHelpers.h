@@ -0,0 +1,144 @@
+#ifndef WHOLE_BODY_DYNAMICS_ONLINE_CALIBRATION_HELPERS_H
+#define WHOLE_BODY_DYNAMICS_ONLINE_CALIBRATION_HELPERS_H
+
+// iDynTree includes
+#include <iDynTree/Core/VectorFixSize.h>
+#include <iDynTree/Core/Wrench.h>
+#include <iDynTree/Model/Model.h>
+#include <iDynTree/Model/JointState.h>
+
+#include <vector>
+
+namespace wholeBodyDynamics
+{
+
+/**
+ * Class detecting if the robot is still, i.e. if the joint positions
+ * did not move from the position at which the robot stopped more than
+ * a given threshold and the angular velocity measured by the IMU is below
+ * a given threshold.
+ *
+ * The joint positions are used instead of the joint velocities
+ * because they are always read by wholeBodyDynamics, and their drift
+ * bounds the average joint velocity during the still interval.
+ */
+class StillnessDetector
+{
+private:
+    iDynTree::JointPosDoubleArray m_referenceJointPos;
+    bool m_isReferenceValid;
+    double m_jointPosThresholdInRad;
+    double m_imuAngularVelThresholdInRadPerSec;
+
+public:
+    StillnessDetector();
+
+    /**
+     * Allocate the buffers, so that update does not allocate memory.
+     */
+    void resize(const iDynTree::Model & model);
+
+    void setThresholds(const double jointPosThresholdInRad, const double imuAngularVelThresholdInRadPerSec);
+
+    /**
+     * Forget the position at which the robot stopped.
+     */
+    void reset();
+
+    /**
+     * Update the detector with the current measurements.
+     *
+     * @return true if the robot was still since the last call that returned false, false otherwise.
+     */
+    bool update(const iDynTree::JointPosDoubleArray & jointPos, const iDynTree::Vector3 & imuAngularVel);
+};
+
+/**
+ * Class estimating the offsets of a set of F/T sensors from the residuals
+ * between the (secondary calibrated) measurements and the measurements predicted
+ * by the model, collected while the robot is still.
+ *
+ * The mean and the variance of the residuals of each sensor are computed with
+ * the Welford algorithm. When a window of nrOfSamplesPerUpdate samples is complete,
+ * if the standard deviation of the force residuals is below maxForceStdDevInNewton
+ * (i.e. the external forces did not change during the window) the offset is moved
+ * towards the mean of the residuals:
+ *
+ * offset = offset + offsetUpdateGain*(mean - offset)
+ *
+ * that is the recursive least squares estimate of a constant offset with an exponential
+ * forgetting of the previous windows.
+ *
+ * A constant external force that is not in the assumed contacts (e.g. a robot leaning on
+ * a table) gives a consistent window as well, so the offset is updated only if the norm
+ * of the force correction (mean - offset) is below maxOffsetCorrectionInNewton.
+ */
+class OnlineFTOffsetEstimator
+{
+private:
+    std::vector<iDynTree::Vector6> m_mean;
+    std::vector<iDynTree::Vector6> m_m2;
+    size_t m_nrOfSamples;
+
+    size_t m_nrOfSamplesPerUpdate;
+    double m_offsetUpdateGain;
+    double m_maxForceStdDevInNewton;
+    double m_maxOffsetCorrectionInNewton;
+
+public:
+    OnlineFTOffsetEstimator();
+
+    /**
+     * Allocate the buffers, so that the other methods do not allocate memory.
+     */
+    void resize(const size_t nrOfFTSensors);
+
+    void setParameters(const size_t nrOfSamplesPerUpdate,
+                       const double offsetUpdateGain,
+                       const double maxForceStdDevInNewton,
+                       const double maxOffsetCorrectionInNewton);
+
+    /**
+     * Discard the samples of the current window.
+     */
+    void reset();
+
+    /**
+     * Add the residual (measurement - prediction) of a sensor.
+     * The residuals of all the sensors should be added before calling completeSample.
+     */
+    void addResidual(const size_t ft, const iDynTree::Wrench & residual);
+
+    /**
+     * Mark the end of a sample.
+     *
+     * @return true if the window of samples is complete, false otherwise.
+     */
+    bool completeSample();
+
+    /**
+     * True if the residuals of the window are consistent, i.e. if
+     * the standard deviation of their forces is below the threshold.
+     */
+    bool isWindowConsistent() const;
+
+    /**
+     * Norm of the force correction (mean of the residuals of the window - offset) of a sensor.
+     */
+    double getForceCorrectionNorm(const size_t ft, const iDynTree::Wrench & offset) const;
+
+    /**
+     * True if the norm of the force correction of the offset of a sensor
+     * is below maxOffsetCorrectionInNewton.
+     */
+    bool isCorrectionBounded(const size_t ft, const iDynTree::Wrench & offset) const;
+
+    /**
+     * Update the offset of a sensor with the mean of the residuals of the window.
+     */
+    void updateOffset(const size_t ft, iDynTree::Wrench & offset) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include "ProfilingHelpers.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace wholeBodyDynamics
+{
+
+TimingStatistics::TimingStatistics(): m_name(),
+                                      m_binWidthInSeconds(1.0),
+                                      m_histogram(0),
+                                      m_nrOfSamples(0),
+                                      m_last(0.0),
+                                      m_min(0.0),
+                                      m_max(0.0),
+                                      m_sum(0.0)
+{
+
+}
+
+void TimingStatistics::init(const std::string& name, const double binWidthInSeconds, const size_t nrOfBins)
+{
+    m_name = name;
+    m_binWidthInSeconds = binWidthInSeconds;
+
+    // The last bin is used for durations that exceed the histogram range
+    m_histogram.resize(nrOfBins+1);
+
+    reset();
+}
+
+void TimingStatistics::reset()
+{
+    std::fill(m_histogram.begin(),m_histogram.end(),0);
+    m_nrOfSamples = 0;
+    m_last = 0.0;
+    m_min = 0.0;
+    m_max = 0.0;
+    m_sum = 0.0;
+}
+
+void TimingStatistics::update(const double durationInSeconds)
+{
+    if( m_histogram.size() == 0 )
+    {
+        return;
+    }
+
+    if( m_nrOfSamples == 0 )
+    {
+        m_min = durationInSeconds;
+        m_max = durationInSeconds;
+    }
+    else
+    {
+        m_min = std::min(m_min,durationInSeconds);
+        m_max = std::max(m_max,durationInSeconds);
+    }
+
+    m_last = durationInSeconds;
+    m_sum += durationInSeconds;
+    m_nrOfSamples++;
+
+    size_t bin = m_histogram.size()-1;
+    if( durationInSeconds >= 0.0 && durationInSeconds < m_binWidthInSeconds*(m_histogram.size()-1) )
+    {
+        bin = static_cast<size_t>(durationInSeconds/m_binWidthInSeconds);
+    }
+
+    m_histogram[bin]++;
+}
+
+const std::string& TimingStatistics::name() const
+{
+    return m_name;
+}
+
+size_t TimingStatistics::nrOfSamples() const
+{
+    return m_nrOfSamples;
+}
+
+double TimingStatistics::last() const
+{
+    return m_last;
+}
+
+double TimingStatistics::min() const
+{
+    return m_min;
+}
+
+double TimingStatistics::mean() const
+{
+    if( m_nrOfSamples == 0 )
+    {
+        return 0.0;
+    }
+
+    return m_sum/m_nrOfSamples;
+}
+
+double TimingStatistics::max() const
+{
+    return m_max;
+}
+
+double TimingStatistics::percentile(const double percentile) const
+{
+    double value;
+    percentiles(&percentile,&value,1);
+    return value;
+}
+
+void TimingStatistics::percentiles(const double * percentiles, double * values, const size_t nrOfPercentiles) const
+{
+    size_t percentileIndex = 0;
+
+    if( m_nrOfSamples > 0 )
+    {
+        // The bins after the one of the max are empty
+        size_t lastBin = m_histogram.size()-1;
+        if( m_max >= 0.0 && m_max < m_binWidthInSeconds*(m_histogram.size()-1) )
+        {
+            lastBin = static_cast<size_t>(m_max/m_binWidthInSeconds);
+        }
+
+        size_t cumulativeSamples = 0;
+        for(size_t bin=0; bin < lastBin && percentileIndex < nrOfPercentiles; bin++)
+        {
+            cumulativeSamples += m_histogram[bin];
+
+            // Number of samples that should be smaller or equal than the percentile
+            while( percentileIndex < nrOfPercentiles &&
+                   cumulativeSamples > 0 &&
+                   cumulativeSamples >= (percentiles[percentileIndex]/100.0)*m_nrOfSamples )
+            {
+                // Upper limit of the bin, but never more than the observed max
+                values[percentileIndex] = std::min((bin+1)*m_binWidthInSeconds,m_max);
+                percentileIndex++;
+            }
+        }
+    }
+
+    // The remaining percentiles fall in the bin of the max (or in the overflow bin)
+    for(; percentileIndex < nrOfPercentiles; percentileIndex++)
+    {
+        values[percentileIndex] = m_max;
+    }
+}
+
+std::string TimingStatistics::toString() const
+{
+    const double reportedPercentiles[3] = {50.0,90.0,99.0};
+    double reportedPercentilesValues[3];
+    percentiles(reportedPercentiles,reportedPercentilesValues,3);
+
+    char buf[512];
+    snprintf(buf,sizeof(buf),
+             "%s : samples %lu last %.3f ms min %.3f ms mean %.3f ms max %.3f ms p50 %.3f ms p90 %.3f ms p99 %.3f ms",
+             m_name.c_str(),
+             static_cast<unsigned long>(m_nrOfSamples),
+             1e3*last(),1e3*min(),1e3*mean(),1e3*max(),
+             1e3*reportedPercentilesValues[0],1e3*reportedPercentilesValues[1],1e3*reportedPercentilesValues[2]);
+    return std::string(buf);
+}
+
+}
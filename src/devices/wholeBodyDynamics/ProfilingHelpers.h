@@ -0,0 +1,97 @@
+#ifndef WHOLE_BODY_DYNAMICS_PROFILING_HELPERS_H
+#define WHOLE_BODY_DYNAMICS_PROFILING_HELPERS_H
+
+#include <string>
+#include <vector>
+
+namespace wholeBodyDynamics
+{
+
+/**
+ * Class collecting running statistics (min, mean, max
+ * and an histogram used to compute percentiles) of the
+ * duration of a stage of the estimation.
+ *
+ * The histogram has a fixed number of bins of fixed width,
+ * plus an additional bin for all the durations exceeding the
+ * histogram range, so the update does not allocate memory and
+ * has constant cost.
+ */
+class TimingStatistics
+{
+private:
+    std::string m_name;
+    double m_binWidthInSeconds;
+    std::vector<size_t> m_histogram;
+
+    size_t m_nrOfSamples;
+    double m_last;
+    double m_min;
+    double m_max;
+    double m_sum;
+
+public:
+    /**
+     * Default constructor, the histogram is not allocated.
+     */
+    TimingStatistics();
+
+    /**
+     * Allocate the histogram and reset the statistics.
+     *
+     * @param name name of the stage.
+     * @param binWidthInSeconds width of a bin of the histogram.
+     * @param nrOfBins number of bins of the histogram (excluding the overflow bin).
+     */
+    void init(const std::string & name, const double binWidthInSeconds, const size_t nrOfBins);
+
+    /**
+     * Reset the statistics.
+     */
+    void reset();
+
+    /**
+     * Add a new duration sample (in seconds).
+     */
+    void update(const double durationInSeconds);
+
+    const std::string & name() const;
+    size_t nrOfSamples() const;
+    double last() const;
+    double min() const;
+    double mean() const;
+    double max() const;
+
+    /**
+     * Get an upper bound on the given percentile of the durations,
+     * with the resolution given by the width of the bins.
+     *
+     * If the percentile falls in the overflow bin, the max is returned.
+     *
+     * @param percentile the percentile, between 0.0 and 100.0 .
+     * @return the percentile in seconds, or 0.0 if no sample is available.
+     */
+    double percentile(const double percentile) const;
+
+    /**
+     * Get several percentiles with a single pass on the histogram,
+     * as done by percentile for each one of them.
+     *
+     * The histogram is only scanned up to the bin of the max duration, so
+     * the cost depends on the observed durations and not on the number of bins.
+     *
+     * @param percentiles the percentiles, in increasing order, between 0.0 and 100.0 .
+     * @param values the values of the percentiles in seconds, of size nrOfPercentiles.
+     * @param nrOfPercentiles number of percentiles.
+     */
+    void percentiles(const double * percentiles, double * values, const size_t nrOfPercentiles) const;
+
+    /**
+     * Return a human readable description of the statistics (in milliseconds).
+     */
+    std::string toString() const;
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "SensorsAcquisitionHelpers.h"
+
+namespace wholeBodyDynamics
+{
+
+SensorsSnapshot::SensorsSnapshot(): readCorrectly(false),
+                                    timestamp(0.0)
+{
+    imuLinProperAcc.zero();
+    imuAngularVel.zero();
+}
+
+void SensorsSnapshot::resize(const iDynTree::Model& model, const iDynTree::SensorsList& sensors)
+{
+    jointPos.resize(model);
+    jointPos.zero();
+    jointVel.resize(model);
+    jointVel.zero();
+    jointAcc.resize(model);
+    jointAcc.zero();
+    rawSensorsMeasurements.resize(sensors);
+    ftTemperatures.assign(sensors.getNrOfSensors(iDynTree::SIX_AXIS_FORCE_TORQUE),0.0);
+    imuLinProperAcc.zero();
+    imuAngularVel.zero();
+    readCorrectly = false;
+    timestamp = 0.0;
+}
+
+SensorsSnapshotBuffer::SensorsSnapshotBuffer(): m_exchangedSnapshot(1),
+                                                m_producerSnapshot(0),
+                                                m_consumerSnapshot(2)
+{
+
+}
+
+void SensorsSnapshotBuffer::resize(const iDynTree::Model& model, const iDynTree::SensorsList& sensors)
+{
+    for(size_t i=0; i < 3; i++)
+    {
+        m_snapshots[i].resize(model,sensors);
+    }
+
+    m_producerSnapshot = 0;
+    m_exchangedSnapshot = 1;
+    m_consumerSnapshot = 2;
+}
+
+SensorsSnapshot& SensorsSnapshotBuffer::producerSnapshot()
+{
+    return m_snapshots[m_producerSnapshot];
+}
+
+void SensorsSnapshotBuffer::publish()
+{
+    // Give the just written snapshot to the consumer, and get back the one that was exchanged
+    m_producerSnapshot = m_exchangedSnapshot.exchange(m_producerSnapshot | newDataFlag) & indexMask;
+}
+
+bool SensorsSnapshotBuffer::fetch()
+{
+    if( !(m_exchangedSnapshot.load() & newDataFlag) )
+    {
+        return false;
+    }
+
+    m_consumerSnapshot = m_exchangedSnapshot.exchange(m_consumerSnapshot) & indexMask;
+
+    return true;
+}
+
+const SensorsSnapshot& SensorsSnapshotBuffer::consumerSnapshot() const
+{
+    return m_snapshots[m_consumerSnapshot];
+}
+
+}
+
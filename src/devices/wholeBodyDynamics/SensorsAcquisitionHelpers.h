@@ -0,0 +1,116 @@
+#ifndef SENSORS_ACQUISITION_HELPERS_H
+#define SENSORS_ACQUISITION_HELPERS_H
+
+// iDynTree includes
+#include <iDynTree/Core/VectorFixSize.h>
+#include <iDynTree/Model/Model.h>
+#include <iDynTree/Model/JointState.h>
+#include <iDynTree/Sensors/Sensors.h>
+
+#include <atomic>
+#include <vector>
+
+namespace wholeBodyDynamics
+{
+
+/**
+ * Snapshot of all the sensors measurements used
+ * by wholeBodyDynamics in a single estimation cycle.
+ *
+ * All the quantities are already converted to the units
+ * used by iDynTree (i.e. radians instead of degrees).
+ */
+struct SensorsSnapshot
+{
+    iDynTree::JointPosDoubleArray  jointPos;
+    iDynTree::JointDOFsDoubleArray jointVel;
+    iDynTree::JointDOFsDoubleArray jointAcc;
+
+    /**< Raw measurements of the F/T sensors, in the order of the model sensors */
+    iDynTree::SensorsMeasurements  rawSensorsMeasurements;
+
+    /**< Temperatures of the F/T sensors (only for the sensors with a temperature channel) */
+    std::vector<double> ftTemperatures;
+
+    iDynTree::Vector3 imuLinProperAcc;
+    iDynTree::Vector3 imuAngularVel;
+
+    /**< True if all the sensors read in the acquisition of the snapshot have been read correctly */
+    bool readCorrectly;
+
+    /**< Time (in seconds) at which the acquisition of the snapshot ended */
+    double timestamp;
+
+    SensorsSnapshot();
+
+    /**
+     * Allocate all the buffers, so that no allocation is
+     * performed when the snapshot is filled or copied.
+     */
+    void resize(const iDynTree::Model & model, const iDynTree::SensorsList & sensors);
+};
+
+/**
+ * Single producer / single consumer buffer
+ * to exchange sensors snapshot between the acquisition
+ * thread and the estimation thread without locks.
+ *
+ * Three snapshots are kept: one owned by the producer,
+ * one owned by the consumer and one that is swapped
+ * (with an atomic exchange) between the two. In this way
+ * the producer never waits for the consumer and
+ * the consumer always get the latest complete snapshot.
+ */
+class SensorsSnapshotBuffer
+{
+private:
+    SensorsSnapshot m_snapshots[3];
+
+    /**
+     * Index of the snapshot that is exchanged between the producer and the consumer.
+     * The newDataFlag bit is set if it contains a snapshot not yet read by the consumer.
+     */
+    std::atomic<int> m_exchangedSnapshot;
+    int m_producerSnapshot;
+    int m_consumerSnapshot;
+
+    static const int newDataFlag = 0x4;
+    static const int indexMask   = 0x3;
+
+public:
+    SensorsSnapshotBuffer();
+
+    /**
+     * Allocate all the snapshots. Not thread safe, call it
+     * before starting the producer and the consumer.
+     */
+    void resize(const iDynTree::Model & model, const iDynTree::SensorsList & sensors);
+
+    /**
+     * Snapshot in which the producer can write the new measurements.
+     */
+    SensorsSnapshot & producerSnapshot();
+
+    /**
+     * Make the producer snapshot available to the consumer.
+     * After this call, producerSnapshot() returns a different snapshot.
+     */
+    void publish();
+
+    /**
+     * Update the consumer snapshot with the latest one published.
+     *
+     * @return true if a new snapshot was available, false otherwise
+     *         (in that case the consumer snapshot is unchanged).
+     */
+    bool fetch();
+
+    /**
+     * Snapshot that can be read by the consumer.
+     */
+    const SensorsSnapshot & consumerSnapshot() const;
+};
+
+}
+
+#endif
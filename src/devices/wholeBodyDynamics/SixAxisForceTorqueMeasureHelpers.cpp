@@ -1,10 +1,16 @@
 #include "SixAxisForceTorqueMeasureHelpers.h"
 #include <iDynTree/Core/EigenHelpers.h>
 
+#include <Eigen/Dense>
+
+#include <cassert>
+#include <cmath>
+
 namespace wholeBodyDynamics
 {
 
-SixAxisForceTorqueMeasureProcessor::SixAxisForceTorqueMeasureProcessor()
+SixAxisForceTorqueMeasureProcessor::SixAxisForceTorqueMeasureProcessor(): m_temperature(0.0),
+                                                                          m_referenceTemperature(0.0)
 {
     // Initialize the affice function to be the identity
     toEigen(m_secondaryCalibrationMatrix).setIdentity();
@@ -32,9 +38,66 @@ const iDynTree::Wrench& SixAxisForceTorqueMeasureProcessor::offset() const
     return m_offset;
 }
 
+bool SixAxisForceTorqueMeasureProcessor::setTemperatureOffsetModel(const std::vector<iDynTree::Vector6>& coeffs)
+{
+    if( coeffs.size() > maxTemperatureOffsetModelOrder )
+    {
+        return false;
+    }
+
+    m_temperatureCoeffs = coeffs;
+    return true;
+}
+
+bool SixAxisForceTorqueMeasureProcessor::hasTemperatureOffsetModel() const
+{
+    return !m_temperatureCoeffs.empty();
+}
+
+void SixAxisForceTorqueMeasureProcessor::setTemperature(const double temperature)
+{
+    m_temperature = temperature;
+}
+
+void SixAxisForceTorqueMeasureProcessor::resetReferenceTemperature()
+{
+    m_referenceTemperature = m_temperature;
+}
+
+void SixAxisForceTorqueMeasureProcessor::getTemperatureOffset(iDynTree::Wrench& temperatureOffset) const
+{
+    Eigen::Matrix<double,6,1> offsetEig = Eigen::Matrix<double,6,1>::Zero();
+
+    double temperaturePower = 1.0;
+    double referenceTemperaturePower = 1.0;
+    for(size_t k=0; k < m_temperatureCoeffs.size(); k++)
+    {
+        temperaturePower *= m_temperature;
+        referenceTemperaturePower *= m_referenceTemperature;
+        offsetEig += (temperaturePower-referenceTemperaturePower)*toEigen(m_temperatureCoeffs[k]);
+    }
+
+    fromEigen(temperatureOffset,offsetEig);
+}
+
+void SixAxisForceTorqueMeasureProcessor::processInPlace(Eigen::Ref<Eigen::Matrix<double,6,1> > measurement) const
+{
+    // The product is evaluated in a temporary on the stack, as the measurement is both input and output
+    Eigen::Matrix<double,6,1> calibrated = toEigen(m_secondaryCalibrationMatrix)*measurement;
+    measurement = calibrated - toEigen(m_offset);
+
+    if( hasTemperatureOffsetModel() )
+    {
+        iDynTree::Wrench temperatureOffset;
+        getTemperatureOffset(temperatureOffset);
+        measurement -= toEigen(temperatureOffset);
+    }
+}
+
 iDynTree::Wrench SixAxisForceTorqueMeasureProcessor::filt(const iDynTree::Wrench& input) const
 {
-    Eigen::Matrix<double,6,1> retEig = toEigen(m_secondaryCalibrationMatrix)*toEigen(input)-toEigen(m_offset);
+    Eigen::Matrix<double,6,1> retEig = toEigen(input);
+    processInPlace(retEig);
 
     iDynTree::Wrench ret;
     fromEigen(ret,retEig);
@@ -42,6 +105,17 @@ iDynTree::Wrench SixAxisForceTorqueMeasureProcessor::filt(const iDynTree::Wrench
     return ret;
 }
 
+void SixAxisForceTorqueMeasureProcessor::processInPlace(const std::vector<SixAxisForceTorqueMeasureProcessor>& processors,
+                                                        Eigen::Ref<Eigen::Matrix<double,6,Eigen::Dynamic> > measurements)
+{
+    assert(measurements.cols() == (Eigen::Index)processors.size());
+
+    for(size_t ft=0; ft < processors.size(); ft++)
+    {
+        processors[ft].processInPlace(measurements.col(ft));
+    }
+}
+
 iDynTree::Wrench SixAxisForceTorqueMeasureProcessor::applySecondaryCalibrationMatrix(const iDynTree::Wrench& input) const
 {
     Eigen::Matrix<double,6,1> retEig = toEigen(m_secondaryCalibrationMatrix)*toEigen(input);
@@ -52,6 +126,99 @@ iDynTree::Wrench SixAxisForceTorqueMeasureProcessor::applySecondaryCalibrationMa
     return ret;
 }
 
+bool SixAxisForceTorqueMeasureProcessor::fitTemperatureOffsetModel(const std::vector<double>& temperatures,
+                                                                   const std::vector<iDynTree::Wrench>& offsets,
+                                                                   const size_t order,
+                                                                   std::vector<iDynTree::Vector6>& coeffs)
+{
+    size_t nrOfSamples = temperatures.size();
+    if( order == 0 || order > maxTemperatureOffsetModelOrder ||
+        offsets.size() != nrOfSamples || nrOfSamples <= order )
+    {
+        return false;
+    }
+
+    // The regressor contains the constant term (the offset at zero temperature, that is
+    // then discarded as the model is relative to the reference temperature) and the powers of T
+    Eigen::MatrixXd regressor(nrOfSamples,order+1);
+    Eigen::MatrixXd knownTerms(nrOfSamples,6);
+    for(size_t smpl=0; smpl < nrOfSamples; smpl++)
+    {
+        double temperaturePower = 1.0;
+        for(size_t k=0; k <= order; k++)
+        {
+            regressor(smpl,k) = temperaturePower;
+            temperaturePower *= temperatures[smpl];
+        }
+        knownTerms.row(smpl) = toEigen(offsets[smpl]).transpose();
+    }
+
+    Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr(regressor);
+    if( qr.rank() < (int)(order+1) )
+    {
+        return false;
+    }
+
+    Eigen::MatrixXd solution = qr.solve(knownTerms);
+
+    coeffs.resize(order);
+    for(size_t k=0; k < order; k++)
+    {
+        toEigen(coeffs[k]) = solution.row(k+1).transpose();
+    }
+
+    return true;
+}
+
+TemperatureOffsetSamples::TemperatureOffsetSamples(): m_capacity(0),
+                                                      m_oldestSample(0)
+{
+
+}
+
+void TemperatureOffsetSamples::setCapacity(const size_t capacity)
+{
+    m_capacity = capacity;
+    m_temperatures.reserve(capacity);
+    m_offsets.reserve(capacity);
+    clear();
+}
+
+void TemperatureOffsetSamples::clear()
+{
+    m_temperatures.clear();
+    m_offsets.clear();
+    m_oldestSample = 0;
 }
 
+void TemperatureOffsetSamples::addSample(const double temperature, const iDynTree::Wrench& offset)
+{
+    if( m_capacity == 0 )
+    {
+        return;
+    }
+
+    if( m_temperatures.size() < m_capacity )
+    {
+        m_temperatures.push_back(temperature);
+        m_offsets.push_back(offset);
+        return;
+    }
+
+    // The order of the samples is not relevant for the fit
+    m_temperatures[m_oldestSample] = temperature;
+    m_offsets[m_oldestSample] = offset;
+    m_oldestSample = (m_oldestSample+1) % m_capacity;
+}
 
+size_t TemperatureOffsetSamples::nrOfSamples() const
+{
+    return m_temperatures.size();
+}
+
+bool TemperatureOffsetSamples::fitTemperatureOffsetModel(const size_t order, std::vector<iDynTree::Vector6>& coeffs) const
+{
+    return SixAxisForceTorqueMeasureProcessor::fitTemperatureOffsetModel(m_temperatures,m_offsets,order,coeffs);
+}
+
+}
@@ -4,6 +4,11 @@
 // iDynTree includes
 #include <iDynTree/Core/Wrench.h>
 #include <iDynTree/Core/MatrixFixSize.h>
+#include <iDynTree/Core/VectorFixSize.h>
+
+#include <Eigen/Core>
+
+#include <vector>
 
 
 namespace wholeBodyDynamics
@@ -23,6 +28,15 @@ namespace wholeBodyDynamics
  * to be acting on the robot, while secondaryCalibrationMatrix is a
  * secondary calibration matrix, that is tipically set to the identity.
  *
+ * Optionally, the offset can depend on the temperature of the sensor,
+ * to compensate its thermal drift:
+ *
+ * ftNew = secondaryCalibrationMatrix*ftOld - offset - \sum_{k=1}^{n} c_k (T^k - T_ref^k)
+ *
+ * where T is the current temperature of the sensor, T_ref is the temperature
+ * at which the offset was computed and c_k are the coefficients of the temperature offset model,
+ * that can be fitted from the offsets recorded at different temperatures (see TemperatureOffsetSamples).
+ *
  */
 class SixAxisForceTorqueMeasureProcessor
 {
@@ -30,6 +44,16 @@ private:
     iDynTree::Matrix6x6 m_secondaryCalibrationMatrix;
     iDynTree::Wrench m_offset;
 
+    /**< Coefficients of the temperature offset model, m_temperatureCoeffs[k-1] multiplies T^k */
+    std::vector<iDynTree::Vector6> m_temperatureCoeffs;
+    double m_temperature;
+    double m_referenceTemperature;
+
+    /**
+     * Process in place a single measurement, see filt.
+     */
+    void processInPlace(Eigen::Ref<Eigen::Matrix<double,6,1> > measurement) const;
+
 public:
     /**
      * Default constructor: the secondaryCalibrationMatrix is
@@ -57,10 +81,37 @@ public:
      */
     const iDynTree::Matrix6x6 & secondaryCalibrationMatrix() const;
 
+    /**
+     * Set the coefficients of the temperature offset model.
+     * An empty vector disables the temperature compensation.
+     *
+     * @return false if the order of the model is greater than maxTemperatureOffsetModelOrder.
+     */
+    bool setTemperatureOffsetModel(const std::vector<iDynTree::Vector6> & coeffs);
+
+    bool hasTemperatureOffsetModel() const;
+
+    /**
+     * Set the current temperature of the sensor.
+     */
+    void setTemperature(const double temperature);
+
+    /**
+     * Use the current temperature as the temperature at which the
+     * offset was computed (to call when the offset is computed).
+     */
+    void resetReferenceTemperature();
+
+    /**
+     * Get the offset due to the difference between the current temperature
+     * and the reference temperature (zero if no temperature model is set).
+     */
+    void getTemperatureOffset(iDynTree::Wrench & temperatureOffset) const;
+
     /**
      * Process the input F/T.
      *
-     * Returns secondaryCalibrationMatrix*input + offset .
+     * Returns secondaryCalibrationMatrix*input - offset (including the temperature offset).
      */
     iDynTree::Wrench filt(const iDynTree::Wrench & input) const;
 
@@ -68,6 +119,74 @@ public:
      * Process the input F/T by only applyng the calibration matrix.
      */
     iDynTree::Wrench applySecondaryCalibrationMatrix(const iDynTree::Wrench & input) const;
+
+    /**
+     * Process in place the measurements of a set of F/T sensors, stored column-wise in a
+     * contiguous 6 x processors.size() buffer: the ft-th column is processed by processors[ft]
+     * exactly as filt would do, but without any temporary wrench.
+     */
+    static void processInPlace(const std::vector<SixAxisForceTorqueMeasureProcessor> & processors,
+                               Eigen::Ref<Eigen::Matrix<double,6,Eigen::Dynamic> > measurements);
+
+    static const size_t maxTemperatureOffsetModelOrder = 3;
+
+    /**
+     * Fit the coefficients of a temperature offset model of the given order from recorded
+     * data, i.e. the offsets of a sensor (measurement-prediction, as computed by the calibration)
+     * observed at different temperatures, with linear least squares.
+     *
+     * @return false if the data is not sufficient to fit the model.
+     */
+    static bool fitTemperatureOffsetModel(const std::vector<double> & temperatures,
+                                          const std::vector<iDynTree::Wrench> & offsets,
+                                          const size_t order,
+                                          std::vector<iDynTree::Vector6> & coeffs);
+};
+
+/**
+ * Offsets of a Six Axis Force Torque sensor recorded at different temperatures
+ * (at the end of each offset calibration), used to fit the coefficients
+ * of the temperature offset model of a SixAxisForceTorqueMeasureProcessor.
+ *
+ * The samples are stored in buffers allocated by setCapacity: when they are full,
+ * the oldest sample is replaced by the new one.
+ */
+class TemperatureOffsetSamples
+{
+private:
+    std::vector<double> m_temperatures;
+    std::vector<iDynTree::Wrench> m_offsets;
+    size_t m_capacity;
+    size_t m_oldestSample;
+
+public:
+    TemperatureOffsetSamples();
+
+    /**
+     * Allocate the buffers for the given number of samples, and remove all the samples.
+     */
+    void setCapacity(const size_t capacity);
+
+    /**
+     * Remove all the samples.
+     */
+    void clear();
+
+    /**
+     * Add the offset of the sensor (including the temperature offset, i.e. measurement-prediction)
+     * observed at the given temperature.
+     */
+    void addSample(const double temperature, const iDynTree::Wrench & offset);
+
+    size_t nrOfSamples() const;
+
+    /**
+     * Fit the coefficients of a temperature offset model of the given order
+     * from the recorded samples, see SixAxisForceTorqueMeasureProcessor::fitTemperatureOffsetModel .
+     *
+     * @return false if the samples are not sufficient to fit the model.
+     */
+    bool fitTemperatureOffsetModel(const size_t order, std::vector<iDynTree::Vector6> & coeffs) const;
 };
 
 }
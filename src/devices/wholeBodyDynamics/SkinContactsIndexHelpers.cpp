@@ -0,0 +1,376 @@
+#include "SkinContactsIndexHelpers.h"
+
+#include <iDynTree/Core/EigenHelpers.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace wholeBodyDynamics
+{
+
+SkinContactsIndex::SkinContactsIndex(): m_nrOfLinksPerBodyPart(0),
+                                        m_nrOfContacts(0),
+                                        m_nrOfDiscardedContacts(0),
+                                        m_nrOfUnknownContacts(0),
+                                        m_maxNrOfContactsPerLink(0),
+                                        m_mergeDistanceInMeters(0.0)
+{
+}
+
+int SkinContactsIndex::aliasIndex(const int bodyPart, const int linkNumber) const
+{
+    if( bodyPart < 0 || bodyPart >= iCub::skinDynLib::BODY_PART_SIZE ||
+        linkNumber < 0 || linkNumber >= m_nrOfLinksPerBodyPart )
+    {
+        return -1;
+    }
+
+    return bodyPart*m_nrOfLinksPerBodyPart+linkNumber;
+}
+
+bool SkinContactsIndex::addSkinDynLibAlias(const int bodyPart, const int linkNumber,
+                                           const iDynTree::FrameIndex frameIndex, const iDynTree::LinkIndex linkIndex)
+{
+    if( bodyPart < 0 || bodyPart >= iCub::skinDynLib::BODY_PART_SIZE || linkNumber < 0 )
+    {
+        return false;
+    }
+
+    // If necessary, enlarge the table preserving the already added aliases
+    if( linkNumber >= m_nrOfLinksPerBodyPart )
+    {
+        int newNrOfLinksPerBodyPart = linkNumber+1;
+        std::vector<iDynTree::FrameIndex> newAliasFrames(iCub::skinDynLib::BODY_PART_SIZE*newNrOfLinksPerBodyPart,iDynTree::FRAME_INVALID_INDEX);
+        std::vector<iDynTree::LinkIndex>  newAliasLinks(iCub::skinDynLib::BODY_PART_SIZE*newNrOfLinksPerBodyPart,iDynTree::LINK_INVALID_INDEX);
+
+        for(int bp=0; bp < iCub::skinDynLib::BODY_PART_SIZE; bp++)
+        {
+            for(int link=0; link < m_nrOfLinksPerBodyPart; link++)
+            {
+                newAliasFrames[bp*newNrOfLinksPerBodyPart+link] = m_aliasFrames[aliasIndex(bp,link)];
+                newAliasLinks[bp*newNrOfLinksPerBodyPart+link]  = m_aliasLinks[aliasIndex(bp,link)];
+            }
+        }
+
+        m_aliasFrames.swap(newAliasFrames);
+        m_aliasLinks.swap(newAliasLinks);
+        m_nrOfLinksPerBodyPart = newNrOfLinksPerBodyPart;
+    }
+
+    m_aliasFrames[aliasIndex(bodyPart,linkNumber)] = frameIndex;
+    m_aliasLinks[aliasIndex(bodyPart,linkNumber)]  = linkIndex;
+
+    return true;
+}
+
+void SkinContactsIndex::setMaxNrOfContacts(const size_t maxNrOfContacts)
+{
+    m_contacts.resize(maxNrOfContacts);
+    m_nrOfContactsOnSameLink.resize(maxNrOfContacts);
+    m_nrOfContacts = 0;
+    m_nrOfDiscardedContacts = 0;
+    m_nrOfUnknownContacts = 0;
+}
+
+size_t SkinContactsIndex::getMaxNrOfContacts() const
+{
+    return m_contacts.size();
+}
+
+void SkinContactsIndex::setReductionParameters(const size_t maxNrOfContactsPerLink, const double mergeDistanceInMeters)
+{
+    m_maxNrOfContactsPerLink = maxNrOfContactsPerLink;
+    m_mergeDistanceInMeters = mergeDistanceInMeters;
+}
+
+namespace
+{
+
+/**
+ * Minimum cosine of the angle between the known force directions of two contacts
+ * that are merged in a contact with known force direction (30 degrees).
+ */
+const double minCosineBetweenMergedForceDirections = 0.866;
+
+/**
+ * Weight of a contact in the merge: the pressure if available, otherwise the number of active taxels.
+ */
+double contactWeight(const IndexedSkinContact & contact)
+{
+    if( contact.pressure > 0.0 )
+    {
+        return contact.pressure;
+    }
+
+    return std::max(contact.activeTaxels,1u);
+}
+
+/**
+ * Two contacts can be merged if the merged contact has no more unknowns than the two contacts together:
+ * the merged contact has the most general type of the two (full wrench, pure force, pure force with known direction),
+ * so only two forces with known directions that do not agree can not be merged (it would need a pure force).
+ */
+bool canBeMerged(const IndexedSkinContact & first, const IndexedSkinContact & second)
+{
+    if( first.unknownWrench.unknownType != iDynTree::PURE_FORCE_WITH_KNOWN_DIRECTION ||
+        second.unknownWrench.unknownType != iDynTree::PURE_FORCE_WITH_KNOWN_DIRECTION )
+    {
+        return true;
+    }
+
+    return iDynTree::toEigen(first.unknownWrench.forceDirection).dot(iDynTree::toEigen(second.unknownWrench.forceDirection))
+           >= minCosineBetweenMergedForceDirections;
+}
+
+}
+
+void SkinContactsIndex::mergeContact(IndexedSkinContact & dst, const IndexedSkinContact & src) const
+{
+    assert(canBeMerged(dst,src));
+
+    double dstWeight = contactWeight(dst);
+    double srcWeight = contactWeight(src);
+    double totalWeight = dstWeight+srcWeight;
+
+    // The merged contact has the most general type of the two, so that the merge never increases
+    // the number of unknowns of the estimation: the moment of the two forces around the merged point
+    // is neglected if they were pure forces (as done for the contacts with less than 10 active taxels)
+    if( dst.unknownWrench.unknownType == iDynTree::FULL_WRENCH ||
+        src.unknownWrench.unknownType == iDynTree::FULL_WRENCH )
+    {
+        dst.unknownWrench.unknownType = iDynTree::FULL_WRENCH;
+    }
+    else if( dst.unknownWrench.unknownType == iDynTree::PURE_FORCE ||
+             src.unknownWrench.unknownType == iDynTree::PURE_FORCE )
+    {
+        dst.unknownWrench.unknownType = iDynTree::PURE_FORCE;
+    }
+
+    iDynTree::toEigen(dst.unknownWrench.contactPoint) = (dstWeight*iDynTree::toEigen(dst.unknownWrench.contactPoint)
+                                                         +srcWeight*iDynTree::toEigen(src.unknownWrench.contactPoint))/totalWeight;
+
+    // The known directions agree (see canBeMerged), so their weighted mean is not zero
+    Eigen::Vector3d forceDirection = dstWeight*iDynTree::toEigen(dst.unknownWrench.forceDirection)
+                                     +srcWeight*iDynTree::toEigen(src.unknownWrench.forceDirection);
+    if( forceDirection.norm() > 0.0 )
+    {
+        iDynTree::toEigen(dst.unknownWrench.forceDirection) = forceDirection.normalized();
+    }
+
+    // The merged contact keeps the id of the heaviest one
+    if( srcWeight > dstWeight )
+    {
+        dst.unknownWrench.contactId = src.unknownWrench.contactId;
+    }
+
+    dst.pressure += src.pressure;
+    dst.activeTaxels += src.activeTaxels;
+}
+
+void SkinContactsIndex::removeContact(const size_t contact)
+{
+    m_nrOfContacts--;
+    if( contact != m_nrOfContacts )
+    {
+        m_contacts[contact] = m_contacts[m_nrOfContacts];
+    }
+}
+
+bool SkinContactsIndex::mergeOverflowContact()
+{
+    double minDistance = std::numeric_limits<double>::max();
+    size_t closestContact = m_nrOfContacts;
+    for(size_t i=0; i < m_nrOfContacts; i++)
+    {
+        if( m_contacts[i].frameIndex != m_overflowContact.frameIndex ||
+            !canBeMerged(m_contacts[i],m_overflowContact) )
+        {
+            continue;
+        }
+
+        double distance = (iDynTree::toEigen(m_contacts[i].unknownWrench.contactPoint)
+                           -iDynTree::toEigen(m_overflowContact.unknownWrench.contactPoint)).norm();
+        if( distance < minDistance )
+        {
+            minDistance = distance;
+            closestContact = i;
+        }
+    }
+
+    if( closestContact == m_nrOfContacts )
+    {
+        return false;
+    }
+
+    mergeContact(m_contacts[closestContact],m_overflowContact);
+    return true;
+}
+
+void SkinContactsIndex::reduceContacts()
+{
+    if( m_maxNrOfContactsPerLink == 0 && m_mergeDistanceInMeters <= 0.0 )
+    {
+        return;
+    }
+
+    // Each iteration removes a contact, so the loop terminates after at most m_nrOfContacts iterations,
+    // and the cost of the reduction is O(m_nrOfContacts^3) in the worst case
+    while( true )
+    {
+        for(size_t i=0; i < m_nrOfContacts; i++)
+        {
+            m_nrOfContactsOnSameLink[i] = 0;
+            for(size_t j=0; j < m_nrOfContacts; j++)
+            {
+                if( m_contacts[i].frameIndex == m_contacts[j].frameIndex )
+                {
+                    m_nrOfContactsOnSameLink[i]++;
+                }
+            }
+        }
+
+        // Find the closest pair of contacts of the same link that should be merged
+        double minDistance = std::numeric_limits<double>::max();
+        size_t bestI = 0, bestJ = 0;
+        for(size_t i=0; i < m_nrOfContacts; i++)
+        {
+            for(size_t j=i+1; j < m_nrOfContacts; j++)
+            {
+                if( m_contacts[i].frameIndex != m_contacts[j].frameIndex ||
+                    !canBeMerged(m_contacts[i],m_contacts[j]) )
+                {
+                    continue;
+                }
+
+                double distance = (iDynTree::toEigen(m_contacts[i].unknownWrench.contactPoint)
+                                   -iDynTree::toEigen(m_contacts[j].unknownWrench.contactPoint)).norm();
+
+                bool tooManyContacts = m_maxNrOfContactsPerLink > 0 && m_nrOfContactsOnSameLink[i] > m_maxNrOfContactsPerLink;
+                bool tooClose = distance < m_mergeDistanceInMeters;
+
+                if( (tooManyContacts || tooClose) && distance < minDistance )
+                {
+                    minDistance = distance;
+                    bestI = i;
+                    bestJ = j;
+                }
+            }
+        }
+
+        if( minDistance == std::numeric_limits<double>::max() )
+        {
+            return;
+        }
+
+        mergeContact(m_contacts[bestI],m_contacts[bestJ]);
+        removeContact(bestJ);
+    }
+}
+
+void SkinContactsIndex::clear()
+{
+    m_nrOfContacts = 0;
+}
+
+void SkinContactsIndex::resetPressures()
+{
+    for(size_t contact=0; contact < m_nrOfContacts; contact++)
+    {
+        m_contacts[contact].pressure = 0.0;
+        m_contacts[contact].activeTaxels = 0;
+    }
+}
+
+size_t SkinContactsIndex::update(const iCub::skinDynLib::skinContactList& contactList)
+{
+    m_nrOfContacts = 0;
+    size_t nrOfDiscardedContacts = 0;
+
+    for(iCub::skinDynLib::skinContactList::const_iterator it=contactList.begin(); it!=contactList.end(); it++)
+    {
+        int alias = aliasIndex(it->getBodyPart(),it->getLinkNumber());
+        if( alias < 0 || m_aliasFrames[alias] == iDynTree::FRAME_INVALID_INDEX )
+        {
+            m_nrOfUnknownContacts++;
+            nrOfDiscardedContacts++;
+            continue;
+        }
+
+        // If all the slots are used, the contact is read in an additional buffer,
+        // and then merged with a stored contact of the same link
+        bool slotsFull = (m_nrOfContacts == m_contacts.size());
+
+        IndexedSkinContact & contact = slotsFull ? m_overflowContact : m_contacts[m_nrOfContacts];
+        contact.frameIndex = m_aliasFrames[alias];
+        contact.linkIndex  = m_aliasLinks[alias];
+        contact.pressure = it->getPressure();
+        contact.activeTaxels = it->getActiveTaxels();
+
+        // If less than 10 taxels are active then suppose zero moment
+        bool isMomentKnown = it->isMomentKnown() || it->getActiveTaxels() < 10;
+
+        iDynTree::UnknownWrenchContact & unknownWrench = contact.unknownWrench;
+        if( !isMomentKnown )
+        {
+            unknownWrench.unknownType = iDynTree::FULL_WRENCH;
+        }
+        else if( it->isForceDirectionKnown() )
+        {
+            unknownWrench.unknownType = iDynTree::PURE_FORCE_WITH_KNOWN_DIRECTION;
+        }
+        else
+        {
+            unknownWrench.unknownType = iDynTree::PURE_FORCE;
+        }
+
+        const yarp::sig::Vector & cop = it->getCoP();
+        unknownWrench.contactPoint = iDynTree::Position(cop[0],cop[1],cop[2]);
+
+        const yarp::sig::Vector & forceDirection = it->getForceDirection();
+        unknownWrench.forceDirection = iDynTree::Direction(forceDirection[0],forceDirection[1],forceDirection[2]);
+
+        unknownWrench.knownWrench.zero();
+        unknownWrench.contactId = it->getContactId();
+
+        if( slotsFull )
+        {
+            m_nrOfDiscardedContacts++;
+            if( !mergeOverflowContact() )
+            {
+                nrOfDiscardedContacts++;
+            }
+        }
+        else
+        {
+            m_nrOfContacts++;
+        }
+    }
+
+    reduceContacts();
+
+    return nrOfDiscardedContacts;
+}
+
+size_t SkinContactsIndex::getNrOfContacts() const
+{
+    return m_nrOfContacts;
+}
+
+const IndexedSkinContact& SkinContactsIndex::getContact(const size_t contact) const
+{
+    assert(contact < m_nrOfContacts);
+    return m_contacts[contact];
+}
+
+size_t SkinContactsIndex::getNrOfDiscardedContacts() const
+{
+    return m_nrOfDiscardedContacts;
+}
+
+size_t SkinContactsIndex::getNrOfUnknownContacts() const
+{
+    return m_nrOfUnknownContacts;
+}
+
+}
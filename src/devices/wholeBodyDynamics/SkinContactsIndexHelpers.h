@@ -0,0 +1,163 @@
+#ifndef WHOLE_BODY_DYNAMICS_SKIN_CONTACTS_INDEX_HELPERS_H
+#define WHOLE_BODY_DYNAMICS_SKIN_CONTACTS_INDEX_HELPERS_H
+
+// iDynTree includes
+#include <iDynTree/Model/Indices.h>
+#include <iDynTree/Estimation/ExternalWrenchesEstimation.h>
+
+// skinDynLib includes
+#include <iCub/skinDynLib/skinContactList.h>
+
+#include <vector>
+
+namespace wholeBodyDynamics
+{
+
+/**
+ * Contact read from the skin, already converted to the
+ * iDynTree unknown wrench expressed in the skin frame of the link.
+ */
+struct IndexedSkinContact
+{
+    iDynTree::FrameIndex frameIndex;
+    iDynTree::LinkIndex linkIndex;
+    iDynTree::UnknownWrenchContact unknownWrench;
+    double pressure;
+    unsigned int activeTaxels;
+};
+
+/**
+ * Preallocated index of the contacts read from the skin.
+ *
+ * The (bodyPart, linkNumber) skinDynLib identifiers are mapped to iDynTree
+ * frames and links with a dense table built at configuration time, and the
+ * contacts are stored in a fixed number of slots that are reused at each update,
+ * so that updating the index does not allocate memory.
+ *
+ * If the skin reports more contacts than the available slots, each exceeding contact is merged
+ * with the closest stored contact of the same link that can be merged with it (see setReductionParameters),
+ * or discarded if there is none.
+ * Reading the contacts costs O(contacts) if there are enough slots, and O(contacts*slots) otherwise.
+ *
+ * Optionally, the contacts of each link can be reduced to a bounded number of representative
+ * contacts (see setReductionParameters), to keep the size of the estimation problem bounded
+ * when many taxels are active on the same link. The reduction costs O(slots^3) in the worst case,
+ * so its time is bounded by the number of slots and not by the number of contacts reported by the skin.
+ */
+class SkinContactsIndex
+{
+private:
+    /**< Dense table of the aliases, indexed by bodyPart*m_nrOfLinksPerBodyPart+linkNumber */
+    std::vector<iDynTree::FrameIndex> m_aliasFrames;
+    std::vector<iDynTree::LinkIndex>  m_aliasLinks;
+    int m_nrOfLinksPerBodyPart;
+
+    std::vector<IndexedSkinContact> m_contacts;
+    size_t m_nrOfContacts;
+    size_t m_nrOfDiscardedContacts;
+    size_t m_nrOfUnknownContacts;
+
+    size_t m_maxNrOfContactsPerLink;
+    double m_mergeDistanceInMeters;
+
+    /**< Buffer of the number of contacts on the link of each contact */
+    std::vector<size_t> m_nrOfContactsOnSameLink;
+
+    /**< Buffer for a contact read when all the slots are used */
+    IndexedSkinContact m_overflowContact;
+
+    int aliasIndex(const int bodyPart, const int linkNumber) const;
+
+    /**
+     * Merge the source contact in the destination contact, that must be mergeable.
+     */
+    void mergeContact(IndexedSkinContact & destination, const IndexedSkinContact & source) const;
+
+    /**
+     * Remove a contact, moving the last contact in its slot.
+     */
+    void removeContact(const size_t contact);
+
+    /**
+     * Merge m_overflowContact with the closest stored contact of the same link that can be merged with it.
+     *
+     * @return false if no such contact is stored.
+     */
+    bool mergeOverflowContact();
+
+    /**
+     * Merge the contacts of each link until the reduction parameters are satisfied.
+     */
+    void reduceContacts();
+
+public:
+    SkinContactsIndex();
+
+    /**
+     * Add the iDynTree frame and link corresponding to a skinDynLib (bodyPart, linkNumber).
+     * This method allocates memory, and it should be called only at configuration time.
+     */
+    bool addSkinDynLibAlias(const int bodyPart, const int linkNumber,
+                            const iDynTree::FrameIndex frameIndex, const iDynTree::LinkIndex linkIndex);
+
+    /**
+     * Allocate the slots for the contacts, discarding the stored ones.
+     */
+    void setMaxNrOfContacts(const size_t maxNrOfContacts);
+
+    size_t getMaxNrOfContacts() const;
+
+    /**
+     * Set the parameters of the reduction of the contacts, applied at each update:
+     * the closest pair of contacts of the same link is iteratively merged in a single contact
+     * (with the pressure-weighted mean of the contact points) until no link has more than
+     * maxNrOfContactsPerLink contacts and no pair of contacts of the same link is closer than mergeDistanceInMeters.
+     *
+     * The merged contact has the most general type of the two contacts (full wrench, pure force or pure force with
+     * known direction), so the merge never increases the number of unknowns of the estimation. Two contacts with
+     * known force directions are merged only if their directions differ by less than 30 degrees, so a link with
+     * contacts with very different known directions can keep more than maxNrOfContactsPerLink contacts.
+     *
+     * @param maxNrOfContactsPerLink maximum number of contacts of each link, 0 for no bound.
+     * @param mergeDistanceInMeters contacts closer than this distance are always merged, 0.0 to disable.
+     */
+    void setReductionParameters(const size_t maxNrOfContactsPerLink, const double mergeDistanceInMeters);
+
+    /**
+     * Remove all the contacts.
+     */
+    void clear();
+
+    /**
+     * Keep the stored contacts, but set their pressure and their active taxels to zero.
+     */
+    void resetPressures();
+
+    /**
+     * Replace the stored contacts with the one of the skin contact list.
+     *
+     * If less than 10 taxels of a contact are active, its moment is assumed to be zero.
+     * The contacts are then reduced according to the reduction parameters.
+     *
+     * @return the number of contacts of the list that were discarded (for lack of slots or unknown link).
+     */
+    size_t update(const iCub::skinDynLib::skinContactList & contactList);
+
+    size_t getNrOfContacts() const;
+
+    const IndexedSkinContact & getContact(const size_t contact) const;
+
+    /**
+     * Total number of contacts discarded or merged for lack of slots since the last setMaxNrOfContacts.
+     */
+    size_t getNrOfDiscardedContacts() const;
+
+    /**
+     * Total number of contacts discarded because their (bodyPart, linkNumber) is unknown since the last setMaxNrOfContacts.
+     */
+    size_t getNrOfUnknownContacts() const;
+};
+
+}
+
+#endif
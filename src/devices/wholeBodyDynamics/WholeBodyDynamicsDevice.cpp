@@ -5,6 +5,7 @@
 #include <yarp/os/LogStream.h>
 #include <yarp/os/Property.h>
 #include <yarp/os/ResourceFinder.h>
+#include <yarp/os/SystemClock.h>
 #include <yarp/os/Time.h>
 
 #include <yarp/dev/IAnalogSensor.h>
@@ -12,9 +13,12 @@
 
 #include <iDynTree/yarp/YARPConversions.h>
 #include <iDynTree/Core/Utils.h>
+#include <iDynTree/Core/EigenHelpers.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <sstream>
 
 namespace yarp
 {
@@ -24,6 +28,11 @@ namespace dev
 const size_t wholeBodyDynamics_nrOfChannelsOfYARPFTSensor = 6;
 const size_t wholeBodyDynamics_nrOfChannelsOfAYARPIMUSensor = 12;
 const double wholeBodyDynamics_sensorTimeoutInSeconds = 2.0;
+const double wholeBodyDynamics_timingHistogramBinWidthInSeconds = 5e-6;
+const size_t wholeBodyDynamics_timingHistogramNrOfBins = 4000;
+const size_t wholeBodyDynamics_nrOfStreamedTimingStatistics = 7;
+const size_t wholeBodyDynamics_maxNrOfTemperatureOffsetSamples = 1000;
+const int wholeBodyDynamics_maxButterworthFilterOrder = 8;
 
 WholeBodyDynamicsDevice::WholeBodyDynamicsDevice(): RateThread(10),
                                                     portPrefix("/wholeBodyDynamics"),
@@ -33,7 +42,19 @@ WholeBodyDynamicsDevice::WholeBodyDynamicsDevice(): RateThread(10),
                                                     estimationWentWell(false),
                                                     validOffsetAvailable(false),
                                                     lastReadingSkinContactListStamp(0.0),
-                                                    settingsEditor(settings)
+                                                    settingsEditor(settings,m_kinematicSourceFramesChanged,m_filtersSettingsGeneration),
+                                                    useSensorsAcquisitionThread(false),
+                                                    sensorsAcquisitionPeriodInSeconds(0.01),
+                                                    acquireJointVelocities(false),
+                                                    acquireJointAccelerations(false),
+                                                    acquireIMU(false),
+                                                    m_imuFrameIndex(iDynTree::FRAME_INVALID_INDEX),
+                                                    m_fixedFrameIndex(iDynTree::FRAME_INVALID_INDEX),
+                                                    m_kinematicSourceFramesChanged(false),
+                                                    m_lastRunStartTime(0.0),
+                                                    m_streamTimingStatistics(false),
+                                                    m_filtersSettingsGeneration(0),
+                                                    m_appliedFiltersSettingsGeneration(0)
 {
     // Calibration quantities
     calibrationBuffers.ongoingCalibration = false;
@@ -45,6 +66,21 @@ WholeBodyDynamicsDevice::WholeBodyDynamicsDevice(): RateThread(10),
     calibrationBuffers.nrOfSamplesToUseForCalibration = 0;
     calibrationBuffers.nrOfSamplesUsedUntilNowForCalibration = 0;
 
+    // Online calibration
+    m_onlineCalibration.enabled = false;
+    m_onlineCalibration.isContactAssumptionExplicit = false;
+    m_onlineCalibration.nrOfUpdates = 0;
+    m_onlineCalibration.nrOfRejectedUpdates = 0;
+    m_onlineCalibration.lastUpdateRejected = false;
+
+    // Gravity compensation modes cache
+    m_gravityCompensationModes.refreshPeriodInSeconds = 0.0;
+    m_gravityCompensationModes.lastRefreshTime = 0.0;
+
+    // Shared memory output
+    m_sharedMemoryOutputEnabled = false;
+
+    initTimingStatistics();
 }
 
 WholeBodyDynamicsDevice::~WholeBodyDynamicsDevice()
@@ -95,6 +131,25 @@ bool WholeBodyDynamicsDevice::closeRPCPort()
     return true;
 }
 
+bool WholeBodyDynamicsDevice::openTimingStatisticsPort()
+{
+    bool ok = m_timingStatisticsPort.open(portPrefix+"/timing:o");
+
+    if( !ok )
+    {
+        yError() << "WholeBodyDynamicsDevice: Impossible to open port " << portPrefix+"/timing:o";
+        return false;
+    }
+
+    return true;
+}
+
+bool WholeBodyDynamicsDevice::closeTimingStatisticsPort()
+{
+    m_timingStatisticsPort.close();
+    return true;
+}
+
 bool WholeBodyDynamicsDevice::closeSkinContactListsPorts()
 {
     this->portContactsInput.close();
@@ -164,6 +219,80 @@ bool getUsedDOFsList(os::Searchable& config, std::vector<std::string> & usedDOFs
     return true;
 }
 
+bool loadFilterParametersFromConfig(yarp::os::Searchable& prop,
+                                    const std::string & signalName,
+                                    const double periodInSeconds,
+                                    double & cutOffInHz,
+                                    wholeBodyDynamicsFilterParameters & params)
+{
+    std::string cutOffOptionName = signalName+"FilterCutoffInHz";
+    if( prop.check(cutOffOptionName.c_str()) )
+    {
+        if( !prop.find(cutOffOptionName.c_str()).isDouble() )
+        {
+            yError() << "wholeBodyDynamics : " << cutOffOptionName << " is present, but it is not a double";
+            return false;
+        }
+
+        cutOffInHz = prop.find(cutOffOptionName.c_str()).asDouble();
+    }
+
+    std::string typeOptionName = signalName+"FilterType";
+    if( prop.check(typeOptionName.c_str()) )
+    {
+        std::string type = prop.find(typeOptionName.c_str()).asString();
+        if( type == "firstOrder" )
+        {
+            params.type = FIRST_ORDER_LOW_PASS_FILTER;
+        }
+        else if( type == "butterworth" )
+        {
+            params.type = BUTTERWORTH_LOW_PASS_FILTER;
+        }
+        else
+        {
+            yError() << "wholeBodyDynamics : " << typeOptionName << " is " << type << " , while the supported values are firstOrder and butterworth";
+            return false;
+        }
+    }
+
+    std::string orderOptionName = signalName+"FilterOrder";
+    if( prop.check(orderOptionName.c_str()) )
+    {
+        if( !prop.find(orderOptionName.c_str()).isInt() )
+        {
+            yError() << "wholeBodyDynamics : " << orderOptionName << " is present, but it is not an integer";
+            return false;
+        }
+
+        params.order = prop.find(orderOptionName.c_str()).asInt();
+    }
+
+    std::string notchFrequencyOptionName = signalName+"NotchFrequencyInHz";
+    std::string notchBandwidthOptionName = signalName+"NotchBandwidthInHz";
+    if( prop.check(notchFrequencyOptionName.c_str()) )
+    {
+        if( !prop.find(notchFrequencyOptionName.c_str()).isDouble() ||
+            !prop.check(notchBandwidthOptionName.c_str()) ||
+            !prop.find(notchBandwidthOptionName.c_str()).isDouble() )
+        {
+            yError() << "wholeBodyDynamics : " << notchFrequencyOptionName << " and " << notchBandwidthOptionName << " should be both present and be doubles";
+            return false;
+        }
+
+        params.notchFrequencyInHz = prop.find(notchFrequencyOptionName.c_str()).asDouble();
+        params.notchBandwidthInHz = prop.find(notchBandwidthOptionName.c_str()).asDouble();
+    }
+
+    if( !params.isValid(cutOffInHz,periodInSeconds) )
+    {
+        yError() << "wholeBodyDynamics : the filter parameters of the " << signalName << " signals are not valid, check that the frequencies are positive and smaller than the Nyquist frequency " << 0.5/periodInSeconds << " Hz, and that the order is between 1 and " << wholeBodyDynamics_maxButterworthFilterOrder;
+        return false;
+    }
+
+    return true;
+}
+
 bool getGravityCompensationDOFsList(os::Searchable& config, std::vector<std::string> & gravityCompensationDOFs)
 {
     yarp::os::Property prop;
@@ -413,8 +542,62 @@ bool WholeBodyDynamicsDevice::openSkinContactListPorts(os::Searchable& config)
                       << " and frame " << iDynTree_skinFrame_name << " and not found in urdf model";
             return false;
         }
+
+        ret_sdl = skinContactsIndex.addSkinDynLibAlias(skinDynLib_body_part,skinDynLib_link_index,
+                                                       estimator.model().getFrameIndex(iDynTree_skinFrame_name),
+                                                       estimator.model().getLinkIndex(iDynTree_link_name));
+
+        if( !ret_sdl )
+        {
+            yError() << "WholeBodyDynamicsDevice: IDYNTREE_SKINDYNLIB_LINKS body part " << skinDynLib_body_part
+                      << " and link " << skinDynLib_link_index << " are not valid skinDynLib identifiers";
+            return false;
+        }
+    }
+
+    // Allocate the contacts read from the skin
+    int maxNrOfSkinContacts = 32;
+    if( config.check("maxNrOfSkinContacts") )
+    {
+        if( !config.find("maxNrOfSkinContacts").isInt() || config.find("maxNrOfSkinContacts").asInt() < 0 )
+        {
+            yError() << "WholeBodyDynamicsDevice: maxNrOfSkinContacts parameter is present, but it is not a non-negative integer";
+            return false;
+        }
+
+        maxNrOfSkinContacts = config.find("maxNrOfSkinContacts").asInt();
+    }
+
+    skinContactsIndex.setMaxNrOfContacts(maxNrOfSkinContacts);
+
+    // Load the parameters of the reduction of the contacts of each link
+    int maxNrOfSkinContactsPerLink = 0;
+    if( config.check("maxNrOfSkinContactsPerLink") )
+    {
+        if( !config.find("maxNrOfSkinContactsPerLink").isInt() || config.find("maxNrOfSkinContactsPerLink").asInt() < 0 )
+        {
+            yError() << "WholeBodyDynamicsDevice: maxNrOfSkinContactsPerLink parameter is present, but it is not a non-negative integer";
+            return false;
+        }
+
+        maxNrOfSkinContactsPerLink = config.find("maxNrOfSkinContactsPerLink").asInt();
+    }
+
+    double skinContactsMergeDistanceInMeters = 0.0;
+    if( config.check("skinContactsMergeDistanceInMeters") )
+    {
+        if( !config.find("skinContactsMergeDistanceInMeters").isDouble() || config.find("skinContactsMergeDistanceInMeters").asDouble() < 0.0 )
+        {
+            yError() << "WholeBodyDynamicsDevice: skinContactsMergeDistanceInMeters parameter is present, but it is not a non-negative double";
+            return false;
+        }
+
+        skinContactsMergeDistanceInMeters = config.find("skinContactsMergeDistanceInMeters").asDouble();
     }
 
+    skinContactsIndex.setReductionParameters(maxNrOfSkinContactsPerLink,skinContactsMergeDistanceInMeters);
+    nrOfSkinContactsForSubModel.resize(estimator.submodels().getNrOfSubModels(),0);
+
     return ok;
 }
 
@@ -549,6 +732,62 @@ bool WholeBodyDynamicsDevice::openFilteredFTPorts(os::Searchable& config)
     return ok;
 }
 
+bool WholeBodyDynamicsDevice::openSharedMemoryOutput(os::Searchable& config)
+{
+    yarp::os::Property propAll;
+    propAll.fromString(config.toString().c_str());
+
+    m_sharedMemoryOutputEnabled = false;
+    if( !propAll.check("SHARED_MEMORY_OUTPUT") )
+    {
+        return true;
+    }
+
+    yarp::os::Property propSharedMemory;
+    propSharedMemory.fromString(propAll.findGroup("SHARED_MEMORY_OUTPUT").toString());
+
+    std::string name = propSharedMemory.find("name").asString();
+    if( !propSharedMemory.check("name") || !propSharedMemory.find("name").isString() ||
+        name.size() < 2 || name[0] != '/' || name.find('/',1) != std::string::npos )
+    {
+        yError() << "wholeBodyDynamics: SHARED_MEMORY_OUTPUT group should contain a name parameter in the form /name";
+        return false;
+    }
+
+    int nrOfSlots = 8;
+    if( propSharedMemory.check("nrOfSlots") )
+    {
+        if( !propSharedMemory.find("nrOfSlots").isInt() || propSharedMemory.find("nrOfSlots").asInt() < 2 )
+        {
+            yError() << "wholeBodyDynamics: nrOfSlots parameter of SHARED_MEMORY_OUTPUT group is present, but it is not an integer greater than 1";
+            return false;
+        }
+
+        nrOfSlots = propSharedMemory.find("nrOfSlots").asInt();
+    }
+
+    size_t nrOfDOFs  = estimator.model().getNrOfDOFs();
+    size_t nrOfLinks = estimator.model().getNrOfLinks();
+    size_t nrOfFTSensors = estimator.sensors().getNrOfSensors(iDynTree::SIX_AXIS_FORCE_TORQUE);
+
+    bool ok = m_sharedMemoryJointTorques.open(name+"_jointTorques",nrOfDOFs,nrOfSlots);
+    ok = ok && m_sharedMemoryExternalWrenches.open(name+"_externalWrenches",6*nrOfLinks,nrOfSlots);
+    ok = ok && m_sharedMemoryFilteredFT.open(name+"_filteredFT",6*nrOfFTSensors,nrOfSlots);
+
+    if( !ok )
+    {
+        yError() << "wholeBodyDynamics: impossible to open the shared memory output " << name;
+        m_sharedMemoryJointTorques.close();
+        m_sharedMemoryExternalWrenches.close();
+        m_sharedMemoryFilteredFT.close();
+        return false;
+    }
+
+    m_sharedMemoryBuffer.resize(std::max(nrOfDOFs,6*std::max(nrOfLinks,nrOfFTSensors)));
+    m_sharedMemoryOutputEnabled = true;
+
+    return true;
+}
 
 void WholeBodyDynamicsDevice::resizeBuffers()
 {
@@ -578,6 +817,22 @@ void WholeBodyDynamicsDevice::resizeBuffers()
     calibrationBuffers.predictedSensorMeasurementsForCalibration.resize(estimator.sensors());
 
     ftProcessors.resize(nrOfFTSensors);
+    ftTemperatures.assign(nrOfFTSensors,0.0);
+    m_ftTemperatureChannels.assign(nrOfFTSensors,-1);
+    m_ftTemperatureOffsetSamples.resize(nrOfFTSensors);
+    for(size_t ft=0; ft < nrOfFTSensors; ft++)
+    {
+        m_ftTemperatureOffsetSamples[ft].setCapacity(wholeBodyDynamics_maxNrOfTemperatureOffsetSamples);
+    }
+
+    m_onlineCalibration.stillnessDetector.resize(estimator.model());
+    m_onlineCalibration.offsetEstimator.resize(nrOfFTSensors);
+
+    // Resize the sensors snapshots used by the acquisition thread
+    sensorsSnapshots.resize(estimator.model(),estimator.sensors());
+    acquisitionBuffers.lastSnapshot.resize(estimator.model(),estimator.sensors());
+    acquisitionBuffers.ftMeasurement.resize(wholeBodyDynamics_nrOfChannelsOfYARPFTSensor);
+    acquisitionBuffers.imuMeasurement.resize(wholeBodyDynamics_nrOfChannelsOfAYARPIMUSensor);
 
     // Resize filters
     filters.init(nrOfFTSensors,
@@ -711,7 +966,65 @@ bool WholeBodyDynamicsDevice::loadSettingsFromConfig(os::Searchable& config)
         settings.useJointAcceleration = prop.find(useJointAccelerationOptionName.c_str()).asBool();
     }
 
-    return true;
+    // Set the period of the estimation thread. The default value of 10 ms
+    // is set in the device constructor
+    if( prop.check("devicePeriodInSeconds") )
+    {
+        if( !prop.find("devicePeriodInSeconds").isDouble() || prop.find("devicePeriodInSeconds").asDouble() <= 0.0 )
+        {
+            yError() << "wholeBodyDynamics : devicePeriodInSeconds is present, but it is not a positive double";
+            return false;
+        }
+
+        this->setRate(static_cast<int>(1000.0*prop.find("devicePeriodInSeconds").asDouble()));
+    }
+
+    // Enable or disable the streaming of the timing statistics. The default value is false
+    if( prop.check("streamTimingStatistics") &&
+        prop.find("streamTimingStatistics").isBool() )
+    {
+        m_streamTimingStatistics = prop.find("streamTimingStatistics").asBool();
+    }
+
+    // Enable or disable the sensors acquisition thread. The default value is false
+    if( prop.check("useSensorsAcquisitionThread") &&
+        prop.find("useSensorsAcquisitionThread").isBool() )
+    {
+        useSensorsAcquisitionThread = prop.find("useSensorsAcquisitionThread").asBool();
+    }
+
+    sensorsAcquisitionPeriodInSeconds = getRate()/1000.0;
+    if( prop.check("sensorsAcquisitionPeriodInSeconds") )
+    {
+        if( !prop.find("sensorsAcquisitionPeriodInSeconds").isDouble() || prop.find("sensorsAcquisitionPeriodInSeconds").asDouble() <= 0.0 )
+        {
+            yError() << "wholeBodyDynamics : sensorsAcquisitionPeriodInSeconds is present, but it is not a positive double";
+            return false;
+        }
+
+        sensorsAcquisitionPeriodInSeconds = prop.find("sensorsAcquisitionPeriodInSeconds").asDouble();
+    }
+
+    // Duration of the transition of the filters after a cutoff change. The default value is 0.1 seconds
+    filters.cutOffTransitionTimeInSeconds = 0.1;
+    if( prop.check("filterCutoffTransitionTimeInSeconds") )
+    {
+        if( !prop.find("filterCutoffTransitionTimeInSeconds").isDouble() || prop.find("filterCutoffTransitionTimeInSeconds").asDouble() < 0.0 )
+        {
+            yError() << "wholeBodyDynamics : filterCutoffTransitionTimeInSeconds is present, but it is not a non-negative double";
+            return false;
+        }
+
+        filters.cutOffTransitionTimeInSeconds = prop.find("filterCutoffTransitionTimeInSeconds").asDouble();
+    }
+
+    // Load the cutoff and the type of the filters of each group of signals
+    bool ok = loadFilterParametersFromConfig(prop,"imu",getRate()/1000.0,settings.imuFilterCutoffInHz,filters.imuFilterParameters);
+    ok = ok && loadFilterParametersFromConfig(prop,"forceTorque",getRate()/1000.0,settings.forceTorqueFilterCutoffInHz,filters.forceTorqueFilterParameters);
+    ok = ok && loadFilterParametersFromConfig(prop,"jointVel",getRate()/1000.0,settings.jointVelFilterCutoffInHz,filters.jointVelFilterParameters);
+    ok = ok && loadFilterParametersFromConfig(prop,"jointAcc",getRate()/1000.0,settings.jointAccFilterCutoffInHz,filters.jointAccFilterParameters);
+
+    return ok;
 }
 
 bool WholeBodyDynamicsDevice::loadSecondaryCalibrationSettingsFromConfig(os::Searchable& config)
@@ -789,6 +1102,7 @@ bool WholeBodyDynamicsDevice::loadGravityCompensationSettingsFromConfig(os::Sear
         yWarning() << "wholeBodyDynamics: GRAVITY_COMPENSATION group not found,  disabling gravity compensation support";
         m_gravityCompensationEnabled = false;
         m_gravityCompesationJoints.resize(0);
+        resizeGravityCompensationModesCache();
         ret = true;
     }
     else
@@ -843,10 +1157,26 @@ bool WholeBodyDynamicsDevice::loadGravityCompensationSettingsFromConfig(os::Sear
             m_gravityCompesationJoints.push_back(dofOffset);
         }
 
+        resizeGravityCompensationModesCache();
+
+        m_gravityCompensationModes.refreshPeriodInSeconds = 0.0;
+        if( propGravComp.check("gravityCompensationModesRefreshPeriodInSeconds") )
+        {
+            if( !propGravComp.find("gravityCompensationModesRefreshPeriodInSeconds").isDouble() ||
+                propGravComp.find("gravityCompensationModesRefreshPeriodInSeconds").asDouble() < 0.0 )
+            {
+                yError() << "wholeBodyDynamics: gravityCompensationModesRefreshPeriodInSeconds parameter is present, but it is not a non-negative double";
+                return false;
+            }
+
+            m_gravityCompensationModes.refreshPeriodInSeconds = propGravComp.find("gravityCompensationModesRefreshPeriodInSeconds").asDouble();
+        }
+
         // We use the kinDynComp class that was opened together with the estimator
         std::string gravityCompensationBaseLink = propGravComp.find("gravityCompensationBaseLink").asString().c_str();
 
         ret = m_gravCompHelper.loadModel(this->estimator.model(),gravityCompensationBaseLink);
+        m_gravCompHelper.setKinematicsMethod(wholeBodyDynamics::ORIENTATION_ONLY_KINEMATICS);
         m_gravityCompensationTorques.resize(this->estimator.model());
 
         if( !ret )
@@ -859,6 +1189,145 @@ bool WholeBodyDynamicsDevice::loadGravityCompensationSettingsFromConfig(os::Sear
     return ret;
 }
 
+bool WholeBodyDynamicsDevice::loadTemperatureCompensationSettingsFromConfig(os::Searchable& config)
+{
+    yarp::os::Property propAll;
+    propAll.fromString(config.toString().c_str());
+
+    if( !propAll.check("FT_TEMPERATURE_COMPENSATION") )
+    {
+        return true;
+    }
+
+    yarp::os::Bottle & propTempComp = propAll.findGroup("FT_TEMPERATURE_COMPENSATION");
+    for(int i=1; i < propTempComp.size(); i++ )
+    {
+        yarp::os::Bottle * map_bot = propTempComp.get(i).asList();
+        if( map_bot == NULL || map_bot->size() != 2 || map_bot->get(1).asList() == NULL )
+        {
+            yError() << "wholeBodyDynamics: FT_TEMPERATURE_COMPENSATION group is malformed (" << propTempComp.get(i).toString() << "). ";
+            return false;
+        }
+
+        std::string iDynTree_sensorName = map_bot->get(0).asString();
+        yarp::os::Bottle * modelBot = map_bot->get(1).asList();
+
+        // Only the temperature channel can be specified, to record the offsets
+        // at different temperatures and then fit the model
+        int nrOfCoeffs = modelBot->size()-1;
+        size_t order = nrOfCoeffs/6;
+        if( nrOfCoeffs < 0 || nrOfCoeffs % 6 != 0 ||
+            order > wholeBodyDynamics::SixAxisForceTorqueMeasureProcessor::maxTemperatureOffsetModelOrder ||
+            !modelBot->get(0).isInt() || modelBot->get(0).asInt() < (int)wholeBodyDynamics_nrOfChannelsOfYARPFTSensor )
+        {
+            yError() << "wholeBodyDynamics: FT_TEMPERATURE_COMPENSATION for sensor " << iDynTree_sensorName
+                     << " should contain the temperature channel (after the six F/T channels) optionally followed by 6, 12 or 18 coefficients";
+            return false;
+        }
+
+        std::vector<iDynTree::Vector6> coeffs(order);
+        for(size_t k=0; k < order; k++)
+        {
+            for(unsigned int j=0; j < 6; j++)
+            {
+                coeffs[k](j) = modelBot->get(1+6*k+j).asDouble();
+            }
+        }
+
+        unsigned int ft;
+        if( !estimator.sensors().getSensorIndex(iDynTree::SIX_AXIS_FORCE_TORQUE,iDynTree_sensorName,ft) )
+        {
+            yError() << "wholeBodyDynamics: temperature offset model specified for FT sensor " << iDynTree_sensorName
+                     << " but no sensor with that name found in the model";
+            return false;
+        }
+
+        yDebug() << "wholeBodyDynamics: using temperature offset model of order " << order << " for sensor " << iDynTree_sensorName;
+
+        ftProcessors[ft].setTemperatureOffsetModel(coeffs);
+        m_ftTemperatureChannels[ft] = modelBot->get(0).asInt();
+    }
+
+    return true;
+}
+
+bool WholeBodyDynamicsDevice::loadOnlineCalibrationSettingsFromConfig(os::Searchable& config)
+{
+    yarp::os::Property propAll;
+    propAll.fromString(config.toString().c_str());
+
+    double jointPosThresholdInDeg = 0.2;
+    double imuAngularVelThresholdInDegPerSec = 1.0;
+    int nrOfSamplesPerUpdate = 100;
+    double offsetUpdateGain = 0.1;
+    double maxForceStdDevInNewton = 1.0;
+    double maxOffsetCorrectionInNewton = 5.0;
+
+    m_onlineCalibration.enabled = false;
+
+    if( propAll.check("ONLINE_FT_CALIBRATION") )
+    {
+        yarp::os::Searchable & propOnlineCalib = propAll.findGroup("ONLINE_FT_CALIBRATION");
+
+        if( propOnlineCalib.check("enableOnlineCalibration") )
+        {
+            if( !propOnlineCalib.find("enableOnlineCalibration").isBool() )
+            {
+                yError() << "wholeBodyDynamics: ONLINE_FT_CALIBRATION group found, but enableOnlineCalibration is not a bool";
+                return false;
+            }
+            m_onlineCalibration.enabled = propOnlineCalib.find("enableOnlineCalibration").asBool();
+        }
+
+        const char * doubleParams[5] = {"stillnessJointPosThresholdInDeg",
+                                        "stillnessIMUAngularVelThresholdInDegPerSec",
+                                        "offsetUpdateGain",
+                                        "maxForceStdDevInNewton",
+                                        "maxOffsetCorrectionInNewton"};
+        double * doubleValues[5] = {&jointPosThresholdInDeg,
+                                    &imuAngularVelThresholdInDegPerSec,
+                                    &offsetUpdateGain,
+                                    &maxForceStdDevInNewton,
+                                    &maxOffsetCorrectionInNewton};
+
+        for(size_t i=0; i < 5; i++)
+        {
+            if( propOnlineCalib.check(doubleParams[i]) )
+            {
+                if( !propOnlineCalib.find(doubleParams[i]).isDouble() || propOnlineCalib.find(doubleParams[i]).asDouble() < 0.0 )
+                {
+                    yError() << "wholeBodyDynamics: ONLINE_FT_CALIBRATION group found, but " << doubleParams[i] << " is not a non-negative double";
+                    return false;
+                }
+                *(doubleValues[i]) = propOnlineCalib.find(doubleParams[i]).asDouble();
+            }
+        }
+
+        if( offsetUpdateGain > 1.0 )
+        {
+            yError() << "wholeBodyDynamics: ONLINE_FT_CALIBRATION group found, but offsetUpdateGain is greater than 1.0";
+            return false;
+        }
+
+        if( propOnlineCalib.check("nrOfSamplesPerUpdate") )
+        {
+            if( !propOnlineCalib.find("nrOfSamplesPerUpdate").isInt() || propOnlineCalib.find("nrOfSamplesPerUpdate").asInt() < 2 )
+            {
+                yError() << "wholeBodyDynamics: ONLINE_FT_CALIBRATION group found, but nrOfSamplesPerUpdate is not an integer greater than 1";
+                return false;
+            }
+            nrOfSamplesPerUpdate = propOnlineCalib.find("nrOfSamplesPerUpdate").asInt();
+        }
+    }
+
+    m_onlineCalibration.stillnessDetector.setThresholds(jointPosThresholdInDeg*M_PI/180.0,imuAngularVelThresholdInDegPerSec*M_PI/180.0);
+    m_onlineCalibration.offsetEstimator.setParameters((size_t)nrOfSamplesPerUpdate,offsetUpdateGain,maxForceStdDevInNewton,maxOffsetCorrectionInNewton);
+    m_onlineCalibration.nrOfUpdates = 0;
+    m_onlineCalibration.nrOfRejectedUpdates = 0;
+    m_onlineCalibration.lastUpdateRejected = false;
+
+    return true;
+}
 
 bool WholeBodyDynamicsDevice::open(os::Searchable& config)
 {
@@ -882,6 +1351,14 @@ bool WholeBodyDynamicsDevice::open(os::Searchable& config)
         return false;
     } 
 
+    // Resolve the frames used as kinematic source (we need the estimator to be open)
+    ok = this->resolveKinematicSourceFrames();
+    if( !ok )
+    {
+        yError() << "wholeBodyDynamics: Problem in resolving the frames used as kinematic source.";
+        return false;
+    }
+
     // Open settings related to gravity compensation (we need the estimator to be open)
     ok = this->loadGravityCompensationSettingsFromConfig(config);
     if( !ok ) 
@@ -898,6 +1375,22 @@ bool WholeBodyDynamicsDevice::open(os::Searchable& config)
         return false;
     } 
 
+    // Load the temperature compensation settings (we need the estimator to be open)
+    ok = this->loadTemperatureCompensationSettingsFromConfig(config);
+    if( !ok )
+    {
+        yError() << "wholeBodyDynamics: Problem in loading temperature compensation settings.";
+        return false;
+    }
+
+    // Open settings related to the online calibration
+    ok = this->loadOnlineCalibrationSettingsFromConfig(config);
+    if( !ok )
+    {
+        yError() << "wholeBodyDynamics: Problem in loading online calibration settings.";
+        return false;
+    }
+
     // Open rpc port
     ok = this->openRPCPort();
     if( !ok ) 
@@ -963,6 +1456,25 @@ bool WholeBodyDynamicsDevice::open(os::Searchable& config)
         }
     }
 
+    // Open the shared memory output, if requested
+    ok = this->openSharedMemoryOutput(config);
+    if( !ok )
+    {
+        yError() << "wholeBodyDynamics: Problem in opening shared memory output.";
+        return false;
+    }
+
+    // Open the port for streaming the timing statistics
+    if( m_streamTimingStatistics )
+    {
+        ok = this->openTimingStatisticsPort();
+        if( !ok )
+        {
+            yError() << "wholeBodyDynamics: Problem in opening timing statistics port.";
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -1134,7 +1646,28 @@ bool WholeBodyDynamicsDevice::attachAll(const PolyDriverList& p)
 
     ok = ok && this->setupCalibrationWithExternalWrenchOnOneFrame("base_link",100);
 
-    if( ok )
+    // The default contact assumption is not used by the online calibration
+    m_onlineCalibration.isContactAssumptionExplicit = false;
+    if( m_onlineCalibration.enabled )
+    {
+        yWarning() << "wholeBodyDynamics : online calibration enabled, but the offsets will be updated only after a calib* RPC call sets the contacts assumed during calibration";
+    }
+
+    if( ok && useSensorsAcquisitionThread )
+    {
+        this->updateSensorsToAcquire();
+
+        int acquisitionPeriodInMs = static_cast<int>(1000.0*sensorsAcquisitionPeriodInSeconds);
+        sensorsAcquisitionThread.reset(new wholeBodyDynamicsSensorsAcquisitionThread(*this,acquisitionPeriodInMs));
+        ok = sensorsAcquisitionThread->start();
+
+        if( !ok )
+        {
+            yError() << "WholeBodyDynamicsDevice::attachAll : impossible to start the sensors acquisition thread";
+        }
+    }
+
+    if( ok )
     {
         correctlyConfigured = true;
         this->start();
@@ -1159,12 +1692,20 @@ void convertVectorFromDegreesToRadians(iDynTree::VectorDynSize & vector)
 }
 
 bool WholeBodyDynamicsDevice::readFTSensors(bool verbose)
+{
+    return readFTSensors(rawSensorsMeasurements,ftTemperatures,ftMeasurement,verbose);
+}
+
+bool WholeBodyDynamicsDevice::readFTSensors(iDynTree::SensorsMeasurements & ftMeasurements,
+                                            std::vector<double> & ftTemperatures,
+                                            yarp::sig::Vector & ftBuffer,
+                                            bool verbose)
 {
     bool FTSensorsReadCorrectly = true;
     for(size_t ft=0; ft < estimator.sensors().getNrOfSensors(iDynTree::SIX_AXIS_FORCE_TORQUE); ft++ )
     {
         iDynTree::Wrench bufWrench;
-        int ftRetVal = ftSensors[ft]->read(ftMeasurement);
+        int ftRetVal = ftSensors[ft]->read(ftBuffer);
 
         bool ok = (ftRetVal == IAnalogSensor::AS_OK);
 
@@ -1177,9 +1718,9 @@ bool WholeBodyDynamicsDevice::readFTSensors(bool verbose)
         }
 
         bool isNaN = false;
-        for (size_t i = 0; i < ftMeasurement.size(); i++)
+        for (size_t i = 0; i < ftBuffer.size(); i++)
         {
-            if( std::isnan(ftMeasurement[i]) )
+            if( std::isnan(ftBuffer[i]) )
             {
                 isNaN = true;
                 break;
@@ -1188,16 +1729,32 @@ bool WholeBodyDynamicsDevice::readFTSensors(bool verbose)
         if( isNaN )
         {
             std::string sensorName = estimator.sensors().getSensor(iDynTree::SIX_AXIS_FORCE_TORQUE,ft)->getName();
-            yError() << "wholeBodyDynamics : FT sensor " << sensorName << " contains nan: " << ftMeasurement.toString() << ", returning error.";
+            yError() << "wholeBodyDynamics : FT sensor " << sensorName << " contains nan: " << ftBuffer.toString() << ", returning error.";
             return false;
         }
 
+        if( ok && m_ftTemperatureChannels[ft] >= 0 )
+        {
+            if( (int)ftBuffer.size() <= m_ftTemperatureChannels[ft] )
+            {
+                std::string sensorName = estimator.sensors().getSensor(iDynTree::SIX_AXIS_FORCE_TORQUE,ft)->getName();
+                yError() << "wholeBodyDynamics : FT sensor " << sensorName << " has no temperature channel " << m_ftTemperatureChannels[ft] << ", returning error.";
+                return false;
+            }
+
+            ftTemperatures[ft] = ftBuffer[m_ftTemperatureChannels[ft]];
+        }
+
         if( ok )
         {
             // Format of F/T measurement in YARP/iDynTree is consistent: linear/angular
-            iDynTree::toiDynTree(ftMeasurement,bufWrench);
+            // (the additional channels, such as the temperature, are after the six F/T channels)
+            for(unsigned int i=0; i < wholeBodyDynamics_nrOfChannelsOfYARPFTSensor; i++)
+            {
+                bufWrench(i) = ftBuffer[i];
+            }
 
-            rawSensorsMeasurements.setMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft,bufWrench);
+            ftMeasurements.setMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft,bufWrench);
         }
     }
 
@@ -1210,7 +1767,15 @@ bool WholeBodyDynamicsDevice::readIMUSensors(bool verbose)
     rawIMUMeasurements.linProperAcc.zero();
     rawIMUMeasurements.angularVel.zero();
 
-    bool ok = imuInterface->read(imuMeasurement);
+    return readIMUSensors(rawIMUMeasurements.linProperAcc,rawIMUMeasurements.angularVel,imuMeasurement,verbose);
+}
+
+bool WholeBodyDynamicsDevice::readIMUSensors(iDynTree::Vector3 & linProperAcc,
+                                             iDynTree::Vector3 & angularVel,
+                                             yarp::sig::Vector & imuBuffer,
+                                             bool verbose)
+{
+    bool ok = imuInterface->read(imuBuffer);
 
     if( !ok && verbose )
     {
@@ -1220,71 +1785,92 @@ bool WholeBodyDynamicsDevice::readIMUSensors(bool verbose)
     if( ok )
     {
         // Check format of IMU in YARP http://wiki.icub.org/wiki/Inertial_Sensor
-        rawIMUMeasurements.angularVel(0) = deg2rad(imuMeasurement[6]);
-        rawIMUMeasurements.angularVel(1) = deg2rad(imuMeasurement[7]);
-        rawIMUMeasurements.angularVel(2) = deg2rad(imuMeasurement[8]);
+        angularVel(0) = deg2rad(imuBuffer[6]);
+        angularVel(1) = deg2rad(imuBuffer[7]);
+        angularVel(2) = deg2rad(imuBuffer[8]);
 
-        rawIMUMeasurements.linProperAcc(0) = imuMeasurement[3];
-        rawIMUMeasurements.linProperAcc(1) = imuMeasurement[4];
-        rawIMUMeasurements.linProperAcc(2) = imuMeasurement[5];
+        linProperAcc(0) = imuBuffer[3];
+        linProperAcc(1) = imuBuffer[4];
+        linProperAcc(2) = imuBuffer[5];
     }
 
     return ok;
 }
 
 
-void WholeBodyDynamicsDevice::readSensors()
+bool WholeBodyDynamicsDevice::readJointSensors(iDynTree::JointPosDoubleArray & pos,
+                                               iDynTree::JointDOFsDoubleArray & vel,
+                                               iDynTree::JointDOFsDoubleArray & acc,
+                                               bool readVel,
+                                               bool readAcc)
 {
     // Read encoders
-    sensorReadCorrectly = remappedControlBoardInterfaces.encs->getEncoders(jointPos.data());
+    bool jointSensorsReadCorrectly = remappedControlBoardInterfaces.encs->getEncoders(pos.data());
 
     // Convert from degrees (used on wire by YARP) to radians (used by iDynTree)
-    convertVectorFromDegreesToRadians(jointPos);
+    convertVectorFromDegreesToRadians(pos);
 
     bool ok;
 
-    if( !sensorReadCorrectly )
+    if( !jointSensorsReadCorrectly )
     {
         yWarning() << "wholeBodyDynamics warning : joint positions was not readed correctly";
     }
 
     // At the moment we are assuming that all joints are revolute
 
-    if( settings.useJointVelocity )
+    if( readVel )
     {
-        ok = remappedControlBoardInterfaces.encs->getEncoderSpeeds(jointVel.data());
-        sensorReadCorrectly = sensorReadCorrectly && ok;
+        ok = remappedControlBoardInterfaces.encs->getEncoderSpeeds(vel.data());
+        jointSensorsReadCorrectly = jointSensorsReadCorrectly && ok;
         if( !ok )
         {
             yWarning() << "wholeBodyDynamics warning : joint velocities was not readed correctly";
         }
 
         // Convert from degrees (used on wire by YARP) to radians (used by iDynTree)
-        convertVectorFromDegreesToRadians(jointVel);
+        convertVectorFromDegreesToRadians(vel);
     }
     else
     {
-        jointVel.zero();
+        vel.zero();
     }
 
-    if( settings.useJointAcceleration )
+    if( readAcc )
     {
-        ok = remappedControlBoardInterfaces.encs->getEncoderAccelerations(jointAcc.data());
-        sensorReadCorrectly = sensorReadCorrectly && ok;
+        ok = remappedControlBoardInterfaces.encs->getEncoderAccelerations(acc.data());
+        jointSensorsReadCorrectly = jointSensorsReadCorrectly && ok;
         if( !ok )
         {
             yWarning() << "wholeBodyDynamics warning : joint accelerations was not readed correctly";
         }
 
         // Convert from degrees (used on wire by YARP) to radians (used by iDynTree)
-        convertVectorFromDegreesToRadians(jointAcc);
+        convertVectorFromDegreesToRadians(acc);
 
     }
     else
     {
-        jointAcc.zero();
+        acc.zero();
     }
 
+    return jointSensorsReadCorrectly;
+}
+
+void WholeBodyDynamicsDevice::readSensors()
+{
+    if( useSensorsAcquisitionThread )
+    {
+        readSensorsFromAcquisitionThread();
+        return;
+    }
+
+    // Read encoders
+    sensorReadCorrectly = readJointSensors(jointPos,jointVel,jointAcc,
+                                           settings.useJointVelocity,settings.useJointAcceleration);
+
+    bool ok;
+
     // Read F/T sensors
     ok = readFTSensors();
     sensorReadCorrectly = ok && sensorReadCorrectly;
@@ -1299,68 +1885,149 @@ void WholeBodyDynamicsDevice::readSensors()
 
 }
 
-void WholeBodyDynamicsDevice::filterSensorsAndRemoveSensorOffsets()
+void WholeBodyDynamicsDevice::acquireSensorsSnapshot()
 {
-    filters.updateCutOffFrequency(settings.forceTorqueFilterCutoffInHz,
-                                  settings.imuFilterCutoffInHz,
-                                  settings.jointVelFilterCutoffInHz,
-                                  settings.jointAccFilterCutoffInHz);
+    // This method is called by the acquisition thread: it should not access
+    // the settings (protected by the deviceMutex), so the optional sensors to read
+    // are taken from the copy updated by the estimation thread
+    wholeBodyDynamics::SensorsSnapshot & lastSnapshot = acquisitionBuffers.lastSnapshot;
 
-    // Filter and remove offset fromn F/T sensors
-    for(size_t ft=0; ft < estimator.sensors().getNrOfSensors(iDynTree::SIX_AXIS_FORCE_TORQUE); ft++ )
+    bool ok = readJointSensors(lastSnapshot.jointPos,lastSnapshot.jointVel,lastSnapshot.jointAcc,
+                               acquireJointVelocities.load(std::memory_order_relaxed),
+                               acquireJointAccelerations.load(std::memory_order_relaxed));
+
+    ok = readFTSensors(lastSnapshot.rawSensorsMeasurements,lastSnapshot.ftTemperatures,acquisitionBuffers.ftMeasurement) && ok;
+
+    if( acquireIMU.load(std::memory_order_relaxed) )
     {
-        iDynTree::Wrench rawFTMeasure;
-        rawSensorsMeasurements.getMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft,rawFTMeasure);
+        ok = readIMUSensors(lastSnapshot.imuLinProperAcc,lastSnapshot.imuAngularVel,acquisitionBuffers.imuMeasurement) && ok;
+    }
 
-        iDynTree::Wrench rawFTMeasureWithOffsetRemoved  = ftProcessors[ft].filt(rawFTMeasure);
+    lastSnapshot.readCorrectly = ok;
+    lastSnapshot.timestamp = yarp::os::Time::now();
 
-        // Filter the data
-        iDynTree::toYarp(rawFTMeasureWithOffsetRemoved,filters.bufferYarp6);
+    // If a sensor was not read correctly, lastSnapshot still contains its old measurement
+    sensorsSnapshots.producerSnapshot() = lastSnapshot;
+    sensorsSnapshots.publish();
+}
 
-        // Run the filter
-        const yarp::sig::Vector & outputFt = filters.forcetorqueFilters[ft]->filt(filters.bufferYarp6);
+void WholeBodyDynamicsDevice::updateSensorsToAcquire()
+{
+    acquireJointVelocities.store(settings.useJointVelocity,std::memory_order_relaxed);
+    acquireJointAccelerations.store(settings.useJointAcceleration,std::memory_order_relaxed);
+    acquireIMU.store(settings.kinematicSource == IMU,std::memory_order_relaxed);
+}
 
-        iDynTree::Wrench filteredFTMeasure;
+void WholeBodyDynamicsDevice::readSensorsFromAcquisitionThread()
+{
+    // The settings can be changed by the RPC and settings ports at any time,
+    // so the sensors to read are copied to the acquisition thread at each cycle
+    this->updateSensorsToAcquire();
 
-        iDynTree::toiDynTree(outputFt,filteredFTMeasure);
+    // If no new snapshot is available, the last one is used again
+    sensorsSnapshots.fetch();
 
-        filteredSensorMeasurements.setMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft,filteredFTMeasure);
-    }
+    useSensorsSnapshot(sensorsSnapshots.consumerSnapshot());
+}
+
+void WholeBodyDynamicsDevice::useSensorsSnapshot(const wholeBodyDynamics::SensorsSnapshot& snapshot)
+{
+    jointPos = snapshot.jointPos;
 
-    // Filter joint vel
     if( settings.useJointVelocity )
     {
-        iDynTree::toYarp(jointVel,filters.bufferYarpDofs);
+        jointVel = snapshot.jointVel;
+    }
+    else
+    {
+        jointVel.zero();
+    }
+
+    if( settings.useJointAcceleration )
+    {
+        jointAcc = snapshot.jointAcc;
+    }
+    else
+    {
+        jointAcc.zero();
+    }
+
+    rawSensorsMeasurements = snapshot.rawSensorsMeasurements;
+    ftTemperatures = snapshot.ftTemperatures;
+
+    rawIMUMeasurements.linProperAcc = snapshot.imuLinProperAcc;
+    rawIMUMeasurements.angularVel   = snapshot.imuAngularVel;
+    rawIMUMeasurements.angularAcc.zero();
 
-        const yarp::sig::Vector & outputJointVel = filters.jntVelFilter->filt(filters.bufferYarpDofs);
+    sensorReadCorrectly = snapshot.readCorrectly;
+}
 
-        iDynTree::toiDynTree(outputJointVel,jointVel);
+void WholeBodyDynamicsDevice::filterSensorsAndRemoveSensorOffsets()
+{
+    // Update the filters only if their cutoffs were changed through RPC or through the settings port
+    size_t filtersSettingsGeneration = m_filtersSettingsGeneration.load();
+    if( filtersSettingsGeneration != m_appliedFiltersSettingsGeneration )
+    {
+        filters.updateCutOffFrequency(settings.forceTorqueFilterCutoffInHz,
+                                      settings.imuFilterCutoffInHz,
+                                      settings.jointVelFilterCutoffInHz,
+                                      settings.jointAccFilterCutoffInHz);
+        m_appliedFiltersSettingsGeneration = filtersSettingsGeneration;
     }
 
-    // Filter joint acc
-    if( settings.useJointAcceleration )
+    // Copy all the signals in the filters buffer
+    for(size_t ft=0; ft < estimator.sensors().getNrOfSensors(iDynTree::SIX_AXIS_FORCE_TORQUE); ft++ )
     {
-        iDynTree::toYarp(jointAcc,filters.bufferYarpDofs);
+        iDynTree::Wrench rawFTMeasure;
+        rawSensorsMeasurements.getMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft,rawFTMeasure);
 
-        const yarp::sig::Vector & outputJointAcc = filters.jntAccFilter->filt(filters.bufferYarpDofs);
+        if( m_ftTemperatureChannels[ft] >= 0 )
+        {
+            ftProcessors[ft].setTemperature(ftTemperatures[ft]);
+        }
 
-        iDynTree::toiDynTree(outputJointAcc,jointVel);
+        filters.forceTorque(ft) = iDynTree::toEigen(rawFTMeasure);
     }
 
-    // Filter IMU Sensor
-    if( settings.kinematicSource == IMU )
+    // Apply the secondary calibration matrix and remove the offset of all the F/T sensors
+    // in place in the filters buffer, that is then filtered in the same pass of the other signals
+    wholeBodyDynamics::SixAxisForceTorqueMeasureProcessor::processInPlace(ftProcessors,filters.forceTorqueMeasurements());
+
+    filters.imuLinearAcceleration() = iDynTree::toEigen(rawIMUMeasurements.linProperAcc);
+    filters.imuAngularVelocity()    = iDynTree::toEigen(rawIMUMeasurements.angularVel);
+    filters.jointVelocities()       = iDynTree::toEigen(jointVel);
+    filters.jointAccelerations()    = iDynTree::toEigen(jointAcc);
+
+    // Run all the filters in a single pass
+    filters.filt();
+
+    // Copy back the filtered F/T sensors
+    for(size_t ft=0; ft < estimator.sensors().getNrOfSensors(iDynTree::SIX_AXIS_FORCE_TORQUE); ft++ )
     {
-        iDynTree::toYarp(rawIMUMeasurements.linProperAcc,filters.bufferYarp3);
+        iDynTree::Wrench filteredFTMeasure;
 
-        const yarp::sig::Vector & outputLinAcc = filters.imuLinearAccelerationFilter->filt(filters.bufferYarp3);
+        iDynTree::toEigen(filteredFTMeasure) = filters.forceTorque(ft);
 
-        iDynTree::toiDynTree(outputLinAcc,filteredIMUMeasurements.linProperAcc);
+        filteredSensorMeasurements.setMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft,filteredFTMeasure);
+    }
 
-        iDynTree::toYarp(rawIMUMeasurements.angularVel,filters.bufferYarp3);
+    // Filtered joint vel
+    if( settings.useJointVelocity )
+    {
+        iDynTree::toEigen(jointVel) = filters.jointVelocities();
+    }
 
-        const yarp::sig::Vector & outputAngVel = filters.imuAngularVelocityFilter->filt(filters.bufferYarp3);
+    // Filtered joint acc
+    if( settings.useJointAcceleration )
+    {
+        iDynTree::toEigen(jointAcc) = filters.jointAccelerations();
+    }
 
-        iDynTree::toiDynTree(outputAngVel,filteredIMUMeasurements.angularVel);
+    // Filtered IMU Sensor
+    if( settings.kinematicSource == IMU )
+    {
+        iDynTree::toEigen(filteredIMUMeasurements.linProperAcc) = filters.imuLinearAcceleration();
+        iDynTree::toEigen(filteredIMUMeasurements.angularVel)   = filters.imuAngularVelocity();
 
         // For now we just assume that the angular acceleration is zero
         filteredIMUMeasurements.angularAcc.zero();
@@ -1369,19 +2036,18 @@ void WholeBodyDynamicsDevice::filterSensorsAndRemoveSensorOffsets()
 
 void WholeBodyDynamicsDevice::updateKinematics()
 {
+    this->updateKinematicSourceFrames();
+
     // Read IMU Sensor and update the kinematics in the model
     if( settings.kinematicSource == IMU )
     {
-        // Hardcode for the meanwhile
-        iDynTree::FrameIndex imuFrameIndex = estimator.model().getFrameIndex(settings.imuFrameName);
-
-        estimator.updateKinematicsFromFloatingBase(jointPos,jointVel,jointAcc,imuFrameIndex,
+        estimator.updateKinematicsFromFloatingBase(jointPos,jointVel,jointAcc,m_imuFrameIndex,
                                                    filteredIMUMeasurements.linProperAcc,filteredIMUMeasurements.angularVel,filteredIMUMeasurements.angularAcc);
 
         if( m_gravityCompensationEnabled )
         {
             m_gravCompHelper.updateKinematicsFromProperAcceleration(jointPos,
-                                                                    imuFrameIndex,
+                                                                    m_imuFrameIndex,
                                                                     filteredIMUMeasurements.linProperAcc);
         }
     }
@@ -1389,147 +2055,133 @@ void WholeBodyDynamicsDevice::updateKinematics()
     {
         iDynTree::Vector3 gravity;
 
-        // this should be valid because it was validated when set
-        iDynTree::FrameIndex fixedFrameIndex = estimator.model().getFrameIndex(settings.fixedFrameName);
-
         gravity(0) = settings.fixedFrameGravity.x;
         gravity(1) = settings.fixedFrameGravity.y;
         gravity(2) = settings.fixedFrameGravity.z;
 
-        estimator.updateKinematicsFromFixedBase(jointPos,jointVel,jointAcc,fixedFrameIndex,gravity);
+        // this should be valid because it was validated when set
+        estimator.updateKinematicsFromFixedBase(jointPos,jointVel,jointAcc,m_fixedFrameIndex,gravity);
 
         if( m_gravityCompensationEnabled )
         {
             m_gravCompHelper.updateKinematicsFromGravity(jointPos,
-                                                         fixedFrameIndex,
+                                                         m_fixedFrameIndex,
                                                          gravity);
         }
     }
 }
 
 
+bool WholeBodyDynamicsDevice::resolveKinematicSourceFrames()
+{
+    m_imuFrameIndex = estimator.model().getFrameIndex(settings.imuFrameName);
+    m_fixedFrameIndex = estimator.model().getFrameIndex(settings.fixedFrameName);
+
+    if( settings.kinematicSource == IMU && m_imuFrameIndex == iDynTree::FRAME_INVALID_INDEX )
+    {
+        yError() << "wholeBodyDynamics : imuFrameName " << settings.imuFrameName << " is not a frame in the model";
+        return false;
+    }
+
+    if( settings.kinematicSource == FIXED_FRAME && m_fixedFrameIndex == iDynTree::FRAME_INVALID_INDEX )
+    {
+        yError() << "wholeBodyDynamics : fixed frame " << settings.fixedFrameName << " is not a frame in the model";
+        return false;
+    }
+
+    return true;
+}
+
+void WholeBodyDynamicsDevice::updateKinematicSourceFrames()
+{
+    // The frames are looked up in the model only in the cycle after they are
+    // written through the settings port, the flag is cleared before reading the names
+    // so that a change written during the lookup is applied in the next cycle
+    if( m_kinematicSourceFramesChanged.exchange(false) )
+    {
+        m_imuFrameIndex = estimator.model().getFrameIndex(settings.imuFrameName);
+        if( m_imuFrameIndex == iDynTree::FRAME_INVALID_INDEX )
+        {
+            yError() << "wholeBodyDynamics : imuFrameName " << settings.imuFrameName << " is not a frame in the model";
+        }
+
+        m_fixedFrameIndex = estimator.model().getFrameIndex(settings.fixedFrameName);
+        if( m_fixedFrameIndex == iDynTree::FRAME_INVALID_INDEX )
+        {
+            yError() << "wholeBodyDynamics : fixed frame " << settings.fixedFrameName << " is not a frame in the model";
+        }
+    }
+}
+
 void WholeBodyDynamicsDevice::readContactPoints()
 {
     // In this function the location of the external forces acting on the robot
     // are computed. The basic strategy is to assume a contact for each subtree in which the
     // robot is divided by the F/T sensors.
 
+    // read skin
+    iCub::skinDynLib::skinContactList *scl =this->portContactsInput.read(false); //scl=null could also mean no new message
+
+    processContactPoints(scl,yarp::os::Time::now());
+}
+
+void WholeBodyDynamicsDevice::processContactPoints(iCub::skinDynLib::skinContactList* scl, const double now)
+{
     measuredContactLocations.clear();
-    int numberOfContacts=0;
     size_t nrOfSubModels = estimator.submodels().getNrOfSubModels();
 
-    // read skin
-    iCub::skinDynLib::skinContactList *scl =this->portContactsInput.read(false); //scl=null could also mean no new message
     if(scl)
     {
         //< \todo TODO check for envelope?
-        lastReadingSkinContactListStamp = yarp::os::Time::now();
+        lastReadingSkinContactListStamp = now;
         if(scl->empty())   // if no skin contacts => leave the old contacts but reset pressure and contact list
         {
-            if (contactsReadFromSkin.empty())
-            {
-
-                for(size_t subModel = 0; subModel < nrOfSubModels; subModel++)
-                {
-                    bool ok = measuredContactLocations.addNewContactInFrame(estimator.model(),
-                                                                            subModelIndex2DefaultContact[subModel], //frameIndex in iDynTree
-                                                                            iDynTree::UnknownWrenchContact(iDynTree::FULL_WRENCH,iDynTree::Position::Zero()));
-                    if( !ok )
-                    {
-                        yWarning() << "wholeBodyDynamics: Failing in adding default contact for submodel " << subModel;
-                    }
-                }
-                return;
-            }
-
             //< \todo TODO this (using the last contacts if no contacts are detected) should be at subtree level, not at global level??
-            // ask what is intended with this TODO
-            else
-            {
-                for(iCub::skinDynLib::skinContactList::iterator it=contactsReadFromSkin.begin(); it!=contactsReadFromSkin.end(); it++)
-                {
-                    it->setPressure(0.0);
-                    it->setActiveTaxels(0);
-                    numberOfContacts++;
-                }
-            }
+            skinContactsIndex.resetPressures();
         }
         else
         {
-            contactsReadFromSkin.clear();
-            for(iCub::skinDynLib::skinContactList::iterator it=scl->begin(); it!=scl->end(); it++)
+            size_t nrOfPreviouslyDiscardedContacts = skinContactsIndex.getNrOfDiscardedContacts();
+            skinContactsIndex.update(*scl);
+
+            // Warn only the first time, to avoid flooding the log at each cycle
+            if( nrOfPreviouslyDiscardedContacts == 0 && skinContactsIndex.getNrOfDiscardedContacts() > 0 )
             {
-                //  less than 10 taxels are active then suppose zero moment
-                if( it->getActiveTaxels()<10)
-                {
-                    it->fixMoment();                    
-                }
-                contactsReadFromSkin.insert(contactsReadFromSkin.end(),*it);
-                numberOfContacts++;
+                yWarning() << "wholeBodyDynamics: the skin reported " << scl->size() << " contacts, the ones exceeding the first "
+                           << skinContactsIndex.getMaxNrOfContacts() << " are merged with the closest contact of the same link (see the maxNrOfSkinContacts parameter).";
             }
         }
     }
     else
     {
-        if(yarp::os::Time::now()-lastReadingSkinContactListStamp>SKIN_EVENTS_TIMEOUT && lastReadingSkinContactListStamp!=0.0)
-        {
-            contactsReadFromSkin.clear();
-        }
-        // For now just put the default contact points
-        //This logic only gives the location of the contacts but it does not store any value of pressure or wrench in the contact,
-        if (contactsReadFromSkin.empty())
-        {
-            for(size_t subModel = 0; subModel < nrOfSubModels; subModel++)
-            {
-                bool ok = measuredContactLocations.addNewContactInFrame(estimator.model(),
-                                                                        subModelIndex2DefaultContact[subModel], //frameIndex in iDynTree
-                                                                        iDynTree::UnknownWrenchContact(iDynTree::FULL_WRENCH,iDynTree::Position::Zero()));
-                if( !ok )
-                {
-                    yWarning() << "wholeBodyDynamics: Failing in adding default contact for submodel " << subModel;
-                }
-            }
-            return;
-        }
-
-        //< \todo TODO this (using the last contacts if no contacts are detected) should be at subtree level, not at global level??
-        // ask what is intended with this TODO
-        else
+        if(now-lastReadingSkinContactListStamp>SKIN_EVENTS_TIMEOUT && lastReadingSkinContactListStamp!=0.0)
         {
-            for(iCub::skinDynLib::skinContactList::iterator it=contactsReadFromSkin.begin(); it!=contactsReadFromSkin.end(); it++)
-            {
-                it->setPressure(0.0);
-                it->setActiveTaxels(0);
-                //yDebug() << "wholeBodyDynamics: skincontactlist empty, setting pressure and active taxels to 0";
-                numberOfContacts++;
-            }
+            skinContactsIndex.clear();
         }
 
-        //return;
+        // The location of the last contacts is kept, but the pressure is reset as no new skin data is available
+        skinContactsIndex.resetPressures();
     }
 
-    // convert skinContactList into LinkUnknownWrenchContacts TODO: change function to keep and store wrench information only contact location and force directionis kept
-    conversionHelper.fromSkinDynLibToiDynTree(estimator.model(),contactsReadFromSkin,measuredContactLocations);
-
-    //declare and initialize contact count to 0
-    std::vector<int> contacts_for_given_subModel(nrOfSubModels,0);
-
-    numberOfContacts=0;
-    int subModelIndex=0;
-    // check each link to see if they have and assigned contact in which case check the subModelIndex
-    for(size_t linkIndex = 0; linkIndex < estimator.model().getNrOfLinks(); linkIndex++)
+    // Add the skin contacts (in their skin frames) and count the contacts of each submodel
+    std::fill(nrOfSkinContactsForSubModel.begin(),nrOfSkinContactsForSubModel.end(),0);
+    for(size_t contact = 0; contact < skinContactsIndex.getNrOfContacts(); contact++)
     {
-        numberOfContacts= measuredContactLocations.getNrOfContactsForLink(linkIndex);
-        if( numberOfContacts >0)
+        const wholeBodyDynamics::IndexedSkinContact & skinContact = skinContactsIndex.getContact(contact);
+
+        bool ok = measuredContactLocations.addNewContactInFrame(estimator.model(),
+                                                                skinContact.frameIndex,
+                                                                skinContact.unknownWrench);
+        if( ok )
         {
-            subModelIndex = estimator.submodels().getSubModelOfLink(linkIndex);
-            contacts_for_given_subModel[subModelIndex]++;
+            nrOfSkinContactsForSubModel[estimator.submodels().getSubModelOfLink(skinContact.linkIndex)]++;
         }
     }
 
+    // Use the default contact for the submodels without skin contacts
     for(size_t subModel = 0; subModel < nrOfSubModels; subModel++)
     {
-        if( contacts_for_given_subModel[subModel] == 0 )
+        if( nrOfSkinContactsForSubModel[subModel] == 0 )
         {
             bool ok = measuredContactLocations.addNewContactInFrame(estimator.model(),
                                                                     subModelIndex2DefaultContact[subModel], //frameIndex in iDynTree
@@ -1539,10 +2191,6 @@ void WholeBodyDynamicsDevice::readContactPoints()
                 yWarning() << "wholeBodyDynamics: Failing in adding default contact for submodel " << subModel;
             }
         }
-        /*else
-        {
-             yDebug() << "wholeBodyDynamics: number of contacts in submodel "<<subModel<<" = "<<contacts_for_given_subModel[subModel];
-        }*/
     }
 
     return;
@@ -1608,6 +2256,8 @@ void WholeBodyDynamicsDevice::computeCalibration()
                 {
                     iDynTree::Wrench measurementMean, estimationMean;
                     computeMean(calibrationBuffers.offsetSumBuffer[ft],calibrationBuffers.nrOfSamplesUsedUntilNowForCalibration,ftProcessors[ft].offset());
+                    ftProcessors[ft].resetReferenceTemperature();
+                    this->addTemperatureOffsetSample(ft);
                     computeMean(calibrationBuffers.measurementSumBuffer[ft],calibrationBuffers.nrOfSamplesUsedUntilNowForCalibration,measurementMean);
                     computeMean(calibrationBuffers.estimationSumBuffer[ft],calibrationBuffers.nrOfSamplesUsedUntilNowForCalibration,estimationMean);
 
@@ -1620,6 +2270,10 @@ void WholeBodyDynamicsDevice::computeCalibration()
             this->endCalibration();
         }
     }
+    else if( m_onlineCalibration.enabled && validOffsetAvailable )
+    {
+        this->computeOnlineCalibration();
+    }
 
 }
 
@@ -1643,6 +2297,15 @@ void WholeBodyDynamicsDevice::publishEstimatedQuantities()
         // Only send estimation if a valid offset is available
         if( validOffsetAvailable )
         {
+            computeNetExternalWrenches();
+
+            // Write the estimates in shared memory, if requested, before publishing
+            // them on the ports so that the local consumers do not wait for YARP
+            if( m_sharedMemoryOutputEnabled )
+            {
+                publishSharedMemoryOutput();
+            }
+
             //Send torques
             publishTorques();
 
@@ -1666,51 +2329,101 @@ void WholeBodyDynamicsDevice::publishEstimatedQuantities()
     }
 }
 
+void WholeBodyDynamicsDevice::resizeGravityCompensationModesCache()
+{
+    size_t nrOfJoints = m_gravityCompesationJoints.size();
+
+    m_gravityCompensationModes.joints.resize(nrOfJoints);
+    for(size_t ii=0; ii < nrOfJoints; ii++)
+    {
+        m_gravityCompensationModes.joints[ii] = (int)m_gravityCompesationJoints[ii];
+    }
+
+    m_gravityCompensationModes.controlModes.resize(nrOfJoints);
+    m_gravityCompensationModes.interactionModes.resize(nrOfJoints);
+    m_gravityCompensationModes.activeJoints.reserve(nrOfJoints);
+    m_gravityCompensationModes.activeJoints.resize(0);
+    m_gravityCompensationModes.lastRefreshTime = 0.0;
+}
+
+void WholeBodyDynamicsDevice::refreshGravityCompensationModesCache()
+{
+    m_gravityCompensationModes.activeJoints.resize(0);
+
+    int nrOfJoints = (int)m_gravityCompensationModes.joints.size();
+
+    if( nrOfJoints == 0 )
+    {
+        return;
+    }
+
+    bool ok = remappedControlBoardInterfaces.ctrlmode->getControlModes(nrOfJoints,
+                                                                       m_gravityCompensationModes.joints.data(),
+                                                                       m_gravityCompensationModes.controlModes.data());
+    ok = ok && remappedControlBoardInterfaces.intmode->getInteractionModes(nrOfJoints,
+                                                                          m_gravityCompensationModes.joints.data(),
+                                                                          m_gravityCompensationModes.interactionModes.data());
+
+    // If the modes are not available, no impedance offset is set until the next refresh
+    if( !ok )
+    {
+        return;
+    }
+
+    for(size_t ii=0; ii < m_gravityCompensationModes.joints.size(); ii++)
+    {
+        switch(m_gravityCompensationModes.controlModes[ii])
+        {
+            case VOCAB_CM_POSITION:
+            case VOCAB_CM_POSITION_DIRECT:
+            case VOCAB_CM_MIXED:
+            case VOCAB_CM_VELOCITY:
+                 if (m_gravityCompensationModes.interactionModes[ii] == VOCAB_IM_COMPLIANT)
+                 {
+                     m_gravityCompensationModes.activeJoints.push_back(m_gravityCompesationJoints[ii]);
+                 }
+                 else
+                 {
+                     //stiff or unknown mode, nothing to do
+                 }
+                 break;
+            default:
+                // We don't do anything in VOCAB_CM_TORQUE, differently from the
+                // old gravity compensation : because otherwise we interfere
+                // with any torque control loop
+                //
+                // for all this other control modes do nothing
+                // VOCAB_CM_PWM
+                // VOCAB_CM_CURRENT
+                // VOCAB_CM_OPENLOOP:
+                // VOCAB_CM_IDLE:
+                // VOCAB_CM_UNKNOWN:
+                // VOCAB_CM_HW_FAULT:
+                break;
+        }
+    }
+}
+
 void WholeBodyDynamicsDevice::publishGravityCompensation()
 {
     if( m_gravityCompensationEnabled )
     {
         this->m_gravCompHelper.getGravityCompensationTorques(this->m_gravityCompensationTorques);
-        // Publish torques only in joints that are in compliant mode that they need it
 
-        for(size_t ii=0; ii < m_gravityCompesationJoints.size(); ii++)
+        // Refresh the modes of the joints, if the cached ones are too old
+        double now = yarp::os::Time::now();
+        if( m_gravityCompensationModes.lastRefreshTime == 0.0 ||
+            now - m_gravityCompensationModes.lastRefreshTime >= m_gravityCompensationModes.refreshPeriodInSeconds )
         {
-            size_t dof = m_gravityCompesationJoints[ii];
-
-            int ctrl_mode=0;
-            yarp::dev::InteractionModeEnum int_mode;
-            remappedControlBoardInterfaces.ctrlmode->getControlMode(dof,&ctrl_mode);
-            remappedControlBoardInterfaces.intmode->getInteractionMode(dof,&int_mode);
+            refreshGravityCompensationModesCache();
+            m_gravityCompensationModes.lastRefreshTime = now;
+        }
 
-            switch(ctrl_mode)
-            {
-                case VOCAB_CM_POSITION:
-                case VOCAB_CM_POSITION_DIRECT:
-                case VOCAB_CM_MIXED:
-                case VOCAB_CM_VELOCITY:
-                     if (int_mode == VOCAB_IM_COMPLIANT)
-                     {
-                         remappedControlBoardInterfaces.impctrl->setImpedanceOffset((int)dof,this->m_gravityCompensationTorques(dof));
-                     }
-                     else
-                     {
-                         //stiff or unknown mode, nothing to do
-                     }
-                     break;
-                default:
-                    // We don't do anything in VOCAB_CM_TORQUE, differently from the
-                    // old gravity compensation : because otherwise we interfere
-                    // with any torque control loop
-                    //
-                    // for all this other control modes do nothing
-                    // VOCAB_CM_PWM
-                    // VOCAB_CM_CURRENT
-                    // VOCAB_CM_OPENLOOP:
-                    // VOCAB_CM_IDLE:
-                    // VOCAB_CM_UNKNOWN:
-                    // VOCAB_CM_HW_FAULT:
-                    break;
-            }
+        // Publish torques only in joints that are in compliant mode that they need it
+        for(size_t ii=0; ii < m_gravityCompensationModes.activeJoints.size(); ii++)
+        {
+            size_t dof = m_gravityCompensationModes.activeJoints[ii];
+            remappedControlBoardInterfaces.impctrl->setImpedanceOffset((int)dof,this->m_gravityCompensationTorques(dof));
         }
     }
 }
@@ -1726,6 +2439,10 @@ void WholeBodyDynamicsDevice::resetGravityCompensation()
             // Regardless of the controlmode, we reset the setImpedanceOffset
             remappedControlBoardInterfaces.impctrl->setImpedanceOffset((int)dof,0.0);
         }
+
+        // Force a refresh of the modes when the gravity compensation is published again
+        m_gravityCompensationModes.activeJoints.resize(0);
+        m_gravityCompensationModes.lastRefreshTime = 0.0;
     }
 }
 
@@ -1763,9 +2480,9 @@ void WholeBodyDynamicsDevice::publishContacts()
     }
 }
 
-void WholeBodyDynamicsDevice::publishExternalWrenches()
+void WholeBodyDynamicsDevice::computeNetExternalWrenches()
 {
-    if( this->outputWrenchPorts.size() > 0 )
+    if( this->outputWrenchPorts.size() > 0 || m_sharedMemoryOutputEnabled )
     {
         // Update kinDynComp model
         iDynTree::Vector3 dummyGravity;
@@ -1775,7 +2492,10 @@ void WholeBodyDynamicsDevice::publishExternalWrenches()
         // Compute net wrenches for each link
         estimateExternalContactWrenches.computeNetWrenches(netExternalWrenchesExertedByTheEnviroment);
     }
+}
 
+void WholeBodyDynamicsDevice::publishExternalWrenches()
+{
 
     // Get wrenches from the estimator and publish it on the port
     for(size_t i=0; i < this->outputWrenchPorts.size(); i++ )
@@ -1813,51 +2533,170 @@ void WholeBodyDynamicsDevice::publishFilteredFTWithoutOffset()
 
 }
 
-void WholeBodyDynamicsDevice::run()
+void WholeBodyDynamicsDevice::publishSharedMemoryOutput()
 {
-    yarp::os::LockGuard guard(this->deviceMutex);
-
-    if( correctlyConfigured )
-    {
-        // Load settings if modified
-        //this->reconfigureClassFromSettings();
-
-        // Read sensor readings
-        this->readSensors();
-
-        // Filter sensor and remove offset
-        this->filterSensorsAndRemoveSensorOffsets();
-
-        // Update kinematics
-        this->updateKinematics();
-
-        // Read contacts info from the skin or from assume contact location
-        this->readContactPoints();
+    double timestamp = yarp::os::Time::now();
 
-        // Compute calibration if we are in calibration mode
-        this->computeCalibration();
+    m_sharedMemoryJointTorques.write(timestamp,estimatedJointTorques.data());
 
-        // Compute estimated external forces and internal joint torques
-        this->computeExternalForcesAndJointTorques();
+    // netExternalWrenchesExertedByTheEnviroment is computed in computeNetExternalWrenches
+    for(size_t link=0; link < estimator.model().getNrOfLinks(); link++)
+    {
+        const iDynTree::Wrench & linkWrench = netExternalWrenchesExertedByTheEnviroment(link);
+        for(unsigned int i=0; i < 6; i++)
+        {
+            m_sharedMemoryBuffer[6*link+i] = linkWrench(i);
+        }
+    }
+    m_sharedMemoryExternalWrenches.write(timestamp,m_sharedMemoryBuffer.data());
 
-        // Publish estimated quantities
-        this->publishEstimatedQuantities();
+    iDynTree::Wrench filteredFTMeasure;
+    for(size_t ft=0; ft < estimator.sensors().getNrOfSensors(iDynTree::SIX_AXIS_FORCE_TORQUE); ft++ )
+    {
+        filteredSensorMeasurements.getMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft,filteredFTMeasure);
+        for(unsigned int i=0; i < 6; i++)
+        {
+            m_sharedMemoryBuffer[6*ft+i] = filteredFTMeasure(i);
+        }
     }
+    m_sharedMemoryFilteredFT.write(timestamp,m_sharedMemoryBuffer.data());
 }
 
-bool WholeBodyDynamicsDevice::detachAll()
+void WholeBodyDynamicsDevice::initTimingStatistics()
 {
-    yarp::os::LockGuard guard(this->deviceMutex);
+    m_stagesTimingStatistics.resize(NR_OF_PROFILED_STAGES);
 
-    correctlyConfigured = false;
+    const char * stageNames[NR_OF_PROFILED_STAGES] = {"period",
+                                                      "readSensors",
+                                                      "filterSensorsAndRemoveSensorOffsets",
+                                                      "updateKinematics",
+                                                      "readContactPoints",
+                                                      "computeCalibration",
+                                                      "computeExternalForcesAndJointTorques",
+                                                      "publishEstimatedQuantities",
+                                                      "total"};
 
-    if (isRunning())
+    for(size_t stage=0; stage < m_stagesTimingStatistics.size(); stage++)
     {
-        stop();
+        m_stagesTimingStatistics[stage].init(stageNames[stage],
+                                             wholeBodyDynamics_timingHistogramBinWidthInSeconds,
+                                             wholeBodyDynamics_timingHistogramNrOfBins);
     }
 
-    // If gravity compensation was enabled, reset the offsets
-    this->resetGravityCompensation();
+    m_lastRunStartTime = 0.0;
+}
+
+double WholeBodyDynamicsDevice::updateStageTiming(const wholeBodyDynamicsProfiledStage stage, const double stageStart)
+{
+    double now = yarp::os::SystemClock::nowSystem();
+    m_stagesTimingStatistics[stage].update(now-stageStart);
+    return now;
+}
+
+void WholeBodyDynamicsDevice::publishTimingStatistics()
+{
+    if( m_timingStatisticsPort.getOutputCount() > 0 )
+    {
+        const double streamedPercentiles[3] = {50.0,90.0,99.0};
+
+        yarp::sig::Vector & timingVector = m_timingStatisticsPort.prepare();
+        timingVector.resize(wholeBodyDynamics_nrOfStreamedTimingStatistics*m_stagesTimingStatistics.size());
+
+        for(size_t stage=0; stage < m_stagesTimingStatistics.size(); stage++)
+        {
+            double * stageTiming = timingVector.data() + wholeBodyDynamics_nrOfStreamedTimingStatistics*stage;
+            stageTiming[0] = m_stagesTimingStatistics[stage].last();
+            stageTiming[1] = m_stagesTimingStatistics[stage].min();
+            stageTiming[2] = m_stagesTimingStatistics[stage].mean();
+            stageTiming[3] = m_stagesTimingStatistics[stage].max();
+            m_stagesTimingStatistics[stage].percentiles(streamedPercentiles,stageTiming+4,3);
+        }
+
+        m_timingStatisticsPort.write();
+    }
+}
+
+void WholeBodyDynamicsDevice::run()
+{
+    yarp::os::LockGuard guard(this->deviceMutex);
+
+    if( correctlyConfigured )
+    {
+        double runStart = yarp::os::SystemClock::nowSystem();
+
+        if( m_lastRunStartTime > 0.0 )
+        {
+            m_stagesTimingStatistics[STAGE_PERIOD].update(runStart-m_lastRunStartTime);
+        }
+        m_lastRunStartTime = runStart;
+
+        // Load settings if modified
+        //this->reconfigureClassFromSettings();
+
+        // Read sensor readings
+        this->readSensors();
+        double stageStart = updateStageTiming(STAGE_READ_SENSORS,runStart);
+
+        // If the sensors are read by the acquisition thread, wait for its first snapshot
+        if( useSensorsAcquisitionThread &&
+            sensorsSnapshots.consumerSnapshot().timestamp == 0.0 )
+        {
+            return;
+        }
+
+        // Filter sensor and remove offset
+        this->filterSensorsAndRemoveSensorOffsets();
+        stageStart = updateStageTiming(STAGE_FILTER_SENSORS,stageStart);
+
+        // Update kinematics
+        this->updateKinematics();
+        stageStart = updateStageTiming(STAGE_UPDATE_KINEMATICS,stageStart);
+
+        // Read contacts info from the skin or from assume contact location
+        this->readContactPoints();
+        stageStart = updateStageTiming(STAGE_READ_CONTACT_POINTS,stageStart);
+
+        // Compute calibration if we are in calibration mode
+        this->computeCalibration();
+        stageStart = updateStageTiming(STAGE_COMPUTE_CALIBRATION,stageStart);
+
+        // Compute estimated external forces and internal joint torques
+        this->computeExternalForcesAndJointTorques();
+        stageStart = updateStageTiming(STAGE_COMPUTE_ESTIMATION,stageStart);
+
+        // Publish estimated quantities
+        this->publishEstimatedQuantities();
+        updateStageTiming(STAGE_PUBLISH,stageStart);
+
+        updateStageTiming(STAGE_TOTAL,runStart);
+
+        // Publish timing statistics, if requested
+        if( m_streamTimingStatistics )
+        {
+            publishTimingStatistics();
+        }
+    }
+}
+
+bool WholeBodyDynamicsDevice::detachAll()
+{
+    yarp::os::LockGuard guard(this->deviceMutex);
+
+    correctlyConfigured = false;
+
+    if (isRunning())
+    {
+        stop();
+    }
+
+    if( sensorsAcquisitionThread )
+    {
+        sensorsAcquisitionThread->stop();
+        sensorsAcquisitionThread.reset();
+    }
+
+    // If gravity compensation was enabled, reset the offsets
+    this->resetGravityCompensation();
 
 
     this->remappedControlBoardInterfaces.multwrap->detachAll();
@@ -1868,6 +2707,7 @@ bool WholeBodyDynamicsDevice::detachAll()
     closeRPCPort();
     closeSettingsPort();
     closeSkinContactListsPorts();
+    closeTimingStatisticsPort();
 
 
     return true;
@@ -1878,6 +2718,11 @@ bool WholeBodyDynamicsDevice::close()
     this->remappedControlBoard.close();
     this->remappedVirtualAnalogSensors.close();
 
+    m_sharedMemoryJointTorques.close();
+    m_sharedMemoryExternalWrenches.close();
+    m_sharedMemoryFilteredFT.close();
+    m_sharedMemoryOutputEnabled = false;
+
     correctlyConfigured = false;
 
     return true;
@@ -1914,6 +2759,89 @@ bool WholeBodyDynamicsDevice::setupCalibrationWithExternalWrenchOnOneFrame(const
     return true;
 }
 
+void WholeBodyDynamicsDevice::computeOnlineCalibration()
+{
+    // With the default contact assumption (base_link) the residuals of a robot that is
+    // not on the pole would be absorbed by the offsets
+    if( !m_onlineCalibration.isContactAssumptionExplicit )
+    {
+        return;
+    }
+
+    if( !m_onlineCalibration.stillnessDetector.update(jointPos,filteredIMUMeasurements.angularVel) )
+    {
+        // The robot moved, discard the samples collected until now
+        m_onlineCalibration.offsetEstimator.reset();
+        return;
+    }
+
+    // The kinematics information was already set by the updateKinematics method
+    estimator.computeExpectedFTSensorsMeasurements(calibrationBuffers.assumedContactLocationsForCalibration,
+                                                   calibrationBuffers.predictedSensorMeasurementsForCalibration,
+                                                   calibrationBuffers.predictedExternalContactWrenchesForCalibration,
+                                                   calibrationBuffers.predictedJointTorquesForCalibration);
+
+    for(size_t ft = 0; ft < ftProcessors.size(); ft++)
+    {
+        iDynTree::Wrench estimatedFT;
+        iDynTree::Wrench measuredRawFT;
+        calibrationBuffers.predictedSensorMeasurementsForCalibration.getMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft,estimatedFT);
+        rawSensorsMeasurements.getMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft,measuredRawFT);
+
+        // As in computeCalibration, only the secondary calibration matrix is applied,
+        // but the offset due to the temperature change since the last calibration is removed
+        measuredRawFT = ftProcessors[ft].applySecondaryCalibrationMatrix(measuredRawFT);
+
+        iDynTree::Wrench temperatureOffset;
+        ftProcessors[ft].getTemperatureOffset(temperatureOffset);
+
+        m_onlineCalibration.offsetEstimator.addResidual(ft,measuredRawFT-estimatedFT-temperatureOffset);
+    }
+
+    if( m_onlineCalibration.offsetEstimator.completeSample() )
+    {
+        if( m_onlineCalibration.offsetEstimator.isWindowConsistent() )
+        {
+            // A large correction means that the external forces are not the assumed ones:
+            // the window is discarded for all the sensors, and it is logged only when the
+            // rejections start, to avoid logging every window
+            size_t unboundedFT = ftProcessors.size();
+            for(size_t ft = 0; ft < ftProcessors.size() && unboundedFT == ftProcessors.size(); ft++)
+            {
+                if( !m_onlineCalibration.offsetEstimator.isCorrectionBounded(ft,ftProcessors[ft].offset()) )
+                {
+                    unboundedFT = ft;
+                }
+            }
+
+            if( unboundedFT < ftProcessors.size() )
+            {
+                if( !m_onlineCalibration.lastUpdateRejected )
+                {
+                    yWarning() << "wholeBodyDynamics : online calibration update skipped, the offset correction of sensor "
+                               << estimator.sensors().getSensor(iDynTree::SIX_AXIS_FORCE_TORQUE,unboundedFT)->getName()
+                               << " is " << m_onlineCalibration.offsetEstimator.getForceCorrectionNorm(unboundedFT,ftProcessors[unboundedFT].offset())
+                               << " N: the external forces are probably not the ones assumed by the last calibration";
+                }
+                m_onlineCalibration.lastUpdateRejected = true;
+                m_onlineCalibration.nrOfRejectedUpdates++;
+            }
+            else
+            {
+                for(size_t ft = 0; ft < ftProcessors.size(); ft++)
+                {
+                    m_onlineCalibration.offsetEstimator.updateOffset(ft,ftProcessors[ft].offset());
+                    this->addTemperatureOffsetSample(ft);
+                }
+                m_onlineCalibration.lastUpdateRejected = false;
+                m_onlineCalibration.nrOfUpdates++;
+            }
+        }
+
+        m_onlineCalibration.offsetEstimator.reset();
+    }
+}
+
 void WholeBodyDynamicsDevice::setupCalibrationCommonPart(const int32_t nrOfSamples)
 {
     calibrationBuffers.nrOfSamplesToUseForCalibration = (size_t)nrOfSamples;
@@ -1925,6 +2853,13 @@ void WholeBodyDynamicsDevice::setupCalibrationCommonPart(const int32_t nrOfSampl
     }
     calibrationBuffers.ongoingCalibration = true;
 
+    // The samples collected by the online calibration refer to the old offsets,
+    // and the new contact assumption is the one that the online calibration will use
+    m_onlineCalibration.offsetEstimator.reset();
+    m_onlineCalibration.stillnessDetector.reset();
+    m_onlineCalibration.isContactAssumptionExplicit = true;
+    m_onlineCalibration.lastUpdateRejected = false;
+
     for(size_t ft = 0; ft < this->getNrOfFTSensors(); ft++)
     {
         calibrationBuffers.offsetSumBuffer[ft].zero();
@@ -2078,6 +3013,7 @@ bool WholeBodyDynamicsDevice::resetOffset(const std::string& calib_code)
     for(size_t ft = 0; ft < this->getNrOfFTSensors(); ft++)
     {
         ftProcessors[ft].offset().zero();
+        ftProcessors[ft].resetReferenceTemperature();
     }
 
     return true;
@@ -2101,7 +3037,14 @@ bool WholeBodyDynamicsDevice::set_forceTorqueFilterCutoffInHz(const double newCu
 {
     yarp::os::LockGuard guard(this->deviceMutex);
 
+    if( !filters.forceTorqueFilterParameters.isValid(newCutoff,getRate()/1000.0) )
+    {
+        yError() << "wholeBodyDynamics : set_forceTorqueFilterCutoffInHz : " << newCutoff << " Hz is not a valid cutoff for the used filter";
+        return false;
+    }
+
     this->settings.forceTorqueFilterCutoffInHz = newCutoff;
+    m_filtersSettingsGeneration++;
 
     return true;
 }
@@ -2117,7 +3060,14 @@ bool WholeBodyDynamicsDevice::set_jointVelFilterCutoffInHz(const double newCutof
 {
     yarp::os::LockGuard guard(this->deviceMutex);
 
+    if( !filters.jointVelFilterParameters.isValid(newCutoff,getRate()/1000.0) )
+    {
+        yError() << "wholeBodyDynamics : set_jointVelFilterCutoffInHz : " << newCutoff << " Hz is not a valid cutoff for the used filter";
+        return false;
+    }
+
     this->settings.jointVelFilterCutoffInHz = newCutoff;
+    m_filtersSettingsGeneration++;
 
     return true;
 }
@@ -2133,7 +3083,14 @@ bool WholeBodyDynamicsDevice::set_jointAccFilterCutoffInHz(const double newCutof
 {
     yarp::os::LockGuard guard(this->deviceMutex);
 
+    if( !filters.jointAccFilterParameters.isValid(newCutoff,getRate()/1000.0) )
+    {
+        yError() << "wholeBodyDynamics : set_jointAccFilterCutoffInHz : " << newCutoff << " Hz is not a valid cutoff for the used filter";
+        return false;
+    }
+
     this->settings.jointAccFilterCutoffInHz = newCutoff;
+    m_filtersSettingsGeneration++;
 
     return true;
 }
@@ -2150,7 +3107,14 @@ bool WholeBodyDynamicsDevice::set_imuFilterCutoffInHz(const double newCutoff)
 {
     yarp::os::LockGuard guard(this->deviceMutex);
 
+    if( !filters.imuFilterParameters.isValid(newCutoff,getRate()/1000.0) )
+    {
+        yError() << "wholeBodyDynamics : set_imuFilterCutoffInHz : " << newCutoff << " Hz is not a valid cutoff for the used filter";
+        return false;
+    }
+
     this->settings.imuFilterCutoffInHz = newCutoff;
+    m_filtersSettingsGeneration++;
 
     return true;
 }
@@ -2170,6 +3134,7 @@ bool WholeBodyDynamicsDevice::useFixedFrameAsKinematicSource(const std::string&
     // Set the kinematic source to a fixed frame
     settings.kinematicSource = FIXED_FRAME;
     settings.fixedFrameName = fixedFrame;
+    m_fixedFrameIndex = fixedFrameIndex;
 
     yInfo() << "wholeBodyDynamics : successfully set the kinematic source to be the fixed frame " << fixedFrame;
     yInfo() << "wholeBodyDynamics : with gravity " << settings.fixedFrameGravity.toString();
@@ -2181,9 +3146,18 @@ bool WholeBodyDynamicsDevice::useIMUAsKinematicSource()
 {
     yarp::os::LockGuard guard(this->deviceMutex);
 
+    iDynTree::FrameIndex imuFrameIndex = estimator.model().getFrameIndex(settings.imuFrameName);
+
+    if( imuFrameIndex == iDynTree::FRAME_INVALID_INDEX )
+    {
+        yError() << "wholeBodyDynamics : useIMUAsKinematicSource : imu frame " << settings.imuFrameName << " is not a frame in the model, method failed";
+        return false;
+    }
+
     yInfo() << "wholeBodyDynamics : successfully set the kinematic source to be the IMU ";
 
     settings.kinematicSource = IMU;
+    m_imuFrameIndex = imuFrameIndex;
 
     return true;
 }
@@ -2213,6 +3187,33 @@ std::string WholeBodyDynamicsDevice::getCurrentSettingsString()
    return settings.toString();
 }
 
+std::string WholeBodyDynamicsDevice::getTimingStatistics()
+{
+    yarp::os::LockGuard guard(this->deviceMutex);
+
+    std::string ret;
+    for(size_t stage=0; stage < m_stagesTimingStatistics.size(); stage++)
+    {
+        ret += m_stagesTimingStatistics[stage].toString() + "\n";
+    }
+
+    return ret;
+}
+
+bool WholeBodyDynamicsDevice::resetTimingStatistics()
+{
+    yarp::os::LockGuard guard(this->deviceMutex);
+
+    for(size_t stage=0; stage < m_stagesTimingStatistics.size(); stage++)
+    {
+        m_stagesTimingStatistics[stage].reset();
+    }
+
+    m_lastRunStartTime = 0.0;
+
+    return true;
+}
+
 bool WholeBodyDynamicsDevice::resetSimpleLeggedOdometry(const std::string& /*initial_world_frame*/, const std::string& /*initial_fixed_link*/)
 {
     yError() << " wholeBodyDynamics : resetSimpleLeggedOdometry method not implemented";
@@ -2244,14 +3245,297 @@ void WholeBodyDynamicsDevice::endCalibration()
     return;
 }
 
-wholeBodyDynamicsDeviceFilters::wholeBodyDynamicsDeviceFilters(): imuLinearAccelerationFilter(0),
-                                                                  imuAngularVelocityFilter(0),
-                                                                  forcetorqueFilters(0),
-                                                                  jntVelFilter(0),
-                                                                  jntAccFilter(0),
-                                                                  bufferYarp3(0),
-                                                                  bufferYarp6(0),
-                                                                  bufferYarpDofs(0)
+bool WholeBodyDynamicsDevice::enableOnlineCalibration(const bool enable)
+{
+    yarp::os::LockGuard guard(this->deviceMutex);
+
+    m_onlineCalibration.enabled = enable;
+    m_onlineCalibration.offsetEstimator.reset();
+    m_onlineCalibration.stillnessDetector.reset();
+
+    yInfo() << "wholeBodyDynamics : online calibration " << (enable ? "enabled" : "disabled")
+            << ", " << m_onlineCalibration.nrOfUpdates << " online updates of the offsets performed until now"
+            << " (" << m_onlineCalibration.nrOfRejectedUpdates << " skipped for a too large correction)";
+
+    if( enable && !m_onlineCalibration.isContactAssumptionExplicit )
+    {
+        yWarning() << "wholeBodyDynamics : the offsets will be updated only after a calib* RPC call sets the contacts assumed during calibration";
+    }
+
+    return true;
+}
+
+void WholeBodyDynamicsDevice::addTemperatureOffsetSample(const size_t ft)
+{
+    if( m_ftTemperatureChannels[ft] < 0 )
+    {
+        return;
+    }
+
+    // The offset of the processor refers to the reference temperature,
+    // the sample contains the total offset at the current temperature
+    iDynTree::Wrench temperatureOffset;
+    ftProcessors[ft].getTemperatureOffset(temperatureOffset);
+
+    m_ftTemperatureOffsetSamples[ft].addSample(ftTemperatures[ft],ftProcessors[ft].offset()+temperatureOffset);
+}
+
+bool WholeBodyDynamicsDevice::fitTemperatureOffsetModel(const int32_t order)
+{
+    yarp::os::LockGuard guard(this->deviceMutex);
+
+    if( order <= 0 || order > (int32_t)wholeBodyDynamics::SixAxisForceTorqueMeasureProcessor::maxTemperatureOffsetModelOrder )
+    {
+        yError() << "wholeBodyDynamics : fitTemperatureOffsetModel : order " << order << " is not supported, it should be between 1 and "
+                 << wholeBodyDynamics::SixAxisForceTorqueMeasureProcessor::maxTemperatureOffsetModelOrder;
+        return false;
+    }
+
+    bool ok = true;
+    bool atLeastOneSensorFitted = false;
+    for(size_t ft = 0; ft < ftProcessors.size(); ft++)
+    {
+        if( m_ftTemperatureChannels[ft] < 0 )
+        {
+            continue;
+        }
+
+        std::string sensorName = estimator.sensors().getSensor(iDynTree::SIX_AXIS_FORCE_TORQUE,ft)->getName();
+
+        std::vector<iDynTree::Vector6> coeffs;
+        if( !m_ftTemperatureOffsetSamples[ft].fitTemperatureOffsetModel((size_t)order,coeffs) )
+        {
+            yError() << "wholeBodyDynamics : fitTemperatureOffsetModel : the " << m_ftTemperatureOffsetSamples[ft].nrOfSamples()
+                     << " offsets recorded for sensor " << sensorName << " are not sufficient to fit a model of order " << order
+                     << ", calibrate the sensor at more temperatures";
+            ok = false;
+            continue;
+        }
+
+        // The offset remains the one at the reference temperature, only its correction changes
+        ftProcessors[ft].setTemperatureOffsetModel(coeffs);
+        atLeastOneSensorFitted = true;
+
+        // Print the model in the format of the FT_TEMPERATURE_COMPENSATION group, to save it in the configuration
+        std::stringstream modelString;
+        modelString << "(" << m_ftTemperatureChannels[ft];
+        for(size_t k=0; k < coeffs.size(); k++)
+        {
+            for(unsigned int j=0; j < 6; j++)
+            {
+                modelString << " " << coeffs[k](j);
+            }
+        }
+        modelString << ")";
+
+        yInfo() << "wholeBodyDynamics : fitTemperatureOffsetModel : fitted model for sensor " << sensorName << " from "
+                << m_ftTemperatureOffsetSamples[ft].nrOfSamples() << " offsets : " << sensorName << " " << modelString.str();
+    }
+
+    if( !atLeastOneSensorFitted )
+    {
+        yError() << "wholeBodyDynamics : fitTemperatureOffsetModel : no sensor with a temperature channel in the FT_TEMPERATURE_COMPENSATION group";
+    }
+
+    return ok && atLeastOneSensorFitted;
+}
+
+bool WholeBodyDynamicsDevice::initReplay()
+{
+    yarp::os::LockGuard guard(this->deviceMutex);
+
+    // Same default calibration set in attachAll
+    bool ok = this->setupCalibrationWithExternalWrenchOnOneFrame("base_link",100);
+    m_onlineCalibration.isContactAssumptionExplicit = false;
+    return ok;
+}
+
+bool WholeBodyDynamicsDevice::replayEstimationCycle(const wholeBodyDynamics::SensorsSnapshot& snapshot,
+                                                    iCub::skinDynLib::skinContactList* skinContacts)
+{
+    yarp::os::LockGuard guard(this->deviceMutex);
+
+    double runStart = yarp::os::SystemClock::nowSystem();
+
+    this->useSensorsSnapshot(snapshot);
+    double stageStart = updateStageTiming(STAGE_READ_SENSORS,runStart);
+
+    this->filterSensorsAndRemoveSensorOffsets();
+    stageStart = updateStageTiming(STAGE_FILTER_SENSORS,stageStart);
+
+    this->updateKinematics();
+    stageStart = updateStageTiming(STAGE_UPDATE_KINEMATICS,stageStart);
+
+    this->processContactPoints(skinContacts,snapshot.timestamp);
+    stageStart = updateStageTiming(STAGE_READ_CONTACT_POINTS,stageStart);
+
+    this->computeCalibration();
+    stageStart = updateStageTiming(STAGE_COMPUTE_CALIBRATION,stageStart);
+
+    this->computeExternalForcesAndJointTorques();
+    updateStageTiming(STAGE_COMPUTE_ESTIMATION,stageStart);
+
+    updateStageTiming(STAGE_TOTAL,runStart);
+
+    return estimationWentWell;
+}
+
+const iDynTree::Model& WholeBodyDynamicsDevice::getEstimatorModel() const
+{
+    return estimator.model();
+}
+
+const iDynTree::SensorsList& WholeBodyDynamicsDevice::getEstimatorSensors() const
+{
+    return estimator.sensors();
+}
+
+bool WholeBodyDynamicsDevice::isOffsetAvailable() const
+{
+    return validOffsetAvailable;
+}
+
+const iDynTree::JointDOFsDoubleArray& WholeBodyDynamicsDevice::getEstimatedJointTorques() const
+{
+    return estimatedJointTorques;
+}
+
+const iDynTree::LinkContactWrenches& WholeBodyDynamicsDevice::getEstimatedExternalContactWrenches() const
+{
+    return estimateExternalContactWrenches;
+}
+
+const iDynTree::SensorsMeasurements& WholeBodyDynamicsDevice::getFilteredSensorMeasurements() const
+{
+    return filteredSensorMeasurements;
+}
+
+const std::vector<wholeBodyDynamics::TimingStatistics>& WholeBodyDynamicsDevice::getStagesTimingStatistics() const
+{
+    return m_stagesTimingStatistics;
+}
+
+wholeBodyDynamicsSensorsAcquisitionThread::wholeBodyDynamicsSensorsAcquisitionThread(WholeBodyDynamicsDevice& device,
+                                                                                     int periodInMs): RateThread(periodInMs),
+                                                                                                      m_device(device)
+{
+
+}
+
+void wholeBodyDynamicsSensorsAcquisitionThread::run()
+{
+    m_device.acquireSensorsSnapshot();
+}
+
+wholeBodyDynamicsFilterParameters::wholeBodyDynamicsFilterParameters(): type(FIRST_ORDER_LOW_PASS_FILTER),
+                                                                        order(2),
+                                                                        notchFrequencyInHz(0.0),
+                                                                        notchBandwidthInHz(0.0)
+{
+
+}
+
+size_t wholeBodyDynamicsFilterParameters::getNrOfSections() const
+{
+    size_t nrOfSections = 1;
+
+    if( type == BUTTERWORTH_LOW_PASS_FILTER )
+    {
+        nrOfSections = iCub::ctrl::realTime::butterworthLowPassNrOfSections(order);
+    }
+
+    if( notchFrequencyInHz > 0.0 )
+    {
+        nrOfSections++;
+    }
+
+    return nrOfSections;
+}
+
+bool wholeBodyDynamicsFilterParameters::isValid(const double cutOffInHz, const double periodInSeconds) const
+{
+    double nyquistFrequencyInHz = 0.5/periodInSeconds;
+
+    if( cutOffInHz <= 0.0 )
+    {
+        return false;
+    }
+
+    if( type == BUTTERWORTH_LOW_PASS_FILTER &&
+        (order < 1 || order > wholeBodyDynamics_maxButterworthFilterOrder || cutOffInHz >= nyquistFrequencyInHz) )
+    {
+        return false;
+    }
+
+    if( notchFrequencyInHz > 0.0 &&
+        (notchBandwidthInHz <= 0.0 || notchFrequencyInHz >= nyquistFrequencyInHz) )
+    {
+        return false;
+    }
+
+    return true;
+}
+
+wholeBodyDynamicsSettingsEditor::wholeBodyDynamicsSettingsEditor(wholeBodyDynamicsSettings& settings,
+                                                                 std::atomic<bool>& kinematicSourceFramesChanged,
+                                                                 std::atomic<size_t>& filtersSettingsGeneration):
+                                                                 wholeBodyDynamicsSettings::Editor(settings),
+                                                                 m_kinematicSourceFramesChanged(kinematicSourceFramesChanged),
+                                                                 m_filtersSettingsGeneration(filtersSettingsGeneration)
+{
+}
+
+bool wholeBodyDynamicsSettingsEditor::did_set_fixedFrameName()
+{
+    m_kinematicSourceFramesChanged = true;
+    return true;
+}
+
+bool wholeBodyDynamicsSettingsEditor::did_set_imuFrameName()
+{
+    m_kinematicSourceFramesChanged = true;
+    return true;
+}
+
+bool wholeBodyDynamicsSettingsEditor::did_set_imuFilterCutoffInHz()
+{
+    m_filtersSettingsGeneration++;
+    return true;
+}
+
+bool wholeBodyDynamicsSettingsEditor::did_set_forceTorqueFilterCutoffInHz()
+{
+    m_filtersSettingsGeneration++;
+    return true;
+}
+
+bool wholeBodyDynamicsSettingsEditor::did_set_jointVelFilterCutoffInHz()
+{
+    m_filtersSettingsGeneration++;
+    return true;
+}
+
+bool wholeBodyDynamicsSettingsEditor::did_set_jointAccFilterCutoffInHz()
+{
+    m_filtersSettingsGeneration++;
+    return true;
+}
+
+wholeBodyDynamicsDeviceFilters::wholeBodyDynamicsDeviceFilters(): filterBank(),
+                                                                  signals(0),
+                                                                  nrOfFTSensors(0),
+                                                                  imuOffset(0),
+                                                                  jointVelOffset(0),
+                                                                  jointAccOffset(0),
+                                                                  nrOfDOFs(0),
+                                                                  periodInSeconds(1.0),
+                                                                  cutOffTransitionTimeInSeconds(0.0),
+                                                                  forceTorqueCutOffInHz(0.0),
+                                                                  imuCutOffInHz(0.0),
+                                                                  jointVelCutOffInHz(0.0),
+                                                                  jointAccCutOffInHz(0.0),
+                                                                  sectionNum(3,0.0),
+                                                                  sectionDen(3,0.0)
 {
 
 }
@@ -2264,80 +3548,167 @@ void wholeBodyDynamicsDeviceFilters::init(int nrOfFTSensors,
                                           double initialCutOffForJointAccInHz,
                                           double periodInSeconds)
 {
+    this->nrOfFTSensors = nrOfFTSensors;
+    this->nrOfDOFs = nrOfDOFsProcessed;
+    this->periodInSeconds = periodInSeconds;
+    imuOffset = 6*this->nrOfFTSensors;
+    jointVelOffset = imuOffset + 6;
+    jointAccOffset = jointVelOffset + this->nrOfDOFs;
+
+    size_t nrOfChannels = jointAccOffset + this->nrOfDOFs;
+
+    // All the channels have the same number of sections, the unused ones are pass-through
+    size_t nrOfSections = std::max(std::max(forceTorqueFilterParameters.getNrOfSections(),
+                                            imuFilterParameters.getNrOfSections()),
+                                   std::max(jointVelFilterParameters.getNrOfSections(),
+                                            jointAccFilterParameters.getNrOfSections()));
+
     // Allocate buffers
-    bufferYarp3.resize(3,0.0);
-    bufferYarp6.resize(6,0.0);
-    bufferYarpDofs.resize(nrOfDOFsProcessed,0.0);
+    signals.setZero(nrOfChannels);
+    filterBank.resize(nrOfChannels,nrOfSections);
+
+    // The initial coefficients are used immediately
+    filterBank.setTransitionLength(0);
 
-    imuLinearAccelerationFilter =
-        new iCub::ctrl::realTime::FirstOrderLowPassFilter(initialCutOffForIMUInHz,periodInSeconds,bufferYarp3);
-    imuAngularVelocityFilter =
-        new iCub::ctrl::realTime::FirstOrderLowPassFilter(initialCutOffForIMUInHz,periodInSeconds,bufferYarp3);
+    bool ok = true;
+    ok = setFilterCoefficients(0,imuOffset,forceTorqueFilterParameters,initialCutOffForFTInHz) && ok;
+    ok = setFilterCoefficients(imuOffset,6,imuFilterParameters,initialCutOffForIMUInHz) && ok;
+    ok = setFilterCoefficients(jointVelOffset,nrOfDOFs,jointVelFilterParameters,initialCutOffForJointVelInHz) && ok;
+    ok = setFilterCoefficients(jointAccOffset,nrOfDOFs,jointAccFilterParameters,initialCutOffForJointAccInHz) && ok;
 
-    forcetorqueFilters.resize(nrOfFTSensors);
-    for(int ft_numeric = 0; ft_numeric < nrOfFTSensors; ft_numeric++ )
+    if( !ok )
     {
-        forcetorqueFilters[ft_numeric] =
-                new iCub::ctrl::realTime::FirstOrderLowPassFilter(initialCutOffForFTInHz,periodInSeconds,bufferYarp6);
+        yWarning() << "wholeBodyDynamics : some of the filters parameters are not valid for a period of " << periodInSeconds << " seconds, the related filters are left as pass-through.";
     }
 
-    jntVelFilter =
-        new iCub::ctrl::realTime::FirstOrderLowPassFilter(initialCutOffForJointVelInHz,periodInSeconds,bufferYarpDofs);
-    jntAccFilter =
-        new iCub::ctrl::realTime::FirstOrderLowPassFilter(initialCutOffForJointAccInHz,periodInSeconds,bufferYarpDofs);
-}
+    forceTorqueCutOffInHz = initialCutOffForFTInHz;
+    imuCutOffInHz = initialCutOffForIMUInHz;
+    jointVelCutOffInHz = initialCutOffForJointVelInHz;
+    jointAccCutOffInHz = initialCutOffForJointAccInHz;
 
+    filterBank.setTransitionLength(static_cast<size_t>(std::floor(cutOffTransitionTimeInSeconds/periodInSeconds+0.5)));
+}
 
-void wholeBodyDynamicsDeviceFilters::updateCutOffFrequency(double cutoffForFTInHz,
-                                                           double cutOffForIMUInHz,
-                                                           double cutOffForJointVelInHz,
-                                                           double cutOffForJointAccInHz)
+bool wholeBodyDynamicsDeviceFilters::setFilterCoefficients(const size_t firstChannel,
+                                                           const size_t nrOfChannels,
+                                                           const wholeBodyDynamicsFilterParameters& params,
+                                                           const double cutOffInHz)
 {
-    imuLinearAccelerationFilter->setCutFrequency(cutOffForIMUInHz);
-    imuAngularVelocityFilter->setCutFrequency(cutOffForIMUInHz);
-
-    for(size_t ft_numeric = 0; ft_numeric < forcetorqueFilters.size(); ft_numeric++ )
+    // Invalid parameters leave the filters of the group unchanged
+    if( !params.isValid(cutOffInHz,periodInSeconds) )
     {
-        forcetorqueFilters[ft_numeric]->setCutFrequency(cutoffForFTInHz);
+        return false;
     }
 
-    jntVelFilter->setCutFrequency(cutOffForJointVelInHz);
-    jntAccFilter->setCutFrequency(cutOffForJointAccInHz);
-}
+    size_t section = 0;
 
-void wholeBodyDynamicsDeviceFilters::fini()
-{
-    if( imuLinearAccelerationFilter )
+    if( params.type == BUTTERWORTH_LOW_PASS_FILTER )
+    {
+        for(; section < iCub::ctrl::realTime::butterworthLowPassNrOfSections(params.order); section++)
+        {
+            iCub::ctrl::realTime::butterworthLowPassSectionCoeffs(params.order,section,cutOffInHz,periodInSeconds,sectionNum,sectionDen);
+            filterBank.setSectionCoeffs(section,firstChannel,nrOfChannels,sectionNum,sectionDen);
+        }
+    }
+    else
     {
-        delete imuLinearAccelerationFilter;
-        imuLinearAccelerationFilter = 0;
+        iCub::ctrl::realTime::firstOrderLowPassSectionCoeffs(cutOffInHz,periodInSeconds,sectionNum,sectionDen);
+        filterBank.setSectionCoeffs(section,firstChannel,nrOfChannels,sectionNum,sectionDen);
+        section++;
     }
 
-    if( imuAngularVelocityFilter )
+    if( params.notchFrequencyInHz > 0.0 )
     {
-        delete imuAngularVelocityFilter;
-        imuAngularVelocityFilter = 0;
+        iCub::ctrl::realTime::notchSectionCoeffs(params.notchFrequencyInHz,params.notchBandwidthInHz,periodInSeconds,sectionNum,sectionDen);
+        filterBank.setSectionCoeffs(section,firstChannel,nrOfChannels,sectionNum,sectionDen);
+        section++;
     }
 
-    for(size_t ft_numeric = 0; ft_numeric < forcetorqueFilters.size(); ft_numeric++ )
+    for(; section < filterBank.getNrOfSections(); section++)
     {
-        delete forcetorqueFilters[ft_numeric];
-        forcetorqueFilters[ft_numeric] = 0;
+        filterBank.setSectionPassThrough(section,firstChannel,nrOfChannels);
     }
 
-    forcetorqueFilters.resize(0);
+    return true;
+}
+
 
-    if( jntVelFilter )
+void wholeBodyDynamicsDeviceFilters::updateCutOffFrequency(double cutoffForFTInHz,
+                                                           double cutOffForIMUInHz,
+                                                           double cutOffForJointVelInHz,
+                                                           double cutOffForJointAccInHz)
+{
+    // Note: in general the equality between two doubles is not a
+    // reliable check, but in this case it make sense
+    if( cutoffForFTInHz != forceTorqueCutOffInHz &&
+        setFilterCoefficients(0,imuOffset,forceTorqueFilterParameters,cutoffForFTInHz) )
+    {
+        forceTorqueCutOffInHz = cutoffForFTInHz;
+    }
+
+    if( cutOffForIMUInHz != imuCutOffInHz &&
+        setFilterCoefficients(imuOffset,6,imuFilterParameters,cutOffForIMUInHz) )
     {
-        delete jntVelFilter;
-        jntVelFilter = 0;
+        imuCutOffInHz = cutOffForIMUInHz;
     }
 
-    if( jntAccFilter )
+    if( cutOffForJointVelInHz != jointVelCutOffInHz &&
+        setFilterCoefficients(jointVelOffset,nrOfDOFs,jointVelFilterParameters,cutOffForJointVelInHz) )
     {
-        delete jntAccFilter;
-        jntAccFilter = 0;
+        jointVelCutOffInHz = cutOffForJointVelInHz;
     }
+
+    if( cutOffForJointAccInHz != jointAccCutOffInHz &&
+        setFilterCoefficients(jointAccOffset,nrOfDOFs,jointAccFilterParameters,cutOffForJointAccInHz) )
+    {
+        jointAccCutOffInHz = cutOffForJointAccInHz;
+    }
+}
+
+void wholeBodyDynamicsDeviceFilters::filt()
+{
+    filterBank.filt(signals);
+}
+
+Eigen::VectorBlock<Eigen::VectorXd,6> wholeBodyDynamicsDeviceFilters::forceTorque(const size_t ft)
+{
+    return signals.segment<6>(6*ft);
+}
+
+Eigen::Map<Eigen::Matrix<double,6,Eigen::Dynamic> > wholeBodyDynamicsDeviceFilters::forceTorqueMeasurements()
+{
+    return Eigen::Map<Eigen::Matrix<double,6,Eigen::Dynamic> >(signals.data(),6,nrOfFTSensors);
+}
+
+Eigen::VectorBlock<Eigen::VectorXd,3> wholeBodyDynamicsDeviceFilters::imuLinearAcceleration()
+{
+    return signals.segment<3>(imuOffset);
+}
+
+Eigen::VectorBlock<Eigen::VectorXd,3> wholeBodyDynamicsDeviceFilters::imuAngularVelocity()
+{
+    return signals.segment<3>(imuOffset+3);
+}
+
+Eigen::VectorBlock<Eigen::VectorXd> wholeBodyDynamicsDeviceFilters::jointVelocities()
+{
+    return signals.segment(jointVelOffset,nrOfDOFs);
+}
+
+Eigen::VectorBlock<Eigen::VectorXd> wholeBodyDynamicsDeviceFilters::jointAccelerations()
+{
+    return signals.segment(jointAccOffset,nrOfDOFs);
+}
+
+void wholeBodyDynamicsDeviceFilters::fini()
+{
+    filterBank.resize(0,0);
+    signals.resize(0);
+    nrOfFTSensors = 0;
+    imuOffset = 0;
+    jointVelOffset = 0;
+    jointAccOffset = 0;
+    nrOfDOFs = 0;
 }
 
 wholeBodyDynamicsDeviceFilters::~wholeBodyDynamicsDeviceFilters()
@@ -30,7 +30,14 @@
 #include <wholeBodyDynamics_IDLServer.h>
 #include "SixAxisForceTorqueMeasureHelpers.h"
 #include "GravityCompensationHelpers.h"
-
+#include "SensorsAcquisitionHelpers.h"
+#include "ProfilingHelpers.h"
+#include "OnlineCalibrationHelpers.h"
+#include "SkinContactsIndexHelpers.h"
+#include <wholeBodyDynamicsSharedMemory/SharedMemoryRingBuffer.h>
+
+#include <atomic>
+#include <memory>
 #include <vector>
 
 
@@ -56,6 +63,57 @@ struct outputWrenchPortInformation
 };
 
 
+/**
+ * Type of the low pass filter used for a group of signals.
+ */
+enum wholeBodyDynamicsFilterType
+{
+    FIRST_ORDER_LOW_PASS_FILTER,
+    BUTTERWORTH_LOW_PASS_FILTER
+};
+
+/**
+ * Parameters of the filter used for a group of signals (F/T sensors, IMU, joint velocities or joint accelerations),
+ * loaded from the configuration. The cut frequency is part of the wholeBodyDynamicsSettings, as it can be changed at runtime.
+ */
+struct wholeBodyDynamicsFilterParameters
+{
+    wholeBodyDynamicsFilterType type;
+
+    ///< Order of the filter, used if type is BUTTERWORTH_LOW_PASS_FILTER
+    int order;
+
+    ///< Frequency rejected by a notch filter in cascade with the low pass filter, no notch is used if it is not positive
+    double notchFrequencyInHz;
+
+    ///< Width of the band rejected by the notch filter
+    double notchBandwidthInHz;
+
+    wholeBodyDynamicsFilterParameters();
+
+    /**
+     * Number of second order sections needed to implement the filter.
+     */
+    size_t getNrOfSections() const;
+
+    /**
+     * Check if the parameters (together with the given cut frequency) describe
+     * a filter that can be implemented with the given sample time.
+     */
+    bool isValid(const double cutOffInHz, const double periodInSeconds) const;
+};
+
+/**
+ * Filters of the input measurements.
+ *
+ * All the filtered signals are stored in a single contiguous vector, with the layout:
+ * [ F/T sensors (6 for each sensor) | IMU linear acc (3) | IMU angular vel (3) | joint vel (dofs) | joint acc (dofs) ]
+ * and they are filtered in a single pass by a iCub::ctrl::realTime::SecondOrderSectionsFilterBank,
+ * so that no memory is allocated after init and no temporary YARP vector is used.
+ *
+ * The type of filter of each group of signals is specified by the corresponding wholeBodyDynamicsFilterParameters,
+ * that should be set before calling init.
+ */
 class wholeBodyDynamicsDeviceFilters
 {
     public:
@@ -73,10 +131,21 @@ class wholeBodyDynamicsDeviceFilters
               double initialCutOffForJointAccInHz,
               double periodInSeconds);
 
+    /**
+     * Update the cut frequencies of the filters. The coefficients of a group of signals
+     * are recomputed only if its cut frequency changed, and are moved to the new values
+     * in cutOffTransitionTimeInSeconds, while the internal state of the filters is preserved.
+     */
     void updateCutOffFrequency(double cutOffForFTInHz,
                                double cutOffForIMUInHz,
                                double cutOffForJointVelInHz,
                                double cutOffForJointAccInHz);
+
+    /**
+     * Filter all the signals, the filtered values overwrite the raw ones.
+     */
+    void filt();
+
     /**
      * Deallocate the filters
      */
@@ -85,29 +154,118 @@ class wholeBodyDynamicsDeviceFilters
 
     ~wholeBodyDynamicsDeviceFilters();
 
-    ///<  low pass filters for IMU linear accelerations
-    iCub::ctrl::realTime::FirstOrderLowPassFilter * imuLinearAccelerationFilter;
+    ///< Segment of the signals buffer relative to the ft-th F/T sensor
+    Eigen::VectorBlock<Eigen::VectorXd,6> forceTorque(const size_t ft);
+
+    ///< Segment of the signals buffer relative to all the F/T sensors, as a 6 x nrOfFTSensors matrix
+    Eigen::Map<Eigen::Matrix<double,6,Eigen::Dynamic> > forceTorqueMeasurements();
+
+    ///< Segment of the signals buffer relative to the IMU linear acceleration
+    Eigen::VectorBlock<Eigen::VectorXd,3> imuLinearAcceleration();
+
+    ///< Segment of the signals buffer relative to the IMU angular velocity
+    Eigen::VectorBlock<Eigen::VectorXd,3> imuAngularVelocity();
+
+    ///< Segment of the signals buffer relative to the joint velocities
+    Eigen::VectorBlock<Eigen::VectorXd> jointVelocities();
+
+    ///< Segment of the signals buffer relative to the joint accelerations
+    Eigen::VectorBlock<Eigen::VectorXd> jointAccelerations();
 
-    ///< low pass filters for IMU angular velocity
-    iCub::ctrl::realTime::FirstOrderLowPassFilter * imuAngularVelocityFilter;
+    ///< Parameters of the filters of each group of signals
+    wholeBodyDynamicsFilterParameters forceTorqueFilterParameters;
+    wholeBodyDynamicsFilterParameters imuFilterParameters;
+    wholeBodyDynamicsFilterParameters jointVelFilterParameters;
+    wholeBodyDynamicsFilterParameters jointAccFilterParameters;
 
-    ///< low pass filters for ForceTorque sensors
-    std::vector<iCub::ctrl::realTime::FirstOrderLowPassFilter *> forcetorqueFilters;
+    ///< filters for all the signals
+    iCub::ctrl::realTime::SecondOrderSectionsFilterBank filterBank;
 
-    ///< low pass filter for Joint velocities
-    iCub::ctrl::realTime::FirstOrderLowPassFilter * jntVelFilter;
+    ///< buffer of all the signals, both raw (before filt()) and filtered (after filt())
+    Eigen::VectorXd signals;
 
-    ///< low pass filter for Joint accelerations
-    iCub::ctrl::realTime::FirstOrderLowPassFilter * jntAccFilter;
+    ///< Offsets of the different groups of signals in the signals buffer
+    size_t nrOfFTSensors;
+    size_t imuOffset;
+    size_t jointVelOffset;
+    size_t jointAccOffset;
+    size_t nrOfDOFs;
 
-    ///< Yarp vector buffer of dimension 3
-    yarp::sig::Vector bufferYarp3;
+    ///< Sample time of the filters
+    double periodInSeconds;
 
-    ///< Yarp vector buffer of dimension 6
-    yarp::sig::Vector bufferYarp6;
+    ///< Duration of the transition of the filters coefficients after a change of the cut frequency, should be set before init
+    double cutOffTransitionTimeInSeconds;
 
-    ///< Yarp vector buffer of dimension dofs
-    yarp::sig::Vector bufferYarpDofs;
+    ///< Cut frequencies currently used by the filters
+    double forceTorqueCutOffInHz;
+    double imuCutOffInHz;
+    double jointVelCutOffInHz;
+    double jointAccCutOffInHz;
+
+    ///< Buffers for the coefficients of a section
+    yarp::sig::Vector sectionNum;
+    yarp::sig::Vector sectionDen;
+
+    private:
+    /**
+     * Set the coefficients of the filters of a group of signals, given its cut frequency.
+     */
+    bool setFilterCoefficients(const size_t firstChannel,
+                               const size_t nrOfChannels,
+                               const wholeBodyDynamicsFilterParameters & params,
+                               const double cutOffInHz);
+};
+
+/**
+ * Editor of the settings used as reader of the settings port.
+ *
+ * The hooks called after a setting is written through the port mark the change,
+ * so that the estimation thread updates the quantities that depend on the settings
+ * (the indices of the kinematic source frames and the coefficients of the filters)
+ * only after they are changed, without comparing the settings at each cycle.
+ */
+class wholeBodyDynamicsSettingsEditor : public wholeBodyDynamicsSettings::Editor
+{
+private:
+    std::atomic<bool> & m_kinematicSourceFramesChanged;
+    std::atomic<size_t> & m_filtersSettingsGeneration;
+
+public:
+    /**
+     * @param kinematicSourceFramesChanged flag set when imuFrameName or fixedFrameName is written
+     * @param filtersSettingsGeneration counter increased when a filter cutoff is written
+     */
+    wholeBodyDynamicsSettingsEditor(wholeBodyDynamicsSettings & settings,
+                                    std::atomic<bool> & kinematicSourceFramesChanged,
+                                    std::atomic<size_t> & filtersSettingsGeneration);
+
+    virtual bool did_set_fixedFrameName();
+    virtual bool did_set_imuFrameName();
+    virtual bool did_set_imuFilterCutoffInHz();
+    virtual bool did_set_forceTorqueFilterCutoffInHz();
+    virtual bool did_set_jointVelFilterCutoffInHz();
+    virtual bool did_set_jointAccFilterCutoffInHz();
+};
+
+class WholeBodyDynamicsDevice;
+
+/**
+ * Thread used to acquire the sensors measurements
+ * when the useSensorsAcquisitionThread option is enabled.
+ *
+ * The thread fills the sensors snapshot buffer of the device,
+ * so that the estimation thread does not have to wait for the
+ * (possibly remote) sensors devices.
+ */
+class wholeBodyDynamicsSensorsAcquisitionThread : public yarp::os::RateThread
+{
+    WholeBodyDynamicsDevice & m_device;
+
+public:
+    wholeBodyDynamicsSensorsAcquisitionThread(WholeBodyDynamicsDevice & device, int periodInMs);
+
+    virtual void run();
 };
 
 /**
@@ -122,16 +280,28 @@ class wholeBodyDynamicsDeviceFilters
  * | assume_fixed    |                | frame name        |   -   |     -         | No       | If it is present, the initial kinematic source used for estimation will be that specified frame is fixed, and its gravity is specified by fixedFrameGravity. Otherwise, the default IMU will be used. | |
  * | fixedFrameGravity  |      -     | vector of doubles | m/s^2 | -             | Yes      | Gravity of the frame that is assumed to be fixed, if the kinematic source used is the fixed frame. | |
  * | imuFrameName   |       -        | string            |   -   |      -        | Yes      | Name of the frame (in the robot model) with respect to which the IMU broadcast its sensor measurements. |  |
- * | imuFilterCutoffInHz |     -     | double            | Hz    |      -        | Yes      | Cutoff frequency of the filter used to filter IMU measures. | The used filter is a simple first order filter. |
- * | forceTorqueFilterCutoffInHz | - | double            | Hz    |      -        | Yes      | Cutoff frequency of the filter used to filter FT measures.  |  The used filter is a simple first order filter. |
- * | jointVelFilterCutoffInHz    | - | double            | Hz    |      -        | Yes      | Cutoff frequency of the filter used to filter joint velocities measures. | The used filter is a simple first order filter. |
- * | jointAccFilterCutoffInHz    | - | double            | Hz    |      -        | Yes      | Cutoff frequency of the filter used to filter joint accelerations measures. | The used filter is a simple first order filter. |
+ * | imuFilterCutoffInHz |     -     | double            | Hz    |      3.0      | No       | Cutoff frequency of the filter used to filter IMU measures. | The type of filter is selected by imuFilterType. |
+ * | forceTorqueFilterCutoffInHz | - | double            | Hz    |      3.0      | No       | Cutoff frequency of the filter used to filter FT measures.  | The type of filter is selected by forceTorqueFilterType. |
+ * | jointVelFilterCutoffInHz    | - | double            | Hz    |      3.0      | No       | Cutoff frequency of the filter used to filter joint velocities measures. | The type of filter is selected by jointVelFilterType. |
+ * | jointAccFilterCutoffInHz    | - | double            | Hz    |      3.0      | No       | Cutoff frequency of the filter used to filter joint accelerations measures. | The type of filter is selected by jointAccFilterType. |
+ * | *signal*FilterType   |        - | string            |  -    |   firstOrder  |  No      | Type of low pass filter used for the *signal* measures, where *signal* is one of imu, forceTorque, jointVel or jointAcc. Possible values are firstOrder and butterworth. | See the Filters section. |
+ * | *signal*FilterOrder  |        - | int               |  -    |      2        |  No      | Order of the filter used for the *signal* measures, if *signal*FilterType is butterworth. | Orders from 1 to 8 are supported. |
+ * | *signal*NotchFrequencyInHz |  - | double            | Hz    |      -        |  No      | If present, a notch filter rejecting this frequency is added in cascade to the low pass filter of the *signal* measures. | The frequency should be smaller than the Nyquist frequency. |
+ * | *signal*NotchBandwidthInHz |  - | double            | Hz    |      -        |  No      | Width of the band rejected by the notch filter of the *signal* measures. | Required if *signal*NotchFrequencyInHz is present. |
+ * | filterCutoffTransitionTimeInSeconds | - | double       | s     |      0.1      |  No      | Duration of the transition of the filters coefficients when a cutoff frequency is changed at runtime. | If 0.0, the new coefficients are used immediately. |
  * | defaultContactFrames      | -   | vector of strings (name of frames ) |-| - |  Yes     | Vector of default contact frames. If no external force read from the skin is found on a given submodel, the defaultContactFrames list is scanned and the first frame found on the submodel is the one at which origin the unknown contact force is assumed to be. | - |
  * | alwaysUpdateAllVirtualTorqueSensors | -     |  bool |  -    |      -        |  Yes     | Enforce that a virtual sensor for each estimated axes is available. | Tipically this is set to false when the device is running in the robot, while to true if it is running outside the robot. |
  * | defaultContactFrames |      -   | vector of strings |  -    |    -          | Yes      | If not data is read from the skin, specify the location of the default contacts | For each submodel induced by the FT sensor, the first not used frame that belongs to that submodel is selected from the list. An error is raised if not suitable frame is found for a submodel. |
  * | useJointVelocity     |        - | bool              |  -    |      true     |  No      | Select if the measured joint velocities (read from the getEncoderSpeeds method) are used for estimation, or if they should be forced to 0.0 . | The default value of true is deprecated, and in the future the parameter will be required. |
  * | useJointAcceleration |        - | bool              |  -    |      true     |  No      | Select if the measured joint accelerations (read from the getEncoderAccelerations method) are used for estimation, or if they should be forced to 0.0 . | The default value of true is deprecated, and in the future the parameter will be required. |
+ * | maxNrOfSkinContacts  |        - | int               |  -    |      32       |  No      | Maximum number of contacts read from the skin that are used for estimation. | If the skin reports more contacts, each exceeding one is merged with the closest contact of the same link, or discarded if there is none. |
+ * | maxNrOfSkinContactsPerLink |  - | int               |  -    |      0        |  No      | If positive, the closest contacts of each link are merged until the link has at most this number of contacts. | The merged contact point is the pressure-weighted mean of the contact points, and the merged contact has the most general type of the two (so the number of unknowns does not increase). Contacts with known force directions more than 30 degrees apart are not merged. |
+ * | skinContactsMergeDistanceInMeters | - | double     |  m    |      0.0      |  No      | Contacts of the same link closer than this distance are merged in a single contact. | If 0.0, contacts are merged only to respect maxNrOfSkinContactsPerLink. |
  * | streamFilteredFT     |        - | bool              |  -    |      false    |  No      | Select if the filtered and offset removed forces will be streamed or not. The name of the ports have the following syntax:  portname=(portPrefix+"/filteredFT/"+sensorName). Example: "myPrefix/filteredFT/l_leg_ft_sensor" | The value streamed by this ports is affected by the secondary calibration matrix, the estimated offset and temperature coefficients ( if any ). |
+ * | devicePeriodInSeconds |       - | double            | s     |      0.01     |  No      | Period of the estimation thread. | |
+ * | useSensorsAcquisitionThread | - | bool              |  -    |      false    |  No      | If true, the sensors (encoders, F/T and IMU) are read by a separate thread, and the estimation thread uses the latest complete measurements, see the SensorsAcquisitionThread section. | |
+ * | sensorsAcquisitionPeriodInSeconds | - | double      | s     | devicePeriodInSeconds | No | Period of the sensors acquisition thread, used only if useSensorsAcquisitionThread is true. | |
+ * | streamTimingStatistics |      - | bool              |  -    |      false    |  No      | Select if the timing statistics of the estimation stages will be streamed on the port portPrefix+"/timing:o", see the Profiling section. | |
  * | IDYNTREE_SKINDYNLIB_LINKS |  -  | group             | -     | -             | Yes      |  Group describing the mapping between link names and skinDynLib identifiers. | |
  * |                |   linkName_1   | string (name of a link in the model) | - | - | Yes   | Bottle of three elements describing how the link with linkName is described in skinDynLib: the first element is the name of the frame in which the contact info is expressed in skinDynLib (tipically DH frames), the second a integer describing the skinDynLib BodyPart , and the third a integer describing the skinDynLib LinkIndex  | |
  * |                |   ...   | string (name of a link in the model) | - | -     | Yes      | Bottle of three elements describing how the link with linkName is described in skinDynLib: the first element is the name of the frame in which the contact info is expressed in skinDynLib (tipically DH frames), the second a integer describing the skinDynLib BodyPart , and the third a integer describing the skinDynLib LinkIndex  | |
@@ -144,6 +314,7 @@ class wholeBodyDynamicsDeviceFilters
  * |                      | enableGravityCompensation | bool | -  | -           | No        |  |  |
  * |                      | gravityCompensationBaseLink| string | - | -         | No        | ..  | |
  * |                      | gravityCompensationAxesNames | vector of strings | - | - | No   | Axes for which the gravity compensation is published. | |
+ * |                      | gravityCompensationModesRefreshPeriodInSeconds | double | s | 0.0 | No | Period at which the control and interaction modes of the gravity compensation axes are read from the controlboards. | If 0.0, the modes are read at each estimation cycle. |
  *
  * The axes contained in the axesNames parameter are then mapped to the wrapped controlboard in the attachAll method, using controlBoardRemapper class.
  * Furthermore are also used to match the yarp axes to the joint names found in the passed URDF file.
@@ -155,6 +326,41 @@ class wholeBodyDynamicsDeviceFilters
  * at which all external forces are exerted.
  * Tipically this estimates are provided only for the upper joints (arms and torso) of the robots, as the gravity
  * compensation terms for the legs depends on the support state of the robot.
+ * As the gravity compensation torques are computed assuming zero velocities and accelerations, only the
+ * orientations of the links are propagated from the frame used as kinematic source to compute
+ * the acceleration of each link, instead of running a full velocity and acceleration kinematic pass.
+ * The control and interaction modes of all the gravity compensation axes are read with a single
+ * IControlMode2::getControlModes and IInteractionMode::getInteractionModes call, and they are cached for
+ * gravityCompensationModesRefreshPeriodInSeconds, so that in the other cycles only the setImpedanceOffset
+ * calls for the axes that need the gravity compensation are performed.
+ *
+ * \subsection OnlineCalibration
+ * Beside the calibration of the F/T sensors offsets requested through the calib* RPC methods (that
+ * require the robot to stay still for the requested number of samples), the offsets can be continuously
+ * updated while the robot is running. When the online calibration is enabled and a valid offset is available,
+ * the robot is considered still if its joint positions move less than stillnessJointPosThresholdInDeg
+ * from the position at which it stopped and the (filtered) IMU angular velocity is below stillnessIMUAngularVelThresholdInDegPerSec.
+ * While the robot is still, the residuals between the measured F/T and the ones predicted assuming that the external
+ * forces act only on the links used for the last calibration are collected, and after
+ * nrOfSamplesPerUpdate samples, if the standard deviation of the force residuals is below maxForceStdDevInNewton,
+ * the offsets are moved towards the mean residuals by offsetUpdateGain. If the robot moves, the collected samples are discarded.
+ * The offsets are not updated (and a warning is printed) if the force correction of any sensor is larger than
+ * maxOffsetCorrectionInNewton, as a constant unmodeled external force (e.g. the robot leaning on a table or holding an object)
+ * would otherwise be absorbed by the offsets.
+ * The offsets are updated only after the contacts assumed during calibration are set by a calib* RPC call:
+ * the default assumption (base_link) is not used.
+ * The online calibration can also be enabled or disabled with the enableOnlineCalibration RPC method.
+ *
+ * | Parameter name | SubParameter   | Type              | Units | Default Value | Required |   Description                                                     | Notes |
+ * |:--------------:|:--------------:|:-----------------:|:-----:|:-------------:|:--------:|:-----------------------------------------------------------------:|:-----:|
+ * | ONLINE_FT_CALIBRATION | -       | group             | -     | -             | No       |  Group for the online calibration of the F/T sensors offsets. | |
+ * |                | enableOnlineCalibration | bool     | -     | false         | No       |  Enable the online calibration at startup. | |
+ * |                | stillnessJointPosThresholdInDeg | double | deg | 0.2         | No       |  Maximum motion of the joints for which the robot is considered still. | |
+ * |                | stillnessIMUAngularVelThresholdInDegPerSec | double | deg/s | 1.0 | No  |  Maximum IMU angular velocity for which the robot is considered still. | |
+ * |                | nrOfSamplesPerUpdate | int        | -     | 100           | No       |  Number of still samples used for each update of the offsets. | |
+ * |                | offsetUpdateGain | double         | -     | 0.1           | No       |  Gain (between 0 and 1) of each update of the offsets. | |
+ * |                | maxForceStdDevInNewton | double   | N     | 1.0           | No       |  Maximum standard deviation of the force residuals for which the offsets are updated. | |
+ * |                | maxOffsetCorrectionInNewton | double | N    | 5.0           | No       |  Maximum norm of the force correction of the offsets for which the offsets are updated. | |
  *
  * \subsection SecondaryCalibrationMatrix
  * This device support to specify a secondary calibration matrix to apply on the top of the (already calibrated) measure coming from the F/T sensors.
@@ -170,6 +376,26 @@ class wholeBodyDynamicsDeviceFilters
  *
  * All sensors not specified will use a 6x6 identity as a secondary calibration matrix.
  *
+ * \subsection TemperatureCompensation
+ * The offset of the F/T sensors can be compensated for the thermal drift, using a polynomial model
+ * of the offset as a function of the temperature of the sensor, read from an additional channel of the analog sensor.
+ * The offset computed by the calibration is associated to the temperature at the end of the calibration, and
+ * at each cycle the offset is corrected with the model for the difference between the current temperature and that one.
+ * The offsets computed by the calibrations (and by the online calibration updates) of the sensors with a temperature
+ * channel are recorded with the temperature at which they were computed (up to the last 1000 offsets of each sensor).
+ * The fitTemperatureOffsetModel RPC method fits the coefficients of the model of the given order from these offsets
+ * with linear least squares, uses the fitted model and prints it in the format of the FT_TEMPERATURE_COMPENSATION
+ * group, so that it can be saved in the configuration. To record the offsets before a model is available,
+ * only the temperature channel can be specified for a sensor.
+ *
+ * | Parameter name | SubParameter   | Type              | Units | Default Value | Required |   Description                                                     | Notes |
+ * |:--------------:|:--------------:|:-----------------:|:-----:|:-------------:|:--------:|:-----------------------------------------------------------------:|:-----:|
+ * | FT_TEMPERATURE_COMPENSATION |  -  | group          | -     | -             | No       |  Group for providing the temperature offset model of the FT sensors. |   |
+ * |                | ftSensorName_1 | vector of 1+6*n doubles | -  | -             | No       |  The first element is the channel of the analog sensor containing the temperature, followed by the coefficients c_1 .. c_n (6 elements each) of the powers of the temperature. | n can be at most 3, if n is 0 the temperature is only used to record the offsets. |
+ * |                | ...            | ..                | -     | -             | No       |  .. |   |
+ *
+ * All sensors not specified are not compensated for the temperature.
+ *
  * Example of part of a configuration file using .xml yarprobotinterface format (remember to put the fractional dot!).
  * \code{.xml}
  *      <group name="FT_SECONDARY_CALIBRATION">
@@ -188,8 +414,69 @@ class wholeBodyDynamicsDeviceFilters
  *      </group>
  * \endcode
  *
+ * \subsection SensorsAcquisitionThread
+ * By default the sensors are read at the beginning of each estimation cycle, so the time spent
+ * waiting for the sensors devices (that can be remote devices) is part of the estimation cycle.
+ * If the useSensorsAcquisitionThread option is enabled, the sensors are instead read by a separate thread
+ * that publishes a complete snapshot of the measurements at each acquisition cycle. The estimation thread
+ * just takes the latest available snapshot without locking, so its timing does not depend on the sensors devices.
+ * If a new snapshot is not available, the estimation thread uses again the last one.
+ * As in the synchronous case, the joint velocities and accelerations and the IMU are read only if they are
+ * used by the current settings (useJointVelocity, useJointAcceleration and kinematicSource).
+ *
+ * \subsection Profiling
+ * The duration of each stage of the estimation cycle (and the period between two consecutive cycles)
+ * is always measured, and running statistics (min, mean, max and percentiles) are kept for each stage.
+ * The statistics can be read with the getTimingStatistics RPC command, and reset with resetTimingStatistics.
+ * If streamTimingStatistics is true, the statistics are also streamed at each cycle on the port portPrefix+"/timing:o":
+ * for each stage (in the order period, readSensors, filterSensorsAndRemoveSensorOffsets, updateKinematics,
+ * readContactPoints, computeCalibration, computeExternalForcesAndJointTorques, publishEstimatedQuantities, total)
+ * the vector contains seven elements: the last, minimum, mean and maximum duration and the 50th, 90th and 99th
+ * percentiles of the duration, all in seconds. The percentiles have the resolution of the histogram bins (5 us).
+ *
+ * \subsection OfflineReplay
+ * The wholeBodyDynamicsReplay executable runs the estimation of the device on the measurements
+ * logged by yarpdatadumper (encoders, F/T sensors, IMU and optionally skin contacts), as fast as possible
+ * and without any robot or YARP server, saving the estimated joint torques and external wrenches to file.
+ * The executable is compiled if the CODYCO_BUILD_TOOLS option is enabled, see the documentation in replay/main.cpp for its configuration.
+ *
+ * \subsection SharedMemoryOutput
+ * The estimated joint torques, the net external wrenches of each link and the filtered F/T measurements (without offset)
+ * can also be published in POSIX shared memory ring buffers, so that the consumers running on the same machine
+ * (such as a joint torque controller) can read the latest estimate without any serialization or network transport.
+ * Each sample is written with a sequence number and a timestamp, see wholeBodyDynamics::SharedMemoryRingBufferWriter
+ * for the memory layout and wholeBodyDynamics::SharedMemoryRingBufferReader for reading it: both are in the
+ * installed wholeBodyDynamicsSharedMemory library (header wholeBodyDynamicsSharedMemory/SharedMemoryRingBuffer.h),
+ * that the consumers can link without depending on the device.
+ * The samples are written right after the estimation, before the estimates are published on the YARP ports.
+ *
+ * | Parameter name | SubParameter   | Type              | Units | Default Value | Required |   Description                                                     | Notes |
+ * |:--------------:|:--------------:|:-----------------:|:-----:|:-------------:|:--------:|:-----------------------------------------------------------------:|:-----:|
+ * | SHARED_MEMORY_OUTPUT |   -      | group             | -     | -             | No       |  Group for configuring the shared memory output.                 | If not present, no shared memory is used. |
+ * |                | name           | string            | -     | -             | Yes      |  Prefix of the name of the shared memory objects, in the form /name. | The objects name+"_jointTorques", name+"_externalWrenches" and name+"_filteredFT" are created. |
+ * |                | nrOfSlots      | int               | -     | 8             | No       |  Number of samples in each ring buffer. | At least 2. |
+ *
+ * The jointTorques buffer contains the estimated torques in the order of the DOFs of the model (the same used for the virtual
+ * analog sensors), the externalWrenches buffer
+ * contains the 6 elements (force and torque) of the net external wrench of each link of the model, expressed
+ * in the link frame, and the filteredFT buffer contains the 6 elements of each F/T sensor in the order of the model.
+ *
  * \subsection Filters
- * All the filters used for the input measurements are using the iCub::ctrl::realTime::FirstOrderLowPassFilter class.
+ * All the input measurements are stored in a single buffer and filtered in a single pass
+ * using the iCub::ctrl::realTime::SecondOrderSectionsFilterBank class.
+ * For each group of signals (IMU, F/T sensors, joint velocities and joint accelerations) the type of
+ * low pass filter can be selected with the *signal*FilterType parameter:
+ * - firstOrder : first order low pass filter, the same implemented by iCub::ctrl::realTime::FirstOrderLowPassFilter (default),
+ * - butterworth : Butterworth low pass filter of order *signal*FilterOrder, implemented as a cascade of second order sections.
+ *   For a given attenuation of the high frequency noise, it introduces less delay than a first order filter.
+ *
+ * Optionally, a notch filter can be added in cascade to the low pass filter of each group of signals, to reject
+ * a narrow band of frequencies (for example, a known mechanical resonance) without reducing the low pass cutoff.
+ * The cut frequency of the low pass filters can be changed at runtime using the set_*FilterCutoffInHz RPC methods
+ * (that reject the cutoffs that are not valid for the used filter) or the settings port:
+ * the coefficients of the filters are recomputed only when a cutoff is changed, and they are linearly
+ * interpolated to the new values in filterCutoffTransitionTimeInSeconds, while the internal state of
+ * the filters is preserved, so that the filtered signals do not jump.
  *
  * \subsection ConfigurationExamples
  *
@@ -273,6 +560,8 @@ class WholeBodyDynamicsDevice :  public yarp::dev::DeviceDriver,
                                  public yarp::os::RateThread,
                                  public wholeBodyDynamics_IDLServer
 {
+    friend class wholeBodyDynamicsSensorsAcquisitionThread;
+
     struct imuMeasurements
     {
         iDynTree::Vector3 linProperAcc;
@@ -357,7 +646,7 @@ private:
      * a YARP RPC port.
      */
     wholeBodyDynamicsSettings settings;
-    wholeBodyDynamicsSettings::Editor settingsEditor;
+    wholeBodyDynamicsSettingsEditor settingsEditor;
 
     /**
      * Mutex to protect the settings data structure, and all the data in
@@ -385,6 +674,7 @@ private:
     bool openSkinContactListPorts(os::Searchable& config);
     bool openExternalWrenchesPorts(os::Searchable& config);    
     bool openFilteredFTPorts(os::Searchable& config);
+    bool openSharedMemoryOutput(os::Searchable& config);
 
     /**
      * Close-related methods
@@ -445,17 +735,127 @@ private:
      * the internal buffers, false otherwise.
      */
     bool readFTSensors(bool verbose=true);
+    bool readFTSensors(iDynTree::SensorsMeasurements & ftMeasurements,
+                       std::vector<double> & ftTemperatures,
+                       yarp::sig::Vector & ftBuffer,
+                       bool verbose=true);
 
     /**
      * Return true if we were able to read the sensors and update
      * the internal buffers, false otherwise.
      */
     bool readIMUSensors(bool verbose=true);
+    bool readIMUSensors(iDynTree::Vector3 & linProperAcc,
+                        iDynTree::Vector3 & angularVel,
+                        yarp::sig::Vector & imuBuffer,
+                        bool verbose=true);
+
+    /**
+     * Read joint positions, velocities and accelerations (converting them to radians).
+     * If readVel (readAcc) is false, the velocities (accelerations) are set to zero.
+     */
+    bool readJointSensors(iDynTree::JointPosDoubleArray & pos,
+                          iDynTree::JointDOFsDoubleArray & vel,
+                          iDynTree::JointDOFsDoubleArray & acc,
+                          bool readVel,
+                          bool readAcc);
     void readSensors();
+
+    /**
+     * Sensors acquisition thread related methods and attributes.
+     */
+
+    /**
+     * Read the sensors and publish them in sensorsSnapshots,
+     * called by the acquisition thread.
+     */
+    void acquireSensorsSnapshot();
+
+    /**
+     * Copy from the settings to the acquisition thread which optional sensors
+     * have to be read, called by the estimation thread.
+     */
+    void updateSensorsToAcquire();
+
+    /**
+     * Copy the latest snapshot published by the acquisition thread in the estimation buffers.
+     */
+    void readSensorsFromAcquisitionThread();
+
+    /**
+     * Copy a sensors snapshot in the estimation buffers.
+     */
+    void useSensorsSnapshot(const wholeBodyDynamics::SensorsSnapshot & snapshot);
+
+    bool useSensorsAcquisitionThread;
+    double sensorsAcquisitionPeriodInSeconds;
+    std::unique_ptr<wholeBodyDynamicsSensorsAcquisitionThread> sensorsAcquisitionThread;
+    wholeBodyDynamics::SensorsSnapshotBuffer sensorsSnapshots;
+
+    /**
+     * Optional sensors read by the acquisition thread. They are a copy of
+     * the settings, that can not be accessed by the acquisition thread without
+     * locking the deviceMutex.
+     */
+    std::atomic<bool> acquireJointVelocities;
+    std::atomic<bool> acquireJointAccelerations;
+    std::atomic<bool> acquireIMU;
+
+    /**
+     * Buffers used only by the acquisition thread: the last acquired measurements
+     * (used if a sensor read fails, as in the synchronous case) and the YARP buffers.
+     */
+    struct
+    {
+        wholeBodyDynamics::SensorsSnapshot lastSnapshot;
+        yarp::sig::Vector ftMeasurement;
+        yarp::sig::Vector imuMeasurement;
+    } acquisitionBuffers;
     void filterSensorsAndRemoveSensorOffsets();
     void updateKinematics();
     void readContactPoints();
+
+    /**
+     * Indices in the estimator model of the frames used as kinematic source,
+     * resolved from settings.imuFrameName and settings.fixedFrameName when they are
+     * set (in open and in the useIMUAsKinematicSource and useFixedFrameAsKinematicSource
+     * RPC methods) or when they are changed through the settings port,
+     * so that updateKinematics does not look up frames by name at each cycle.
+     */
+    iDynTree::FrameIndex m_imuFrameIndex;
+    iDynTree::FrameIndex m_fixedFrameIndex;
+
+    /**
+     * Set by the settings editor when the kinematic source frames are written through the settings port.
+     */
+    std::atomic<bool> m_kinematicSourceFramesChanged;
+
+    /**
+     * Resolve the indices of the frames used as kinematic source.
+     *
+     * @return false if the frame of the current kinematic source is not in the model.
+     */
+    bool resolveKinematicSourceFrames();
+
+    /**
+     * Resolve again the indices of the frames used as kinematic source if their
+     * names were changed through the settings port, called at each cycle by updateKinematics.
+     */
+    void updateKinematicSourceFrames();
+
+    /**
+     * Compute the contact locations from the skin contacts (that can be null if no new
+     * contact list was received), given the current time (used for the skin timeout).
+     */
+    void processContactPoints(iCub::skinDynLib::skinContactList * scl, const double now);
+
     void computeCalibration();
+
+    /**
+     * Update the F/T offsets online, if the robot is still.
+     */
+    void computeOnlineCalibration();
+
     void computeExternalForcesAndJointTorques();
 
 
@@ -463,17 +863,55 @@ private:
     // Publish related methods
     void publishTorques();
     void publishContacts();
+    void computeNetExternalWrenches();
     void publishExternalWrenches();
     void publishEstimatedQuantities();
     void publishGravityCompensation();
     void publishFilteredFTWithoutOffset();
+    void publishSharedMemoryOutput();
+
+    /**
+     * Profiling related methods and attributes.
+     */
+    enum wholeBodyDynamicsProfiledStage
+    {
+        STAGE_PERIOD = 0,
+        STAGE_READ_SENSORS,
+        STAGE_FILTER_SENSORS,
+        STAGE_UPDATE_KINEMATICS,
+        STAGE_READ_CONTACT_POINTS,
+        STAGE_COMPUTE_CALIBRATION,
+        STAGE_COMPUTE_ESTIMATION,
+        STAGE_PUBLISH,
+        STAGE_TOTAL,
+        NR_OF_PROFILED_STAGES
+    };
+
+    void initTimingStatistics();
+
+    /**
+     * Add to the statistics of the stage the time passed since stageStart,
+     * and return the current time (to be used as start of the next stage).
+     */
+    double updateStageTiming(const wholeBodyDynamicsProfiledStage stage, const double stageStart);
+
+    bool openTimingStatisticsPort();
+    bool closeTimingStatisticsPort();
+    void publishTimingStatistics();
+
+    std::vector<wholeBodyDynamics::TimingStatistics> m_stagesTimingStatistics;
+    double m_lastRunStartTime;
+    bool m_streamTimingStatistics;
+    yarp::os::BufferedPort<yarp::sig::Vector> m_timingStatisticsPort;
 
     /**
      * Load settings from config.
      */
     bool loadSettingsFromConfig(yarp::os::Searchable& config);
     bool loadSecondaryCalibrationSettingsFromConfig(yarp::os::Searchable& config);
+    bool loadTemperatureCompensationSettingsFromConfig(yarp::os::Searchable& config);
     bool loadGravityCompensationSettingsFromConfig(yarp::os::Searchable & config);
+    bool loadOnlineCalibrationSettingsFromConfig(yarp::os::Searchable & config);
 
     /**
      * Class actually doing computations.
@@ -502,11 +940,37 @@ private:
     iDynTree::SensorsMeasurements  rawSensorsMeasurements;
     imuMeasurements                rawIMUMeasurements;
 
+    /**
+     * Temperatures of the F/T sensors, read from the channel m_ftTemperatureChannels[ft]
+     * of the analog sensor (-1 if the sensor has no temperature offset model).
+     */
+    std::vector<double>            ftTemperatures;
+    std::vector<int>               m_ftTemperatureChannels;
+
+    /**
+     * Offsets of the F/T sensors with a temperature channel, recorded at the end of each calibration
+     * (and each online calibration update) with the temperature of the sensor, used by fitTemperatureOffsetModel.
+     */
+    std::vector<wholeBodyDynamics::TemperatureOffsetSamples> m_ftTemperatureOffsetSamples;
+
+    /**
+     * Record the current offset of the ft-th sensor, if it has a temperature channel.
+     */
+    void addTemperatureOffsetSample(const size_t ft);
+
     /**
      * Filters
      */
     wholeBodyDynamicsDeviceFilters filters;
 
+    /**
+     * Generation of the filters settings: it is increased every time
+     * a filter cutoff is changed through the RPC interface or the settings port,
+     * and the filters are updated only if it differs from the last applied generation.
+     */
+    std::atomic<size_t> m_filtersSettingsGeneration;
+    size_t m_appliedFiltersSettingsGeneration;
+
     /**
      * Buffer for filtered (both to reduce noise and remove offset) sensors.
      */
@@ -535,6 +999,20 @@ private:
         size_t nrOfSamplesToUseForCalibration;
     } calibrationBuffers;
 
+    /**
+     * Online F/T offset calibration data structures
+     */
+    struct
+    {
+        bool enabled;
+        wholeBodyDynamics::StillnessDetector stillnessDetector;
+        wholeBodyDynamics::OnlineFTOffsetEstimator offsetEstimator;
+        bool isContactAssumptionExplicit; /*!< false until a calib* RPC call sets the contacts assumed during calibration */
+        bool lastUpdateRejected;
+        size_t nrOfUpdates;
+        size_t nrOfRejectedUpdates;
+    } m_onlineCalibration;
+
     /**
      * Vector of classes used to process the raw FT measurements,
      * removing offset and using a secondary calibration matrix.
@@ -684,6 +1162,31 @@ private:
        */
       virtual std::string getCurrentSettingsString();
 
+      /**
+       * Get the timing statistics of the stages of the estimation.
+       * @return the timing statistics as a human readable string.
+       */
+      virtual std::string getTimingStatistics();
+
+      /**
+       * Reset the timing statistics of the stages of the estimation.
+       * @return true/false on success/failure
+       */
+      virtual bool resetTimingStatistics();
+
+      /**
+       * Enable or disable the online calibration of the F/T sensors offsets.
+       * @return true/false on success/failure
+       */
+      virtual bool enableOnlineCalibration(const bool enable);
+
+      /**
+       * Fit the temperature offset model of the F/T sensors with a temperature channel
+       * from the offsets recorded by the calibrations at different temperatures, and use it.
+       * @return true/false on success/failure
+       */
+      virtual bool fitTemperatureOffsetModel(const int32_t order);
+
     void setupCalibrationCommonPart(const int32_t nrOfSamples);
     bool setupCalibrationWithExternalWrenchOnOneFrame(const std::string & frameName, const int32_t nrOfSamples);
     bool setupCalibrationWithExternalWrenchesOnTwoFrames(const std::string & frame1Name, const std::string & frame2Name, const int32_t nrOfSamples);
@@ -717,9 +1220,14 @@ private:
      yarp::os::BufferedPort<iCub::skinDynLib::skinContactList> portContactsInput;
 
      /**
-      * \todo we should use directly the class in the BufferedPort portContactsInput
+      * Contacts read from the skin, indexed by link.
+      */
+     wholeBodyDynamics::SkinContactsIndex skinContactsIndex;
+
+     /**
+      * Buffer of the number of skin contacts of each submodel.
       */
-     iCub::skinDynLib::skinContactList contactsReadFromSkin;
+     std::vector<size_t> nrOfSkinContactsForSubModel;
 
      /**
       * Port used to publish the external forces acting on the
@@ -759,6 +1267,13 @@ private:
      */
     iDynTree::LinkNetExternalWrenches netExternalWrenchesExertedByTheEnviroment;
 
+    // Attributes for the shared memory output
+    bool m_sharedMemoryOutputEnabled;
+    wholeBodyDynamics::SharedMemoryRingBufferWriter m_sharedMemoryJointTorques;
+    wholeBodyDynamics::SharedMemoryRingBufferWriter m_sharedMemoryExternalWrenches;
+    wholeBodyDynamics::SharedMemoryRingBufferWriter m_sharedMemoryFilteredFT;
+    std::vector<double> m_sharedMemoryBuffer;
+
     // Class for computing relative transforms (useful for net external wrench frame computations and gravity compensation)
     iDynTree::KinDynComputations kinDynComp;
 
@@ -769,6 +1284,23 @@ private:
     iDynTree::JointDOFsDoubleArray m_gravityCompensationTorques;
     void resetGravityCompensation();
 
+    /**
+     * Cache of the control and interaction modes of the gravity compensation joints,
+     * read from the controlboards with group calls every refreshPeriodInSeconds.
+     * activeJoints contains the dofs for which the impedance offset is set.
+     */
+    struct
+    {
+        std::vector<int> joints;
+        std::vector<int> controlModes;
+        std::vector<yarp::dev::InteractionModeEnum> interactionModes;
+        std::vector<size_t> activeJoints;
+        double refreshPeriodInSeconds;
+        double lastRefreshTime;
+    } m_gravityCompensationModes;
+    void resizeGravityCompensationModesCache();
+    void refreshGravityCompensationModesCache();
+
 public:
     // CONSTRUCTOR
     WholeBodyDynamicsDevice();
@@ -784,6 +1316,39 @@ public:
 
     // RATE THREAD
     virtual void run();
+
+    // OFFLINE REPLAY
+    // Methods used by wholeBodyDynamicsReplay to run the estimation on logged measurements.
+    // They can be used after open, on a device that is not attached: in this case
+    // the getters are not protected by the device mutex, as no thread is running.
+
+    /**
+     * Prepare the device to run the estimation without attached devices.
+     */
+    bool initReplay();
+
+    /**
+     * Run a single estimation cycle on the given sensors measurements, without
+     * publishing the estimated quantities.
+     *
+     * @param snapshot the sensors measurements, its timestamp is used as current time.
+     * @param skinContacts the contacts read from the skin in this cycle, or null if no new contact list is available.
+     * @return true if the estimation went well, false otherwise.
+     */
+    bool replayEstimationCycle(const wholeBodyDynamics::SensorsSnapshot & snapshot,
+                               iCub::skinDynLib::skinContactList * skinContacts);
+
+    const iDynTree::Model & getEstimatorModel() const;
+    const iDynTree::SensorsList & getEstimatorSensors() const;
+    bool isOffsetAvailable() const;
+    const iDynTree::JointDOFsDoubleArray & getEstimatedJointTorques() const;
+    const iDynTree::LinkContactWrenches & getEstimatedExternalContactWrenches() const;
+    const iDynTree::SensorsMeasurements & getFilteredSensorMeasurements() const;
+
+    /**
+     * Timing statistics of the estimation stages, in the order of the Profiling section.
+     */
+    const std::vector<wholeBodyDynamics::TimingStatistics> & getStagesTimingStatistics() const;
 };
 
 }
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2017 Fondazione Istituto Italiano di Tecnologia
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ */
+
+/**
+ * Benchmark comparing the cost of computing the gravity compensation
+ * torques of wholeBodyDynamics with the FULL_VEL_ACC_KINEMATICS and
+ * the ORIENTATION_ONLY_KINEMATICS methods of GravityCompensationHelper.
+ *
+ * Usage: wholeBodyDynamicsGravityCompensationBenchmark model.urdf [baseLink] [imuFrame] [nrOfCycles]
+ * (by default root_link and imu_frame, as in the iCub models).
+ */
+
+#include "GravityCompensationHelpers.h"
+
+#include <iDynTree/Core/EigenHelpers.h>
+#include <iDynTree/ModelIO/ModelLoader.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace wholeBodyDynamics;
+
+double gravityCompensation(const iDynTree::Model & model,
+                           const std::string & baseLink,
+                           const iDynTree::FrameIndex imuFrame,
+                           const GravityCompensationKinematicsMethod method,
+                           const size_t nrOfCycles,
+                           iDynTree::JointDOFsDoubleArray & lastTorques)
+{
+    GravityCompensationHelper helper;
+    if( !helper.loadModel(model,baseLink) )
+    {
+        fprintf(stderr,"Impossible to load the model with base link %s\n",baseLink.c_str());
+        exit(EXIT_FAILURE);
+    }
+    helper.setKinematicsMethod(method);
+
+    iDynTree::JointPosDoubleArray jointPos(model);
+    iDynTree::Vector3 properAcc;
+    lastTorques.resize(model);
+
+    std::chrono::steady_clock::time_point tic = std::chrono::steady_clock::now();
+    for (size_t cycle=0; cycle<nrOfCycles; cycle++)
+    {
+        for (size_t dof=0; dof<jointPos.size(); dof++)
+        {
+            jointPos(dof)=0.01*(cycle%100)*(dof+1);
+        }
+        properAcc(0)=0.1*(cycle%10);
+        properAcc(1)=-0.2;
+        properAcc(2)=9.81;
+
+        helper.updateKinematicsFromProperAcceleration(jointPos,imuFrame,properAcc);
+        helper.getGravityCompensationTorques(lastTorques);
+    }
+    std::chrono::steady_clock::time_point toc = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(toc-tic).count()/nrOfCycles;
+}
+
+int main(int argc, char ** argv)
+{
+    if (argc<2)
+    {
+        fprintf(stderr,"Usage: %s model.urdf [baseLink] [imuFrame] [nrOfCycles]\n",argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string baseLink = (argc>2) ? argv[2] : "root_link";
+    std::string imuFrameName = (argc>3) ? argv[3] : "imu_frame";
+    size_t nrOfCycles = (argc>4) ? static_cast<size_t>(atol(argv[4])) : 100000;
+
+    iDynTree::ModelLoader loader;
+    if (!loader.loadModelFromFile(argv[1]))
+    {
+        fprintf(stderr,"Impossible to load model from %s\n",argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    const iDynTree::Model & model = loader.model();
+    iDynTree::FrameIndex imuFrame = model.getFrameIndex(imuFrameName);
+    if (imuFrame == iDynTree::FRAME_INVALID_INDEX)
+    {
+        fprintf(stderr,"Frame %s not found in the model\n",imuFrameName.c_str());
+        return EXIT_FAILURE;
+    }
+
+    iDynTree::JointDOFsDoubleArray fullTorques, orientationOnlyTorques;
+    double fullTime=gravityCompensation(model,baseLink,imuFrame,FULL_VEL_ACC_KINEMATICS,nrOfCycles,fullTorques);
+    double orientationOnlyTime=gravityCompensation(model,baseLink,imuFrame,ORIENTATION_ONLY_KINEMATICS,nrOfCycles,orientationOnlyTorques);
+
+    printf("Gravity compensation torques of %lu dofs for %lu cycles\n",
+           static_cast<unsigned long>(model.getNrOfDOFs()),static_cast<unsigned long>(nrOfCycles));
+    printf("FULL_VEL_ACC_KINEMATICS     : %.3f us per cycle\n",1e6*fullTime);
+    printf("ORIENTATION_ONLY_KINEMATICS : %.3f us per cycle\n",1e6*orientationOnlyTime);
+    printf("Max difference between the torques : %g\n",
+           (iDynTree::toEigen(fullTorques)-iDynTree::toEigen(orientationOnlyTorques)).cwiseAbs().maxCoeff());
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include "DataDumperLogReader.h"
+
+#include <yarp/os/LogStream.h>
+
+namespace wholeBodyDynamics
+{
+
+DataDumperLogReader::DataDumperLogReader(): m_hasSample(false),
+                                            m_timestamp(0.0),
+                                            m_hasNextSample(false),
+                                            m_nextTimestamp(0.0)
+{
+}
+
+bool DataDumperLogReader::readLine(double& timestamp, yarp::os::Bottle& data)
+{
+    while( std::getline(m_file,m_line) )
+    {
+        yarp::os::Bottle line;
+        line.fromString(m_line);
+
+        // Skip empty or malformed lines
+        if( line.size() < 2 || !(line.get(1).isDouble() || line.get(1).isInt()) )
+        {
+            continue;
+        }
+
+        timestamp = line.get(1).asDouble();
+        data = line.tail().tail();
+
+        return true;
+    }
+
+    return false;
+}
+
+bool DataDumperLogReader::open(const std::string& fileName)
+{
+    m_file.open(fileName.c_str());
+    m_fileName = fileName;
+
+    if( !m_file.is_open() )
+    {
+        yError() << "wholeBodyDynamicsReplay : impossible to open log " << fileName;
+        return false;
+    }
+
+    m_hasSample = false;
+    m_hasNextSample = readLine(m_nextTimestamp,m_nextData);
+
+    if( !m_hasNextSample )
+    {
+        yError() << "wholeBodyDynamicsReplay : log " << fileName << " does not contain any sample";
+        return false;
+    }
+
+    return true;
+}
+
+const std::string& DataDumperLogReader::fileName() const
+{
+    return m_fileName;
+}
+
+bool DataDumperLogReader::next()
+{
+    if( !m_hasNextSample )
+    {
+        return false;
+    }
+
+    m_hasSample = true;
+    m_timestamp = m_nextTimestamp;
+    m_data = m_nextData;
+
+    m_hasNextSample = readLine(m_nextTimestamp,m_nextData);
+
+    return true;
+}
+
+bool DataDumperLogReader::advanceTo(const double time)
+{
+    bool changed = false;
+    while( m_hasNextSample && m_nextTimestamp <= time )
+    {
+        changed = this->next();
+    }
+
+    return changed;
+}
+
+bool DataDumperLogReader::hasSample() const
+{
+    return m_hasSample;
+}
+
+double DataDumperLogReader::timestamp() const
+{
+    return m_timestamp;
+}
+
+const yarp::os::Bottle& DataDumperLogReader::data() const
+{
+    return m_data;
+}
+
+bool DataDumperLogReader::getVector(yarp::sig::Vector& vec, const size_t expectedSize) const
+{
+    const yarp::os::Bottle * values = &m_data;
+    if( m_data.size() == 1 && m_data.get(0).isList() )
+    {
+        values = m_data.get(0).asList();
+    }
+
+    if( !m_hasSample || (size_t)values->size() != expectedSize )
+    {
+        return false;
+    }
+
+    vec.resize(expectedSize);
+    for(size_t i=0; i < expectedSize; i++)
+    {
+        if( !values->get(i).isDouble() && !values->get(i).isInt() )
+        {
+            return false;
+        }
+        vec[i] = values->get(i).asDouble();
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,89 @@
+#ifndef WHOLE_BODY_DYNAMICS_DATA_DUMPER_LOG_READER_H
+#define WHOLE_BODY_DYNAMICS_DATA_DUMPER_LOG_READER_H
+
+#include <yarp/os/Bottle.h>
+#include <yarp/sig/Vector.h>
+
+#include <fstream>
+#include <string>
+
+namespace wholeBodyDynamics
+{
+
+/**
+ * Sequential reader of the data.log files saved by yarpdatadumper.
+ *
+ * Each line of the log is in the form "seq timestamp data", where
+ * data is the content of the dumped port (the numbers of a yarp::sig::Vector,
+ * or the content of a Bottle). The file is read one line at the time,
+ * so arbitrary long logs can be replayed.
+ */
+class DataDumperLogReader
+{
+private:
+    std::ifstream m_file;
+    std::string m_fileName;
+    std::string m_line;
+
+    // Current sample
+    bool m_hasSample;
+    double m_timestamp;
+    yarp::os::Bottle m_data;
+
+    // Lookahead sample, used to implement advanceTo
+    bool m_hasNextSample;
+    double m_nextTimestamp;
+    yarp::os::Bottle m_nextData;
+
+    bool readLine(double & timestamp, yarp::os::Bottle & data);
+
+public:
+    DataDumperLogReader();
+
+    /**
+     * Open the log and read its first sample.
+     */
+    bool open(const std::string & fileName);
+
+    const std::string & fileName() const;
+
+    /**
+     * Move to the next sample of the log.
+     *
+     * @return false if the end of the log was reached.
+     */
+    bool next();
+
+    /**
+     * Move to the last sample with a timestamp smaller or equal to time
+     * (zero order hold). The samples are never moved backward.
+     *
+     * @return true if the current sample changed, false otherwise.
+     */
+    bool advanceTo(const double time);
+
+    /**
+     * True if a sample is available, i.e. if the log is not empty
+     * and (after advanceTo) if the log started before the requested time.
+     */
+    bool hasSample() const;
+
+    double timestamp() const;
+
+    /**
+     * Content of the current sample (without sequence number and timestamp).
+     */
+    const yarp::os::Bottle & data() const;
+
+    /**
+     * Copy the current sample in a vector. If the sample contains a single list
+     * (as logged from Bottle ports), the content of the list is copied.
+     *
+     * @return false if the sample is not composed of expectedSize numbers.
+     */
+    bool getVector(yarp::sig::Vector & vec, const size_t expectedSize) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2017 Fondazione Istituto Italiano di Tecnologia
+ * CopyPolicy: Released under the terms of the GNU LGPL v2.1+.
+ */
+
+/**
+\defgroup wholeBodyDynamicsReplay wholeBodyDynamicsReplay
+
+@ingroup codyco_module
+
+Run the estimation of the wholeBodyDynamics device offline, on measurements logged by yarpdatadumper.
+
+\section intro_sec Description
+
+The device is opened without attaching any sensor device, and for each sample of the
+first encoders log an estimation cycle is executed on the measurements (zero order hold)
+of all the logs, as fast as possible. The timestamps of the logs are used as time of the
+estimation, so the results are the same for each run on the same logs and configuration.
+
+The estimated joint torques and the net external wrenches acting on the links are saved to file,
+and the timing statistics of the estimation stages are printed at the end of the replay, so the
+executable can be used to compare filter and calibration settings, to benchmark the throughput
+of the estimation and to check numerical regressions without the robot or the simulator.
+
+No YARP server is needed, as the ports of the device are opened in local mode.
+
+\section parameters_sec Parameters
+~~~
+# Configuration of the wholeBodyDynamics device, in .ini format
+wholeBodyDynamicsDevice wholeBodyDynamicsDevice.ini
+# Encoders logs (of the state:o ports of the controlboards), with the name of the joints in the log.
+# The joints of the log that are not used by the device are ignored.
+# The first log is used as clock of the replay: an estimation cycle is executed for each of its samples.
+encodersLogs ((left_leg/data.log (l_hip_pitch,l_hip_roll,l_hip_yaw,l_knee,l_ankle_pitch,l_ankle_roll)) (right_leg/data.log (r_hip_pitch,r_hip_roll,r_hip_yaw,r_knee,r_ankle_pitch,r_ankle_roll)))
+# F/T sensors logs (of the analog:o ports), with the name of the sensor in the model
+ftLogs ((l_leg_ft_sensor l_leg_ft/data.log) (r_leg_ft_sensor r_leg_ft/data.log))
+# IMU log (of the inertial port), required if the device uses the IMU as kinematic source
+imuLog inertial/data.log
+# Optional skin contacts log (of the skin_events port)
+skinContactsLog skin_events/data.log
+# File in which the estimated quantities are saved
+outputFile wholeBodyDynamicsReplay.log
+# Optional maximum number of estimation cycles
+maxCycles 1000
+~~~
+
+The encoders logs contain only joint positions, so the joint velocities and accelerations
+are assumed to be zero: useJointVelocity and useJointAcceleration should be set to false
+in the device configuration.
+
+Each line of the output file contains the timestamp of the cycle, a flag set to 1 if the estimation
+went well and to 0 otherwise, the estimated joint torques (in the order of axesNames) and the net
+external wrench (force then torque) of each link of the model (in the order of the model), expressed
+in the link frame. The first lines of the file, starting with #, describe the content of the columns.
+
+The executable is compiled only if the CODYCO_BUILD_TOOLS option is enabled.
+*/
+
+#include "WholeBodyDynamicsDevice.h"
+#include "DataDumperLogReader.h"
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Network.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/SystemClock.h>
+
+#include <iDynTree/yarp/YARPConversions.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+
+using namespace yarp::os;
+
+namespace wholeBodyDynamics
+{
+
+/**
+ * Joints (or F/T sensor) measured in a log.
+ */
+struct LoggedSignal
+{
+    std::unique_ptr<DataDumperLogReader> log;
+
+    /**< Size of the vector logged in each sample */
+    size_t loggedSize;
+
+    /**< For each element of the logged vector, index of the joint in the model (or -1 if it is not used) */
+    std::vector<int> modelIndices;
+
+    /**< Index of the F/T sensor in the model sensors */
+    size_t sensorIndex;
+
+    yarp::sig::Vector buffer;
+};
+
+class wholeBodyDynamicsReplay
+{
+private:
+    yarp::dev::WholeBodyDynamicsDevice m_device;
+
+    std::vector<LoggedSignal> m_encoders;
+    std::vector<LoggedSignal> m_fts;
+    std::unique_ptr<DataDumperLogReader> m_imu;
+    std::unique_ptr<DataDumperLogReader> m_skinContacts;
+
+    SensorsSnapshot m_snapshot;
+    iCub::skinDynLib::skinContactList m_skinContactList;
+    iDynTree::LinkNetExternalWrenches m_netExtWrenches;
+    yarp::sig::Vector m_imuBuffer;
+
+    std::ofstream m_output;
+    size_t m_maxCycles;
+
+    bool openLog(ResourceFinder & rf, const std::string & fileName, std::unique_ptr<DataDumperLogReader> & log)
+    {
+        log.reset(new DataDumperLogReader());
+        return log->open(rf.findFileByName(fileName));
+    }
+
+    bool openEncodersLogs(ResourceFinder & rf)
+    {
+        Bottle * logs = rf.find("encodersLogs").asList();
+        if( !logs || logs->size() == 0 )
+        {
+            yError() << "wholeBodyDynamicsReplay : missing required parameter encodersLogs";
+            return false;
+        }
+
+        const iDynTree::Model & model = m_device.getEstimatorModel();
+        std::vector<bool> jointIsLogged(model.getNrOfDOFs(),false);
+
+        m_encoders.resize(logs->size());
+        for(int i=0; i < logs->size(); i++)
+        {
+            Bottle * logInfo = logs->get(i).asList();
+            if( !logInfo || logInfo->size() != 2 || !logInfo->get(0).isString() || !logInfo->get(1).isList() )
+            {
+                yError() << "wholeBodyDynamicsReplay : malformed element of encodersLogs " << logs->get(i).toString();
+                return false;
+            }
+
+            LoggedSignal & encoders = m_encoders[i];
+            if( !openLog(rf,logInfo->get(0).asString(),encoders.log) )
+            {
+                return false;
+            }
+
+            Bottle * jointNames = logInfo->get(1).asList();
+            encoders.loggedSize = jointNames->size();
+            encoders.modelIndices.resize(encoders.loggedSize);
+            for(size_t jnt=0; jnt < encoders.loggedSize; jnt++)
+            {
+                iDynTree::JointIndex jntIdx = model.getJointIndex(jointNames->get(jnt).asString());
+                encoders.modelIndices[jnt] = -1;
+                if( jntIdx != iDynTree::JOINT_INVALID_INDEX && model.getJoint(jntIdx)->getNrOfDOFs() == 1 )
+                {
+                    encoders.modelIndices[jnt] = model.getJoint(jntIdx)->getDOFsOffset();
+                    jointIsLogged[encoders.modelIndices[jnt]] = true;
+                }
+            }
+        }
+
+        for(size_t dof=0; dof < jointIsLogged.size(); dof++)
+        {
+            if( !jointIsLogged[dof] )
+            {
+                yError() << "wholeBodyDynamicsReplay : joint " << model.getJointName(dof) << " is not contained in any of the encodersLogs";
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool openFTLogs(ResourceFinder & rf)
+    {
+        const iDynTree::SensorsList & sensors = m_device.getEstimatorSensors();
+        size_t nrOfFTSensors = sensors.getNrOfSensors(iDynTree::SIX_AXIS_FORCE_TORQUE);
+
+        Bottle * logs = rf.find("ftLogs").asList();
+        if( nrOfFTSensors > 0 && (!logs || (size_t)logs->size() != nrOfFTSensors) )
+        {
+            yError() << "wholeBodyDynamicsReplay : ftLogs should contain a log for each of the " << nrOfFTSensors << " F/T sensors of the model";
+            return false;
+        }
+
+        m_fts.resize(nrOfFTSensors);
+        for(size_t i=0; i < nrOfFTSensors; i++)
+        {
+            Bottle * logInfo = logs->get(i).asList();
+            unsigned int sensorIndex;
+            if( !logInfo || logInfo->size() != 2 ||
+                !sensors.getSensorIndex(iDynTree::SIX_AXIS_FORCE_TORQUE,logInfo->get(0).asString(),sensorIndex) )
+            {
+                yError() << "wholeBodyDynamicsReplay : element of ftLogs " << logs->get(i).toString() << " does not refer to a F/T sensor of the model";
+                return false;
+            }
+
+            m_fts[i].loggedSize = 6;
+            m_fts[i].sensorIndex = sensorIndex;
+            if( !openLog(rf,logInfo->get(1).asString(),m_fts[i].log) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void writeOutputHeader()
+    {
+        const iDynTree::Model & model = m_device.getEstimatorModel();
+
+        m_output << "# timestamp estimationWentWell";
+        for(size_t dof=0; dof < model.getNrOfDOFs(); dof++)
+        {
+            m_output << " " << model.getJointName(dof);
+        }
+        m_output << std::endl;
+
+        m_output << "# followed by the net external wrench (fx fy fz tx ty tz) of the links:";
+        for(size_t link=0; link < model.getNrOfLinks(); link++)
+        {
+            m_output << " " << model.getLinkName(link);
+        }
+        m_output << std::endl;
+    }
+
+    /**
+     * Update the snapshot with the measurements of the logs at the given time.
+     *
+     * @return false if some measurement is not available at the given time.
+     */
+    bool readSnapshot(const double time)
+    {
+        bool ok = true;
+
+        for(size_t i=0; i < m_encoders.size(); i++)
+        {
+            LoggedSignal & encoders = m_encoders[i];
+            encoders.log->advanceTo(time);
+            if( !encoders.log->getVector(encoders.buffer,encoders.loggedSize) )
+            {
+                ok = false;
+                continue;
+            }
+
+            for(size_t jnt=0; jnt < encoders.loggedSize; jnt++)
+            {
+                if( encoders.modelIndices[jnt] >= 0 )
+                {
+                    // Convert from degrees (used on wire by YARP) to radians (used by iDynTree)
+                    m_snapshot.jointPos(encoders.modelIndices[jnt]) = encoders.buffer[jnt]*M_PI/180.0;
+                }
+            }
+        }
+
+        for(size_t i=0; i < m_fts.size(); i++)
+        {
+            LoggedSignal & ft = m_fts[i];
+            ft.log->advanceTo(time);
+            if( !ft.log->getVector(ft.buffer,ft.loggedSize) )
+            {
+                ok = false;
+                continue;
+            }
+
+            iDynTree::Wrench bufWrench;
+            iDynTree::toiDynTree(ft.buffer,bufWrench);
+            m_snapshot.rawSensorsMeasurements.setMeasurement(iDynTree::SIX_AXIS_FORCE_TORQUE,ft.sensorIndex,bufWrench);
+        }
+
+        if( m_imu )
+        {
+            m_imu->advanceTo(time);
+            // Check format of IMU in YARP http://wiki.icub.org/wiki/Inertial_Sensor
+            if( m_imu->getVector(m_imuBuffer,12) )
+            {
+                m_snapshot.imuAngularVel(0) = m_imuBuffer[6]*M_PI/180.0;
+                m_snapshot.imuAngularVel(1) = m_imuBuffer[7]*M_PI/180.0;
+                m_snapshot.imuAngularVel(2) = m_imuBuffer[8]*M_PI/180.0;
+
+                m_snapshot.imuLinProperAcc(0) = m_imuBuffer[3];
+                m_snapshot.imuLinProperAcc(1) = m_imuBuffer[4];
+                m_snapshot.imuLinProperAcc(2) = m_imuBuffer[5];
+            }
+            else
+            {
+                ok = false;
+            }
+        }
+
+        m_snapshot.readCorrectly = ok;
+        m_snapshot.timestamp = time;
+
+        return ok;
+    }
+
+    /**
+     * Get the skin contacts received since the last cycle, or null if no contact list was received.
+     */
+    iCub::skinDynLib::skinContactList * readSkinContacts(const double time)
+    {
+        if( !m_skinContacts || !m_skinContacts->advanceTo(time) )
+        {
+            return 0;
+        }
+
+        Bottle contacts = m_skinContacts->data();
+        m_skinContactList.clear();
+        if( !Portable::copyPortable(contacts,m_skinContactList) )
+        {
+            yWarning() << "wholeBodyDynamicsReplay : impossible to parse skin contacts at time " << m_skinContacts->timestamp();
+            return 0;
+        }
+
+        return &m_skinContactList;
+    }
+
+    void writeOutput(const bool estimationWentWell)
+    {
+        const iDynTree::Model & model = m_device.getEstimatorModel();
+        const iDynTree::JointDOFsDoubleArray & torques = m_device.getEstimatedJointTorques();
+
+        m_device.getEstimatedExternalContactWrenches().computeNetWrenches(m_netExtWrenches);
+
+        m_output << m_snapshot.timestamp << " " << (estimationWentWell ? 1 : 0);
+        for(size_t dof=0; dof < model.getNrOfDOFs(); dof++)
+        {
+            m_output << " " << torques(dof);
+        }
+        for(size_t link=0; link < model.getNrOfLinks(); link++)
+        {
+            const iDynTree::Wrench & wrench = m_netExtWrenches(link);
+            for(unsigned int i=0; i < 6; i++)
+            {
+                m_output << " " << wrench(i);
+            }
+        }
+        m_output << "\n";
+    }
+
+public:
+    wholeBodyDynamicsReplay(): m_maxCycles(0)
+    {
+    }
+
+    bool configure(ResourceFinder & rf)
+    {
+        if( !rf.check("wholeBodyDynamicsDevice") || !rf.check("outputFile") )
+        {
+            yError() << "wholeBodyDynamicsReplay : missing required parameters wholeBodyDynamicsDevice and outputFile";
+            return false;
+        }
+
+        Property deviceOptions;
+        deviceOptions.fromConfigFile(rf.findFile("wholeBodyDynamicsDevice"));
+
+        if( !m_device.open(deviceOptions) || !m_device.initReplay() )
+        {
+            yError() << "wholeBodyDynamicsReplay : error in open wholeBodyDynamicsDevice";
+            return false;
+        }
+
+        if( !openEncodersLogs(rf) || !openFTLogs(rf) )
+        {
+            return false;
+        }
+
+        if( rf.check("imuLog") && !openLog(rf,rf.find("imuLog").asString(),m_imu) )
+        {
+            return false;
+        }
+
+        if( rf.check("skinContactsLog") && !openLog(rf,rf.find("skinContactsLog").asString(),m_skinContacts) )
+        {
+            return false;
+        }
+
+        if( rf.check("maxCycles") )
+        {
+            m_maxCycles = rf.find("maxCycles").asInt();
+        }
+
+        m_snapshot.resize(m_device.getEstimatorModel(),m_device.getEstimatorSensors());
+        m_snapshot.jointVel.zero();
+        m_snapshot.jointAcc.zero();
+        m_snapshot.imuLinProperAcc.zero();
+        m_snapshot.imuAngularVel.zero();
+        m_netExtWrenches.resize(m_device.getEstimatorModel());
+
+        std::string outputFileName = rf.find("outputFile").asString();
+        m_output.open(outputFileName.c_str());
+        if( !m_output.is_open() )
+        {
+            yError() << "wholeBodyDynamicsReplay : impossible to open output file " << outputFileName;
+            return false;
+        }
+        m_output << std::setprecision(10);
+        writeOutputHeader();
+
+        return true;
+    }
+
+    bool replay()
+    {
+        DataDumperLogReader & clock = *(m_encoders[0].log);
+
+        size_t nrOfCycles = 0;
+        size_t nrOfSkippedCycles = 0;
+        size_t nrOfFailedEstimations = 0;
+
+        double replayStart = SystemClock::nowSystem();
+
+        while( (m_maxCycles == 0 || nrOfCycles < m_maxCycles) && clock.next() )
+        {
+            double time = clock.timestamp();
+
+            // Skip the beginning of the logs, in which not all sensors have been logged yet
+            if( !readSnapshot(time) )
+            {
+                nrOfSkippedCycles++;
+                continue;
+            }
+
+            bool ok = m_device.replayEstimationCycle(m_snapshot,readSkinContacts(time));
+            nrOfFailedEstimations += ok ? 0 : 1;
+
+            writeOutput(ok);
+            nrOfCycles++;
+        }
+
+        double replayDuration = SystemClock::nowSystem()-replayStart;
+
+        yInfo() << "wholeBodyDynamicsReplay : replayed " << nrOfCycles << " estimation cycles in " << replayDuration << " seconds ("
+                << (replayDuration > 0.0 ? nrOfCycles/replayDuration : 0.0) << " cycles per second)";
+        yInfo() << "wholeBodyDynamicsReplay : " << nrOfSkippedCycles << " cycles skipped for missing measurements, "
+                << nrOfFailedEstimations << " failed estimations";
+
+        if( !m_device.isOffsetAvailable() )
+        {
+            yWarning() << "wholeBodyDynamicsReplay : the F/T offset calibration was not completed, the estimation used raw F/T measurements";
+        }
+
+        const std::vector<TimingStatistics> & timing = m_device.getStagesTimingStatistics();
+        for(size_t stage=0; stage < timing.size(); stage++)
+        {
+            if( timing[stage].nrOfSamples() > 0 )
+            {
+                yInfo() << "wholeBodyDynamicsReplay : " << timing[stage].toString();
+            }
+        }
+
+        return nrOfCycles > 0;
+    }
+
+    void close()
+    {
+        m_output.close();
+        m_device.close();
+    }
+};
+
+}
+
+/************************************************************************/
+int main(int argc, char *argv[])
+{
+    // The ports of the device are opened without a YARP server
+    Network yarp;
+    Network::setLocalMode(true);
+
+    ResourceFinder rf;
+    rf.setVerbose(true);
+    rf.setDefaultContext("wholeBodyDynamicsReplay");
+    rf.setDefaultConfigFile("wholeBodyDynamicsReplay.ini");
+    rf.configure(argc,argv);
+
+    wholeBodyDynamics::wholeBodyDynamicsReplay replay;
+
+    bool ok = replay.configure(rf) && replay.replay();
+
+    replay.close();
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2017 Fondazione Istituto Italiano di Tecnologia
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ */
+
+/**
+ * Test of the temperature offset model of SixAxisForceTorqueMeasureProcessor:
+ * the coefficients are fitted from the offsets of a synthetic sensor recorded
+ * at different temperatures, and the processor is checked to remove the
+ * offset drift from the measurements.
+ */
+
+#include "SixAxisForceTorqueMeasureHelpers.h"
+
+#include <iDynTree/Core/EigenHelpers.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace wholeBodyDynamics;
+
+const double tolerance = 1e-6;
+
+/**
+ * Offset of the synthetic sensor: o_0 + \sum_{k=1}^{n} c_k T^k
+ */
+iDynTree::Wrench syntheticOffset(const iDynTree::Vector6 & constantOffset,
+                                 const std::vector<iDynTree::Vector6> & coeffs,
+                                 const double temperature)
+{
+    Eigen::Matrix<double,6,1> offset = iDynTree::toEigen(constantOffset);
+
+    double temperaturePower = 1.0;
+    for(size_t k=0; k < coeffs.size(); k++)
+    {
+        temperaturePower *= temperature;
+        offset += temperaturePower*iDynTree::toEigen(coeffs[k]);
+    }
+
+    iDynTree::Wrench ret;
+    iDynTree::fromEigen(ret,offset);
+    return ret;
+}
+
+bool checkEqual(const char * what, const Eigen::Matrix<double,6,1> & actual, const Eigen::Matrix<double,6,1> & expected, const double tol)
+{
+    double error = (actual-expected).cwiseAbs().maxCoeff();
+    if( !(error <= tol) )
+    {
+        std::fprintf(stderr,"%s : error %g greater than the tolerance %g\n",what,error,tol);
+        return false;
+    }
+
+    return true;
+}
+
+int main()
+{
+    const size_t order = 2;
+    const size_t capacity = 30;
+
+    iDynTree::Vector6 constantOffset;
+    std::vector<iDynTree::Vector6> coeffs(order);
+    for(unsigned int j=0; j < 6; j++)
+    {
+        constantOffset(j) = 2.0-0.5*j;
+        coeffs[0](j) = 0.1*(j+1);
+        coeffs[1](j) = -0.002*(j+1);
+    }
+
+    // Not enough samples
+    TemperatureOffsetSamples samples;
+    samples.setCapacity(capacity);
+    samples.addSample(30.0,syntheticOffset(constantOffset,coeffs,30.0));
+    samples.addSample(35.0,syntheticOffset(constantOffset,coeffs,35.0));
+
+    std::vector<iDynTree::Vector6> fittedCoeffs;
+    if( samples.fitTemperatureOffsetModel(order,fittedCoeffs) )
+    {
+        std::fprintf(stderr,"The model was fitted with less samples than coefficients\n");
+        return EXIT_FAILURE;
+    }
+
+    // Samples at the same temperature do not determine the model
+    samples.clear();
+    for(size_t smpl=0; smpl < 10; smpl++)
+    {
+        samples.addSample(30.0,syntheticOffset(constantOffset,coeffs,30.0));
+    }
+
+    if( samples.fitTemperatureOffsetModel(order,fittedCoeffs) )
+    {
+        std::fprintf(stderr,"The model was fitted with samples all at the same temperature\n");
+        return EXIT_FAILURE;
+    }
+
+    // More samples than the capacity, from 20 to 50 degrees: the oldest ones are replaced
+    samples.clear();
+    const size_t nrOfSamples = 2*capacity;
+    for(size_t smpl=0; smpl < nrOfSamples; smpl++)
+    {
+        double temperature = 20.0 + (30.0*smpl)/(nrOfSamples-1);
+        samples.addSample(temperature,syntheticOffset(constantOffset,coeffs,temperature));
+    }
+
+    if( samples.nrOfSamples() != capacity )
+    {
+        std::fprintf(stderr,"%lu samples stored instead of %lu\n",
+                     static_cast<unsigned long>(samples.nrOfSamples()),static_cast<unsigned long>(capacity));
+        return EXIT_FAILURE;
+    }
+
+    if( !samples.fitTemperatureOffsetModel(order,fittedCoeffs) || fittedCoeffs.size() != order )
+    {
+        std::fprintf(stderr,"Impossible to fit the model\n");
+        return EXIT_FAILURE;
+    }
+
+    bool ok = true;
+    ok = checkEqual("c_1",iDynTree::toEigen(fittedCoeffs[0]),iDynTree::toEigen(coeffs[0]),tolerance) && ok;
+    ok = checkEqual("c_2",iDynTree::toEigen(fittedCoeffs[1]),iDynTree::toEigen(coeffs[1]),tolerance) && ok;
+
+    // The processor calibrated at the reference temperature removes the offset at any temperature
+    SixAxisForceTorqueMeasureProcessor processor;
+    if( !processor.setTemperatureOffsetModel(fittedCoeffs) )
+    {
+        std::fprintf(stderr,"Impossible to set the fitted model\n");
+        return EXIT_FAILURE;
+    }
+
+    const double referenceTemperature = 25.0;
+    processor.setTemperature(referenceTemperature);
+    processor.offset() = syntheticOffset(constantOffset,coeffs,referenceTemperature);
+    processor.resetReferenceTemperature();
+
+    Eigen::Matrix<double,6,1> appliedWrench;
+    appliedWrench << 10.0, -5.0, 30.0, 0.5, -0.2, 0.1;
+
+    const double temperatures[3] = {25.0,38.0,47.5};
+    for(size_t i=0; i < 3; i++)
+    {
+        iDynTree::Wrench measurement;
+        iDynTree::fromEigen(measurement,appliedWrench+iDynTree::toEigen(syntheticOffset(constantOffset,coeffs,temperatures[i])));
+
+        processor.setTemperature(temperatures[i]);
+        iDynTree::Wrench compensated = processor.filt(measurement);
+
+        // The residual error is due to the fitted coefficients, amplified by the powers of the temperature
+        ok = checkEqual("compensated measurement",iDynTree::toEigen(compensated),appliedWrench,1e3*tolerance) && ok;
+    }
+
+    if( !ok )
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::printf("Temperature offset model fitted from %lu samples\n",static_cast<unsigned long>(samples.nrOfSamples()));
+
+    return EXIT_SUCCESS;
+}
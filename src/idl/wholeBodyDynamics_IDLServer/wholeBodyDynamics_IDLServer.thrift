@@ -187,6 +187,37 @@ service wholeBodyDynamics_IDLServer
    * @return the current settings as a human readable string.
    */
   string getCurrentSettingsString();
+
+  /**
+   * Get the timing statistics (min, mean, max and percentiles of the duration)
+   * of the stages of the estimation.
+   * @return the timing statistics as a human readable string.
+   */
+  string getTimingStatistics();
+
+  /**
+   * Reset the timing statistics of the stages of the estimation.
+   * @return true/false on success/failure
+   */
+  bool resetTimingStatistics();
+
+  /**
+   * Enable or disable the online calibration of the force/torque sensors offsets,
+   * that updates the offsets while the robot is still
+   * (WARNING: the external forces are assumed to act on the links used for the last calibration).
+   * @param enable true to enable the online calibration, false to disable it
+   * @return true/false on success/failure
+   */
+  bool enableOnlineCalibration(1:bool enable)
+
+  /**
+   * Fit the temperature offset model of the force/torque sensors with a temperature channel
+   * from the offsets computed by the calibrations at different temperatures, and use it.
+   * The fitted models are printed in the format of the FT_TEMPERATURE_COMPENSATION group.
+   * @param order order of the polynomial model of the offset (from 1 to 3)
+   * @return true/false on success/failure
+   */
+  bool fitTemperatureOffsetModel(1:i32 order=1)
 }
 
 
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2017 Fondazione Istituto Italiano di Tecnologia
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ */
+
+/**
+ * Benchmark comparing the cost of filtering the signals used by
+ * wholeBodyDynamics (F/T sensors, IMU, joint velocities and accelerations)
+ * with one FirstOrderLowPassFilter object per signal or with a single
+ * FirstOrderLowPassFilterBank. The cost of filtering the same signals with
+ * a SecondOrderSectionsFilterBank implementing a second order Butterworth
+ * filter is also reported.
+ */
+
+#include "ctrlLibRT/filters.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace iCub::ctrl::realTime;
+
+const size_t nrOfFTSensors = 6;
+const size_t nrOfDOFs = 32;
+const double cutFrequency = 3.0;
+const double sampleTime = 0.001;
+
+double perSensorFilters(const size_t nrOfCycles, Eigen::VectorXd & lastOutput)
+{
+    // Layout of the signals: F/T sensors, IMU linear acc, IMU angular vel, joint vel, joint acc
+    std::vector<FirstOrderLowPassFilter *> filters;
+    std::vector<yarp::sig::Vector> buffers;
+    for (size_t ft=0; ft<nrOfFTSensors; ft++)
+    {
+        buffers.push_back(yarp::sig::Vector(6,0.0));
+    }
+    buffers.push_back(yarp::sig::Vector(3,0.0));
+    buffers.push_back(yarp::sig::Vector(3,0.0));
+    buffers.push_back(yarp::sig::Vector(nrOfDOFs,0.0));
+    buffers.push_back(yarp::sig::Vector(nrOfDOFs,0.0));
+
+    for (size_t i=0; i<buffers.size(); i++)
+    {
+        filters.push_back(new FirstOrderLowPassFilter(cutFrequency,sampleTime,buffers[i]));
+    }
+
+    Eigen::VectorXd input(6*nrOfFTSensors+6+2*nrOfDOFs);
+    lastOutput.resize(input.size());
+
+    std::chrono::steady_clock::time_point tic = std::chrono::steady_clock::now();
+    for (size_t cycle=0; cycle<nrOfCycles; cycle++)
+    {
+        for (int i=0; i<input.size(); i++)
+        {
+            input(i)=0.01*(cycle%100)*(i+1);
+        }
+
+        // As in wholeBodyDynamics, every signal is copied in a YARP vector,
+        // filtered (also updating the cut frequency) and copied back
+        size_t offset=0;
+        for (size_t i=0; i<filters.size(); i++)
+        {
+            for (size_t j=0; j<buffers[i].size(); j++)
+            {
+                buffers[i][j]=input(offset+j);
+            }
+
+            filters[i]->setCutFrequency(cutFrequency);
+            const yarp::sig::Vector & out=filters[i]->filt(buffers[i]);
+
+            for (size_t j=0; j<out.size(); j++)
+            {
+                lastOutput(offset+j)=out[j];
+            }
+            offset+=buffers[i].size();
+        }
+    }
+    std::chrono::steady_clock::time_point toc = std::chrono::steady_clock::now();
+
+    for (size_t i=0; i<filters.size(); i++)
+    {
+        delete filters[i];
+    }
+
+    return std::chrono::duration<double>(toc-tic).count()/nrOfCycles;
+}
+
+double filterBank(const size_t nrOfCycles, Eigen::VectorXd & lastOutput)
+{
+    size_t nrOfChannels=6*nrOfFTSensors+6+2*nrOfDOFs;
+    FirstOrderLowPassFilterBank bank(nrOfChannels,cutFrequency,sampleTime);
+
+    Eigen::VectorXd signals(nrOfChannels);
+
+    std::chrono::steady_clock::time_point tic = std::chrono::steady_clock::now();
+    for (size_t cycle=0; cycle<nrOfCycles; cycle++)
+    {
+        for (int i=0; i<signals.size(); i++)
+        {
+            signals(i)=0.01*(cycle%100)*(i+1);
+        }
+
+        bank.filt(signals);
+    }
+    std::chrono::steady_clock::time_point toc = std::chrono::steady_clock::now();
+
+    lastOutput=signals;
+
+    return std::chrono::duration<double>(toc-tic).count()/nrOfCycles;
+}
+
+double butterworthFilterBank(const size_t nrOfCycles)
+{
+    size_t nrOfChannels=6*nrOfFTSensors+6+2*nrOfDOFs;
+    SecondOrderSectionsFilterBank bank(nrOfChannels,1);
+
+    yarp::sig::Vector num(3,0.0), den(3,0.0);
+    butterworthLowPassSectionCoeffs(2,0,cutFrequency,sampleTime,num,den);
+    bank.setSectionCoeffs(0,0,nrOfChannels,num,den);
+
+    Eigen::VectorXd signals(nrOfChannels);
+
+    std::chrono::steady_clock::time_point tic = std::chrono::steady_clock::now();
+    for (size_t cycle=0; cycle<nrOfCycles; cycle++)
+    {
+        for (int i=0; i<signals.size(); i++)
+        {
+            signals(i)=0.01*(cycle%100)*(i+1);
+        }
+
+        bank.filt(signals);
+    }
+    std::chrono::steady_clock::time_point toc = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double>(toc-tic).count()/nrOfCycles;
+}
+
+int main(int argc, char ** argv)
+{
+    size_t nrOfCycles=100000;
+    if (argc>1)
+    {
+        nrOfCycles=static_cast<size_t>(atol(argv[1]));
+    }
+
+    Eigen::VectorXd outputPerSensor, outputBank;
+    double perSensorTime=perSensorFilters(nrOfCycles,outputPerSensor);
+    double bankTime=filterBank(nrOfCycles,outputBank);
+    double butterworthTime=butterworthFilterBank(nrOfCycles);
+
+    printf("Filtering %lu channels (%lu F/T sensors, IMU, %lu joint velocities and accelerations) for %lu cycles\n",
+           static_cast<unsigned long>(outputBank.size()),static_cast<unsigned long>(nrOfFTSensors),
+           static_cast<unsigned long>(nrOfDOFs),static_cast<unsigned long>(nrOfCycles));
+    printf("FirstOrderLowPassFilter per signal : %.3f us per cycle\n",1e6*perSensorTime);
+    printf("FirstOrderLowPassFilterBank        : %.3f us per cycle\n",1e6*bankTime);
+    printf("Butterworth (2nd order) bank       : %.3f us per cycle\n",1e6*butterworthTime);
+    printf("Max difference between the outputs : %g\n",(outputPerSensor-outputBank).cwiseAbs().maxCoeff());
+
+    return EXIT_SUCCESS;
+}
@@ -34,6 +34,8 @@
 
 #include <yarp/sig/Vector.h>
 
+#include <vector>
+
 
 namespace iCub
 {
@@ -224,6 +226,509 @@ public:
 };
 
 
+/**
+* \ingroup Filters
+*
+* Bank of first order low pass filters, implementing for each channel
+* the transfer function H(s) = \frac{1}{1+\tau s}, discretized with
+* the Tustin method as in FirstOrderLowPassFilter.
+*
+* All the channels are stored in contiguous Eigen vectors and are
+* filtered in a single pass, and each channel can have its own cut
+* frequency. After resize no memory is allocated, so the class can be
+* used to filter several signals (for example all the F/T sensors of a robot)
+* in a real time loop.
+*/
+class FirstOrderLowPassFilterBank
+{
+protected:
+    double Ts;                      // sample time
+    Eigen::VectorXd fc;             // cut frequency of each channel
+    Eigen::VectorXd b;              // numerator coefficient (b0 == b1) of each channel, normalized w.r.t. a0
+    Eigen::VectorXd a1;             // denominator coefficient a1 of each channel, normalized w.r.t. a0
+    Eigen::VectorXd uold;           // last input
+    Eigen::VectorXd yold;           // last output
+    Eigen::VectorXd y;              // filter current output
+
+    void computeCoeff(const size_t firstChannel, const size_t nrOfChannels);
+
+public:
+    /**
+    * Creates an empty filter bank.
+    */
+    FirstOrderLowPassFilterBank();
+
+    /**
+    * Creates a filter bank with specified parameters.
+    * @param nrOfChannels number of filtered channels.
+    * @param cutFrequency cut frequency (Hz) of all the channels.
+    * @param sampleTime sample time (s).
+    */
+    FirstOrderLowPassFilterBank(const size_t nrOfChannels,
+                                const double cutFrequency,
+                                const double sampleTime);
+
+    /**
+    * Allocate the buffers of the filter bank and reset its state to zero.
+    * This is the only method that allocates memory.
+    * @param nrOfChannels number of filtered channels.
+    * @param cutFrequency cut frequency (Hz) of all the channels.
+    * @param sampleTime sample time (s).
+    */
+    void resize(const size_t nrOfChannels,
+                const double cutFrequency,
+                const double sampleTime);
+
+    /**
+    * Number of channels of the filter bank.
+    */
+    size_t getNrOfChannels() const { return static_cast<size_t>(y.size()); }
+
+    /**
+    * Internal state reset.
+    * @param y0 new internal state, of size getNrOfChannels().
+    */
+    void init(const Eigen::Ref<const Eigen::VectorXd> & y0);
+
+    /**
+    * Change the cut frequency of all the channels.
+    * @param cutFrequency the new cut frequency (Hz).
+    */
+    bool setCutFrequency(const double cutFrequency);
+
+    /**
+    * Change the cut frequency of a set of consecutive channels.
+    * @param firstChannel first channel of the set.
+    * @param nrOfChannels number of channels of the set.
+    * @param cutFrequency the new cut frequency (Hz).
+    */
+    bool setCutFrequency(const size_t firstChannel,
+                         const size_t nrOfChannels,
+                         const double cutFrequency);
+
+    /**
+    * Retrieve the cut frequency of a channel.
+    * @return the cut frequency (Hz).
+    */
+    double getCutFrequency(const size_t channel) const { return fc(channel); }
+
+    /**
+    * Change the sample time of the filter bank.
+    * @param sampleTime the new sample time (s).
+    */
+    bool setSampleTime(const double sampleTime);
+
+    /**
+    * Retrieve the sample time of the filter bank.
+    * @return the sample time (s).
+    */
+    double getSampleTime() const { return Ts; }
+
+    /**
+    * Performs filtering on the actual input of all the channels.
+    * @param u the actual input, of size getNrOfChannels().
+    *          It is overwritten with the corresponding output.
+    */
+    void filt(Eigen::Ref<Eigen::VectorXd> u);
+
+    /**
+    * Return current filter output.
+    * @return the filter output.
+    */
+    const Eigen::VectorXd & output() const { return y; }
+};
+
+
+/**
+* \ingroup Filters
+*
+* Compute the coefficients of the first order low pass filter
+* H(s) = \frac{1}{1+\tau s}, discretized with the Tustin method as
+* in FirstOrderLowPassFilter, as a second order section (the coefficients
+* of z^-2 are zero).
+* @param cutFrequency cut frequency (Hz).
+* @param sampleTime sample time (s).
+* @param num numerator coefficients, given as increasing power of z^-1.
+* @param den denominator coefficients, given as increasing power of z^-1.
+* @return true/false on success/fail.
+* @note num and den are resized to 3 only if they have a different size.
+*/
+bool firstOrderLowPassSectionCoeffs(const double cutFrequency, const double sampleTime,
+                                    yarp::sig::Vector &num, yarp::sig::Vector &den);
+
+/**
+* \ingroup Filters
+*
+* Number of second order sections of a Butterworth low pass filter of the given order.
+*/
+size_t butterworthLowPassNrOfSections(const size_t order);
+
+/**
+* \ingroup Filters
+*
+* Compute the coefficients of a second order section of a Butterworth
+* low pass filter, discretized with the Tustin method with the cut
+* frequency prewarped. If the order is odd, the last section is a first
+* order one (the coefficients of z^-2 are zero).
+* @param order order of the Butterworth filter.
+* @param section index of the section, smaller than butterworthLowPassNrOfSections(order).
+* @param cutFrequency cut frequency (Hz), smaller than the Nyquist frequency.
+* @param sampleTime sample time (s).
+* @param num numerator coefficients, given as increasing power of z^-1.
+* @param den denominator coefficients, given as increasing power of z^-1.
+* @return true/false on success/fail.
+* @note num and den are resized to 3 only if they have a different size.
+*/
+bool butterworthLowPassSectionCoeffs(const size_t order, const size_t section,
+                                     const double cutFrequency, const double sampleTime,
+                                     yarp::sig::Vector &num, yarp::sig::Vector &den);
+
+/**
+* \ingroup Filters
+*
+* Compute the coefficients of a second order notch filter
+* H(s) = \frac{s^2+\omega_0^2}{s^2+\frac{\omega_0}{Q}s+\omega_0^2},
+* with Q = notchFrequency/bandwidth, discretized with the Tustin
+* method with the notch frequency prewarped.
+* @param notchFrequency frequency (Hz) rejected by the filter, smaller than the Nyquist frequency.
+* @param bandwidth width (Hz) of the rejected band.
+* @param sampleTime sample time (s).
+* @param num numerator coefficients, given as increasing power of z^-1.
+* @param den denominator coefficients, given as increasing power of z^-1.
+* @return true/false on success/fail.
+* @note num and den are resized to 3 only if they have a different size.
+*/
+bool notchSectionCoeffs(const double notchFrequency, const double bandwidth, const double sampleTime,
+                        yarp::sig::Vector &num, yarp::sig::Vector &den);
+
+
+/**
+* \ingroup Filters
+*
+* Butterworth low pass filter, implemented as a cascade of
+* second order sections, each one being a Filter.
+*
+* Changing the cut frequency only adjusts the coefficients of
+* the sections, so the internal state of the filter is preserved.
+*/
+class ButterworthLowPassFilter
+{
+protected:
+    std::vector<Filter *> sections;  // cascade of second order sections
+    size_t order;                    // order of the filter
+    double fc;                       // cut frequency
+    double Ts;                       // sample time
+    yarp::sig::Vector y;             // filter current output
+    yarp::sig::Vector num;           // buffer for the numerator of a section
+    yarp::sig::Vector den;           // buffer for the denominator of a section
+
+    bool computeCoeff();
+
+public:
+    /**
+    * Creates a filter with specified parameters
+    * @param order order of the filter.
+    * @param cutFrequency cut frequency (Hz).
+    * @param sampleTime sample time (s).
+    * @param y0 initial output.
+    */
+    ButterworthLowPassFilter(const size_t order, const double cutFrequency, const double sampleTime,
+                             const yarp::sig::Vector &y0=yarp::sig::Vector(1,0.0));
+
+    /**
+    * Destructor.
+    */
+    ~ButterworthLowPassFilter();
+
+    /**
+    * Internal state reset.
+    * @param y0 new internal state.
+    */
+    void init(const yarp::sig::Vector &y0);
+
+    /**
+    * Change the cut frequency of the filter, preserving its internal state.
+    * @param cutFrequency the new cut frequency (Hz).
+    */
+    bool setCutFrequency(const double cutFrequency);
+
+    /**
+    * Change the sample time of the filter, preserving its internal state.
+    * @param sampleTime the new sample time (s).
+    */
+    bool setSampleTime(const double sampleTime);
+
+    /**
+    * Retrieve the order of the filter.
+    */
+    size_t getOrder() const { return order; }
+
+    /**
+    * Retrieve the cut frequency of the filter.
+    * @return the cut frequency (Hz).
+    */
+    double getCutFrequency() const { return fc; }
+
+    /**
+    * Retrieve the sample time of the filter.
+    * @return the sample time (s).
+    */
+    double getSampleTime() const { return Ts; }
+
+    /**
+    * Performs filtering on the actual input.
+    * @param u reference to the actual input.
+    * @return the corresponding output.
+    */
+    const yarp::sig::Vector& filt(const yarp::sig::Vector &u);
+
+    /**
+    * Return current filter output.
+    * @return the filter output.
+    */
+    const yarp::sig::Vector& output() const { return y; }
+};
+
+
+/**
+* \ingroup Filters
+*
+* Second order notch filter, rejecting a narrow band around a given frequency.
+*
+* Changing the notch frequency only adjusts the coefficients of
+* the filter, so its internal state is preserved.
+*/
+class NotchFilter
+{
+protected:
+    Filter *filter;         // notch filter
+    double fn;              // notch frequency
+    double bw;              // bandwidth
+    double Ts;              // sample time
+    yarp::sig::Vector y;    // filter current output
+    yarp::sig::Vector num;  // buffer for the numerator
+    yarp::sig::Vector den;  // buffer for the denominator
+
+public:
+    /**
+    * Creates a filter with specified parameters
+    * @param notchFrequency rejected frequency (Hz).
+    * @param bandwidth width of the rejected band (Hz).
+    * @param sampleTime sample time (s).
+    * @param y0 initial output.
+    */
+    NotchFilter(const double notchFrequency, const double bandwidth, const double sampleTime,
+                const yarp::sig::Vector &y0=yarp::sig::Vector(1,0.0));
+
+    /**
+    * Destructor.
+    */
+    ~NotchFilter();
+
+    /**
+    * Internal state reset.
+    * @param y0 new internal state.
+    */
+    void init(const yarp::sig::Vector &y0);
+
+    /**
+    * Change the rejected frequency and bandwidth, preserving the internal state.
+    * @param notchFrequency the new rejected frequency (Hz).
+    * @param bandwidth the new width of the rejected band (Hz).
+    */
+    bool setNotchFrequency(const double notchFrequency, const double bandwidth);
+
+    /**
+    * Retrieve the rejected frequency of the filter.
+    * @return the notch frequency (Hz).
+    */
+    double getNotchFrequency() const { return fn; }
+
+    /**
+    * Retrieve the width of the rejected band.
+    * @return the bandwidth (Hz).
+    */
+    double getBandwidth() const { return bw; }
+
+    /**
+    * Retrieve the sample time of the filter.
+    * @return the sample time (s).
+    */
+    double getSampleTime() const { return Ts; }
+
+    /**
+    * Performs filtering on the actual input.
+    * @param u reference to the actual input.
+    * @return the corresponding output.
+    */
+    const yarp::sig::Vector& filt(const yarp::sig::Vector &u);
+
+    /**
+    * Return current filter output.
+    * @return the filter output.
+    */
+    const yarp::sig::Vector& output() const { return y; }
+};
+
+
+/**
+* \ingroup Filters
+*
+* Bank of filters, each one implemented as a cascade of second
+* order sections (biquads) with the same structure (Direct Form I)
+* used by Filter.
+*
+* All the channels have the same number of sections, but each channel
+* can have its own coefficients: a section can implement for example
+* a first order low pass filter, a section of a Butterworth filter, a
+* notch filter or a pass-through. All the channels are stored in
+* contiguous Eigen matrices and are filtered in a single pass, and after
+* resize no memory is allocated.
+*
+* Changing the coefficients of a section does not reset the past inputs and
+* outputs, so the internal state of the filters is preserved. Furthermore, if a
+* transition length is set, the new coefficients are reached by linear interpolation
+* in the given number of samples, to avoid jumps in the output. Since the set of
+* stable second order sections is convex, all the intermediate sections are stable
+* if the initial and the final ones are stable.
+*/
+class SecondOrderSectionsFilterBank
+{
+protected:
+    // Coefficients normalized w.r.t. a0: each row is a channel, each column a section
+    Eigen::MatrixXd b0;
+    Eigen::MatrixXd b1;
+    Eigen::MatrixXd b2;
+    Eigen::MatrixXd a1;
+    Eigen::MatrixXd a2;
+
+    // Past inputs and outputs of each section: each row is a channel, each column a section
+    Eigen::MatrixXd x1;
+    Eigen::MatrixXd x2;
+    Eigen::MatrixXd y1;
+    Eigen::MatrixXd y2;
+
+    // Coefficients at the end of the transition: each row is a channel, each column a section
+    Eigen::MatrixXd b0Target;
+    Eigen::MatrixXd b1Target;
+    Eigen::MatrixXd b2Target;
+    Eigen::MatrixXd a1Target;
+    Eigen::MatrixXd a2Target;
+
+    size_t transitionLength;        // number of samples of a transition
+    Eigen::VectorXd transitionSteps;// remaining samples of the transition of each channel
+    Eigen::VectorXd transitionGain; // buffer for the interpolation gain of each channel
+    bool inTransition;              // true if at least a channel is in transition
+
+    Eigen::VectorXd y;              // filter current output
+
+    void startTransition(const size_t section, const size_t firstChannel, const size_t nrOfChannels);
+    void updateTransition();
+
+public:
+    /**
+    * Creates an empty filter bank.
+    */
+    SecondOrderSectionsFilterBank();
+
+    /**
+    * Creates a filter bank in which all the sections are pass-through.
+    * @param nrOfChannels number of filtered channels.
+    * @param nrOfSections number of sections of each channel.
+    */
+    SecondOrderSectionsFilterBank(const size_t nrOfChannels, const size_t nrOfSections);
+
+    /**
+    * Allocate the buffers of the filter bank, set all the sections
+    * to pass-through and reset the state to zero.
+    * This is the only method that allocates memory.
+    * @param nrOfChannels number of filtered channels.
+    * @param nrOfSections number of sections of each channel.
+    */
+    void resize(const size_t nrOfChannels, const size_t nrOfSections);
+
+    /**
+    * Number of channels of the filter bank.
+    */
+    size_t getNrOfChannels() const { return static_cast<size_t>(y.size()); }
+
+    /**
+    * Number of sections of each channel.
+    */
+    size_t getNrOfSections() const { return static_cast<size_t>(b0.cols()); }
+
+    /**
+    * Internal state reset to the steady state corresponding to the output y0.
+    * @param y0 new internal state, of size getNrOfChannels().
+    * @note The input of a section with zero DC gain is assumed to be zero.
+    */
+    void init(const Eigen::Ref<const Eigen::VectorXd> & y0);
+
+    /**
+    * Set the coefficients of a section of a set of consecutive channels,
+    * preserving their internal state. If the transition length is not zero,
+    * a transition towards the new coefficients is started for these channels.
+    * @param section index of the section.
+    * @param firstChannel first channel of the set.
+    * @param nrOfChannels number of channels of the set.
+    * @param num vector of (at most 3) numerator elements given as increasing
+    *            power of z^-1.
+    * @param den vector of (at most 3) denominator elements given as increasing
+    *            power of z^-1.
+    * @return true/false on success/fail.
+    * @note den[0] shall not be 0.
+    */
+    bool setSectionCoeffs(const size_t section,
+                          const size_t firstChannel,
+                          const size_t nrOfChannels,
+                          const yarp::sig::Vector &num,
+                          const yarp::sig::Vector &den);
+
+    /**
+    * Set a section of a set of consecutive channels to pass-through.
+    * @param section index of the section.
+    * @param firstChannel first channel of the set.
+    * @param nrOfChannels number of channels of the set.
+    * @return true/false on success/fail.
+    */
+    bool setSectionPassThrough(const size_t section,
+                               const size_t firstChannel,
+                               const size_t nrOfChannels);
+
+    /**
+    * Set the number of samples in which the coefficients are moved
+    * to the ones set by setSectionCoeffs and setSectionPassThrough.
+    * @param nrOfSamples length of the transition, if 0 the new coefficients
+    *                    are used immediately (default).
+    * @note It affects only the transitions started after the call.
+    */
+    void setTransitionLength(const size_t nrOfSamples) { transitionLength=nrOfSamples; }
+
+    /**
+    * Retrieve the number of samples of a transition.
+    */
+    size_t getTransitionLength() const { return transitionLength; }
+
+    /**
+    * Return true if the coefficients of at least one channel are in transition.
+    */
+    bool isInTransition() const { return inTransition; }
+
+    /**
+    * Performs filtering on the actual input of all the channels.
+    * @param u the actual input, of size getNrOfChannels().
+    *          It is overwritten with the corresponding output.
+    */
+    void filt(Eigen::Ref<Eigen::VectorXd> u);
+
+    /**
+    * Return current filter output.
+    * @return the filter output.
+    */
+    const Eigen::VectorXd & output() const { return y; }
+};
+
+
 }
 
 }
@@ -20,6 +20,8 @@
 
 #include <yarp/math/Math.h>
 
+#include <cmath>
+
 using namespace std;
 using namespace yarp::sig;
 using namespace yarp::math;
@@ -247,3 +249,540 @@ void FirstOrderLowPassFilter::computeCoeff()
         filter=new Filter(num,den,y);
 }
 
+
+/**********************************************************************/
+FirstOrderLowPassFilterBank::FirstOrderLowPassFilterBank()
+{
+    resize(0,1.0,1.0);
+}
+
+
+/**********************************************************************/
+FirstOrderLowPassFilterBank::FirstOrderLowPassFilterBank(const size_t nrOfChannels,
+                                                         const double cutFrequency,
+                                                         const double sampleTime)
+{
+    resize(nrOfChannels,cutFrequency,sampleTime);
+}
+
+
+/**********************************************************************/
+void FirstOrderLowPassFilterBank::resize(const size_t nrOfChannels,
+                                         const double cutFrequency,
+                                         const double sampleTime)
+{
+    Ts=sampleTime;
+    fc.setConstant(nrOfChannels,cutFrequency);
+    b.resize(nrOfChannels);
+    a1.resize(nrOfChannels);
+    uold.setZero(nrOfChannels);
+    yold.setZero(nrOfChannels);
+    y.setZero(nrOfChannels);
+
+    computeCoeff(0,nrOfChannels);
+}
+
+
+/**********************************************************************/
+void FirstOrderLowPassFilterBank::init(const Eigen::Ref<const Eigen::VectorXd> & y0)
+{
+    // The DC gain of the filter is one, so the
+    // input corresponding to y0 at steady state is y0
+    y=y0;
+    yold=y0;
+    uold=y0;
+}
+
+
+/**********************************************************************/
+bool FirstOrderLowPassFilterBank::setCutFrequency(const double cutFrequency)
+{
+    return setCutFrequency(0,getNrOfChannels(),cutFrequency);
+}
+
+
+/**********************************************************************/
+bool FirstOrderLowPassFilterBank::setCutFrequency(const size_t firstChannel,
+                                                  const size_t nrOfChannels,
+                                                  const double cutFrequency)
+{
+    if (cutFrequency<=0.0)
+        return false;
+
+    if (firstChannel+nrOfChannels>getNrOfChannels())
+        return false;
+
+    fc.segment(firstChannel,nrOfChannels).setConstant(cutFrequency);
+    computeCoeff(firstChannel,nrOfChannels);
+
+    return true;
+}
+
+
+/**********************************************************************/
+bool FirstOrderLowPassFilterBank::setSampleTime(const double sampleTime)
+{
+    if (sampleTime<=0.0)
+        return false;
+
+    Ts=sampleTime;
+    computeCoeff(0,getNrOfChannels());
+
+    return true;
+}
+
+
+/**********************************************************************/
+void FirstOrderLowPassFilterBank::filt(Eigen::Ref<Eigen::VectorXd> u)
+{
+    // y[k] = b*(u[k]+u[k-1]) - a1*y[k-1]
+    y.array()=b.array()*(u.array()+uold.array())-a1.array()*yold.array();
+
+    uold=u;
+    yold=y;
+    u=y;
+}
+
+
+/**********************************************************************/
+void FirstOrderLowPassFilterBank::computeCoeff(const size_t firstChannel,
+                                               const size_t nrOfChannels)
+{
+    // Same coefficients of FirstOrderLowPassFilter, normalized w.r.t. a0
+    // num = [Ts, Ts], den = [2*tau+Ts, Ts-2*tau]
+    for (size_t i=firstChannel; i<firstChannel+nrOfChannels; i++)
+    {
+        double tau=1.0/(2.0*M_PI*fc(i));
+        double a0=2.0*tau+Ts;
+        b(i)=Ts/a0;
+        a1(i)=(Ts-2.0*tau)/a0;
+    }
+}
+
+
+/**********************************************************************/
+bool iCub::ctrl::realTime::firstOrderLowPassSectionCoeffs(const double cutFrequency,
+                                                          const double sampleTime,
+                                                          Vector &num, Vector &den)
+{
+    if ((cutFrequency<=0.0) || (sampleTime<=0.0))
+        return false;
+
+    if (num.size()!=3)
+        num.resize(3);
+    if (den.size()!=3)
+        den.resize(3);
+
+    // Same coefficients of FirstOrderLowPassFilter
+    double tau=1.0/(2.0*M_PI*cutFrequency);
+    num[0]=sampleTime;         num[1]=sampleTime;         num[2]=0.0;
+    den[0]=2.0*tau+sampleTime; den[1]=sampleTime-2.0*tau; den[2]=0.0;
+
+    return true;
+}
+
+
+/**********************************************************************/
+size_t iCub::ctrl::realTime::butterworthLowPassNrOfSections(const size_t order)
+{
+    return (order+1)/2;
+}
+
+
+/**********************************************************************/
+bool iCub::ctrl::realTime::butterworthLowPassSectionCoeffs(const size_t order,
+                                                           const size_t section,
+                                                           const double cutFrequency,
+                                                           const double sampleTime,
+                                                           Vector &num, Vector &den)
+{
+    if ((order==0) || (section>=butterworthLowPassNrOfSections(order)))
+        return false;
+
+    if ((cutFrequency<=0.0) || (sampleTime<=0.0) || (cutFrequency>=0.5/sampleTime))
+        return false;
+
+    if (num.size()!=3)
+        num.resize(3);
+    if (den.size()!=3)
+        den.resize(3);
+
+    // Tustin transform s = (2/Ts)*(1-z^-1)/(1+z^-1), with the cut frequency
+    // prewarped, of the sections of the normalized analog Butterworth filter
+    double c=1.0/tan(M_PI*cutFrequency*sampleTime);
+
+    if (2*section+1<order)
+    {
+        // H(s) = 1/(s^2+2*zeta*s+1), with 2*zeta = 2*sin((2k+1)*pi/(2N))
+        double twoZeta=2.0*sin((2.0*section+1.0)*M_PI/(2.0*order));
+        num[0]=1.0;                 num[1]=2.0;         num[2]=1.0;
+        den[0]=c*c+twoZeta*c+1.0;   den[1]=2.0-2.0*c*c; den[2]=c*c-twoZeta*c+1.0;
+    }
+    else
+    {
+        // Real pole of the odd order filters, H(s) = 1/(s+1)
+        num[0]=1.0;     num[1]=1.0;     num[2]=0.0;
+        den[0]=c+1.0;   den[1]=1.0-c;   den[2]=0.0;
+    }
+
+    return true;
+}
+
+
+/**********************************************************************/
+bool iCub::ctrl::realTime::notchSectionCoeffs(const double notchFrequency,
+                                              const double bandwidth,
+                                              const double sampleTime,
+                                              Vector &num, Vector &den)
+{
+    if ((notchFrequency<=0.0) || (bandwidth<=0.0) || (sampleTime<=0.0) ||
+        (notchFrequency>=0.5/sampleTime))
+        return false;
+
+    if (num.size()!=3)
+        num.resize(3);
+    if (den.size()!=3)
+        den.resize(3);
+
+    double w0=2.0*M_PI*notchFrequency*sampleTime;
+    double alpha=sin(w0)*bandwidth/(2.0*notchFrequency);
+    num[0]=1.0;         num[1]=-2.0*cos(w0); num[2]=1.0;
+    den[0]=1.0+alpha;   den[1]=-2.0*cos(w0); den[2]=1.0-alpha;
+
+    return true;
+}
+
+
+/**********************************************************************/
+ButterworthLowPassFilter::ButterworthLowPassFilter(const size_t order,
+                                                   const double cutFrequency,
+                                                   const double sampleTime,
+                                                   const Vector &y0)
+{
+    this->order=order;
+    fc=cutFrequency;
+    Ts=sampleTime;
+    y=y0;
+    num.resize(3,0.0);
+    den.resize(3,0.0);
+
+    sections.resize(butterworthLowPassNrOfSections(order),NULL);
+    for (size_t i=0; i<sections.size(); i++)
+    {
+        butterworthLowPassSectionCoeffs(order,i,fc,Ts,num,den);
+        sections[i]=new Filter(num,den,y0);
+    }
+}
+
+
+/**********************************************************************/
+ButterworthLowPassFilter::~ButterworthLowPassFilter()
+{
+    for (size_t i=0; i<sections.size(); i++)
+        delete sections[i];
+}
+
+
+/***************************************************************************/
+void ButterworthLowPassFilter::init(const Vector &y0)
+{
+    // The DC gain of each section is one
+    for (size_t i=0; i<sections.size(); i++)
+        sections[i]->init(y0);
+
+    y=y0;
+}
+
+
+/**********************************************************************/
+bool ButterworthLowPassFilter::setCutFrequency(const double cutFrequency)
+{
+    if ((cutFrequency<=0.0) || (cutFrequency>=0.5/Ts))
+        return false;
+
+    if (fc!=cutFrequency)
+    {
+        fc=cutFrequency;
+        return computeCoeff();
+    }
+
+    return true;
+}
+
+
+/**********************************************************************/
+bool ButterworthLowPassFilter::setSampleTime(const double sampleTime)
+{
+    if ((sampleTime<=0.0) || (fc>=0.5/sampleTime))
+        return false;
+
+    Ts=sampleTime;
+    return computeCoeff();
+}
+
+
+/**********************************************************************/
+const Vector& ButterworthLowPassFilter::filt(const Vector &u)
+{
+    const Vector *in=&u;
+    for (size_t i=0; i<sections.size(); i++)
+        in=&(sections[i]->filt(*in));
+
+    y=*in;
+
+    return y;
+}
+
+
+/**********************************************************************/
+bool ButterworthLowPassFilter::computeCoeff()
+{
+    bool ok=true;
+    for (size_t i=0; i<sections.size(); i++)
+    {
+        ok=butterworthLowPassSectionCoeffs(order,i,fc,Ts,num,den) && ok;
+        ok=sections[i]->adjustCoeffs(num,den) && ok;
+    }
+
+    return ok;
+}
+
+
+/**********************************************************************/
+NotchFilter::NotchFilter(const double notchFrequency,
+                         const double bandwidth,
+                         const double sampleTime,
+                         const Vector &y0)
+{
+    fn=notchFrequency;
+    bw=bandwidth;
+    Ts=sampleTime;
+    y=y0;
+    num.resize(3,0.0);
+    den.resize(3,0.0);
+
+    notchSectionCoeffs(fn,bw,Ts,num,den);
+    filter=new Filter(num,den,y0);
+}
+
+
+/**********************************************************************/
+NotchFilter::~NotchFilter()
+{
+    delete filter;
+}
+
+
+/***************************************************************************/
+void NotchFilter::init(const Vector &y0)
+{
+    filter->init(y0);
+    y=y0;
+}
+
+
+/**********************************************************************/
+bool NotchFilter::setNotchFrequency(const double notchFrequency, const double bandwidth)
+{
+    if ((fn!=notchFrequency) || (bw!=bandwidth))
+    {
+        if (!notchSectionCoeffs(notchFrequency,bandwidth,Ts,num,den))
+            return false;
+
+        fn=notchFrequency;
+        bw=bandwidth;
+        return filter->adjustCoeffs(num,den);
+    }
+
+    return true;
+}
+
+
+/**********************************************************************/
+const Vector& NotchFilter::filt(const Vector &u)
+{
+    y=filter->filt(u);
+
+    return y;
+}
+
+
+/**********************************************************************/
+SecondOrderSectionsFilterBank::SecondOrderSectionsFilterBank() : transitionLength(0)
+{
+    resize(0,0);
+}
+
+
+/**********************************************************************/
+SecondOrderSectionsFilterBank::SecondOrderSectionsFilterBank(const size_t nrOfChannels,
+                                                             const size_t nrOfSections) : transitionLength(0)
+{
+    resize(nrOfChannels,nrOfSections);
+}
+
+
+/**********************************************************************/
+void SecondOrderSectionsFilterBank::resize(const size_t nrOfChannels,
+                                           const size_t nrOfSections)
+{
+    b0.setOnes(nrOfChannels,nrOfSections);
+    b1.setZero(nrOfChannels,nrOfSections);
+    b2.setZero(nrOfChannels,nrOfSections);
+    a1.setZero(nrOfChannels,nrOfSections);
+    a2.setZero(nrOfChannels,nrOfSections);
+
+    x1.setZero(nrOfChannels,nrOfSections);
+    x2.setZero(nrOfChannels,nrOfSections);
+    y1.setZero(nrOfChannels,nrOfSections);
+    y2.setZero(nrOfChannels,nrOfSections);
+
+    b0Target=b0;
+    b1Target=b1;
+    b2Target=b2;
+    a1Target=a1;
+    a2Target=a2;
+
+    transitionSteps.setZero(nrOfChannels);
+    transitionGain.setZero(nrOfChannels);
+    inTransition=false;
+
+    y.setZero(nrOfChannels);
+}
+
+
+/**********************************************************************/
+void SecondOrderSectionsFilterBank::init(const Eigen::Ref<const Eigen::VectorXd> & y0)
+{
+    y=y0;
+
+    // Going backward from the last section, the input of each
+    // section at steady state is its output divided by its DC gain
+    for (int ch=0; ch<y.size(); ch++)
+    {
+        double out=y0(ch);
+        for (int s=static_cast<int>(getNrOfSections())-1; s>=0; s--)
+        {
+            double sum_b=b0(ch,s)+b1(ch,s)+b2(ch,s);
+            double sum_a=1.0+a1(ch,s)+a2(ch,s);
+            double in=(fabs(sum_b)>1e-9)?(sum_a/sum_b)*out:0.0;
+
+            x1(ch,s)=x2(ch,s)=in;
+            y1(ch,s)=y2(ch,s)=out;
+            out=in;
+        }
+    }
+}
+
+
+/**********************************************************************/
+bool SecondOrderSectionsFilterBank::setSectionCoeffs(const size_t section,
+                                                     const size_t firstChannel,
+                                                     const size_t nrOfChannels,
+                                                     const Vector &num,
+                                                     const Vector &den)
+{
+    if ((section>=getNrOfSections()) || (firstChannel+nrOfChannels>getNrOfChannels()))
+        return false;
+
+    if ((num.size()==0) || (num.size()>3) || (den.size()==0) || (den.size()>3) || (den[0]==0.0))
+        return false;
+
+    double a0=den[0];
+    b0Target.col(section).segment(firstChannel,nrOfChannels).setConstant(num[0]/a0);
+    b1Target.col(section).segment(firstChannel,nrOfChannels).setConstant((num.size()>1)?num[1]/a0:0.0);
+    b2Target.col(section).segment(firstChannel,nrOfChannels).setConstant((num.size()>2)?num[2]/a0:0.0);
+    a1Target.col(section).segment(firstChannel,nrOfChannels).setConstant((den.size()>1)?den[1]/a0:0.0);
+    a2Target.col(section).segment(firstChannel,nrOfChannels).setConstant((den.size()>2)?den[2]/a0:0.0);
+
+    startTransition(section,firstChannel,nrOfChannels);
+
+    return true;
+}
+
+
+/**********************************************************************/
+bool SecondOrderSectionsFilterBank::setSectionPassThrough(const size_t section,
+                                                          const size_t firstChannel,
+                                                          const size_t nrOfChannels)
+{
+    if ((section>=getNrOfSections()) || (firstChannel+nrOfChannels>getNrOfChannels()))
+        return false;
+
+    b0Target.col(section).segment(firstChannel,nrOfChannels).setOnes();
+    b1Target.col(section).segment(firstChannel,nrOfChannels).setZero();
+    b2Target.col(section).segment(firstChannel,nrOfChannels).setZero();
+    a1Target.col(section).segment(firstChannel,nrOfChannels).setZero();
+    a2Target.col(section).segment(firstChannel,nrOfChannels).setZero();
+
+    startTransition(section,firstChannel,nrOfChannels);
+
+    return true;
+}
+
+
+/**********************************************************************/
+void SecondOrderSectionsFilterBank::startTransition(const size_t section,
+                                                    const size_t firstChannel,
+                                                    const size_t nrOfChannels)
+{
+    if (transitionLength==0)
+    {
+        // Use the new coefficients immediately
+        b0.col(section).segment(firstChannel,nrOfChannels)=b0Target.col(section).segment(firstChannel,nrOfChannels);
+        b1.col(section).segment(firstChannel,nrOfChannels)=b1Target.col(section).segment(firstChannel,nrOfChannels);
+        b2.col(section).segment(firstChannel,nrOfChannels)=b2Target.col(section).segment(firstChannel,nrOfChannels);
+        a1.col(section).segment(firstChannel,nrOfChannels)=a1Target.col(section).segment(firstChannel,nrOfChannels);
+        a2.col(section).segment(firstChannel,nrOfChannels)=a2Target.col(section).segment(firstChannel,nrOfChannels);
+    }
+    else if (nrOfChannels>0)
+    {
+        transitionSteps.segment(firstChannel,nrOfChannels).setConstant(static_cast<double>(transitionLength));
+        inTransition=true;
+    }
+}
+
+
+/**********************************************************************/
+void SecondOrderSectionsFilterBank::updateTransition()
+{
+    // Move the coefficients of each channel by 1/n of the remaining distance from
+    // the target, where n is the number of remaining steps: the coefficients are
+    // then linearly interpolated between their initial and final values
+    transitionGain.array()=(transitionSteps.array()>0.0).select(transitionSteps.array().inverse(),0.0);
+
+    b0.array()+=(b0Target.array()-b0.array()).colwise()*transitionGain.array();
+    b1.array()+=(b1Target.array()-b1.array()).colwise()*transitionGain.array();
+    b2.array()+=(b2Target.array()-b2.array()).colwise()*transitionGain.array();
+    a1.array()+=(a1Target.array()-a1.array()).colwise()*transitionGain.array();
+    a2.array()+=(a2Target.array()-a2.array()).colwise()*transitionGain.array();
+
+    transitionSteps.array()=(transitionSteps.array()-1.0).max(0.0);
+    inTransition=(transitionSteps.maxCoeff()>0.0);
+}
+
+
+/**********************************************************************/
+void SecondOrderSectionsFilterBank::filt(Eigen::Ref<Eigen::VectorXd> u)
+{
+    if (inTransition)
+        updateTransition();
+
+    for (int s=0; s<b0.cols(); s++)
+    {
+        // y[k] = b0*u[k] + b1*u[k-1] + b2*u[k-2] - a1*y[k-1] - a2*y[k-2]
+        y.array()=b0.col(s).array()*u.array()
+                 +b1.col(s).array()*x1.col(s).array()
+                 +b2.col(s).array()*x2.col(s).array()
+                 -a1.col(s).array()*y1.col(s).array()
+                 -a2.col(s).array()*y2.col(s).array();
+
+        x2.col(s)=x1.col(s);
+        x1.col(s)=u;
+        y2.col(s)=y1.col(s);
+        y1.col(s)=y;
+
+        // The output of a section is the input of the next one
+        u=y;
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef WHOLE_BODY_DYNAMICS_SHARED_MEMORY_RING_BUFFER_H
+#define WHOLE_BODY_DYNAMICS_SHARED_MEMORY_RING_BUFFER_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+namespace wholeBodyDynamics
+{
+
+const uint32_t sharedMemoryRingBufferMagic = 0x57424452; // "WBDR"
+const uint32_t sharedMemoryRingBufferVersion = 1;
+
+/**
+ * Header at the beginning of a shared memory ring buffer.
+ *
+ * The header is followed by nrOfSlots slots, each one composed by a
+ * SharedMemoryRingBufferSlotHeader followed by nrOfChannels doubles.
+ */
+struct SharedMemoryRingBufferHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nrOfChannels;
+    uint32_t nrOfSlots;
+
+    /**< Sequence number of the last complete sample (0 if no sample was written) */
+    std::atomic<uint64_t> lastSequenceNumber;
+
+    uint8_t padding[40];
+};
+
+struct SharedMemoryRingBufferSlotHeader
+{
+    /**< Sequence number of the sample in the slot, 0 while the slot is being written */
+    std::atomic<uint64_t> sequenceNumber;
+    double timestamp;
+};
+
+/**
+ * Writer of a ring buffer of samples (a timestamp and a fixed number of doubles)
+ * in a named POSIX shared memory object, to stream data to processes
+ * running on the same machine without any serialization.
+ *
+ * The sample with sequence number n is written in the slot n % nrOfSlots, and each slot is
+ * protected by a sequence lock: the writer never waits for the readers, and a reader detects
+ * if the slot it is reading was overwritten (that can happen only if the reader is slower
+ * than nrOfSlots-1 samples).
+ *
+ * The std::atomic<uint64_t> in shared memory requires uint64_t atomics to be lock free,
+ * as they are on all the platforms on which the POSIX shared memory is available.
+ */
+class SharedMemoryRingBufferWriter
+{
+private:
+    std::string m_name;
+    size_t m_size;
+    void * m_memory;
+    uint64_t m_sequenceNumber;
+
+public:
+    SharedMemoryRingBufferWriter();
+    ~SharedMemoryRingBufferWriter();
+
+    /**
+     * Create (or recreate) the shared memory object.
+     *
+     * @param name name of the shared memory object, in the form "/name".
+     */
+    bool open(const std::string & name, const size_t nrOfChannels, const size_t nrOfSlots);
+
+    bool isOpen() const;
+
+    /**
+     * Write a sample, data should contain nrOfChannels doubles.
+     * This method does not allocate memory and never blocks.
+     */
+    void write(const double timestamp, const double * data);
+
+    /**
+     * Remove the shared memory object.
+     */
+    void close();
+};
+
+/**
+ * Reader of a ring buffer written by SharedMemoryRingBufferWriter.
+ */
+class SharedMemoryRingBufferReader
+{
+private:
+    size_t m_size;
+    const void * m_memory;
+
+public:
+    SharedMemoryRingBufferReader();
+    ~SharedMemoryRingBufferReader();
+
+    bool open(const std::string & name);
+
+    bool isOpen() const;
+
+    size_t getNrOfChannels() const;
+
+    /**
+     * Read the last sample written, data should have getNrOfChannels() elements.
+     *
+     * @return false if no sample is available or if it was overwritten while it was read.
+     */
+    bool readLatest(uint64_t & sequenceNumber, double & timestamp, double * data) const;
+
+    void close();
+};
+
+}
+
+#endif
@@ -0,0 +1,270 @@
+#include "wholeBodyDynamicsSharedMemory/SharedMemoryRingBuffer.h"
+
+#include <yarp/os/LogStream.h>
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wholeBodyDynamics
+{
+
+static size_t slotSize(const size_t nrOfChannels)
+{
+    return sizeof(SharedMemoryRingBufferSlotHeader)+nrOfChannels*sizeof(double);
+}
+
+static SharedMemoryRingBufferSlotHeader * getSlot(void * memory, const size_t slot)
+{
+    SharedMemoryRingBufferHeader * header = static_cast<SharedMemoryRingBufferHeader *>(memory);
+    char * firstSlot = static_cast<char *>(memory)+sizeof(SharedMemoryRingBufferHeader);
+    return reinterpret_cast<SharedMemoryRingBufferSlotHeader *>(firstSlot+slot*slotSize(header->nrOfChannels));
+}
+
+SharedMemoryRingBufferWriter::SharedMemoryRingBufferWriter(): m_size(0),
+                                                              m_memory(0),
+                                                              m_sequenceNumber(0)
+{
+}
+
+SharedMemoryRingBufferWriter::~SharedMemoryRingBufferWriter()
+{
+    close();
+}
+
+bool SharedMemoryRingBufferWriter::open(const std::string& name, const size_t nrOfChannels, const size_t nrOfSlots)
+{
+    close();
+
+#ifdef _WIN32
+    yError() << "wholeBodyDynamics: shared memory output is not supported on this platform";
+    return false;
+#else
+    if( nrOfSlots < 2 )
+    {
+        yError() << "wholeBodyDynamics: shared memory " << name << " should have at least 2 slots";
+        return false;
+    }
+
+    size_t size = sizeof(SharedMemoryRingBufferHeader)+nrOfSlots*slotSize(nrOfChannels);
+
+    int fd = shm_open(name.c_str(),O_CREAT | O_RDWR,S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if( fd < 0 )
+    {
+        yError() << "wholeBodyDynamics: impossible to create shared memory " << name << " : " << strerror(errno);
+        return false;
+    }
+
+    if( ftruncate(fd,size) != 0 )
+    {
+        yError() << "wholeBodyDynamics: impossible to resize shared memory " << name << " : " << strerror(errno);
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void * memory = mmap(0,size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+    ::close(fd);
+    if( memory == MAP_FAILED )
+    {
+        yError() << "wholeBodyDynamics: impossible to map shared memory " << name << " : " << strerror(errno);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    m_name = name;
+    m_size = size;
+    m_memory = memory;
+    m_sequenceNumber = 0;
+
+    // The magic number is written last, so readers never see a partially initialized header
+    SharedMemoryRingBufferHeader * header = static_cast<SharedMemoryRingBufferHeader *>(m_memory);
+    header->magic = 0;
+    header->version = sharedMemoryRingBufferVersion;
+    header->nrOfChannels = nrOfChannels;
+    header->nrOfSlots = nrOfSlots;
+    header->lastSequenceNumber.store(0);
+    for(size_t slot=0; slot < nrOfSlots; slot++)
+    {
+        getSlot(m_memory,slot)->sequenceNumber.store(0);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = sharedMemoryRingBufferMagic;
+
+    return true;
+#endif
+}
+
+bool SharedMemoryRingBufferWriter::isOpen() const
+{
+    return m_memory != 0;
+}
+
+void SharedMemoryRingBufferWriter::write(const double timestamp, const double* data)
+{
+    if( !isOpen() )
+    {
+        return;
+    }
+
+    SharedMemoryRingBufferHeader * header = static_cast<SharedMemoryRingBufferHeader *>(m_memory);
+
+    m_sequenceNumber++;
+    SharedMemoryRingBufferSlotHeader * slot = getSlot(m_memory,m_sequenceNumber % header->nrOfSlots);
+
+    // Mark the slot as being written, then write the sample and publish it
+    slot->sequenceNumber.store(0,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->timestamp = timestamp;
+    memcpy(reinterpret_cast<char *>(slot)+sizeof(SharedMemoryRingBufferSlotHeader),data,header->nrOfChannels*sizeof(double));
+
+    slot->sequenceNumber.store(m_sequenceNumber,std::memory_order_release);
+    header->lastSequenceNumber.store(m_sequenceNumber,std::memory_order_release);
+}
+
+void SharedMemoryRingBufferWriter::close()
+{
+#ifndef _WIN32
+    if( isOpen() )
+    {
+        munmap(m_memory,m_size);
+        shm_unlink(m_name.c_str());
+    }
+#endif
+
+    m_memory = 0;
+    m_size = 0;
+}
+
+SharedMemoryRingBufferReader::SharedMemoryRingBufferReader(): m_size(0),
+                                                              m_memory(0)
+{
+}
+
+SharedMemoryRingBufferReader::~SharedMemoryRingBufferReader()
+{
+    close();
+}
+
+bool SharedMemoryRingBufferReader::open(const std::string& name)
+{
+    close();
+
+#ifdef _WIN32
+    yError() << "wholeBodyDynamics: shared memory output is not supported on this platform";
+    return false;
+#else
+    int fd = shm_open(name.c_str(),O_RDONLY,0);
+    if( fd < 0 )
+    {
+        yError() << "wholeBodyDynamics: impossible to open shared memory " << name << " : " << strerror(errno);
+        return false;
+    }
+
+    struct stat fdStat;
+    if( fstat(fd,&fdStat) != 0 || fdStat.st_size < (off_t)sizeof(SharedMemoryRingBufferHeader) )
+    {
+        yError() << "wholeBodyDynamics: shared memory " << name << " is not a valid ring buffer";
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = fdStat.st_size;
+    void * memory = mmap(0,size,PROT_READ,MAP_SHARED,fd,0);
+    ::close(fd);
+    if( memory == MAP_FAILED )
+    {
+        yError() << "wholeBodyDynamics: impossible to map shared memory " << name << " : " << strerror(errno);
+        return false;
+    }
+
+    const SharedMemoryRingBufferHeader * header = static_cast<const SharedMemoryRingBufferHeader *>(memory);
+    if( header->magic != sharedMemoryRingBufferMagic ||
+        header->version != sharedMemoryRingBufferVersion ||
+        size < sizeof(SharedMemoryRingBufferHeader)+header->nrOfSlots*slotSize(header->nrOfChannels) )
+    {
+        yError() << "wholeBodyDynamics: shared memory " << name << " is not a valid ring buffer";
+        munmap(memory,size);
+        return false;
+    }
+
+    m_memory = memory;
+    m_size = size;
+
+    return true;
+#endif
+}
+
+bool SharedMemoryRingBufferReader::isOpen() const
+{
+    return m_memory != 0;
+}
+
+size_t SharedMemoryRingBufferReader::getNrOfChannels() const
+{
+    if( !isOpen() )
+    {
+        return 0;
+    }
+
+    return static_cast<const SharedMemoryRingBufferHeader *>(m_memory)->nrOfChannels;
+}
+
+bool SharedMemoryRingBufferReader::readLatest(uint64_t& sequenceNumber, double& timestamp, double* data) const
+{
+    if( !isOpen() )
+    {
+        return false;
+    }
+
+    const SharedMemoryRingBufferHeader * header = static_cast<const SharedMemoryRingBufferHeader *>(m_memory);
+
+    uint64_t lastSequenceNumber = header->lastSequenceNumber.load(std::memory_order_acquire);
+    if( lastSequenceNumber == 0 )
+    {
+        return false;
+    }
+
+    // The memory is mapped read-only, but the slot is only read
+    const SharedMemoryRingBufferSlotHeader * slot = getSlot(const_cast<void *>(m_memory),lastSequenceNumber % header->nrOfSlots);
+
+    if( slot->sequenceNumber.load(std::memory_order_acquire) != lastSequenceNumber )
+    {
+        return false;
+    }
+
+    timestamp = slot->timestamp;
+    memcpy(data,reinterpret_cast<const char *>(slot)+sizeof(SharedMemoryRingBufferSlotHeader),header->nrOfChannels*sizeof(double));
+
+    // If the slot was overwritten while it was copied, the sample is not consistent
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if( slot->sequenceNumber.load(std::memory_order_relaxed) != lastSequenceNumber )
+    {
+        return false;
+    }
+
+    sequenceNumber = lastSequenceNumber;
+    return true;
+}
+
+void SharedMemoryRingBufferReader::close()
+{
+#ifndef _WIN32
+    if( isOpen() )
+    {
+        munmap(const_cast<void *>(m_memory),m_size);
+    }
+#endif
+
+    m_memory = 0;
+    m_size = 0;
+}
+
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2017 Fondazione Istituto Italiano di Tecnologia
+ * CopyPolicy: Released under the terms of the LGPLv2.1 or later, see LGPL.TXT
+ */
+
+/**
+ * Test of the shared memory ring buffer: a writer publishes samples in a shared
+ * memory object, and a reader (opened as a consumer of the wholeBodyDynamics
+ * device would do) is checked to always read the last complete sample.
+ */
+
+#include <wholeBodyDynamicsSharedMemory/SharedMemoryRingBuffer.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace wholeBodyDynamics;
+
+const size_t nrOfChannels = 13;
+const size_t nrOfSlots = 4;
+
+/**
+ * Value of the channel of the synthetic sample with the given sequence number.
+ */
+double syntheticValue(const uint64_t sequenceNumber, const size_t channel)
+{
+    return 1000.0*sequenceNumber+channel;
+}
+
+bool checkLatestSample(const SharedMemoryRingBufferReader & reader, const uint64_t expectedSequenceNumber)
+{
+    uint64_t sequenceNumber = 0;
+    double timestamp = 0.0;
+    std::vector<double> data(reader.getNrOfChannels());
+
+    if( !reader.readLatest(sequenceNumber,timestamp,data.data()) )
+    {
+        std::fprintf(stderr,"Impossible to read the sample %lu\n",(unsigned long)expectedSequenceNumber);
+        return false;
+    }
+
+    if( sequenceNumber != expectedSequenceNumber || timestamp != 0.5*expectedSequenceNumber )
+    {
+        std::fprintf(stderr,"Read the sample %lu (timestamp %g) instead of %lu\n",
+                     (unsigned long)sequenceNumber,timestamp,(unsigned long)expectedSequenceNumber);
+        return false;
+    }
+
+    for(size_t channel=0; channel < data.size(); channel++)
+    {
+        if( data[channel] != syntheticValue(sequenceNumber,channel) )
+        {
+            std::fprintf(stderr,"Wrong value %g of the channel %lu of the sample %lu\n",
+                         data[channel],(unsigned long)channel,(unsigned long)sequenceNumber);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main()
+{
+    std::stringstream nameStream;
+    nameStream << "/wholeBodyDynamicsSharedMemoryRingBufferTest_" << getpid();
+    std::string name = nameStream.str();
+
+    SharedMemoryRingBufferReader reader;
+    if( reader.open(name) )
+    {
+        std::fprintf(stderr,"The reader opened a shared memory that does not exist\n");
+        return EXIT_FAILURE;
+    }
+
+    SharedMemoryRingBufferWriter writer;
+    if( !writer.open(name,nrOfChannels,nrOfSlots) )
+    {
+        std::fprintf(stderr,"Impossible to create the shared memory %s\n",name.c_str());
+        return EXIT_FAILURE;
+    }
+
+    if( !reader.open(name) || reader.getNrOfChannels() != nrOfChannels )
+    {
+        std::fprintf(stderr,"Impossible to open the shared memory %s with %lu channels\n",
+                     name.c_str(),(unsigned long)nrOfChannels);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t sequenceNumber = 0;
+    double timestamp = 0.0;
+    std::vector<double> data(nrOfChannels);
+    if( reader.readLatest(sequenceNumber,timestamp,data.data()) )
+    {
+        std::fprintf(stderr,"A sample was read before any sample was written\n");
+        return EXIT_FAILURE;
+    }
+
+    // Write more samples than the slots, so that each slot is reused
+    for(uint64_t sample=1; sample <= 3*nrOfSlots+1; sample++)
+    {
+        for(size_t channel=0; channel < nrOfChannels; channel++)
+        {
+            data[channel] = syntheticValue(sample,channel);
+        }
+        writer.write(0.5*sample,data.data());
+
+        if( !checkLatestSample(reader,sample) )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The shared memory object is removed when the writer is closed
+    reader.close();
+    writer.close();
+    if( reader.open(name) )
+    {
+        std::fprintf(stderr,"The shared memory %s was not removed by the writer\n",name.c_str());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
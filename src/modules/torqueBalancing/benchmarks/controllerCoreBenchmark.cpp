@@ -0,0 +1,249 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+/**
+ * Benchmark of the cycle of the torque balancing controller (ControllerCore).
+ *
+ * The states of the robot are computed with iDynTree from a URDF model (with l_sole and r_sole frames)
+ * in random joint configurations or, if no model is passed, they are randomly generated.
+ *
+ * The benchmark is compiled with EIGEN_RUNTIME_NO_MALLOC, and the cycle is run with the
+ * Eigen heap allocations forbidden: if the cycle allocates memory the benchmark aborts
+ * (the check is done by an Eigen assertion, so it is active only if NDEBUG is not defined).
+ *
+ * The torques are compared with the ones of a reference implementation of the same controller
+ * that uses the explicit inverse of the mass matrix (tests/controllerCoreReference.h), and the accuracy of the two methods
+ * is compared on the computation of M^-1 Jc^T.
+ * The null space projectors computed from the singular vectors (default) are compared with the
+ * ones computed from the explicit pseudo inverses (NullSpaceProjectorMethodPseudoInverse).
+ * Finally the cycle is run with the contact forces computed by the QP (default parameters).
+ *
+ * Usage: torqueBalancingControllerCoreBenchmark [nrOfCycles] [model.urdf]
+ * (without model, the states have 25 actuated DOFs, as iCub without hands and eyes).
+ */
+
+#include "ControllerCore.h"
+#include "config.h"
+#include "controllerCoreReference.h"
+
+#include <iDynTree/Core/EigenHelpers.h>
+#include <iDynTree/KinDynComputations.h>
+#include <iDynTree/ModelIO/ModelLoader.h>
+
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace codyco::torquebalancing;
+
+void modelState(iDynTree::KinDynComputations& kinDynComputations, int sample, ControllerState& state)
+{
+    const iDynTree::Model& model = kinDynComputations.model();
+    int actuatedDOFs = model.getNrOfDOFs();
+
+    iDynTree::VectorDynSize jointPositions(actuatedDOFs), jointVelocities(actuatedDOFs);
+    iDynTree::toEigen(jointPositions) = 0.3 * Eigen::VectorXd::Random(actuatedDOFs);
+    iDynTree::toEigen(jointVelocities) = 0.1 * Eigen::VectorXd::Random(actuatedDOFs);
+    iDynTree::Twist baseVelocity = iDynTree::Twist::Zero();
+    iDynTree::Vector3 gravity;
+    gravity.zero();
+    gravity(2) = -9.81;
+    kinDynComputations.setRobotState(iDynTree::Transform::Identity(), jointPositions, baseVelocity, jointVelocities, gravity);
+
+    state.jointPositions = iDynTree::toEigen(jointPositions);
+    state.centerOfMassPosition = iDynTree::toEigen(kinDynComputations.getCenterOfMassPosition());
+    state.contactsPosition.col(0) = iDynTree::toEigen(kinDynComputations.getWorldTransform("l_sole").getPosition());
+    state.contactsPosition.col(1) = iDynTree::toEigen(kinDynComputations.getWorldTransform("r_sole").getPosition());
+    state.contactsOrientation.middleCols<3>(0) = iDynTree::toEigen(kinDynComputations.getWorldTransform("l_sole").getRotation());
+    state.contactsOrientation.middleCols<3>(3) = iDynTree::toEigen(kinDynComputations.getWorldTransform("r_sole").getRotation());
+    //alternate double and single support
+    state.contactsActivation(0) = 1.0;
+    state.contactsActivation(1) = (sample % 2) ? 1.0 : 0.0;
+
+    iDynTree::MatrixDynSize massMatrix(actuatedDOFs + 6, actuatedDOFs + 6);
+    kinDynComputations.getFreeFloatingMassMatrix(massMatrix);
+    state.massMatrix = iDynTree::toEigen(massMatrix);
+
+    iDynTree::FreeFloatingGeneralizedTorques biasForces(model);
+    kinDynComputations.generalizedBiasForces(biasForces);
+    state.generalizedBiasForces.head<6>() = iDynTree::toEigen(biasForces.baseWrench().asVector());
+    state.generalizedBiasForces.tail(actuatedDOFs) = iDynTree::toEigen(biasForces.jointTorques());
+    kinDynComputations.generalizedGravityForces(biasForces);
+    state.gravityBiasTorques.head<6>() = iDynTree::toEigen(biasForces.baseWrench().asVector());
+    state.gravityBiasTorques.tail(actuatedDOFs) = iDynTree::toEigen(biasForces.jointTorques());
+
+    state.centroidalMomentum = iDynTree::toEigen(kinDynComputations.getCentroidalTotalMomentum().asVector());
+
+    iDynTree::MatrixDynSize jacobian(6, actuatedDOFs + 6);
+    kinDynComputations.getFrameFreeFloatingJacobian("l_sole", jacobian);
+    state.contactsJacobian.topRows<6>() = state.contactsActivation(0) * iDynTree::toEigen(jacobian);
+    kinDynComputations.getFrameFreeFloatingJacobian("r_sole", jacobian);
+    state.contactsJacobian.bottomRows<6>() = state.contactsActivation(1) * iDynTree::toEigen(jacobian);
+    state.contactsDJacobianDq.head<6>() = state.contactsActivation(0) * iDynTree::toEigen(kinDynComputations.getFrameBiasAcc("l_sole"));
+    state.contactsDJacobianDq.tail<6>() = state.contactsActivation(1) * iDynTree::toEigen(kinDynComputations.getFrameBiasAcc("r_sole"));
+}
+
+int main(int argc, char ** argv)
+{
+    int nrOfCycles = (argc > 1) ? atoi(argv[1]) : 10000;
+    if (nrOfCycles <= 0) {
+        fprintf(stderr, "Usage: %s [nrOfCycles] [model.urdf]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    iDynTree::KinDynComputations kinDynComputations;
+    int actuatedDOFs = 25;
+    if (argc > 2) {
+        iDynTree::ModelLoader loader;
+        if (!loader.loadModelFromFile(argv[2]) || !kinDynComputations.loadRobotModel(loader.model())) {
+            fprintf(stderr, "Impossible to load model from %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+        if (kinDynComputations.model().getFrameIndex("l_sole") == iDynTree::FRAME_INVALID_INDEX
+            || kinDynComputations.model().getFrameIndex("r_sole") == iDynTree::FRAME_INVALID_INDEX) {
+            fprintf(stderr, "Frames l_sole and r_sole not found in the model\n");
+            return EXIT_FAILURE;
+        }
+        kinDynComputations.setFrameVelocityRepresentation(iDynTree::MIXED_REPRESENTATION);
+        actuatedDOFs = kinDynComputations.model().getNrOfDOFs();
+    }
+
+#ifdef NDEBUG
+    printf("NDEBUG is defined: the check of the heap allocations is disabled\n");
+#endif
+
+    //states are generated before the benchmark, to measure only the controller cycle
+    const int nrOfStates = 10;
+    std::vector<ControllerState, Eigen::aligned_allocator<ControllerState> > states(nrOfStates, ControllerState(actuatedDOFs));
+    Eigen::VectorXd contactsActivation(2);
+    for (int i = 0; i < nrOfStates; i++) {
+        if (argc > 2) {
+            modelState(kinDynComputations, i, states[i]);
+        } else {
+            //alternate double and single support
+            contactsActivation << 1.0, (i % 2) ? 1.0 : 0.0;
+            randomState(contactsActivation, states[i]);
+        }
+    }
+
+    ControllerCore core(actuatedDOFs);
+    Eigen::Vector3d desiredCOMAcceleration(0.1, 0.0, -0.1);
+    Eigen::VectorXd desiredJointsConfiguration = Eigen::VectorXd::Zero(actuatedDOFs);
+    Eigen::VectorXd impedanceGains = Eigen::VectorXd::Constant(actuatedDOFs, 10.0);
+    Eigen::VectorXd torqueSaturationLimit = Eigen::VectorXd::Constant(actuatedDOFs, 1e6);
+    Eigen::VectorXd contactForces = Eigen::VectorXd::Zero(6 * 2);
+    Eigen::VectorXd torques = Eigen::VectorXd::Zero(actuatedDOFs);
+
+    Eigen::internal::set_is_malloc_allowed(false);
+    std::chrono::steady_clock::time_point tic = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < nrOfCycles; cycle++) {
+        const ControllerState& state = states[cycle % nrOfStates];
+        core.computeContactForces(state, desiredCOMAcceleration, 1.0, contactForces);
+        if (!core.computeTorques(state, desiredJointsConfiguration, impedanceGains, torqueSaturationLimit, contactForces, torques)) {
+            fprintf(stderr, "Mass matrix is not positive definite\n");
+            return EXIT_FAILURE;
+        }
+    }
+    std::chrono::steady_clock::time_point toc = std::chrono::steady_clock::now();
+    Eigen::internal::set_is_malloc_allowed(true);
+    double coreTime = std::chrono::duration<double>(toc - tic).count() / nrOfCycles;
+
+    //same cycle with the projectors computed from the explicit pseudo inverses
+    ControllerCore pseudoInverseCore(actuatedDOFs);
+    pseudoInverseCore.setNullSpaceProjectorMethod(NullSpaceProjectorMethodPseudoInverse);
+    Eigen::internal::set_is_malloc_allowed(false);
+    tic = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < nrOfCycles; cycle++) {
+        const ControllerState& state = states[cycle % nrOfStates];
+        pseudoInverseCore.computeContactForces(state, desiredCOMAcceleration, 1.0, contactForces);
+        pseudoInverseCore.computeTorques(state, desiredJointsConfiguration, impedanceGains, torqueSaturationLimit, contactForces, torques);
+    }
+    toc = std::chrono::steady_clock::now();
+    Eigen::internal::set_is_malloc_allowed(true);
+    double pseudoInverseCoreTime = std::chrono::duration<double>(toc - tic).count() / nrOfCycles;
+
+    //same cycle with the contact forces QP
+    ControllerCore qpCore(actuatedDOFs);
+    qpCore.setContactForcesQPParameters(ContactForcesQPParameters());
+    int maximumQPIterations = 0, nonOptimalQPSolutions = 0;
+    Eigen::internal::set_is_malloc_allowed(false);
+    tic = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < nrOfCycles; cycle++) {
+        const ControllerState& state = states[cycle % nrOfStates];
+        qpCore.computeContactForces(state, desiredCOMAcceleration, 1.0, contactForces);
+        qpCore.computeTorques(state, desiredJointsConfiguration, impedanceGains, torqueSaturationLimit, contactForces, torques);
+        maximumQPIterations = std::max(maximumQPIterations, qpCore.contactForcesQPIterations());
+        if (qpCore.contactForcesQPStatus() != ActiveSetQPSolverStatusOptimal) nonOptimalQPSolutions++;
+    }
+    toc = std::chrono::steady_clock::now();
+    Eigen::internal::set_is_malloc_allowed(true);
+    double qpCoreTime = std::chrono::duration<double>(toc - tic).count() / nrOfCycles;
+
+    //reference implementation
+    std::vector<Eigen::VectorXd> expectedContactForces(nrOfStates);
+    std::vector<Eigen::MatrixXd> nullSpaces(nrOfStates);
+    for (int i = 0; i < nrOfStates; i++) {
+        referenceContactForces(states[i], desiredCOMAcceleration, 1.0, expectedContactForces[i], nullSpaces[i]);
+    }
+
+    Eigen::VectorXd referenceOutput;
+    tic = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < nrOfCycles; cycle++) {
+        int i = cycle % nrOfStates;
+        referenceOutput = referenceTorques(states[i], nullSpaces[i], desiredJointsConfiguration, impedanceGains, expectedContactForces[i]);
+    }
+    toc = std::chrono::steady_clock::now();
+    double referenceTime = std::chrono::duration<double>(toc - tic).count() / nrOfCycles;
+
+    //accuracy
+    double maxTorquesDifference = 0, maxTorques = 0, maxProjectorsDifference = 0;
+    Eigen::VectorXd pseudoInverseTorques = Eigen::VectorXd::Zero(actuatedDOFs);
+    double inverseResidual = 0, choleskyResidual = 0;
+    for (int i = 0; i < nrOfStates; i++) {
+        core.computeContactForces(states[i], desiredCOMAcceleration, 1.0, contactForces);
+        core.computeTorques(states[i], desiredJointsConfiguration, impedanceGains, torqueSaturationLimit, contactForces, torques);
+        referenceOutput = referenceTorques(states[i], nullSpaces[i], desiredJointsConfiguration, impedanceGains, expectedContactForces[i]);
+        maxTorquesDifference = std::max(maxTorquesDifference, (torques - referenceOutput).cwiseAbs().maxCoeff());
+        maxTorques = std::max(maxTorques, referenceOutput.cwiseAbs().maxCoeff());
+        pseudoInverseCore.computeContactForces(states[i], desiredCOMAcceleration, 1.0, contactForces);
+        pseudoInverseCore.computeTorques(states[i], desiredJointsConfiguration, impedanceGains, torqueSaturationLimit, contactForces, pseudoInverseTorques);
+        maxProjectorsDifference = std::max(maxProjectorsDifference, (torques - pseudoInverseTorques).cwiseAbs().maxCoeff());
+
+        Eigen::MatrixXd contactsJacobianTranspose = states[i].contactsJacobian.transpose();
+        Eigen::MatrixXd inverseSolution = states[i].massMatrix.inverse() * contactsJacobianTranspose;
+        Eigen::MatrixXd choleskySolution = states[i].massMatrix.llt().solve(contactsJacobianTranspose);
+        inverseResidual = std::max(inverseResidual, (states[i].massMatrix * inverseSolution - contactsJacobianTranspose).norm());
+        choleskyResidual = std::max(choleskyResidual, (states[i].massMatrix * choleskySolution - contactsJacobianTranspose).norm());
+    }
+
+    printf("Controller cycle with %d actuated DOFs for %d cycles\n", actuatedDOFs, nrOfCycles);
+    printf("ControllerCore (Cholesky, no heap allocations) : %.3f us per cycle\n", 1e6 * coreTime);
+    printf("ControllerCore with pseudo inverse projectors  : %.3f us per cycle\n", 1e6 * pseudoInverseCoreTime);
+    printf("ControllerCore with contact forces QP          : %.3f us per cycle (max %d iterations, %d non optimal)\n",
+           1e6 * qpCoreTime, maximumQPIterations, nonOptimalQPSolutions);
+    printf("Explicit inverse of the mass matrix            : %.3f us per cycle\n", 1e6 * referenceTime);
+    printf("Max difference between the torques             : %g (max torque %g)\n", maxTorquesDifference, maxTorques);
+    printf("Max difference between the projectors methods  : %g\n", maxProjectorsDifference);
+    printf("Max residual of M^-1 Jc^T with explicit inverse : %g\n", inverseResidual);
+    printf("Max residual of M^-1 Jc^T with Cholesky         : %g\n", choleskyResidual);
+
+    return EXIT_SUCCESS;
+}
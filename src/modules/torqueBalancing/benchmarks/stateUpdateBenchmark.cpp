@@ -0,0 +1,259 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+/**
+ * Benchmark of the computation of the state of the robot (ControllerState) used by the
+ * torque balancing controller.
+ *
+ * The baseline (SeparateStateUpdater) is iDynTree::KinDynComputations itself, with its state
+ * set again before each query: this invalidates the kinematic cache, so that every quantity
+ * (center of mass, mass matrix, centroidal momentum, jacobian, dJdq and pose of each contact,
+ * bias forces, gravity forces) runs its own traversal of the model, as the wbi calls of
+ * TorqueBalancingController::updateRobotState do. It does not run the wbi implementation:
+ * the timings only measure the cost of the repeated traversals.
+ * The fused computation (KinDynStateUpdater) sets the state once per cycle.
+ *
+ * The two states are compared to check that caching does not change the result. The consistency
+ * with the wbi (base link, velocity representation, centroidal momentum, dJdq) is checked by
+ * the controller when the fused update is enabled (see TorqueBalancingController::setDynamicsModel).
+ *
+ * Usage: torqueBalancingStateUpdateBenchmark model.urdf [nrOfCycles]
+ * (the model must contain the l_sole and r_sole frames, which are used as contacts).
+ */
+
+#include "KinDynStateUpdater.h"
+#include "ControllerCore.h"
+
+#include <iDynTree/Core/EigenHelpers.h>
+#include <iDynTree/KinDynComputations.h>
+#include <iDynTree/ModelIO/ModelLoader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace codyco::torquebalancing;
+
+/**
+ * Computes the state with one traversal of the model for each quantity
+ * (same structure of the wbi calls of TorqueBalancingController::updateRobotState, computed with iDynTree)
+ */
+class SeparateStateUpdater {
+public:
+    SeparateStateUpdater(const iDynTree::Model& model, const std::string& baseLinkName, const std::vector<std::string>& contactsFrameName)
+    : m_massMatrix(model.getNrOfDOFs() + 6, model.getNrOfDOFs() + 6)
+    , m_jacobian(6, model.getNrOfDOFs() + 6)
+    , m_jointPositions(model.getNrOfDOFs())
+    , m_jointVelocities(model.getNrOfDOFs())
+    , m_zeroJointVelocities(model.getNrOfDOFs())
+    , m_generalizedForces(model)
+    {
+        m_kinDynComputations.loadRobotModel(model);
+        m_kinDynComputations.setFloatingBase(baseLinkName);
+        m_kinDynComputations.setFrameVelocityRepresentation(iDynTree::MIXED_REPRESENTATION);
+        for (std::size_t i = 0; i < contactsFrameName.size(); i++) {
+            m_contactsFrameIndex.push_back(m_kinDynComputations.getFrameIndex(contactsFrameName[i]));
+        }
+        m_zeroJointVelocities.zero();
+    }
+
+    void updateState(const Eigen::VectorXd& jointPositions,
+                     const Eigen::VectorXd& jointVelocities,
+                     const iDynTree::Transform& worldToBase,
+                     const iDynTree::Twist& baseVelocity,
+                     const iDynTree::Vector3& gravity,
+                     ControllerState& state)
+    {
+        int actuatedDOFs = jointPositions.size();
+        iDynTree::toEigen(m_jointPositions) = jointPositions;
+        iDynTree::toEigen(m_jointVelocities) = jointVelocities;
+
+        setRobotState(worldToBase, baseVelocity, gravity);
+        state.centerOfMassPosition = iDynTree::toEigen(m_kinDynComputations.getCenterOfMassPosition());
+
+        setRobotState(worldToBase, baseVelocity, gravity);
+        m_kinDynComputations.getFreeFloatingMassMatrix(m_massMatrix);
+        state.massMatrix = iDynTree::toEigen(m_massMatrix);
+
+        setRobotState(worldToBase, baseVelocity, gravity);
+        state.centroidalMomentum = iDynTree::toEigen(m_kinDynComputations.getCentroidalTotalMomentum().asVector());
+
+        for (std::size_t contact = 0; contact < m_contactsFrameIndex.size(); contact++) {
+            double activation = state.contactsActivation(contact);
+            if (activation <= 0) {
+                state.contactsJacobian.middleRows<6>(6 * contact).setZero();
+                state.contactsDJacobianDq.segment<6>(6 * contact).setZero();
+                continue;
+            }
+            setRobotState(worldToBase, baseVelocity, gravity);
+            m_kinDynComputations.getFrameFreeFloatingJacobian(m_contactsFrameIndex[contact], m_jacobian);
+            state.contactsJacobian.middleRows<6>(6 * contact) = activation * iDynTree::toEigen(m_jacobian);
+
+            setRobotState(worldToBase, baseVelocity, gravity);
+            state.contactsDJacobianDq.segment<6>(6 * contact) = activation * iDynTree::toEigen(m_kinDynComputations.getFrameBiasAcc(m_contactsFrameIndex[contact]));
+
+            setRobotState(worldToBase, baseVelocity, gravity);
+            iDynTree::Transform worldToContact = m_kinDynComputations.getWorldTransform(m_contactsFrameIndex[contact]);
+            state.contactsPosition.col(contact) = iDynTree::toEigen(worldToContact.getPosition());
+            state.contactsOrientation.middleCols<3>(3 * contact) = iDynTree::toEigen(worldToContact.getRotation());
+        }
+
+        setRobotState(worldToBase, baseVelocity, gravity);
+        m_kinDynComputations.generalizedBiasForces(m_generalizedForces);
+        state.generalizedBiasForces.head<6>() = iDynTree::toEigen(m_generalizedForces.baseWrench().asVector());
+        state.generalizedBiasForces.tail(actuatedDOFs) = iDynTree::toEigen(m_generalizedForces.jointTorques());
+
+        //gravity torques are computed as bias forces with zero velocities
+        m_kinDynComputations.setRobotState(worldToBase, m_jointPositions, iDynTree::Twist::Zero(), m_zeroJointVelocities, gravity);
+        m_kinDynComputations.generalizedBiasForces(m_generalizedForces);
+        state.gravityBiasTorques.head<6>() = iDynTree::toEigen(m_generalizedForces.baseWrench().asVector());
+        state.gravityBiasTorques.tail(actuatedDOFs) = iDynTree::toEigen(m_generalizedForces.jointTorques());
+    }
+
+private:
+    void setRobotState(const iDynTree::Transform& worldToBase, const iDynTree::Twist& baseVelocity, const iDynTree::Vector3& gravity)
+    {
+        m_kinDynComputations.setRobotState(worldToBase, m_jointPositions, baseVelocity, m_jointVelocities, gravity);
+    }
+
+    iDynTree::KinDynComputations m_kinDynComputations;
+    std::vector<iDynTree::FrameIndex> m_contactsFrameIndex;
+    iDynTree::MatrixDynSize m_massMatrix;
+    iDynTree::MatrixDynSize m_jacobian;
+    iDynTree::VectorDynSize m_jointPositions;
+    iDynTree::VectorDynSize m_jointVelocities;
+    iDynTree::VectorDynSize m_zeroJointVelocities;
+    iDynTree::FreeFloatingGeneralizedTorques m_generalizedForces;
+};
+
+double maximumDifference(const ControllerState& state1, const ControllerState& state2)
+{
+    double difference = (state1.centerOfMassPosition - state2.centerOfMassPosition).lpNorm<Eigen::Infinity>();
+    difference = std::max(difference, (state1.massMatrix - state2.massMatrix).lpNorm<Eigen::Infinity>());
+    difference = std::max(difference, (state1.centroidalMomentum - state2.centroidalMomentum).lpNorm<Eigen::Infinity>());
+    difference = std::max(difference, (state1.generalizedBiasForces - state2.generalizedBiasForces).lpNorm<Eigen::Infinity>());
+    difference = std::max(difference, (state1.gravityBiasTorques - state2.gravityBiasTorques).lpNorm<Eigen::Infinity>());
+    difference = std::max(difference, (state1.contactsJacobian - state2.contactsJacobian).lpNorm<Eigen::Infinity>());
+    difference = std::max(difference, (state1.contactsDJacobianDq - state2.contactsDJacobianDq).lpNorm<Eigen::Infinity>());
+    difference = std::max(difference, (state1.contactsPosition - state2.contactsPosition).lpNorm<Eigen::Infinity>());
+    difference = std::max(difference, (state1.contactsOrientation - state2.contactsOrientation).lpNorm<Eigen::Infinity>());
+    return difference;
+}
+
+int main(int argc, char ** argv)
+{
+    int nrOfCycles = (argc > 2) ? atoi(argv[2]) : 10000;
+    if (argc < 2 || nrOfCycles <= 0) {
+        fprintf(stderr, "Usage: %s model.urdf [nrOfCycles]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    iDynTree::ModelLoader loader;
+    if (!loader.loadModelFromFile(argv[1])) {
+        fprintf(stderr, "Impossible to load model from %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    const iDynTree::Model& model = loader.model();
+    std::vector<std::string> jointsName;
+    for (iDynTree::JointIndex joint = 0; joint < static_cast<iDynTree::JointIndex>(model.getNrOfJoints()); joint++) {
+        if (model.getJoint(joint)->getNrOfDOFs() > 0) jointsName.push_back(model.getJointName(joint));
+    }
+    std::string baseLinkName = model.getLinkName(model.getDefaultBaseLink());
+    std::vector<std::string> contactsFrameName;
+    contactsFrameName.push_back("l_sole");
+    contactsFrameName.push_back("r_sole");
+
+    KinDynStateUpdater fusedUpdater;
+    if (!fusedUpdater.loadModelFromFile(argv[1], jointsName, baseLinkName) || !fusedUpdater.setContactsFrames(contactsFrameName)) {
+        fprintf(stderr, "Frames l_sole and r_sole not found in the model\n");
+        return EXIT_FAILURE;
+    }
+    int actuatedDOFs = fusedUpdater.actuatedDOFs();
+    SeparateStateUpdater separateUpdater(model, baseLinkName, contactsFrameName);
+
+#ifdef NDEBUG
+    printf("NDEBUG is defined: the check of the heap allocations is disabled\n");
+#endif
+
+    //inputs are generated before the benchmark, to measure only the state update
+    const int nrOfInputs = 10;
+    std::vector<Eigen::VectorXd> jointPositions(nrOfInputs), jointVelocities(nrOfInputs);
+    std::vector<Eigen::Matrix<double, 6, 1>, Eigen::aligned_allocator<Eigen::Matrix<double, 6, 1> > > baseVelocities(nrOfInputs);
+    for (int i = 0; i < nrOfInputs; i++) {
+        jointPositions[i] = 0.3 * Eigen::VectorXd::Random(actuatedDOFs);
+        jointVelocities[i] = 0.1 * Eigen::VectorXd::Random(actuatedDOFs);
+        baseVelocities[i] = 0.1 * Eigen::Matrix<double, 6, 1>::Random();
+    }
+    Eigen::Matrix4d worldToBase = Eigen::Matrix4d::Identity();
+    worldToBase(2, 3) = 0.6;
+    Eigen::Vector3d gravity(0, 0, -9.81);
+
+    ControllerState fusedState(actuatedDOFs, contactsFrameName.size());
+    fusedState.contactsActivation.setOnes();
+
+    Eigen::internal::set_is_malloc_allowed(false);
+    std::chrono::steady_clock::time_point tic = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < nrOfCycles; cycle++) {
+        int input = cycle % nrOfInputs;
+        if (!fusedUpdater.updateState(jointPositions[input], jointVelocities[input], worldToBase, baseVelocities[input], gravity, fusedState)) {
+            fprintf(stderr, "Failed to compute the state of the robot\n");
+            return EXIT_FAILURE;
+        }
+    }
+    std::chrono::steady_clock::time_point toc = std::chrono::steady_clock::now();
+    Eigen::internal::set_is_malloc_allowed(true);
+    double fusedTime = std::chrono::duration<double>(toc - tic).count() / nrOfCycles;
+
+    ControllerState separateState(actuatedDOFs, contactsFrameName.size());
+    separateState.contactsActivation.setOnes();
+    iDynTree::Transform iDynTreeWorldToBase;
+    iDynTree::Rotation rotation;
+    iDynTree::toEigen(rotation) = worldToBase.topLeftCorner<3, 3>();
+    iDynTree::Position position;
+    iDynTree::toEigen(position) = worldToBase.topRightCorner<3, 1>();
+    iDynTreeWorldToBase.setRotation(rotation);
+    iDynTreeWorldToBase.setPosition(position);
+    std::vector<iDynTree::Twist> iDynTreeBaseVelocities(nrOfInputs);
+    for (int i = 0; i < nrOfInputs; i++) {
+        iDynTree::toEigen(iDynTreeBaseVelocities[i].getLinearVec3()) = baseVelocities[i].head<3>();
+        iDynTree::toEigen(iDynTreeBaseVelocities[i].getAngularVec3()) = baseVelocities[i].tail<3>();
+    }
+    iDynTree::Vector3 iDynTreeGravity;
+    iDynTree::toEigen(iDynTreeGravity) = gravity;
+
+    tic = std::chrono::steady_clock::now();
+    for (int cycle = 0; cycle < nrOfCycles; cycle++) {
+        int input = cycle % nrOfInputs;
+        separateUpdater.updateState(jointPositions[input], jointVelocities[input], iDynTreeWorldToBase, iDynTreeBaseVelocities[input], iDynTreeGravity, separateState);
+    }
+    toc = std::chrono::steady_clock::now();
+    double separateTime = std::chrono::duration<double>(toc - tic).count() / nrOfCycles;
+
+    double difference = 0;
+    for (int i = 0; i < nrOfInputs; i++) {
+        fusedUpdater.updateState(jointPositions[i], jointVelocities[i], worldToBase, baseVelocities[i], gravity, fusedState);
+        separateUpdater.updateState(jointPositions[i], jointVelocities[i], iDynTreeWorldToBase, iDynTreeBaseVelocities[i], iDynTreeGravity, separateState);
+        difference = std::max(difference, maximumDifference(fusedState, separateState));
+    }
+
+    printf("State update with %d actuated DOFs and 2 active contacts for %d cycles\n", actuatedDOFs, nrOfCycles);
+    printf("Separate traversal for each quantity : %g us per cycle\n", separateTime * 1e6);
+    printf("Fused (single traversal)             : %g us per cycle (%.1fx)\n", fusedTime * 1e6, separateTime / fusedTime);
+    printf("Max difference between the states    : %g\n", difference);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef ACTIVESETQPSOLVER_H
+#define ACTIVESETQPSOLVER_H
+
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        /** Result of ActiveSetQPSolver#solve */
+        typedef enum {
+            ActiveSetQPSolverStatusOptimal, /*!< The solution is the optimum of the problem */
+            ActiveSetQPSolverStatusMaximumIterationsReached, /*!< The solution is feasible but not optimal */
+            ActiveSetQPSolverStatusInfeasibleStartingPoint, /*!< Neither the previous solution nor the given point are feasible */
+            ActiveSetQPSolverStatusHessianNotPositiveDefinite, /*!< The hessian is not positive definite */
+            ActiveSetQPSolverStatusWorkingSetFull /*!< A constraint blocks the step but the working set is full: the solution is feasible but not optimal */
+        } ActiveSetQPSolverStatus;
+
+        /** @brief Primal active-set solver for small dense strictly convex QPs.
+         *
+         * Solves
+         * min 1/2 x^T H x + g^T x
+         * s.t. C x <= d
+         * with H positive definite.
+         *
+         * Each iteration solves the equality constrained problem on the working set with
+         * the range-space method, using the Cholesky factor of H (computed once per solve).
+         * All the iterates are feasible, so if the maximum number of iterations is reached
+         * the returned solution still satisfies the constraints.
+         * The working set has at most variables constraints: if a constraint blocks the step when
+         * the working set is full (which happens only because of numerical errors, as the step
+         * should be zero), the solver returns the current feasible point instead of iterating
+         * without progress until the maximum number of iterations.
+         * The solver is warm-started with the solution and the working set of the previous call,
+         * if the previous solution is feasible for the new constraints.
+         * All the workspaces are allocated by the constructor, so solve does not allocate memory.
+         */
+        class ActiveSetQPSolver {
+        public:
+            /** Constructor
+             * @param variables number of optimization variables
+             * @param maximumConstraints maximum number of (inequality) constraints
+             */
+            ActiveSetQPSolver(int variables, int maximumConstraints);
+
+            /** Solves the QP problem
+             *
+             * @param hessian variables x variables positive definite matrix H
+             * @param gradient variables vector g
+             * @param constraintsMatrix constraints x variables matrix C (constraints <= maximumConstraints)
+             * @param constraintsBounds constraints vector d
+             * @param feasiblePoint point satisfying the constraints, used if the previous solution is not feasible
+             * @param maximumIterations maximum number of active set iterations
+             * @return the status of the solution
+             */
+            ActiveSetQPSolverStatus solve(const Eigen::Ref<const Eigen::MatrixXd>& hessian,
+                                          const Eigen::Ref<const Eigen::VectorXd>& gradient,
+                                          const Eigen::Ref<const Eigen::MatrixXd>& constraintsMatrix,
+                                          const Eigen::Ref<const Eigen::VectorXd>& constraintsBounds,
+                                          const Eigen::Ref<const Eigen::VectorXd>& feasiblePoint,
+                                          int maximumIterations);
+
+            /** Returns the last computed solution
+             * @return variables vector
+             */
+            const Eigen::VectorXd& solution() const;
+
+            /** Returns the number of iterations of the last solve
+             * @return the number of iterations
+             */
+            int iterations() const;
+
+            /** Discards the solution and the working set of the previous solve
+             */
+            void resetWarmStart();
+
+            /** Sets the tolerance used to check the feasibility of the constraints
+             * and the termination of the iterations
+             * @param tolerance the new tolerance. Default 1e-9
+             */
+            void setTolerance(double tolerance);
+
+        private:
+            bool isFeasible(const Eigen::Ref<const Eigen::VectorXd>& point,
+                            const Eigen::Ref<const Eigen::MatrixXd>& constraintsMatrix,
+                            const Eigen::Ref<const Eigen::VectorXd>& constraintsBounds) const;
+            bool solveEqualityConstrainedProblem(const Eigen::Ref<const Eigen::MatrixXd>& constraintsMatrix);
+            void removeFromWorkingSet(int workingSetIndex);
+
+            int m_variables;
+            int m_maximumConstraints;
+            double m_tolerance;
+
+            Eigen::LLT<Eigen::MatrixXd> m_lltDecompositionOfHessian; /*!< variables x variables */
+            Eigen::VectorXd m_solution; /*!< variables */
+            bool m_hasPreviousSolution;
+            int m_iterations;
+
+            Eigen::VectorXi m_workingSet; /*!< variables: only the first m_workingSetSize elements are valid */
+            int m_workingSetSize;
+            Eigen::VectorXi m_isInWorkingSet; /*!< maximumConstraints */
+
+            Eigen::VectorXd m_gradientAtSolution; /*!< variables: H x + g, then L^-1 (H x + g) */
+            Eigen::MatrixXd m_LInvCwt; /*!< variables x variables: L^-1 C_W^T (only the first m_workingSetSize columns are valid) */
+            Eigen::MatrixXd m_workingSetMatrix; /*!< variables x variables: Cholesky factor of C_W H^-1 C_W^T (top left block) */
+            Eigen::VectorXd m_multipliers; /*!< variables: multipliers of the working set (first m_workingSetSize elements) */
+            Eigen::VectorXd m_step; /*!< variables */
+            Eigen::VectorXd m_constraintsStep; /*!< maximumConstraints: C p */
+            Eigen::VectorXd m_constraintsResidual; /*!< maximumConstraints: d - C x */
+        };
+    }
+}
+
+#endif /* end of include guard: ACTIVESETQPSOLVER_H */
@@ -0,0 +1,252 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef CONTROLLERCORE_H
+#define CONTROLLERCORE_H
+
+#include "ActiveSetQPSolver.h"
+#include "PseudoInverse.h"
+#include "config.h"
+
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+#include <Eigen/LU>
+
+#include <vector>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        /** @brief State of the robot used by the controller at each cycle.
+         *
+         * Contacts quantities are stacked in the order of the contacts set of the controller
+         * (e.g. [left foot, right foot]).
+         */
+        struct ControllerState {
+            /** Constructor
+             * @param actuatedDOFs number of joint actuated
+             * @param contacts number of contacts (active or not) of the robot
+             */
+            explicit ControllerState(int actuatedDOFs, int contacts = 2);
+
+            Eigen::VectorXd jointPositions; /*!< actuatedDOFs */
+            Eigen::Vector3d centerOfMassPosition;
+            Eigen::Matrix3Xd contactsPosition; /*!< 3 x contacts: origin of the contact frames */
+            Eigen::Matrix3Xd contactsOrientation; /*!< 3 x (3 x contacts): rotations from the contact frames to the world frame */
+            Eigen::VectorXd contactsActivation; /*!< contacts: continuous value of the constraints. 0 if the constraint is not active */
+
+            Eigen::MatrixXd massMatrix; /*!< totalDOFs x totalDOFs */
+            Eigen::VectorXd generalizedBiasForces; /*!< totalDOFs */
+            Eigen::VectorXd gravityBiasTorques; /*!< totalDOFs */
+            Eigen::Matrix<double, 6, 1> centroidalMomentum;
+            Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> contactsJacobian; /*!< (6 x contacts) x totalDOFs, already multiplied by the constraints activation */
+            Eigen::VectorXd contactsDJacobianDq; /*!< (6 x contacts), already multiplied by the constraints activation */
+
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        };
+
+        /** @brief Parameters of the QP computing the contact forces.
+         *
+         * The same parameters are used for all the contacts.
+         * The constraints are expressed in the frame of each contact, whose z axis
+         * is the normal of the contact surface (pointing towards the robot).
+         * The center of pressure is expressed with respect to the origin of the contact frame.
+         */
+        struct ContactForcesQPParameters {
+            /** Constructor. Initializes the parameters to their default values
+             */
+            ContactForcesQPParameters();
+
+            double frictionCoefficient; /*!< static friction coefficient. Default 1/3 */
+            int frictionConeSides; /*!< sides of the linearized (inner) friction cone. Default 4 */
+            Eigen::Vector2d minimumCenterOfPressure; /*!< lower bounds of the x and y coordinates of the CoP. Default (-0.03, -0.025) */
+            Eigen::Vector2d maximumCenterOfPressure; /*!< upper bounds of the x and y coordinates of the CoP. Default (0.08, 0.025) */
+            double minimumNormalForce; /*!< Default 0 */
+            double maximumNormalForce; /*!< Default infinity */
+            double regularization; /*!< weight of the norm of the contact forces in the cost. Default 1e-6 */
+            int maximumIterations; /*!< maximum number of iterations of the active set solver. Default 20 */
+
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        };
+
+        /** @brief Computations of the torque balancing controller.
+         *
+         * All the workspaces are allocated by the constructor, so the computation
+         * of the contact forces and of the torques does not allocate memory.
+         * Quantities whose size does not depend on the robot (base and centroidal quantities)
+         * use fixed-size Eigen types.
+         * The active contacts are compacted in the leading rows (and columns) of the workspaces,
+         * and the computations use only the leading 6 x active contacts rows, so their cost depends on
+         * the number of active contacts and not on the number of contacts of the robot.
+         * The decompositions (SVDs, QP solver) can not change size without allocating memory,
+         * so one of them is allocated for each number of active contacts.
+         * This class does not depend on the robot interface, so it can be used (and benchmarked)
+         * on any source of ControllerState.
+         */
+        class ControllerCore {
+        public:
+            /** Constructor
+             * @param actuatedDOFs number of joint actuated (dimension of output torques)
+             * @param contacts number of contacts (active or not) of the robot
+             */
+            explicit ControllerCore(int actuatedDOFs, int contacts = 2);
+
+            /** Returns the number of contacts (active or not) handled by the controller
+             * @return the number of contacts
+             */
+            int contacts() const;
+
+            /** Enables the computation of the contact forces with a QP
+             *
+             * The contact forces minimize the error on the desired rate of change of the centroidal momentum
+             * subject to linearized friction cones, center of pressure bounds and normal force limits.
+             * This function allocates memory, so it should not be called in the control loop.
+             * @param parameters parameters of the QP
+             * @return true if the parameters are valid. If false, the previous configuration is not changed
+             */
+            bool setContactForcesQPParameters(const ContactForcesQPParameters& parameters);
+
+            /** Returns the parameters of the contact forces QP
+             * @return the parameters of the QP
+             */
+            const ContactForcesQPParameters& contactForcesQPParameters() const;
+
+            /** Disables the computation of the contact forces with the QP
+             */
+            void disableContactForcesQP();
+
+            /** Returns true if the contact forces are computed with the QP
+             * @return true if the QP is enabled
+             */
+            bool isContactForcesQPEnabled() const;
+
+            /** Returns the status of the last solution of the contact forces QP
+             * @return the status of the QP solver
+             */
+            ActiveSetQPSolverStatus contactForcesQPStatus() const;
+
+            /** Returns the number of iterations of the last solution of the contact forces QP
+             * @return the number of iterations
+             */
+            int contactForcesQPIterations() const;
+
+            /** Sets the computation of the null space projectors used in computeTorques
+             * @param method the new method. Default is TorquesNullSpaceProjectorMethod (config.h)
+             */
+            void setNullSpaceProjectorMethod(NullSpaceProjectorMethod method);
+
+            /** Returns the computation of the null space projectors used in computeTorques
+             * @return the current method
+             */
+            NullSpaceProjectorMethod nullSpaceProjectorMethod() const;
+
+            /** Computes the contact forces realizing the desired rate of change of the centroidal momentum
+             *
+             * If the QP is enabled and it is solved, the contact forces satisfy the contact constraints,
+             * and they are not modified in the computation of the torques (the null space of the
+             * centroidal force matrix is set to zero). Otherwise the unconstrained solution is used.
+             * @param state state of the robot
+             * @param desiredCOMAcceleration desired acceleration of the center of mass
+             * @param centroidalMomentumGain gain on the angular part of the centroidal momentum
+             * @param[out] desiredContactForces (6 x contacts) contact forces. The forces of the inactive contacts are zero
+             */
+            void computeContactForces(const ControllerState& state,
+                                      const Eigen::Vector3d& desiredCOMAcceleration,
+                                      double centroidalMomentumGain,
+                                      Eigen::Ref<Eigen::VectorXd> desiredContactForces);
+
+            /** Computes the torques realizing the contact forces
+             *
+             * This function uses the null space of the centroidal force matrix computed
+             * by the last call to computeContactForces
+             * @param state state of the robot
+             * @param desiredJointsConfiguration postural reference (actuatedDOFs)
+             * @param impedanceGains postural gains (actuatedDOFs)
+             * @param torqueSaturationLimit absolute limit of the torques (actuatedDOFs)
+             * @param desiredContactForces (6 x contacts) contact forces
+             * @param[out] torques actuatedDOFs output torques
+             * @return false if the mass matrix is not positive definite. In this case torques are not modified
+             */
+            bool computeTorques(const ControllerState& state,
+                                const Eigen::VectorXd& desiredJointsConfiguration,
+                                const Eigen::VectorXd& impedanceGains,
+                                const Eigen::VectorXd& torqueSaturationLimit,
+                                const Eigen::Ref<const Eigen::VectorXd>& desiredContactForces,
+                                Eigen::Ref<Eigen::VectorXd> torques);
+
+        private:
+            void updateActiveContacts(const ControllerState& state);
+            bool computeContactForcesWithQP(const ControllerState& state);
+
+            int m_actuatedDOFs;
+            int m_contacts;
+
+            //active contacts: contact quantities are stored in the order of m_activeContactsIndices
+            int m_activeContacts;
+            Eigen::VectorXi m_activeContactsIndices; /*!< contacts: only the first m_activeContacts elements are valid */
+            Eigen::VectorXd m_activeContactForces; /*!< (6 x contacts) */
+
+            //contact forces computation
+            Eigen::MatrixXd m_centroidalForceMatrix; /*!< 6 x (6 x contacts) */
+            Eigen::Matrix<double, 6, 1> m_gravityForce;
+            Eigen::Matrix<double, 6, 1> m_desiredCentroidalMomentum;
+            Eigen::Matrix<double, 6, 1> m_centroidalMomentumError; /*!< desired centroidal momentum minus gravity force */
+            std::vector<PseudoInverse> m_pseudoInversesOfCentroidalForceMatrix; /*!< for each number of active contacts: (6 x active contacts) x 6 */
+            Eigen::MatrixXd m_nullSpaceOfCentroidalForceMatrix; /*!< (6 x contacts) x (6 x contacts) */
+            Eigen::PartialPivLU<Eigen::Matrix<double, 6, 6> > m_luDecompositionOfCentroidalMatrix; /*!< Used for plain inversion */
+
+            //contact forces QP
+            bool m_contactForcesQPEnabled;
+            ContactForcesQPParameters m_contactForcesQPParameters;
+            Eigen::MatrixXd m_localContactConstraints; /*!< constraintsPerContact x 6: constraints on the wrench in the contact frame */
+            Eigen::VectorXd m_localContactConstraintsBounds; /*!< constraintsPerContact */
+            Eigen::MatrixXd m_qpHessian; /*!< (6 x contacts) x (6 x contacts) */
+            Eigen::VectorXd m_qpGradient; /*!< (6 x contacts) */
+            Eigen::MatrixXd m_qpConstraints; /*!< (constraintsPerContact x contacts) x (6 x contacts) */
+            Eigen::VectorXd m_qpConstraintsBounds; /*!< (constraintsPerContact x contacts) */
+            Eigen::VectorXd m_qpFeasiblePoint; /*!< (6 x contacts) */
+            std::vector<ActiveSetQPSolver> m_contactForcesQPSolvers; /*!< for each number of active contacts: (6 x active contacts) variables */
+            ActiveSetQPSolverStatus m_contactForcesQPStatus;
+            int m_contactForcesQPIterations;
+
+            //torques computation
+            NullSpaceProjectorMethod m_nullSpaceProjectorMethod;
+            Eigen::LLT<Eigen::MatrixXd> m_lltDecompositionOfMassMatrix; /*!< totalDOFs x totalDOFs */
+            Eigen::LLT<Eigen::Matrix<double, 6, 6> > m_lltDecompositionOfBaseMassMatrix;
+            Eigen::MatrixXd m_LInvJct; /*!< totalDOFs x (6 x contacts): L^-1 Jc^T, with L the Cholesky factor of the mass matrix */
+            Eigen::MatrixXd m_MInvJct; /*!< totalDOFs x (6 x contacts) */
+            Eigen::MatrixXd m_JcMInvJct; /*!< (6 x contacts) x (6 x contacts), only the lower triangular part is valid */
+            Eigen::MatrixXd m_JcMInvTorqueSelector; /*!< (6 x contacts) x actuatedDOFs */
+            Eigen::MatrixXd m_jointProjectedBaseAccelerationsTranspose; /*!< 6 x actuatedDOFs */
+            Eigen::MatrixXd m_activeContactsJacobian; /*!< (6 x contacts) x totalDOFs */
+            Eigen::VectorXd m_activeContactsDJacobianDq; /*!< (6 x contacts) */
+            std::vector<PseudoInverse> m_pseudoInversesOfJcMInvSt; /*!< for each number of active contacts: actuatedDOFs x (6 x active contacts) */
+            Eigen::MatrixXd m_nullSpaceProjectorOfJcMInvSt; /*!< actuatedDOFs x actuatedDOFs */
+            Eigen::MatrixXd m_mult_f_tau0; /*!< actuatedDOFs x (6 x contacts) */
+            Eigen::MatrixXd m_mult_f_tau; /*!< actuatedDOFs x (6 x contacts) */
+            Eigen::MatrixXd m_mult_f_tauTimesNullSpace; /*!< actuatedDOFs x (6 x contacts) */
+            std::vector<PseudoInverse> m_pseudoInversesOfTauN0_f; /*!< for each number of active contacts: (6 x active contacts) x actuatedDOFs */
+            Eigen::VectorXd m_torques0; /*!< actuatedDOFs */
+            Eigen::VectorXd m_n_tau; /*!< actuatedDOFs */
+            Eigen::VectorXd m_unprojectedTorques; /*!< actuatedDOFs */
+            Eigen::VectorXd m_contactsVector; /*!< (6 x contacts) */
+
+        public:
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        };
+    }
+}
+
+#endif /* end of include guard: CONTROLLERCORE_H */
@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef KINDYNSTATEUPDATER_H
+#define KINDYNSTATEUPDATER_H
+
+#include <iDynTree/KinDynComputations.h>
+#include <iDynTree/Core/MatrixDynSize.h>
+#include <iDynTree/Core/VectorDynSize.h>
+#include <iDynTree/Model/FreeFloatingState.h>
+
+#include <Eigen/Core>
+
+#include <string>
+#include <vector>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        struct ControllerState;
+
+        /** @brief Computes the ControllerState from a single kinematic traversal of the model.
+         *
+         * The state of the robot is set once per cycle in iDynTree::KinDynComputations, which caches
+         * the forward kinematics (positions and velocities) of all the links.
+         * The mass matrix, the centroidal momentum, the bias forces and the contacts quantities
+         * are then computed from the cached kinematics, instead of running one traversal of the
+         * model for each quantity (as the separate wbi calls do).
+         *
+         * Velocities are expressed in the mixed representation and the floating base is set
+         * explicitly, to match the quantities computed by the wbi.
+         * All the buffers are allocated when the model is loaded.
+         */
+        class KinDynStateUpdater {
+        public:
+            /** Constructor
+             */
+            KinDynStateUpdater();
+
+            /** Loads the model of the robot
+             *
+             * @param urdfFile path of the URDF model
+             * @param jointsName actuated joints, in the order of the controller
+             * @param baseLinkName floating base link, i.e. the link of the worldToBase pose and
+             * of the base velocity passed to updateState
+             * @return true if the model is loaded and it contains all the joints and the base link
+             */
+            bool loadModelFromFile(const std::string& urdfFile, const std::vector<std::string>& jointsName, const std::string& baseLinkName);
+
+            /** Sets the frames of the contacts
+             *
+             * @param contactsFrameName frames of the contacts, in the order of the contacts of the controller
+             * @return true if all the frames exist in the model
+             */
+            bool setContactsFrames(const std::vector<std::string>& contactsFrameName);
+
+            /** Returns the number of actuated DOFs of the loaded model
+             * @return the number of actuated DOFs
+             */
+            int actuatedDOFs() const;
+
+            /** Computes the state of the robot
+             *
+             * The contacts quantities (jacobians, dJdq, poses) are computed only for the contacts
+             * whose activation is positive. The other ones have zero jacobians and dJdq.
+             * @param jointPositions actuatedDOFs joints positions
+             * @param jointVelocities actuatedDOFs joints velocities
+             * @param worldToBase pose of the base with respect to the world
+             * @param baseVelocity velocity of the base (linear, angular)
+             * @param gravity gravity acceleration in the world frame
+             * @param[in,out] state state of the robot. contactsActivation is used as input
+             * and jointPositions is not modified
+             * @return true on success
+             */
+            bool updateState(const Eigen::Ref<const Eigen::VectorXd>& jointPositions,
+                             const Eigen::Ref<const Eigen::VectorXd>& jointVelocities,
+                             const Eigen::Matrix4d& worldToBase,
+                             const Eigen::Matrix<double, 6, 1>& baseVelocity,
+                             const Eigen::Vector3d& gravity,
+                             ControllerState& state);
+
+        private:
+            iDynTree::KinDynComputations m_kinDynComputations;
+            std::vector<iDynTree::FrameIndex> m_contactsFrameIndex;
+
+            iDynTree::Transform m_worldToBase;
+            iDynTree::VectorDynSize m_jointPositions; /*!< actuatedDOFs */
+            iDynTree::VectorDynSize m_jointVelocities; /*!< actuatedDOFs */
+            iDynTree::Twist m_baseVelocity;
+            iDynTree::Vector3 m_gravity;
+
+            iDynTree::MatrixDynSize m_massMatrix; /*!< totalDOFs x totalDOFs */
+            iDynTree::MatrixDynSize m_jacobian; /*!< 6 x totalDOFs */
+            iDynTree::FreeFloatingGeneralizedTorques m_generalizedForces;
+        };
+    }
+}
+
+#endif /* end of include guard: KINDYNSTATEUPDATER_H */
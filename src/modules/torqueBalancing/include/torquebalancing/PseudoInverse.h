@@ -0,0 +1,94 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef PSEUDOINVERSE_H
+#define PSEUDOINVERSE_H
+
+#include <Eigen/Core>
+#include <Eigen/SVD>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        /** @brief Pseudo inverse of matrices of a given size.
+         *
+         * Same computation of math::pseudoInverse, but all the workspaces (SVD included)
+         * are allocated by the constructor, so that the computations do not allocate memory.
+         */
+        class PseudoInverse {
+        public:
+            /** Constructor
+             * @param rows rows of the matrices to be inverted
+             * @param cols columns of the matrices to be inverted
+             * @param computationOptions options of the SVD decomposition (U and V must be computed)
+             */
+            PseudoInverse(int rows, int cols, unsigned int computationOptions = Eigen::ComputeThinU | Eigen::ComputeThinV);
+
+            /** Computes the pseudo inverse of the matrix
+             *
+             * @param matrix rows x cols matrix to be inverted
+             * @param tolerance singular values smaller than tolerance are considered zero
+             */
+            void compute(const Eigen::Ref<const Eigen::MatrixXd>& matrix, double tolerance);
+
+            /** Computes only the SVD and the rank of the matrix, without forming the pseudo inverse
+             *
+             * Use this if only the projectors are needed
+             * @param matrix rows x cols matrix
+             * @param tolerance singular values smaller than tolerance are considered zero
+             */
+            void computeDecomposition(const Eigen::Ref<const Eigen::MatrixXd>& matrix, double tolerance);
+
+            /** Computes the projector in the null space of the last decomposed matrix A,
+             * i.e. I - pinv(A) A, as I - V_r V_r^T with V_r the first rank right singular vectors
+             *
+             * @param[out] projector cols x cols projector
+             */
+            void computeNullSpaceProjector(Eigen::Ref<Eigen::MatrixXd> projector) const;
+
+            /** Projects a vector in the null space of the transpose of the last decomposed matrix A,
+             * i.e. computes (I - A pinv(A)) vector, as vector - U_r U_r^T vector with U_r the first rank
+             * left singular vectors
+             *
+             * @param[in,out] vector rows vector
+             */
+            void projectOnLeftNullSpace(Eigen::Ref<Eigen::VectorXd> vector);
+
+            /** Returns the last computed pseudo inverse
+             * @return cols x rows pseudo inverse
+             */
+            const Eigen::MatrixXd& pseudoInverse() const;
+
+            /** Returns the rank of the last inverted matrix
+             * @return the rank
+             */
+            int rank() const;
+
+        private:
+            void computePseudoInverseFromSingularValuesInverse();
+
+            Eigen::MatrixXd m_matrix; /*!< rows x cols: copy of the decomposed matrix, as the SVD takes only plain matrices */
+            Eigen::JacobiSVD<Eigen::MatrixXd> m_svd;
+            unsigned int m_computationOptions;
+            Eigen::VectorXd m_singularValuesInverse; /*!< min(rows, cols) */
+            Eigen::MatrixXd m_scaledV; /*!< cols x min(rows, cols) */
+            Eigen::MatrixXd m_pseudoInverse; /*!< cols x rows */
+            Eigen::VectorXd m_projectionCoefficients; /*!< min(rows, cols) */
+            int m_rank;
+        };
+    }
+}
+
+#endif /* end of include guard: PSEUDOINVERSE_H */
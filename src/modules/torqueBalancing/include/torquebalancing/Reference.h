@@ -38,6 +38,9 @@ namespace codyco {
          * The size is passed at construction and cannot be changed. It can be obtained by calling valueSize() function.
          * The content of this object which is not valid is not guaranteed to contain meaningful values (i.e. it can be garbage, so do not use it).
          * This class is thread-safe for setting and reading values.
+         * The value is also published in a lock-free mailbox (see ReferenceMailbox), so a single
+         * real-time reader (the controller) can read it with readLatestValue without ever blocking.
+         * Only one thread at the time should set the value.
          */
         class Reference
         {
@@ -55,6 +58,15 @@ namespace codyco {
              * @return the current value
              */
             const Eigen::VectorXd& value() const;
+
+            /** Copies the most recent value, if it is valid.
+             *
+             * This function never blocks and it does not allocate memory, but only one thread
+             * at the time can call it (it is meant for the controller thread).
+             * @param[out] value the most recent value. It is not modified if the value is not valid
+             * @return true if the most recent value is valid. False otherwise
+             */
+            bool readLatestValue(Eigen::Ref<Eigen::VectorXd> value);
             
             /** Sets the value for the current reference.
              * The state of the reference automatically switch to active.
@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef REFERENCEMAILBOX_H
+#define REFERENCEMAILBOX_H
+
+#include <Eigen/Core>
+
+#include <atomic>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        /** @brief Lock-free exchange of the last value of a reference between one writer and one reader.
+         *
+         * The value is exchanged through a triple buffer, so neither the writer nor the reader
+         * ever wait for each other: the writer copies the new value in the back buffer and swaps
+         * it with the middle one, while the reader swaps the front buffer with the middle one
+         * only if it contains a value that was not read yet.
+         * The reader always sees a consistent value (never a partially written one), and it sees
+         * the most recent value written before the call to read.
+         *
+         * Only one thread at the time can call write, and only one thread at the time can call read
+         * (value and isValid must be called by the reader thread).
+         * All the buffers are allocated by the constructor.
+         */
+        class ReferenceMailbox {
+        public:
+            /** Constructor
+             * @param valueSize size of the exchanged values
+             */
+            explicit ReferenceMailbox(int valueSize);
+
+            /** Publishes a new value. Never blocks
+             *
+             * @param value valueSize vector
+             * @param isValid validity of the value
+             */
+            void write(const Eigen::Ref<const Eigen::VectorXd>& value, bool isValid = true);
+
+            /** Takes the most recent value published by the writer, if there is a new one. Never blocks
+             *
+             * @return true if a new value has been received since the last call
+             */
+            bool read();
+
+            /** Returns the value taken by the last call to read
+             * @return valueSize vector. Zero if no value has been published yet
+             */
+            const Eigen::VectorXd& value() const;
+
+            /** Returns the validity of the value taken by the last call to read
+             * @return true if the value is valid. False if no value has been published yet
+             */
+            bool isValid() const;
+
+            /** Returns the size of the exchanged values
+             * @return the size of the values
+             */
+            int valueSize() const;
+
+        private:
+            ReferenceMailbox(const ReferenceMailbox&);
+            ReferenceMailbox& operator=(const ReferenceMailbox&);
+
+            struct Slot {
+                Eigen::VectorXd value;
+                bool valid;
+            };
+
+            Slot m_slots[3];
+            int m_backIndex; /*!< used only by the writer */
+            int m_frontIndex; /*!< used only by the reader */
+            std::atomic<int> m_middleIndex; /*!< index of the middle buffer, with the new value bit set if it was not read yet */
+        };
+    }
+}
+
+#endif /* end of include guard: REFERENCEMAILBOX_H */
@@ -18,16 +18,16 @@
 #define TORQUEBALANCINGCONTROLLER_H
 
 #include "config.h"
+#include "ControllerCore.h"
 #include <yarp/os/RateThread.h>
 #include <yarp/os/Mutex.h>
 #include <wbi/wbiUtil.h>
 
 
 #include <Eigen/Core>
-#include <Eigen/SVD>
-#include <Eigen/LU>
 
-#include <map>
+#include <string>
+#include <vector>
 
 #include <yarp/os/BufferedPort.h>
 #include <yarp/sig/Vector.h>
@@ -40,6 +40,7 @@ namespace wbi {
 namespace codyco {
     namespace torquebalancing {
         class DynamicContraint;
+        class KinDynStateUpdater;
 
         //Move this somewhere else (and make this more generic)
         class TorqueBalancingController;
@@ -125,19 +126,49 @@ namespace codyco {
              */
             const Eigen::VectorXd& torqueSaturationLimit();
 
+            /** Enables the computation of the contact forces with a QP, which
+             * enforces friction cones, center of pressure bounds and normal force limits
+             *
+             * @note this function allocates memory and it should be called before starting the control
+             * @param parameters parameters of the QP
+             * @return true if the parameters are valid
+             */
+            bool setContactForcesQPParameters(const ContactForcesQPParameters& parameters);
+
+            /** Computes the state of the robot with a single traversal of the model
+             * (see KinDynStateUpdater) instead of one wbi call for each quantity
+             *
+             * At the initialization of the thread one state is computed both with the model
+             * and with the wbi calls. If they differ (e.g. different base link, velocity representation,
+             * centroidal momentum ordering or dJdq) the model is discarded and the wbi calls are used.
+             * @note this function must be called before the initialization of the thread
+             * to take effect
+             * @param urdfFile path of the URDF model of the robot
+             * @param jointsName actuated joints, in the order of the wbi joint list
+             * @param baseLinkName floating base link of the wbi
+             * @return true if the model is loaded and it has actuatedDOFs joints
+             */
+            bool setDynamicsModel(const std::string &urdfFile, const std::vector<std::string> &jointsName, const std::string &baseLinkName);
+
             /** Sets the current delegate. NULL to unset it
              * 
              * @param delegate the new delegate or NULL to unset it
              */
             void setDelegate(ControllerDelegate *delegate);
 
-            /** Initialize the rigid constraints 
+            /** Initialize the rigid constraints (contacts)
              *
+             * The contacts are indexed in the order they are passed:
+             * the active ones first and then the inactive ones.
+             * Every contact can be activated and deactivated at runtime.
              * @note this function must be called before the initialization of the thread
              * to take effect
-             * @param constraintsLinkName the list of 
+             * @param constraintsLinkName the frames of the contacts which are active at start
+             * @param inactiveConstraintsLinkName the frames of the contacts which are inactive at start
+             * @return true if all the frames exist and at least one contact is specified
              */
-            bool setInitialConstraintSet(const std::vector<std::string> &constraintsLinkName);
+            bool setInitialConstraintSet(const std::vector<std::string> &constraintsLinkName,
+                                         const std::vector<std::string> &inactiveConstraintsLinkName = std::vector<std::string>());
 
             /** Adds an additional constraint to the dynamics equation
              *
@@ -172,8 +203,10 @@ namespace codyco {
             void readReferences();
             bool jointsInLimitRange();
             bool updateRobotState();
-            void computeContactForces(const Eigen::Ref<Eigen::VectorXd>& desiredCOMAcceleration, Eigen::Ref<Eigen::VectorXd> desiredContactForces);
-            void computeTorques(const Eigen::Ref<Eigen::VectorXd>& desiredContactForces, Eigen::Ref<Eigen::VectorXd> torques);
+            bool computeStateWithModel(ControllerState &state);
+            void computeStateWithWBI(ControllerState &state);
+            bool checkDynamicsModel();
+            int contactIndex(const std::string &frameName) const;
             void writeTorques();
             
             wbi::wholeBodyInterface& m_robot;
@@ -188,12 +221,14 @@ namespace codyco {
             bool m_checkJointLimits;
             
             //configuration-time constants
-            int m_leftFootLinkID;
-            int m_rightFootLinkID;
             int m_centerOfMassLinkID;
 
-            typedef std::map<std::string, class DynamicConstraint> ConstraintsMap;
-            ConstraintsMap m_activeConstraints;
+            //contacts set. Indexes are the ones of the contacts quantities in ControllerState
+            std::vector<std::string> m_contactsLinkName;
+            std::vector<int> m_contactsLinkID;
+            std::vector<class DynamicConstraint> m_contactsConstraint;
+            int m_leftFootContactIndex; /*!< -1 if l_sole is not a contact */
+            int m_rightFootContactIndex; /*!< -1 if r_sole is not a contact */
 
             //References
             ControllerReferences& m_references;
@@ -205,83 +240,38 @@ namespace codyco {
 
             //references
             Eigen::Vector3d m_desiredCOMAcceleration;
-            Eigen::VectorXd m_desiredFeetForces; /*!< 12 */
-            Eigen::VectorXd m_desiredCentroidalMomentum;  /*!< 6 */
-            Eigen::VectorXd m_desiredContactForces; /*!< 12 (Vectorisation of contact wrenches at feet: left_wrench and right_wrench) */
+            Eigen::VectorXd m_desiredFeetForces; /*!< 12 (wrenches of l_sole and r_sole, zero if they are not contacts) */
+            Eigen::VectorXd m_desiredContactForces; /*!< 6 x contacts (Vectorisation of contact wrenches) */
 
             //state of the robot
-            Eigen::VectorXd m_jointPositions;  /*!< totalDOFs */
+            ControllerState m_state; /*!< state used by the controller core */
             Eigen::VectorXd m_jointVelocities;  /*!< totalDOFs */
             Eigen::VectorXd m_torques; /*!< actuatedDOFs */
             Eigen::VectorXd m_baseVelocity; /*!< 6 */
             wbi::Frame m_world2BaseFrame;
             Eigen::VectorXd m_world2BaseFrameSerialization;
-            Eigen::Vector3d m_centerOfMassPosition;
-            Eigen::VectorXd m_rightFootPosition; /*!< 7 */
-            Eigen::VectorXd m_leftFootPosition; /*!< 7 */
+            wbi::Frame m_contactFrame;
+            KinDynStateUpdater *m_kinDynStateUpdater; /*!< NULL if the state is computed with the wbi calls */
 
             //Limits
             Eigen::VectorXd m_minJointLimits; /* actuatedDOFs */
             Eigen::VectorXd m_maxJointLimits; /* actuatedDOFs */
             Eigen::VectorXd m_torqueSaturationLimit; /* actuatedDOFs */
-            
-            //Jacobians
-            Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> m_contactsJacobian; /*!< (6x2) x totalDOFs (forces and torques for feet)*/
-            Eigen::VectorXd m_contactsDJacobianDq; /*!< (6x2) */
-            
-            //Kinematic and dynamic variables
-            Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic> m_massMatrix; /*!< totalDOFs x totalDOFs */
-            Eigen::VectorXd m_generalizedBiasForces; /*!< totalDOFs */
-            Eigen::VectorXd m_gravityBiasTorques; /*!< totalDOFs */
-            Eigen::VectorXd m_centroidalMomentum; /*!< 6 */
-            
-            //variables used in computation.
-            Eigen::MatrixXd m_centroidalForceMatrix; /*!< 6 x 12 */
-            Eigen::VectorXd m_gravityForce; /*!< 6 */
-            Eigen::MatrixXd m_torquesSelector; /*!< totalDOFs x actuatedDOFs */
-            //pseuo inverses
-            Eigen::MatrixXd m_pseudoInverseOfJcMInvSt; /*!< actuatedDOFs x (6x2) */
-            Eigen::MatrixXd m_nullSpaceProjectorOfJcMInvSt; /*!< actuatedDOFs x actuatedDOFs */
-//            Eigen::MatrixXd m_pseudoInverseOfJcBase; /*!< 6 x 12 */
-            Eigen::MatrixXd m_pseudoInverseOfCentroidalForceMatrix; /*!< 12 x 6 */
-            Eigen::MatrixXd m_nullSpaceOfCentroidalForceMatrix; /*!< 12 x 12 */
-            Eigen::MatrixXd m_pseudoInverseOfTauN0_f; /*!< 12 x actuatedDoFs */
-            Eigen::JacobiSVD<Eigen::MatrixXd::PlainObject> m_svdDecompositionOfJcMInvSt; /*!< (6x2) x actuatedDOFs */
-            Eigen::JacobiSVD<Eigen::MatrixXd::PlainObject> m_svdDecompositionOfJcBase; /*!< 12 x 6 */
-            Eigen::JacobiSVD<Eigen::MatrixXd::PlainObject> m_svdDecompositionOfCentroidalForceMatrix; /*!< 6 x 12 */
-            Eigen::JacobiSVD<Eigen::MatrixXd::PlainObject> m_svdDecompositionOfTauN0_f; /*!< actuatedDoFs x 12 */
-            Eigen::PartialPivLU<Eigen::MatrixXd::PlainObject> m_luDecompositionOfCentroidalMatrix; /*!< 6 x 6. Used for plain inversion */
-            
+
+            //computation of forces and torques (preallocated)
+            ControllerCore m_core;
+
             //constant auxiliary variables
             double m_gravityUnitVector[3];
             Eigen::Matrix<double, 7, 1> m_rotoTranslationVector; /*!< 7 */
             Eigen::VectorXd m_jointsZeroVector; /*!< actuatedDOFs */
             Eigen::Matrix<double, 6, 1> m_esaZeroVector; /*!< 6 */
             Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> m_jacobianTemporary; /* 6 x totalDOFs */
-            Eigen::VectorXd m_dJacobiaDqTemporary; /* 6 */
-            
-            //TODO: move all buffers inside this struct to simplify reading
-            struct Buffers {
-                Buffers(int actuatedDOFs);
-                
-                Eigen::VectorXd baseAndJointsVector;
-                Eigen::VectorXd jointsVector;
-                Eigen::VectorXd jointsVector2;
-                Eigen::VectorXd esaVector;
-
-                Eigen::MatrixXd totalDoFsIdentity;
-                Eigen::MatrixXd totalDoFsTimesTotalDoFs;
-                Eigen::LDLT<Eigen::MatrixXd::PlainObject> totalDoFsLDLTDecomposition;
-                Eigen::MatrixXd twelveTimesTotalDoFs;
-                Eigen::MatrixXd sixTimesSix;
-                Eigen::MatrixXd twelveTimesDoFs;
-                Eigen::MatrixXd dofsTimesSix;
-                Eigen::MatrixXd dofsTimesDoFs;
-                Eigen::MatrixXd twelveTimesTwelve;
-
-            } m_buffers;
 
             yarp::os::BufferedPort<yarp::sig::Vector> debugPort;
+
+        public:
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
         };
     }
 }
@@ -170,6 +170,15 @@ namespace codyco {
              */
             bool loadTorqueGains(yarp::os::Value &gains);
 
+            /**
+             * Activates or deactivates the constraints listed in the command
+             *
+             * @param command activateConstraints or deactivateConstraints followed by the frames names
+             *
+             * @return true if the command is valid and all the frames are in the contacts set. False otherwise
+             */
+            bool changeConstraintsState(const yarp::os::Bottle &command);
+
             /**
              * Load the PID gains from the specified configuration file
              *
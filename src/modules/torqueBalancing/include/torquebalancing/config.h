@@ -19,8 +19,14 @@
 
 namespace codyco {
     namespace torquebalancing {
+        /** Computation of the null space projectors used in the torques computation */
+        typedef enum {
+            NullSpaceProjectorMethodPseudoInverse, /*!< I - pinv(A) A, from the explicit pseudo inverse */
+            NullSpaceProjectorMethodSingularVectors /*!< I - V_r V_r^T, from the singular vectors of the (thin) SVD */
+        } NullSpaceProjectorMethod;
+
         extern const double PseudoInverseTolerance;
-        extern const double JcMInvSPseudoInverseDampingTerm;
+        extern const NullSpaceProjectorMethod TorquesNullSpaceProjectorMethod;
     }
 }
 
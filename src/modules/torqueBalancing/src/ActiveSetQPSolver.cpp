@@ -0,0 +1,206 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include "ActiveSetQPSolver.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        ActiveSetQPSolver::ActiveSetQPSolver(int variables, int maximumConstraints)
+        : m_variables(variables)
+        , m_maximumConstraints(maximumConstraints)
+        , m_tolerance(1e-9)
+        , m_lltDecompositionOfHessian(variables)
+        , m_solution(Eigen::VectorXd::Zero(variables))
+        , m_hasPreviousSolution(false)
+        , m_iterations(0)
+        , m_workingSet(Eigen::VectorXi::Zero(variables))
+        , m_workingSetSize(0)
+        , m_isInWorkingSet(Eigen::VectorXi::Zero(maximumConstraints))
+        , m_gradientAtSolution(Eigen::VectorXd::Zero(variables))
+        , m_LInvCwt(Eigen::MatrixXd::Zero(variables, variables))
+        , m_workingSetMatrix(Eigen::MatrixXd::Zero(variables, variables))
+        , m_multipliers(Eigen::VectorXd::Zero(variables))
+        , m_step(Eigen::VectorXd::Zero(variables))
+        , m_constraintsStep(Eigen::VectorXd::Zero(maximumConstraints))
+        , m_constraintsResidual(Eigen::VectorXd::Zero(maximumConstraints)) {}
+
+        ActiveSetQPSolverStatus ActiveSetQPSolver::solve(const Eigen::Ref<const Eigen::MatrixXd>& hessian,
+                                                         const Eigen::Ref<const Eigen::VectorXd>& gradient,
+                                                         const Eigen::Ref<const Eigen::MatrixXd>& constraintsMatrix,
+                                                         const Eigen::Ref<const Eigen::VectorXd>& constraintsBounds,
+                                                         const Eigen::Ref<const Eigen::VectorXd>& feasiblePoint,
+                                                         int maximumIterations)
+        {
+            int constraints = constraintsMatrix.rows();
+            m_iterations = 0;
+
+            m_lltDecompositionOfHessian.compute(hessian);
+            if (m_lltDecompositionOfHessian.info() != Eigen::Success) {
+                return ActiveSetQPSolverStatusHessianNotPositiveDefinite;
+            }
+
+            //warm start: use the previous solution if it is still feasible
+            if (!m_hasPreviousSolution || !isFeasible(m_solution, constraintsMatrix, constraintsBounds)) {
+                if (!isFeasible(feasiblePoint, constraintsMatrix, constraintsBounds)) {
+                    m_hasPreviousSolution = false;
+                    return ActiveSetQPSolverStatusInfeasibleStartingPoint;
+                }
+                m_solution = feasiblePoint;
+                m_workingSetSize = 0;
+            }
+            m_hasPreviousSolution = true;
+
+            //keep in the working set only the constraints which are still active
+            m_isInWorkingSet.setZero();
+            int workingSetSize = 0;
+            for (int i = 0; i < m_workingSetSize; i++) {
+                int constraint = m_workingSet(i);
+                if (constraint < constraints
+                    && std::abs(constraintsBounds(constraint) - constraintsMatrix.row(constraint).dot(m_solution)) <= m_tolerance) {
+                    m_workingSet(workingSetSize++) = constraint;
+                    m_isInWorkingSet(constraint) = 1;
+                }
+            }
+            m_workingSetSize = workingSetSize;
+
+            while (m_iterations < maximumIterations) {
+                m_iterations++;
+
+                m_gradientAtSolution = gradient;
+                m_gradientAtSolution.noalias() += hessian * m_solution;
+                if (!solveEqualityConstrainedProblem(constraintsMatrix)) {
+                    //linearly dependent working set: restart from the current (feasible) point
+                    m_isInWorkingSet.setZero();
+                    m_workingSetSize = 0;
+                    continue;
+                }
+
+                if (m_step.lpNorm<Eigen::Infinity>() <= m_tolerance * (1.0 + m_solution.lpNorm<Eigen::Infinity>())) {
+                    //the current point is the minimum on the working set. Check the multipliers
+                    int minimumMultiplierIndex = -1;
+                    double minimumMultiplier = -m_tolerance;
+                    for (int i = 0; i < m_workingSetSize; i++) {
+                        if (m_multipliers(i) < minimumMultiplier) {
+                            minimumMultiplier = m_multipliers(i);
+                            minimumMultiplierIndex = i;
+                        }
+                    }
+                    if (minimumMultiplierIndex < 0) {
+                        return ActiveSetQPSolverStatusOptimal;
+                    }
+                    removeFromWorkingSet(minimumMultiplierIndex);
+
+                } else {
+                    //longest step along m_step which does not violate the constraints
+                    m_constraintsStep.head(constraints).noalias() = constraintsMatrix * m_step;
+                    m_constraintsResidual.head(constraints) = constraintsBounds;
+                    m_constraintsResidual.head(constraints).noalias() -= constraintsMatrix * m_solution;
+
+                    double stepLength = 1.0;
+                    int blockingConstraint = -1;
+                    for (int i = 0; i < constraints; i++) {
+                        if (m_isInWorkingSet(i) || m_constraintsStep(i) <= 0) continue;
+                        double constraintStepLength = std::max(m_constraintsResidual(i), 0.0) / m_constraintsStep(i);
+                        if (constraintStepLength < stepLength) {
+                            stepLength = constraintStepLength;
+                            blockingConstraint = i;
+                        }
+                    }
+
+                    m_solution.noalias() += stepLength * m_step;
+                    if (blockingConstraint >= 0) {
+                        if (m_workingSetSize == m_variables) {
+                            //the blocking constraint can not be added: the next iterations would not move the solution
+                            return ActiveSetQPSolverStatusWorkingSetFull;
+                        }
+                        m_workingSet(m_workingSetSize++) = blockingConstraint;
+                        m_isInWorkingSet(blockingConstraint) = 1;
+                    }
+                }
+            }
+            return ActiveSetQPSolverStatusMaximumIterationsReached;
+        }
+
+        const Eigen::VectorXd& ActiveSetQPSolver::solution() const { return m_solution; }
+
+        int ActiveSetQPSolver::iterations() const { return m_iterations; }
+
+        void ActiveSetQPSolver::resetWarmStart()
+        {
+            m_hasPreviousSolution = false;
+            m_workingSetSize = 0;
+        }
+
+        void ActiveSetQPSolver::setTolerance(double tolerance) { m_tolerance = tolerance; }
+
+        bool ActiveSetQPSolver::isFeasible(const Eigen::Ref<const Eigen::VectorXd>& point,
+                                           const Eigen::Ref<const Eigen::MatrixXd>& constraintsMatrix,
+                                           const Eigen::Ref<const Eigen::VectorXd>& constraintsBounds) const
+        {
+            for (int i = 0; i < constraintsMatrix.rows(); i++) {
+                if (constraintsMatrix.row(i).dot(point) - constraintsBounds(i) > m_tolerance) return false;
+            }
+            return true;
+        }
+
+        bool ActiveSetQPSolver::solveEqualityConstrainedProblem(const Eigen::Ref<const Eigen::MatrixXd>& constraintsMatrix)
+        {
+            //Range space method. With H = L L^T, y = L^-1 (H x + g) and Z = L^-1 C_W^T:
+            //multipliers = -(Z^T Z)^-1 Z^T y
+            //step = -L^-T (y + Z multipliers)
+            m_lltDecompositionOfHessian.matrixL().solveInPlace(m_gradientAtSolution);
+            m_step = -m_gradientAtSolution;
+
+            int size = m_workingSetSize;
+            if (size > 0) {
+                for (int i = 0; i < size; i++) {
+                    m_LInvCwt.col(i) = constraintsMatrix.row(m_workingSet(i)).transpose();
+                }
+                m_lltDecompositionOfHessian.matrixL().solveInPlace(m_LInvCwt.leftCols(size));
+                m_workingSetMatrix.topLeftCorner(size, size).noalias() = m_LInvCwt.leftCols(size).transpose() * m_LInvCwt.leftCols(size);
+
+                //in place Cholesky decomposition of Z^T Z (size changes at every iteration)
+                for (int j = 0; j < size; j++) {
+                    double diagonal = m_workingSetMatrix(j, j);
+                    double pivot = diagonal - m_workingSetMatrix.row(j).head(j).squaredNorm();
+                    if (pivot <= 1e-12 * diagonal) return false;
+                    m_workingSetMatrix(j, j) = std::sqrt(pivot);
+                    for (int i = j + 1; i < size; i++) {
+                        m_workingSetMatrix(i, j) = (m_workingSetMatrix(i, j) - m_workingSetMatrix.row(i).head(j).dot(m_workingSetMatrix.row(j).head(j))) / m_workingSetMatrix(j, j);
+                    }
+                }
+
+                m_multipliers.head(size).noalias() = m_LInvCwt.leftCols(size).transpose() * m_step;
+                m_workingSetMatrix.topLeftCorner(size, size).triangularView<Eigen::Lower>().solveInPlace(m_multipliers.head(size));
+                m_workingSetMatrix.topLeftCorner(size, size).triangularView<Eigen::Lower>().transpose().solveInPlace(m_multipliers.head(size));
+
+                m_step.noalias() -= m_LInvCwt.leftCols(size) * m_multipliers.head(size);
+            }
+            m_lltDecompositionOfHessian.matrixU().solveInPlace(m_step);
+            return true;
+        }
+
+        void ActiveSetQPSolver::removeFromWorkingSet(int workingSetIndex)
+        {
+            m_isInWorkingSet(m_workingSet(workingSetIndex)) = 0;
+            m_workingSet(workingSetIndex) = m_workingSet(m_workingSetSize - 1);
+            m_workingSetSize--;
+        }
+    }
+}
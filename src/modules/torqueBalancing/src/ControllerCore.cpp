@@ -0,0 +1,394 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include "ControllerCore.h"
+#include "config.h"
+
+#include <cmath>
+#include <limits>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        static void skewSymmetricMatrixFrom3DVector(const Eigen::Vector3d& vector, Eigen::Ref<Eigen::Matrix3d> skewSymmetricMatrix)
+        {
+            skewSymmetricMatrix << 0, -vector(2), vector(1),
+                                   vector(2), 0, -vector(0),
+                                   -vector(1), vector(0), 0;
+        }
+
+        ControllerState::ControllerState(int actuatedDOFs, int contacts)
+        : jointPositions(Eigen::VectorXd::Zero(actuatedDOFs))
+        , centerOfMassPosition(Eigen::Vector3d::Zero())
+        , contactsPosition(Eigen::Matrix3Xd::Zero(3, contacts))
+        , contactsOrientation(Eigen::Matrix3Xd::Zero(3, 3 * contacts))
+        , contactsActivation(Eigen::VectorXd::Zero(contacts))
+        , massMatrix(Eigen::MatrixXd::Zero(actuatedDOFs + 6, actuatedDOFs + 6))
+        , generalizedBiasForces(Eigen::VectorXd::Zero(actuatedDOFs + 6))
+        , gravityBiasTorques(Eigen::VectorXd::Zero(actuatedDOFs + 6))
+        , centroidalMomentum(Eigen::Matrix<double, 6, 1>::Zero())
+        , contactsJacobian(Eigen::MatrixXd::Zero(6 * contacts, actuatedDOFs + 6))
+        , contactsDJacobianDq(Eigen::VectorXd::Zero(6 * contacts))
+        {
+            for (int contact = 0; contact < contacts; contact++) {
+                contactsOrientation.middleCols<3>(3 * contact).setIdentity();
+            }
+        }
+
+        ContactForcesQPParameters::ContactForcesQPParameters()
+        : frictionCoefficient(1.0 / 3.0)
+        , frictionConeSides(4)
+        , minimumCenterOfPressure(-0.03, -0.025)
+        , maximumCenterOfPressure(0.08, 0.025)
+        , minimumNormalForce(0)
+        , maximumNormalForce(std::numeric_limits<double>::infinity())
+        , regularization(1e-6)
+        , maximumIterations(20) {}
+
+        ControllerCore::ControllerCore(int actuatedDOFs, int contacts)
+        : m_actuatedDOFs(actuatedDOFs)
+        , m_contacts(contacts)
+        , m_activeContacts(0)
+        , m_activeContactsIndices(Eigen::VectorXi::Zero(contacts))
+        , m_activeContactForces(Eigen::VectorXd::Zero(6 * contacts))
+        , m_centroidalForceMatrix(Eigen::MatrixXd::Zero(6, 6 * contacts))
+        , m_gravityForce(Eigen::Matrix<double, 6, 1>::Zero())
+        , m_desiredCentroidalMomentum(Eigen::Matrix<double, 6, 1>::Zero())
+        , m_centroidalMomentumError(Eigen::Matrix<double, 6, 1>::Zero())
+        , m_nullSpaceOfCentroidalForceMatrix(Eigen::MatrixXd::Zero(6 * contacts, 6 * contacts))
+        , m_contactForcesQPEnabled(false)
+        , m_qpHessian(Eigen::MatrixXd::Zero(6 * contacts, 6 * contacts))
+        , m_qpGradient(Eigen::VectorXd::Zero(6 * contacts))
+        , m_qpFeasiblePoint(Eigen::VectorXd::Zero(6 * contacts))
+        , m_contactForcesQPStatus(ActiveSetQPSolverStatusOptimal)
+        , m_contactForcesQPIterations(0)
+        , m_nullSpaceProjectorMethod(TorquesNullSpaceProjectorMethod)
+        , m_lltDecompositionOfMassMatrix(actuatedDOFs + 6)
+        , m_LInvJct(actuatedDOFs + 6, 6 * contacts)
+        , m_MInvJct(actuatedDOFs + 6, 6 * contacts)
+        , m_JcMInvJct(6 * contacts, 6 * contacts)
+        , m_JcMInvTorqueSelector(6 * contacts, actuatedDOFs)
+        , m_jointProjectedBaseAccelerationsTranspose(6, actuatedDOFs)
+        , m_activeContactsJacobian(6 * contacts, actuatedDOFs + 6)
+        , m_activeContactsDJacobianDq(6 * contacts)
+        , m_nullSpaceProjectorOfJcMInvSt(actuatedDOFs, actuatedDOFs)
+        , m_mult_f_tau0(actuatedDOFs, 6 * contacts)
+        , m_mult_f_tau(actuatedDOFs, 6 * contacts)
+        , m_mult_f_tauTimesNullSpace(actuatedDOFs, 6 * contacts)
+        , m_torques0(actuatedDOFs)
+        , m_n_tau(actuatedDOFs)
+        , m_unprojectedTorques(actuatedDOFs)
+        , m_contactsVector(6 * contacts)
+        {
+            //the element i is used when i + 1 contacts are active
+            m_pseudoInversesOfCentroidalForceMatrix.reserve(contacts);
+            m_pseudoInversesOfJcMInvSt.reserve(contacts);
+            m_pseudoInversesOfTauN0_f.reserve(contacts);
+            for (int activeContacts = 1; activeContacts <= contacts; activeContacts++) {
+                m_pseudoInversesOfCentroidalForceMatrix.push_back(PseudoInverse(6, 6 * activeContacts));
+                m_pseudoInversesOfJcMInvSt.push_back(PseudoInverse(6 * activeContacts, actuatedDOFs));
+                m_pseudoInversesOfTauN0_f.push_back(PseudoInverse(actuatedDOFs, 6 * activeContacts));
+            }
+        }
+
+        bool ControllerCore::setContactForcesQPParameters(const ContactForcesQPParameters& parameters)
+        {
+            if (parameters.frictionCoefficient <= 0
+                || parameters.frictionConeSides < 3
+                || (parameters.minimumCenterOfPressure.array() >= 0).any()
+                || (parameters.maximumCenterOfPressure.array() <= 0).any()
+                || parameters.minimumNormalForce < 0
+                || parameters.maximumNormalForce <= parameters.minimumNormalForce
+                || parameters.regularization <= 0
+                || parameters.maximumIterations <= 0) {
+                return false;
+            }
+            m_contactForcesQPParameters = parameters;
+
+            //constraints on the wrench [f; tau] expressed in the contact frame: C w <= d
+            int constraintsPerContact = parameters.frictionConeSides + 4 + 2;
+            m_localContactConstraints.setZero(constraintsPerContact, 6);
+            m_localContactConstraintsBounds.setZero(constraintsPerContact);
+
+            //friction cone approximated by the inscribed polygon: n_i^T f_t <= mu cos(pi / sides) f_z
+            double sideAngle = 2 * M_PI / parameters.frictionConeSides;
+            for (int side = 0; side < parameters.frictionConeSides; side++) {
+                m_localContactConstraints(side, 0) = std::cos(side * sideAngle);
+                m_localContactConstraints(side, 1) = std::sin(side * sideAngle);
+                m_localContactConstraints(side, 2) = -parameters.frictionCoefficient * std::cos(sideAngle / 2);
+            }
+            //center of pressure: CoP_x = -tau_y / f_z, CoP_y = tau_x / f_z
+            int row = parameters.frictionConeSides;
+            m_localContactConstraints.row(row++) << 0, 0, -parameters.maximumCenterOfPressure(0), 0, -1, 0;
+            m_localContactConstraints.row(row++) << 0, 0, parameters.minimumCenterOfPressure(0), 0, 1, 0;
+            m_localContactConstraints.row(row++) << 0, 0, -parameters.maximumCenterOfPressure(1), 1, 0, 0;
+            m_localContactConstraints.row(row++) << 0, 0, parameters.minimumCenterOfPressure(1), -1, 0, 0;
+            //normal force limits
+            m_localContactConstraints(row, 2) = -1;
+            m_localContactConstraintsBounds(row++) = -parameters.minimumNormalForce;
+            m_localContactConstraints(row, 2) = 1;
+            m_localContactConstraintsBounds(row++) = parameters.maximumNormalForce;
+
+            m_qpConstraints.setZero(constraintsPerContact * m_contacts, 6 * m_contacts);
+            m_qpConstraintsBounds.setZero(constraintsPerContact * m_contacts);
+            m_contactForcesQPSolvers.clear();
+            m_contactForcesQPSolvers.reserve(m_contacts);
+            for (int activeContacts = 1; activeContacts <= m_contacts; activeContacts++) {
+                m_contactForcesQPSolvers.push_back(ActiveSetQPSolver(6 * activeContacts, constraintsPerContact * activeContacts));
+            }
+            m_contactForcesQPEnabled = true;
+            return true;
+        }
+
+        int ControllerCore::contacts() const { return m_contacts; }
+
+        const ContactForcesQPParameters& ControllerCore::contactForcesQPParameters() const { return m_contactForcesQPParameters; }
+
+        void ControllerCore::disableContactForcesQP() { m_contactForcesQPEnabled = false; }
+
+        bool ControllerCore::isContactForcesQPEnabled() const { return m_contactForcesQPEnabled; }
+
+        ActiveSetQPSolverStatus ControllerCore::contactForcesQPStatus() const { return m_contactForcesQPStatus; }
+
+        int ControllerCore::contactForcesQPIterations() const { return m_contactForcesQPIterations; }
+
+        void ControllerCore::updateActiveContacts(const ControllerState& state)
+        {
+            m_activeContacts = 0;
+            for (int contact = 0; contact < m_contacts; contact++) {
+                if (state.contactsActivation(contact) > 0) {
+                    m_activeContactsIndices(m_activeContacts++) = contact;
+                }
+            }
+        }
+
+        void ControllerCore::computeContactForces(const ControllerState& state,
+                                                  const Eigen::Vector3d& desiredCOMAcceleration,
+                                                  double centroidalMomentumGain,
+                                                  Eigen::Ref<Eigen::VectorXd> desiredContactForces)
+        {
+#if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
+            Eigen::internal::set_is_malloc_allowed(false);
+#endif
+            double mass = state.massMatrix(0, 0);
+            m_gravityForce(2) = -mass * 9.81;
+
+            //building centroidalForceMatrix of the active contacts
+            updateActiveContacts(state);
+            int activeContactsSize = 6 * m_activeContacts;
+            for (int active = 0; active < m_activeContacts; active++) {
+                int contact = m_activeContactsIndices(active);
+                m_centroidalForceMatrix.middleCols<6>(6 * active).setIdentity();
+                skewSymmetricMatrixFrom3DVector(state.contactsPosition.col(contact) - state.centerOfMassPosition, m_centroidalForceMatrix.block<3, 3>(3, 6 * active));
+                m_centroidalForceMatrix.middleCols<6>(6 * active) *= state.contactsActivation(contact);
+            }
+
+            m_desiredCentroidalMomentum.head<3>() = mass * desiredCOMAcceleration;
+            m_desiredCentroidalMomentum.tail<3>() = -centroidalMomentumGain * state.centroidalMomentum.tail<3>();
+
+            m_centroidalMomentumError = m_desiredCentroidalMomentum - m_gravityForce;
+            if (m_activeContacts == 0) {
+                //no contact forces: computeTorques does not use the null space
+                m_activeContactForces.setZero();
+
+            } else if (m_contactForcesQPEnabled && computeContactForcesWithQP(state)) {
+                //the forces satisfy the contact constraints: they must not be modified in the null space
+                m_nullSpaceOfCentroidalForceMatrix.topLeftCorner(activeContactsSize, activeContactsSize).setZero();
+
+            } else if (m_activeContacts == 1) {
+                //substitute the pseudoinverse with its inverse
+                m_luDecompositionOfCentroidalMatrix.compute(m_centroidalForceMatrix.leftCols<6>());
+                m_activeContactForces.head<6>() = m_luDecompositionOfCentroidalMatrix.solve(m_centroidalMomentumError);
+                m_nullSpaceOfCentroidalForceMatrix.topLeftCorner<6, 6>().setZero();
+
+            } else {
+                PseudoInverse& pseudoInverseOfCentroidalForceMatrix = m_pseudoInversesOfCentroidalForceMatrix[m_activeContacts - 1];
+                pseudoInverseOfCentroidalForceMatrix.compute(m_centroidalForceMatrix.leftCols(activeContactsSize), PseudoInverseTolerance);
+                m_activeContactForces.head(activeContactsSize).noalias() = pseudoInverseOfCentroidalForceMatrix.pseudoInverse() * m_centroidalMomentumError;
+
+                //TODO: change the following line by using the null space basis obtained by the pseudoinverse method
+                m_nullSpaceOfCentroidalForceMatrix.topLeftCorner(activeContactsSize, activeContactsSize).setIdentity();
+                m_nullSpaceOfCentroidalForceMatrix.topLeftCorner(activeContactsSize, activeContactsSize).noalias() -= pseudoInverseOfCentroidalForceMatrix.pseudoInverse() * m_centroidalForceMatrix.leftCols(activeContactsSize);
+            }
+
+            //forces in the order of the contacts of the robot
+            desiredContactForces.setZero();
+            for (int active = 0; active < m_activeContacts; active++) {
+                desiredContactForces.segment<6>(6 * m_activeContactsIndices(active)) = m_activeContactForces.segment<6>(6 * active);
+            }
+#if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
+            Eigen::internal::set_is_malloc_allowed(true);
+#endif
+        }
+
+        bool ControllerCore::computeContactForcesWithQP(const ControllerState& state)
+        {
+            //the variables are the forces of the active contacts
+            int variables = 6 * m_activeContacts;
+            ActiveSetQPSolver& solver = m_contactForcesQPSolvers[m_activeContacts - 1];
+
+            //min 1/2 |A f - (desired momentum rate - gravity)|^2 + 1/2 regularization |f|^2
+            m_qpHessian.topLeftCorner(variables, variables).setIdentity();
+            m_qpHessian.topLeftCorner(variables, variables) *= m_contactForcesQPParameters.regularization;
+            m_qpHessian.topLeftCorner(variables, variables).noalias() += m_centroidalForceMatrix.leftCols(variables).transpose() * m_centroidalForceMatrix.leftCols(variables);
+            m_qpGradient.head(variables).noalias() = -m_centroidalForceMatrix.leftCols(variables).transpose() * m_centroidalMomentumError;
+
+            //constraints of the active contacts, rotated in the world frame.
+            //The feasible point has only the normal force, equal to the weight shared among the contacts
+            int constraintsPerContact = m_localContactConstraints.rows();
+            int constraints = constraintsPerContact * m_activeContacts;
+            double feasibleNormalForce = -m_gravityForce(2) / m_activeContacts;
+            feasibleNormalForce = std::min(std::max(feasibleNormalForce, m_contactForcesQPParameters.minimumNormalForce),
+                                           m_contactForcesQPParameters.maximumNormalForce);
+
+            m_qpConstraints.topLeftCorner(constraints, variables).setZero();
+            m_qpFeasiblePoint.head(variables).setZero();
+            for (int active = 0; active < m_activeContacts; active++) {
+                const Eigen::Matrix3d orientation = state.contactsOrientation.middleCols<3>(3 * m_activeContactsIndices(active));
+                m_qpConstraints.block(constraintsPerContact * active, 6 * active, constraintsPerContact, 3).noalias() = m_localContactConstraints.leftCols<3>() * orientation.transpose();
+                m_qpConstraints.block(constraintsPerContact * active, 6 * active + 3, constraintsPerContact, 3).noalias() = m_localContactConstraints.rightCols<3>() * orientation.transpose();
+                m_qpConstraintsBounds.segment(constraintsPerContact * active, constraintsPerContact) = m_localContactConstraintsBounds;
+                m_qpFeasiblePoint.segment<3>(6 * active) = feasibleNormalForce * orientation.col(2);
+            }
+
+            m_contactForcesQPStatus = solver.solve(m_qpHessian.topLeftCorner(variables, variables),
+                                                   m_qpGradient.head(variables),
+                                                   m_qpConstraints.topLeftCorner(constraints, variables),
+                                                   m_qpConstraintsBounds.head(constraints),
+                                                   m_qpFeasiblePoint.head(variables),
+                                                   m_contactForcesQPParameters.maximumIterations);
+            m_contactForcesQPIterations = solver.iterations();
+            //if the maximum number of iterations is reached or the working set is full the solution is still feasible
+            if (m_contactForcesQPStatus != ActiveSetQPSolverStatusOptimal
+                && m_contactForcesQPStatus != ActiveSetQPSolverStatusMaximumIterationsReached
+                && m_contactForcesQPStatus != ActiveSetQPSolverStatusWorkingSetFull) {
+                return false;
+            }
+            m_activeContactForces.head(variables) = solver.solution();
+            return true;
+        }
+
+        void ControllerCore::setNullSpaceProjectorMethod(NullSpaceProjectorMethod method) { m_nullSpaceProjectorMethod = method; }
+
+        NullSpaceProjectorMethod ControllerCore::nullSpaceProjectorMethod() const { return m_nullSpaceProjectorMethod; }
+
+        bool ControllerCore::computeTorques(const ControllerState& state,
+                                            const Eigen::VectorXd& desiredJointsConfiguration,
+                                            const Eigen::VectorXd& impedanceGains,
+                                            const Eigen::VectorXd& torqueSaturationLimit,
+                                            const Eigen::Ref<const Eigen::VectorXd>& desiredContactForces,
+                                            Eigen::Ref<Eigen::VectorXd> torques)
+        {
+#if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
+            Eigen::internal::set_is_malloc_allowed(false);
+#endif
+            //Names are taken from "math" from brevity
+            //The mass matrix is never inverted: with M = L L^T,
+            //Jc M^-1 Jc^T = (L^-1 Jc^T)^T (L^-1 Jc^T) and M^-1 Jc^T = L^-T (L^-1 Jc^T)
+            m_lltDecompositionOfMassMatrix.compute(state.massMatrix);
+            m_lltDecompositionOfBaseMassMatrix.compute(state.massMatrix.topLeftCorner<6, 6>());
+            if (m_lltDecompositionOfMassMatrix.info() != Eigen::Success
+                || m_lltDecompositionOfBaseMassMatrix.info() != Eigen::Success) {
+#if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
+                Eigen::internal::set_is_malloc_allowed(true);
+#endif
+                return false;
+            }
+
+            //transpose of the joint projected base accelerations M_jb * M_bb^-1
+            m_jointProjectedBaseAccelerationsTranspose = state.massMatrix.topRightCorner(6, m_actuatedDOFs);
+            m_lltDecompositionOfBaseMassMatrix.solveInPlace(m_jointProjectedBaseAccelerationsTranspose);
+
+            m_torques0 = state.gravityBiasTorques.tail(m_actuatedDOFs) - impedanceGains.cwiseProduct(state.jointPositions - desiredJointsConfiguration);
+            m_torques0.noalias() -= m_jointProjectedBaseAccelerationsTranspose.transpose() * state.generalizedBiasForces.head<6>();
+
+            //only the rows of the active contacts are used (the rows of the inactive ones are zero)
+            updateActiveContacts(state);
+            int activeContactsSize = 6 * m_activeContacts;
+            if (m_activeContacts == 0) {
+                torques = m_torques0;
+            } else {
+                for (int active = 0; active < m_activeContacts; active++) {
+                    int contact = m_activeContactsIndices(active);
+                    m_activeContactsJacobian.middleRows<6>(6 * active) = state.contactsJacobian.middleRows<6>(6 * contact);
+                    m_activeContactsDJacobianDq.segment<6>(6 * active) = state.contactsDJacobianDq.segment<6>(6 * contact);
+                    m_activeContactForces.segment<6>(6 * active) = desiredContactForces.segment<6>(6 * contact);
+                }
+
+                Eigen::Ref<const Eigen::MatrixXd> contactsJacobian = m_activeContactsJacobian.topRows(activeContactsSize);
+                m_LInvJct.leftCols(activeContactsSize) = contactsJacobian.transpose();
+                m_lltDecompositionOfMassMatrix.matrixL().solveInPlace(m_LInvJct.leftCols(activeContactsSize));
+                m_MInvJct.leftCols(activeContactsSize) = m_LInvJct.leftCols(activeContactsSize);
+                m_lltDecompositionOfMassMatrix.matrixU().solveInPlace(m_MInvJct.leftCols(activeContactsSize));
+
+                //only the lower triangular part of JcMInvJct is computed
+                m_JcMInvJct.topLeftCorner(activeContactsSize, activeContactsSize).setZero();
+                m_JcMInvJct.topLeftCorner(activeContactsSize, activeContactsSize).selfadjointView<Eigen::Lower>().rankUpdate(m_LInvJct.leftCols(activeContactsSize).transpose());
+                //multiplication by the torques selector
+                m_JcMInvTorqueSelector.topRows(activeContactsSize) = m_MInvJct.bottomLeftCorner(m_actuatedDOFs, activeContactsSize).transpose();
+
+                PseudoInverse& pseudoInverseOfJcMInvStDecomposition = m_pseudoInversesOfJcMInvSt[m_activeContacts - 1];
+                pseudoInverseOfJcMInvStDecomposition.compute(m_JcMInvTorqueSelector.topRows(activeContactsSize), PseudoInverseTolerance);
+                const Eigen::MatrixXd& pseudoInverseOfJcMInvSt = pseudoInverseOfJcMInvStDecomposition.pseudoInverse();
+
+                if (m_nullSpaceProjectorMethod == NullSpaceProjectorMethodSingularVectors) {
+                    pseudoInverseOfJcMInvStDecomposition.computeNullSpaceProjector(m_nullSpaceProjectorOfJcMInvSt);
+                } else {
+                    m_nullSpaceProjectorOfJcMInvSt.setIdentity();
+                    m_nullSpaceProjectorOfJcMInvSt.noalias() -= pseudoInverseOfJcMInvSt * m_JcMInvTorqueSelector.topRows(activeContactsSize);
+                }
+
+                Eigen::Ref<Eigen::MatrixXd> mult_f_tau = m_mult_f_tau.leftCols(activeContactsSize);
+                Eigen::Ref<Eigen::MatrixXd> mult_f_tauTimesNullSpace = m_mult_f_tauTimesNullSpace.leftCols(activeContactsSize);
+
+                m_mult_f_tau0.leftCols(activeContactsSize) = -contactsJacobian.rightCols(m_actuatedDOFs).transpose();
+                m_mult_f_tau0.leftCols(activeContactsSize).noalias() += m_jointProjectedBaseAccelerationsTranspose.transpose() * contactsJacobian.leftCols<6>().transpose();
+
+                mult_f_tau.noalias() = m_nullSpaceProjectorOfJcMInvSt * m_mult_f_tau0.leftCols(activeContactsSize);
+                mult_f_tau.noalias() -= pseudoInverseOfJcMInvSt * m_JcMInvJct.topLeftCorner(activeContactsSize, activeContactsSize).selfadjointView<Eigen::Lower>();
+
+                m_contactsVector.head(activeContactsSize) = -m_activeContactsDJacobianDq.head(activeContactsSize);
+                m_contactsVector.head(activeContactsSize).noalias() += m_MInvJct.leftCols(activeContactsSize).transpose() * state.generalizedBiasForces;
+                m_n_tau.noalias() = pseudoInverseOfJcMInvSt * m_contactsVector.head(activeContactsSize);
+                m_n_tau.noalias() += m_nullSpaceProjectorOfJcMInvSt * m_torques0;
+
+                mult_f_tauTimesNullSpace.noalias() = mult_f_tau * m_nullSpaceOfCentroidalForceMatrix.topLeftCorner(activeContactsSize, activeContactsSize);
+
+                //torques = (I - mult_f_tau * N * pinv(mult_f_tau * N)) * (n_tau + mult_f_tau * f)
+                m_unprojectedTorques = m_n_tau;
+                m_unprojectedTorques.noalias() += mult_f_tau * m_activeContactForces.head(activeContactsSize);
+                torques = m_unprojectedTorques;
+                PseudoInverse& pseudoInverseOfTauN0_f = m_pseudoInversesOfTauN0_f[m_activeContacts - 1];
+                if (m_nullSpaceProjectorMethod == NullSpaceProjectorMethodSingularVectors) {
+                    //the pseudo inverse is not needed: A pinv(A) = U_r U_r^T
+                    pseudoInverseOfTauN0_f.computeDecomposition(mult_f_tauTimesNullSpace, PseudoInverseTolerance);
+                    pseudoInverseOfTauN0_f.projectOnLeftNullSpace(torques);
+                } else {
+                    pseudoInverseOfTauN0_f.compute(mult_f_tauTimesNullSpace, PseudoInverseTolerance);
+                    m_contactsVector.head(activeContactsSize).noalias() = pseudoInverseOfTauN0_f.pseudoInverse() * m_unprojectedTorques;
+                    torques.noalias() -= mult_f_tauTimesNullSpace * m_contactsVector.head(activeContactsSize);
+                }
+            }
+
+            //apply saturation
+            //TODO: check isinf or isnan
+            torques = torques.cwiseMin(torqueSaturationLimit).cwiseMax(-torqueSaturationLimit);
+#if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
+            Eigen::internal::set_is_malloc_allowed(true);
+#endif
+            return true;
+        }
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include "KinDynStateUpdater.h"
+#include "ControllerCore.h"
+
+#include <iDynTree/Core/EigenHelpers.h>
+#include <iDynTree/ModelIO/ModelLoader.h>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        KinDynStateUpdater::KinDynStateUpdater()
+        : m_worldToBase(iDynTree::Transform::Identity())
+        , m_baseVelocity(iDynTree::Twist::Zero())
+        {
+            m_gravity.zero();
+        }
+
+        bool KinDynStateUpdater::loadModelFromFile(const std::string& urdfFile, const std::vector<std::string>& jointsName, const std::string& baseLinkName)
+        {
+            iDynTree::ModelLoader loader;
+            if (!loader.loadReducedModelFromFile(urdfFile, jointsName)) return false;
+            if (!m_kinDynComputations.loadRobotModel(loader.model())
+                || !m_kinDynComputations.setFloatingBase(baseLinkName)) return false;
+            m_kinDynComputations.setFrameVelocityRepresentation(iDynTree::MIXED_REPRESENTATION);
+
+            const iDynTree::Model& model = m_kinDynComputations.model();
+            int actuatedDOFs = model.getNrOfDOFs();
+            m_jointPositions.resize(actuatedDOFs);
+            m_jointPositions.zero();
+            m_jointVelocities.resize(actuatedDOFs);
+            m_jointVelocities.zero();
+            m_massMatrix.resize(actuatedDOFs + 6, actuatedDOFs + 6);
+            m_jacobian.resize(6, actuatedDOFs + 6);
+            m_generalizedForces.resize(model);
+            m_contactsFrameIndex.clear();
+            return true;
+        }
+
+        bool KinDynStateUpdater::setContactsFrames(const std::vector<std::string>& contactsFrameName)
+        {
+            std::vector<iDynTree::FrameIndex> contactsFrameIndex;
+            for (std::vector<std::string>::const_iterator it = contactsFrameName.begin();
+                 it != contactsFrameName.end(); it++) {
+                iDynTree::FrameIndex frameIndex = m_kinDynComputations.getFrameIndex(*it);
+                if (frameIndex == iDynTree::FRAME_INVALID_INDEX) return false;
+                contactsFrameIndex.push_back(frameIndex);
+            }
+            m_contactsFrameIndex = contactsFrameIndex;
+            return true;
+        }
+
+        int KinDynStateUpdater::actuatedDOFs() const { return m_kinDynComputations.getNrOfDegreesOfFreedom(); }
+
+        bool KinDynStateUpdater::updateState(const Eigen::Ref<const Eigen::VectorXd>& jointPositions,
+                                             const Eigen::Ref<const Eigen::VectorXd>& jointVelocities,
+                                             const Eigen::Matrix4d& worldToBase,
+                                             const Eigen::Matrix<double, 6, 1>& baseVelocity,
+                                             const Eigen::Vector3d& gravity,
+                                             ControllerState& state)
+        {
+            int actuatedDOFs = m_jointPositions.size();
+            if (jointPositions.size() != actuatedDOFs
+                || static_cast<int>(m_contactsFrameIndex.size()) != state.contactsActivation.size()) return false;
+
+            //single traversal of the model: forward kinematics are cached until the next setRobotState
+            iDynTree::toEigen(m_jointPositions) = jointPositions;
+            iDynTree::toEigen(m_jointVelocities) = jointVelocities;
+            iDynTree::Rotation rotation;
+            iDynTree::toEigen(rotation) = worldToBase.topLeftCorner<3, 3>();
+            iDynTree::Position position;
+            iDynTree::toEigen(position) = worldToBase.topRightCorner<3, 1>();
+            m_worldToBase.setRotation(rotation);
+            m_worldToBase.setPosition(position);
+            iDynTree::toEigen(m_baseVelocity.getLinearVec3()) = baseVelocity.head<3>();
+            iDynTree::toEigen(m_baseVelocity.getAngularVec3()) = baseVelocity.tail<3>();
+            iDynTree::toEigen(m_gravity) = gravity;
+            if (!m_kinDynComputations.setRobotState(m_worldToBase, m_jointPositions, m_baseVelocity, m_jointVelocities, m_gravity)) return false;
+
+            bool result = true;
+            state.centerOfMassPosition = iDynTree::toEigen(m_kinDynComputations.getCenterOfMassPosition());
+            result = result && m_kinDynComputations.getFreeFloatingMassMatrix(m_massMatrix);
+            state.massMatrix = iDynTree::toEigen(m_massMatrix);
+            state.centroidalMomentum = iDynTree::toEigen(m_kinDynComputations.getCentroidalTotalMomentum().asVector());
+
+            result = result && m_kinDynComputations.generalizedBiasForces(m_generalizedForces);
+            state.generalizedBiasForces.head<6>() = iDynTree::toEigen(m_generalizedForces.baseWrench().asVector());
+            state.generalizedBiasForces.tail(actuatedDOFs) = iDynTree::toEigen(m_generalizedForces.jointTorques());
+            result = result && m_kinDynComputations.generalizedGravityForces(m_generalizedForces);
+            state.gravityBiasTorques.head<6>() = iDynTree::toEigen(m_generalizedForces.baseWrench().asVector());
+            state.gravityBiasTorques.tail(actuatedDOFs) = iDynTree::toEigen(m_generalizedForces.jointTorques());
+
+            for (std::size_t contact = 0; contact < m_contactsFrameIndex.size(); contact++) {
+                double activation = state.contactsActivation(contact);
+                if (activation <= 0) {
+                    state.contactsJacobian.middleRows<6>(6 * contact).setZero();
+                    state.contactsDJacobianDq.segment<6>(6 * contact).setZero();
+                    continue;
+                }
+                iDynTree::FrameIndex frameIndex = m_contactsFrameIndex[contact];
+                result = result && m_kinDynComputations.getFrameFreeFloatingJacobian(frameIndex, m_jacobian);
+                state.contactsJacobian.middleRows<6>(6 * contact) = activation * iDynTree::toEigen(m_jacobian);
+                state.contactsDJacobianDq.segment<6>(6 * contact) = activation * iDynTree::toEigen(m_kinDynComputations.getFrameBiasAcc(frameIndex));
+
+                iDynTree::Transform worldToContact = m_kinDynComputations.getWorldTransform(frameIndex);
+                state.contactsPosition.col(contact) = iDynTree::toEigen(worldToContact.getPosition());
+                state.contactsOrientation.middleCols<3>(3 * contact) = iDynTree::toEigen(worldToContact.getRotation());
+            }
+            return result;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include "PseudoInverse.h"
+
+#include <algorithm>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        PseudoInverse::PseudoInverse(int rows, int cols, unsigned int computationOptions)
+        : m_matrix(Eigen::MatrixXd::Zero(rows, cols))
+        , m_svd(rows, cols, computationOptions)
+        , m_computationOptions(computationOptions)
+        , m_singularValuesInverse(std::min(rows, cols))
+        , m_scaledV(cols, std::min(rows, cols))
+        , m_pseudoInverse(cols, rows)
+        , m_projectionCoefficients(std::min(rows, cols))
+        , m_rank(0)
+        {
+            m_singularValuesInverse.setZero();
+            m_scaledV.setZero();
+            m_pseudoInverse.setZero();
+        }
+
+        void PseudoInverse::compute(const Eigen::Ref<const Eigen::MatrixXd>& matrix, double tolerance)
+        {
+            computeDecomposition(matrix, tolerance);
+            computePseudoInverseFromSingularValuesInverse();
+        }
+
+        void PseudoInverse::computeDecomposition(const Eigen::Ref<const Eigen::MatrixXd>& matrix, double tolerance)
+        {
+            m_matrix = matrix;
+            m_svd.compute(m_matrix, m_computationOptions);
+
+            const Eigen::VectorXd& singularValues = m_svd.singularValues();
+            m_rank = 0;
+            for (int index = 0; index < singularValues.size(); index++) {
+                if (tolerance > 0 && singularValues(index) > tolerance) {
+                    m_singularValuesInverse(index) = 1.0 / singularValues(index);
+                    m_rank++;
+                } else {
+                    m_singularValuesInverse(index) = 0.0;
+                }
+            }
+        }
+
+        const Eigen::MatrixXd& PseudoInverse::pseudoInverse() const { return m_pseudoInverse; }
+
+        int PseudoInverse::rank() const { return m_rank; }
+
+        void PseudoInverse::computeNullSpaceProjector(Eigen::Ref<Eigen::MatrixXd> projector) const
+        {
+            //singular values are sorted in decreasing order: the first m_rank are the inverted ones
+            projector.setIdentity();
+            projector.noalias() -= m_svd.matrixV().leftCols(m_rank) * m_svd.matrixV().leftCols(m_rank).transpose();
+        }
+
+        void PseudoInverse::projectOnLeftNullSpace(Eigen::Ref<Eigen::VectorXd> vector)
+        {
+            m_projectionCoefficients.head(m_rank).noalias() = m_svd.matrixU().leftCols(m_rank).transpose() * vector;
+            vector.noalias() -= m_svd.matrixU().leftCols(m_rank) * m_projectionCoefficients.head(m_rank);
+        }
+
+        void PseudoInverse::computePseudoInverseFromSingularValuesInverse()
+        {
+            //the product is split in two steps so that no temporary is needed
+            //(U and V can be full, so take only the first min(rows, cols) columns)
+            int size = m_singularValuesInverse.size();
+            m_scaledV.noalias() = m_svd.matrixV().leftCols(size) * m_singularValuesInverse.asDiagonal();
+            m_pseudoInverse.noalias() = m_scaledV * m_svd.matrixU().leftCols(size).adjoint();
+        }
+    }
+}
@@ -15,6 +15,7 @@
  */
 
 #include "Reference.h"
+#include "ReferenceMailbox.h"
 #include "config.h"
 
 #include <yarp/os/Mutex.h>
@@ -78,7 +79,12 @@ namespace codyco {
             ReferenceReader reader;
             yarp::os::BufferedPort<yarp::sig::Vector> *readerPort;
 
-            ReferencePrivateImplementation(Reference& reference): reader(reference), readerPort(NULL) {}
+            ReferenceMailbox mailbox; /*!< lock-free copy of the value for readLatestValue */
+
+            ReferencePrivateImplementation(Reference& reference)
+            : reader(reference)
+            , readerPort(NULL)
+            , mailbox(reference.valueSize()) {}
 
             ~ReferencePrivateImplementation() {
                 if (readerPort) {
@@ -90,7 +96,7 @@ namespace codyco {
             }
 
         private:
-            ReferencePrivateImplementation(const ReferencePrivateImplementation& other):reader(other.reader) {}
+            ReferencePrivateImplementation(const ReferencePrivateImplementation& other):reader(other.reader), mailbox(0) {}
             ReferencePrivateImplementation& operator=(const ReferencePrivateImplementation &);
         };
 
@@ -176,6 +182,7 @@ namespace codyco {
                 m_value = _value;
                 m_valid = true;
             }
+            implementation->mailbox.write(_value, true);
             if (implementation->delegates.size() > 0)
                 for (std::set<ReferenceDelegate*>::iterator delegate = implementation->delegates.begin(); delegate != implementation->delegates.end(); delegate++) {
                     (*delegate)->referenceDidChangeValue(*this);
@@ -185,8 +192,12 @@ namespace codyco {
         void Reference::setValid(bool isValid)
         {
             ReferencePrivateImplementation *implementation = static_cast<ReferencePrivateImplementation*>(m_implementation);
-            yarp::os::LockGuard guard(implementation->m_lock);
-            m_valid = isValid;
+            {
+                yarp::os::LockGuard guard(implementation->m_lock);
+                m_valid = isValid;
+            }
+            //m_value is modified only by the writer thread (this one)
+            implementation->mailbox.write(m_value, isValid);
         }
         
         bool Reference::isValid()
@@ -196,6 +207,16 @@ namespace codyco {
             return m_valid;
         }
         
+        bool Reference::readLatestValue(Eigen::Ref<Eigen::VectorXd> value)
+        {
+            ReferencePrivateImplementation *implementation = static_cast<ReferencePrivateImplementation*>(m_implementation);
+            ReferenceMailbox &mailbox = implementation->mailbox;
+            mailbox.read();
+            if (!mailbox.isValid()) return false;
+            value = mailbox.value();
+            return true;
+        }
+
         int Reference::valueSize() const
         {
             return m_valueSize;
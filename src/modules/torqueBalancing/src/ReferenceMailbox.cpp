@@ -0,0 +1,62 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include "ReferenceMailbox.h"
+
+namespace codyco {
+    namespace torquebalancing {
+
+        //Bit of ReferenceMailbox::m_middleIndex set when the middle buffer contains a value not read yet
+        static const int ReferenceMailboxNewValueFlag = 4;
+        static const int ReferenceMailboxIndexMask = 3;
+
+        ReferenceMailbox::ReferenceMailbox(int valueSize)
+        : m_backIndex(0)
+        , m_frontIndex(2)
+        , m_middleIndex(1)
+        {
+            for (int i = 0; i < 3; i++) {
+                m_slots[i].value = Eigen::VectorXd::Zero(valueSize);
+                m_slots[i].valid = false;
+            }
+        }
+
+        void ReferenceMailbox::write(const Eigen::Ref<const Eigen::VectorXd>& value, bool isValid)
+        {
+            Slot &back = m_slots[m_backIndex];
+            back.value = value;
+            back.valid = isValid;
+
+            //publish the value, and take the old middle buffer as the new back buffer
+            int oldMiddle = m_middleIndex.exchange(m_backIndex | ReferenceMailboxNewValueFlag, std::memory_order_acq_rel);
+            m_backIndex = oldMiddle & ReferenceMailboxIndexMask;
+        }
+
+        bool ReferenceMailbox::read()
+        {
+            if (!(m_middleIndex.load(std::memory_order_acquire) & ReferenceMailboxNewValueFlag)) return false;
+            //take the middle buffer as the new front buffer
+            int oldMiddle = m_middleIndex.exchange(m_frontIndex, std::memory_order_acq_rel);
+            m_frontIndex = oldMiddle & ReferenceMailboxIndexMask;
+            return true;
+        }
+
+        const Eigen::VectorXd& ReferenceMailbox::value() const { return m_slots[m_frontIndex].value; }
+
+        bool ReferenceMailbox::isValid() const { return m_slots[m_frontIndex].valid; }
+
+        int ReferenceMailbox::valueSize() const { return m_slots[0].value.size(); }
+    }
+}
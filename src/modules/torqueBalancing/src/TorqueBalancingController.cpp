@@ -17,6 +17,7 @@
 #include "TorqueBalancingController.h"
 #include "Reference.h"
 #include "DynamicConstraint.h"
+#include "KinDynStateUpdater.h"
 
 #include <wbi/wholeBodyInterface.h>
 #include <wbi/wbiUtil.h>
@@ -28,12 +29,12 @@
 
 #include <iCub/ctrl/minJerkCtrl.h>
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
-#include <Eigen/LU>
-
 #define TORQUEBALANCING_STATEACTIVE_THRESHOLD 0.05
+#define TORQUEBALANCING_DYNAMICSMODEL_TOLERANCE 1e-6
 
 namespace codyco {
     namespace torquebalancing {
@@ -43,6 +44,17 @@ namespace codyco {
         void ControllerDelegate::controllerDidStart(TorqueBalancingController& controller) {}
         void ControllerDelegate::controllerDidStop(TorqueBalancingController& controller) {}
 
+        //true if the quantity computed with the dynamics model is equal (up to a relative tolerance) to the wbi one
+        template <typename ModelDerived, typename WBIDerived>
+        static bool isEqualToWBIQuantity(const char *quantityName, const Eigen::MatrixBase<ModelDerived>& modelQuantity, const Eigen::MatrixBase<WBIDerived>& wbiQuantity)
+        {
+            double difference = (modelQuantity - wbiQuantity).template lpNorm<Eigen::Infinity>();
+            double scale = std::max(1.0, wbiQuantity.template lpNorm<Eigen::Infinity>());
+            if (difference <= TORQUEBALANCING_DYNAMICSMODEL_TOLERANCE * scale) return true;
+            yWarning("%s of the dynamics model differs from the wbi one (max difference %lf)", quantityName, difference);
+            return false;
+        }
+
 #pragma mark - Torque Balancing Controller Implementation
 
         TorqueBalancingController::TorqueBalancingController(int period, ControllerReferences& references, wbi::wholeBodyInterface& robot, int actuatedDOFs, double dynamicSmoothingTime)
@@ -54,109 +66,58 @@ namespace codyco {
         , m_active(false)
         , m_checkJointLimits(true)
         , m_centerOfMassLinkID(wbi::wholeBodyInterface::COM_LINK_ID)
+        , m_leftFootContactIndex(-1)
+        , m_rightFootContactIndex(-1)
         , m_references(references)
         , m_desiredJointsConfiguration(actuatedDOFs)
         , m_centroidalMomentumGain(0)
         , m_impedanceGains(actuatedDOFs)
         , m_desiredCOMAcceleration(3)
         , m_desiredFeetForces(12)
-        , m_desiredCentroidalMomentum(6)
         , m_desiredContactForces(6 * 2)
-        , m_jointPositions(actuatedDOFs)
+        , m_state(actuatedDOFs)
         , m_jointVelocities(actuatedDOFs)
         , m_torques(actuatedDOFs)
         , m_baseVelocity(6)
         , m_world2BaseFrameSerialization(16)
-        , m_centerOfMassPosition(3)
-        , m_rightFootPosition(7)
-        , m_leftFootPosition(7)
+        , m_kinDynStateUpdater(0)
         , m_minJointLimits(actuatedDOFs)
         , m_maxJointLimits(actuatedDOFs)
         , m_torqueSaturationLimit(actuatedDOFs)
-        , m_contactsJacobian(6 * 2, actuatedDOFs + 6)
-        , m_contactsDJacobianDq(6 * 2)
-        , m_massMatrix(actuatedDOFs + 6, actuatedDOFs + 6)
-        , m_generalizedBiasForces(actuatedDOFs + 6)
-        , m_gravityBiasTorques(actuatedDOFs + 6)
-        , m_centroidalMomentum(6)
-        , m_centroidalForceMatrix(6, 12)
-        , m_gravityForce(6)
-        , m_torquesSelector(actuatedDOFs + 6, actuatedDOFs)
-        , m_pseudoInverseOfJcMInvSt(actuatedDOFs, 6 * 2)
-        , m_nullSpaceProjectorOfJcMInvSt(actuatedDOFs, actuatedDOFs)
-        //        , m_pseudoInverseOfJcBase(6, 12)
-        , m_pseudoInverseOfCentroidalForceMatrix(12, 6)
-        , m_nullSpaceOfCentroidalForceMatrix(12, 12)
-        , m_pseudoInverseOfTauN0_f(12, actuatedDOFs)
-        , m_svdDecompositionOfJcMInvSt(6 * 2, actuatedDOFs)
-        , m_svdDecompositionOfJcBase(12, 6)
-        , m_svdDecompositionOfCentroidalForceMatrix(6, 12)
-        , m_svdDecompositionOfTauN0_f(actuatedDOFs, 12)
-        , m_luDecompositionOfCentroidalMatrix(6)
+        , m_core(actuatedDOFs)
         , m_rotoTranslationVector(7)
         , m_jointsZeroVector(actuatedDOFs)
         , m_esaZeroVector(6)
-        , m_jacobianTemporary(6, actuatedDOFs + 6)
-        , m_dJacobiaDqTemporary(6)
-        , m_buffers(actuatedDOFs) {}
-
-        TorqueBalancingController::Buffers::Buffers(int actuatedDOFs)
-        : baseAndJointsVector(actuatedDOFs + 6)
-        , jointsVector(actuatedDOFs)
-        , jointsVector2(actuatedDOFs)
-        , esaVector(6)
-        , totalDoFsIdentity(Eigen::MatrixXd::Identity(actuatedDOFs + 6, actuatedDOFs + 6))
-        , totalDoFsTimesTotalDoFs(actuatedDOFs + 6, actuatedDOFs + 6)
-        , totalDoFsLDLTDecomposition(actuatedDOFs + 6)
-        , twelveTimesTotalDoFs(12, actuatedDOFs + 6)
-        , sixTimesSix(6, 6)
-        , twelveTimesDoFs(12, actuatedDOFs)
-        , dofsTimesSix(actuatedDOFs, 6)
-        , dofsTimesDoFs(actuatedDOFs, actuatedDOFs)
-        , twelveTimesTwelve(12, 12) {}
-
-        TorqueBalancingController::~TorqueBalancingController() {}
+        , m_jacobianTemporary(6, actuatedDOFs + 6) {}
+
+        TorqueBalancingController::~TorqueBalancingController()
+        {
+            delete m_kinDynStateUpdater;
+            m_kinDynStateUpdater = 0;
+        }
 
 #pragma mark - RateThread methods
         bool TorqueBalancingController::threadInit()
         {
             using namespace Eigen;
             //Initialize constant variables
-            bool linkFound = true;
-            linkFound = m_robot.getFrameList().idToIndex("l_sole", m_leftFootLinkID);
-            linkFound = linkFound && m_robot.getFrameList().idToIndex("r_sole", m_rightFootLinkID);
-
-            //centroidal force matrix
-            m_centroidalForceMatrix.setZero();
-            m_centroidalForceMatrix.block<3, 3>(0, 0) = Matrix3d::Identity();
-            m_centroidalForceMatrix.block<3, 3>(0, 6) = Matrix3d::Identity();
-            m_centroidalForceMatrix.block<3, 3>(3, 3) = Matrix3d::Identity();
-            m_centroidalForceMatrix.block<3, 3>(3, 9) = Matrix3d::Identity();
             //gravity
-            m_gravityForce.setZero();
             m_gravityUnitVector[0] = m_gravityUnitVector[1] = 0;
             m_gravityUnitVector[2] = -9.81;
 
-            m_torquesSelector.setZero();
-            m_torquesSelector.bottomRows(m_actuatedDOFs).setIdentity();
-
             m_jointsZeroVector.setZero();
             m_esaZeroVector.setZero();
             m_torqueSaturationLimit.setConstant(std::numeric_limits<double>::max());
 
+            if (m_kinDynStateUpdater && !m_kinDynStateUpdater->setContactsFrames(m_contactsLinkName)) {
+                yError("Constraint frames not found in the dynamics model.");
+                return false;
+            }
+
             //reset status to zero
-            m_jointPositions.setZero();
+            m_state = ControllerState(m_actuatedDOFs, m_contactsLinkName.size());
             m_jointVelocities.setZero();
             m_baseVelocity.setZero();
-            m_centerOfMassPosition.setZero();
-            m_rightFootPosition.setZero();
-            m_leftFootPosition.setZero();
-            m_contactsJacobian.setZero();
-            m_contactsDJacobianDq.setZero();
-            m_generalizedBiasForces.setZero();
-            m_gravityBiasTorques.setZero();
-            m_centroidalMomentum.setZero();
-            m_massMatrix.setZero();
 
             m_desiredJointsConfiguration.setZero();
 
@@ -186,22 +147,33 @@ namespace codyco {
             int count = 10;
 
             do {
-                result = m_robot.getEstimates(wbi::ESTIMATE_JOINT_POS, m_jointPositions.data());
+                result = m_robot.getEstimates(wbi::ESTIMATE_JOINT_POS, m_state.jointPositions.data());
                 count--;
             } while(!result && count >0);
 
+            //the fused update is used only if it computes the same state as the wbi calls
+            if (m_kinDynStateUpdater) {
+                if (checkDynamicsModel()) {
+                    yInfo("Fused dynamics update is ENABLED");
+                } else {
+                    yWarning("The dynamics model is not consistent with the wbi. Fused dynamics update is DISABLED");
+                    delete m_kinDynStateUpdater;
+                    m_kinDynStateUpdater = 0;
+                }
+            }
+
             std::stringstream formattedConstraintsString;
-            formattedConstraintsString << m_activeConstraints.size() << " Dyn. Constraints = ";
-            for (ConstraintsMap::const_iterator it = m_activeConstraints.begin();
-                 it != m_activeConstraints.end(); it++) {
-                formattedConstraintsString << it->first << " ";
+            formattedConstraintsString << m_contactsLinkName.size() << " Dyn. Constraints = ";
+            for (std::size_t contact = 0; contact < m_contactsLinkName.size(); contact++) {
+                formattedConstraintsString << m_contactsLinkName[contact]
+                << (m_contactsConstraint[contact].isActive() ? " " : " (inactive) ");
             }
             yInfo("%s", formattedConstraintsString.str().c_str());
 
 
 //            debugPort.open("/tb/debug:o");
 
-            return linkFound && result && !m_activeConstraints.empty();
+            return result && !m_contactsLinkName.empty();
         }
 
         void TorqueBalancingController::threadRelease()
@@ -236,10 +208,24 @@ namespace codyco {
             }
 
             //compute desired feet forces
-            computeContactForces(m_desiredCOMAcceleration, m_desiredContactForces);
+            m_core.computeContactForces(m_state, m_desiredCOMAcceleration, m_centroidalMomentumGain, m_desiredContactForces);
+            m_desiredFeetForces.setZero();
+            if (m_leftFootContactIndex >= 0) {
+                m_desiredFeetForces.head<6>() = m_desiredContactForces.segment<6>(6 * m_leftFootContactIndex);
+            }
+            if (m_rightFootContactIndex >= 0) {
+                m_desiredFeetForces.tail<6>() = m_desiredContactForces.segment<6>(6 * m_rightFootContactIndex);
+            }
 
             //compute torques
-            computeTorques(m_desiredContactForces, m_torques);
+            if (!m_core.computeTorques(m_state, m_desiredJointsConfiguration, m_impedanceGains, m_torqueSaturationLimit,
+                                       m_desiredContactForces, m_torques)) {
+                yInfo() << "Mass matrix is not positive definite. Deactivating control";
+                m_robot.setControlMode(wbi::CTRL_MODE_POS);
+                m_active = false;
+                if (m_delegate) m_delegate->controllerDidStop(*this);
+                return;
+            }
 
             //write torques
             writeTorques();
@@ -322,6 +308,12 @@ namespace codyco {
             return m_torqueSaturationLimit;
         }
 
+        bool TorqueBalancingController::setContactForcesQPParameters(const ContactForcesQPParameters& parameters)
+        {
+            yarp::os::LockGuard guard(m_mutex);
+            return m_core.setContactForcesQPParameters(parameters);
+        }
+
         void TorqueBalancingController::setDelegate(ControllerDelegate *delegate)
         {
             yarp::os::LockGuard guard(m_mutex);
@@ -329,59 +321,88 @@ namespace codyco {
         }
 
 
-        bool TorqueBalancingController::setInitialConstraintSet(const std::vector<std::string> &constraintsLinkName)
+        bool TorqueBalancingController::setInitialConstraintSet(const std::vector<std::string> &constraintsLinkName,
+                                                                const std::vector<std::string> &inactiveConstraintsLinkName)
         {
             if (isRunning()) return false;
-            //TODO: two days before the demo is not the right moment to make the constraints generic.
-            // For now simply accept the l_sole or r_sole constraints.
-            // move everything to something more generic ASAP
+            std::vector<std::string> contactsLinkName;
+            std::vector<int> contactsLinkID;
+            std::vector<DynamicConstraint> contactsConstraint;
             bool result = true;
-            m_activeConstraints.clear();
-            for (std::vector<std::string>::const_iterator it = constraintsLinkName.begin();
-                 it != constraintsLinkName.end(); it++) {
-                if ((*it).compare("l_sole") == 0) {
-                    DynamicConstraint leftFoot;
-                    result = result && leftFoot.init(true, getRate() / 1000.0, m_dynamicsTransitionTime);
-                    m_activeConstraints.insert(ConstraintsMap::value_type(*it, leftFoot));
-
-                } else if ((*it).compare("r_sole") == 0) {
-                    DynamicConstraint rightFoot;
-                    result = result && rightFoot.init(true, getRate() / 1000.0, m_dynamicsTransitionTime);
-                    m_activeConstraints.insert(ConstraintsMap::value_type(*it, rightFoot));
+            for (std::size_t i = 0; i < constraintsLinkName.size() + inactiveConstraintsLinkName.size(); i++) {
+                bool isActive = i < constraintsLinkName.size();
+                const std::string &linkName = isActive ? constraintsLinkName[i] : inactiveConstraintsLinkName[i - constraintsLinkName.size()];
+                if (std::find(contactsLinkName.begin(), contactsLinkName.end(), linkName) != contactsLinkName.end()) continue;
+
+                int linkID = -1;
+                if (!m_robot.getFrameList().idToIndex(linkName.c_str(), linkID)) {
+                    yError("Constraint frame %s not found", linkName.c_str());
+                    return false;
                 }
+                DynamicConstraint constraint;
+                result = result && constraint.init(isActive, getRate() / 1000.0, m_dynamicsTransitionTime);
+                contactsLinkName.push_back(linkName);
+                contactsLinkID.push_back(linkID);
+                contactsConstraint.push_back(constraint);
             }
+            if (!result || contactsLinkName.empty()) return false;
+
+            m_contactsLinkName = contactsLinkName;
+            m_contactsLinkID = contactsLinkID;
+            m_contactsConstraint = contactsConstraint;
+            m_leftFootContactIndex = contactIndex("l_sole");
+            m_rightFootContactIndex = contactIndex("r_sole");
+
+            //resize the quantities depending on the number of contacts
+            int contacts = m_contactsLinkName.size();
+            m_state = ControllerState(m_actuatedDOFs, contacts);
+            m_desiredContactForces = Eigen::VectorXd::Zero(6 * contacts);
+            ControllerCore core(m_actuatedDOFs, contacts);
+            if (m_core.isContactForcesQPEnabled()) {
+                core.setContactForcesQPParameters(m_core.contactForcesQPParameters());
+            }
+            m_core = core;
+            return true;
+        }
 
-            return result && m_activeConstraints.size() >= 1 && m_activeConstraints.size() <= 2;
+        bool TorqueBalancingController::setDynamicsModel(const std::string &urdfFile, const std::vector<std::string> &jointsName, const std::string &baseLinkName)
+        {
+            if (isRunning()) return false;
+            KinDynStateUpdater *kinDynStateUpdater = new KinDynStateUpdater();
+            if (!kinDynStateUpdater->loadModelFromFile(urdfFile, jointsName, baseLinkName)
+                || kinDynStateUpdater->actuatedDOFs() != m_actuatedDOFs) {
+                delete kinDynStateUpdater;
+                return false;
+            }
+            delete m_kinDynStateUpdater;
+            m_kinDynStateUpdater = kinDynStateUpdater;
+            return true;
         }
 
         bool TorqueBalancingController::addDynamicConstraint(std::string frameName, bool /*smooth*/)
         {
-            //For now full jacobians are not written in an "iterative" way.
-            //just hardcode all the possible scenarios. (as in MATLAB version)
-            //This must be changed in the future
-            //            ConstraintsMap::iterator found = m_activeConstraints.find(frameName);
-            //            if (found != m_activeConstraints.end()) return false;
-            //            DynamicContraint constraint(frameName);
-            //            constraint.createMemory();
-            //            m_activeConstraints.insert(ConstraintsMap::value_type(frameName, constraint));
             yarp::os::LockGuard guard(m_mutex);
-            ConstraintsMap::iterator found = m_activeConstraints.find(frameName);
-            if (found == m_activeConstraints.end()) return false;
-            found->second.activate();
-
+            int contact = contactIndex(frameName);
+            if (contact < 0) return false;
+            m_contactsConstraint[contact].activate();
             return true;
         }
 
         bool TorqueBalancingController::removeDynamicConstraint(std::string frameName, bool /*smooth*/)
         {
             yarp::os::LockGuard guard(m_mutex);
-            ConstraintsMap::iterator found = m_activeConstraints.find(frameName);
-            if (found == m_activeConstraints.end()) return false;
-            found->second.deactivate();
-
+            int contact = contactIndex(frameName);
+            if (contact < 0) return false;
+            m_contactsConstraint[contact].deactivate();
             return true;
         }
 
+        int TorqueBalancingController::contactIndex(const std::string &frameName) const
+        {
+            std::vector<std::string>::const_iterator found = std::find(m_contactsLinkName.begin(), m_contactsLinkName.end(), frameName);
+            return found == m_contactsLinkName.end() ? -1 : static_cast<int>(found - m_contactsLinkName.begin());
+        }
+
 #pragma mark - Monitorable variables
 
         const Eigen::VectorXd& TorqueBalancingController::desiredFeetForces()
@@ -400,19 +421,17 @@ namespace codyco {
 
         void TorqueBalancingController::readReferences()
         {
-            if (m_references.desiredCOMAcceleration().isValid())
-                m_desiredCOMAcceleration = m_references.desiredCOMAcceleration().value();
-            if (m_references.desiredJointsConfiguration().isValid()) {
-                m_desiredJointsConfiguration = m_references.desiredJointsConfiguration().value();
-            }
+            //lock-free: the controller never waits for the reference generators
+            m_references.desiredCOMAcceleration().readLatestValue(m_desiredCOMAcceleration);
+            m_references.desiredJointsConfiguration().readLatestValue(m_desiredJointsConfiguration);
         }
 
         bool TorqueBalancingController::jointsInLimitRange()
         {
-            for (int i = 0; i < m_jointPositions.size(); i++) {
-                if (m_jointPositions(i) < m_minJointLimits(i) ||
-                    m_jointPositions(i) > m_maxJointLimits(i)) {
-                    yInfo("Joint %d is outside limit [%lf,%lf is %lf]. Stop control", i, m_minJointLimits(i), m_maxJointLimits(i), m_jointPositions(i));
+            for (int i = 0; i < m_state.jointPositions.size(); i++) {
+                if (m_state.jointPositions(i) < m_minJointLimits(i) ||
+                    m_state.jointPositions(i) > m_maxJointLimits(i)) {
+                    yInfo("Joint %d is outside limit [%lf,%lf is %lf]. Stop control", i, m_minJointLimits(i), m_maxJointLimits(i), m_state.jointPositions(i));
                     return false;
                 }
             }
@@ -427,7 +446,7 @@ namespace codyco {
 #endif
             bool result = true;
             //read positions and velocities
-            result = result && m_robot.getEstimates(wbi::ESTIMATE_JOINT_POS, m_jointPositions.data());
+            result = result && m_robot.getEstimates(wbi::ESTIMATE_JOINT_POS, m_state.jointPositions.data());
             result = result && m_robot.getEstimates(wbi::ESTIMATE_JOINT_VEL, m_jointVelocities.data());
 
             result = result && m_robot.getEstimates(wbi::ESTIMATE_BASE_POS, m_world2BaseFrameSerialization.data());
@@ -435,225 +454,119 @@ namespace codyco {
 
             result = result && m_robot.getEstimates(wbi::ESTIMATE_BASE_VEL, m_baseVelocity.data());
 
-            //update jacobians (both feet in one variable)
-            ConstraintsMap::iterator leftFootConstraint = m_activeConstraints.find("l_sole");
-            if (leftFootConstraint != m_activeConstraints.end()) {
-                leftFootConstraint->second.updateStateInterpolation();
-            }
-            ConstraintsMap::iterator rightFootConstraint = m_activeConstraints.find("r_sole");
-            if (rightFootConstraint != m_activeConstraints.end()) {
-                rightFootConstraint->second.updateStateInterpolation();
-            }
-
-            m_contactsJacobian.setZero();
-            if (leftFootConstraint != m_activeConstraints.end()
-                && leftFootConstraint->second.isActiveWithThreshold(TORQUEBALANCING_STATEACTIVE_THRESHOLD)) {
-                m_jacobianTemporary.setZero();
-                m_robot.computeJacobian(m_jointPositions.data(), m_world2BaseFrame, m_leftFootLinkID, m_jacobianTemporary.data());
-                m_jacobianTemporary *= leftFootConstraint->second.continuousValue();
-                m_contactsJacobian.topRows(6) = m_jacobianTemporary;
-            }
-            if (rightFootConstraint != m_activeConstraints.end()
-                && rightFootConstraint->second.isActiveWithThreshold(TORQUEBALANCING_STATEACTIVE_THRESHOLD)) {
-                m_jacobianTemporary.setZero();
-                m_robot.computeJacobian(m_jointPositions.data(), m_world2BaseFrame, m_rightFootLinkID, m_jacobianTemporary.data());
-                m_jacobianTemporary *= rightFootConstraint->second.continuousValue();
-                m_contactsJacobian.bottomRows(6) = m_jacobianTemporary;
+            //update contacts activation
+            for (std::size_t contact = 0; contact < m_contactsConstraint.size(); contact++) {
+                DynamicConstraint &constraint = m_contactsConstraint[contact];
+                constraint.updateStateInterpolation();
+                double activation = 0;
+                if (constraint.isActiveWithThreshold(TORQUEBALANCING_STATEACTIVE_THRESHOLD)) {
+                    activation = constraint.continuousValue();
+                }
+                m_state.contactsActivation(contact) = activation;
             }
 
-            //update kinematic quantities
-            m_robot.forwardKinematics(m_jointPositions.data(), m_world2BaseFrame, m_centerOfMassLinkID, m_rotoTranslationVector.data());
-            m_centerOfMassPosition = m_rotoTranslationVector.head<3>();
-            m_robot.forwardKinematics(m_jointPositions.data(), m_world2BaseFrame, m_leftFootLinkID, m_leftFootPosition.data());
-            m_robot.forwardKinematics(m_jointPositions.data(), m_world2BaseFrame, m_rightFootLinkID, m_rightFootPosition.data());
-//            yarp::sig::Vector &v = debugPort.prepare();
-//            v.resize(6+16);
-//            v(0) = m_leftFootPosition(0) - m_centerOfMassPosition(0);
-//            v(1) = m_leftFootPosition(1) - m_centerOfMassPosition(1);
-//            v(2) = m_leftFootPosition(2) - m_centerOfMassPosition(2);
-//            v(3) = m_rightFootPosition(0) - m_centerOfMassPosition(0);
-//            v(4) = m_rightFootPosition(1) - m_centerOfMassPosition(1);
-//            v(5) = m_rightFootPosition(2) - m_centerOfMassPosition(2);
-//            for (int i = 0; i < 16; i++) {
-//                v(6+ i) = m_world2BaseFrameSerialization.data()[i];
-//            }
-//            debugPort.write();
-
-            //update dynamic quantities
-            m_robot.computeMassMatrix(m_jointPositions.data(), m_world2BaseFrame, m_massMatrix.data());
-            m_robot.computeCentroidalMomentum(m_jointPositions.data(), m_world2BaseFrame, m_jointVelocities.data(), m_baseVelocity.data(), m_centroidalMomentum.data());
-
-            m_contactsDJacobianDq.setZero();
-            if (leftFootConstraint != m_activeConstraints.end()
-                && leftFootConstraint->second.isActiveWithThreshold(TORQUEBALANCING_STATEACTIVE_THRESHOLD)) {
-                m_robot.computeDJdq(m_jointPositions.data(), m_world2BaseFrame, m_jointVelocities.data(), m_baseVelocity.data(), m_leftFootLinkID, m_contactsDJacobianDq.head(6).data());
-                m_contactsDJacobianDq.head(6) *= leftFootConstraint->second.continuousValue();
-            }
-            if (rightFootConstraint != m_activeConstraints.end()
-                && rightFootConstraint->second.isActiveWithThreshold(TORQUEBALANCING_STATEACTIVE_THRESHOLD)) {
-                m_robot.computeDJdq(m_jointPositions.data(), m_world2BaseFrame, m_jointVelocities.data(), m_baseVelocity.data(), m_rightFootLinkID, m_contactsDJacobianDq.tail(6).data());
-                m_contactsDJacobianDq.tail(6) *= rightFootConstraint->second.continuousValue();
+            if (m_kinDynStateUpdater) {
+                //all the quantities are computed from a single traversal of the model
+                result = result && computeStateWithModel(m_state);
+            } else {
+                computeStateWithWBI(m_state);
             }
 
-            //Compute bias forces
-            m_robot.computeGeneralizedBiasForces(m_jointPositions.data(), m_world2BaseFrame, m_jointVelocities.data(), m_baseVelocity.data(), m_gravityUnitVector, m_generalizedBiasForces.data());
-            m_robot.computeGeneralizedBiasForces(m_jointPositions.data(), m_world2BaseFrame, m_jointsZeroVector.data(), m_esaZeroVector.data(), m_gravityUnitVector, m_gravityBiasTorques.data());
-
 #if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
             Eigen::internal::set_is_malloc_allowed(true);
 #endif
             return result;
         }
 
-        void TorqueBalancingController::computeContactForces(const Eigen::Ref<Eigen::VectorXd>& desiredCOMAcceleration, Eigen::Ref<Eigen::VectorXd> desiredContactForces)
+        bool TorqueBalancingController::computeStateWithModel(ControllerState &state)
         {
-#if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
-            Eigen::internal::set_is_malloc_allowed(false);
-#endif
-            using namespace Eigen;
-            double mass = m_massMatrix(0, 0);
-            m_gravityForce(2) = -mass * 9.81;
-
-            ConstraintsMap::const_iterator leftFootConstraint = m_activeConstraints.find("l_sole");
-            ConstraintsMap::const_iterator rightFootConstraint = m_activeConstraints.find("r_sole");
-
-            //building centroidalForceMatrix
-            bool leftConstraintIsActive = false;
-            bool rightConstraintIsActive = false;
-
-            m_centroidalForceMatrix.setZero();
-            if (leftFootConstraint != m_activeConstraints.end()
-                && leftFootConstraint->second.isActiveWithThreshold(TORQUEBALANCING_STATEACTIVE_THRESHOLD)) {
-                leftConstraintIsActive = true;
-                m_centroidalForceMatrix.block<3, 3>(0, 0).setIdentity();
-                m_centroidalForceMatrix.block<3, 3>(3, 3).setIdentity();
-                math::skewSymmentricMatrixFrom3DVector(m_leftFootPosition.head<3>() - m_centerOfMassPosition, m_centroidalForceMatrix.block<3, 3>(3, 0));
-                m_centroidalForceMatrix.leftCols(6) *= leftFootConstraint->second.continuousValue();
-            }
+            Eigen::Matrix4d world2Base = Eigen::Matrix4d::Identity();
+            world2Base.topLeftCorner<3, 3>() = Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor> >(m_world2BaseFrame.R.data);
+            world2Base.topRightCorner<3, 1>() = Eigen::Map<const Eigen::Vector3d>(m_world2BaseFrame.p);
+            return m_kinDynStateUpdater->updateState(state.jointPositions, m_jointVelocities,
+                                                     world2Base, m_baseVelocity,
+                                                     Eigen::Map<const Eigen::Vector3d>(m_gravityUnitVector),
+                                                     state);
+        }
 
-            if (rightFootConstraint != m_activeConstraints.end()
-                && rightFootConstraint->second.isActiveWithThreshold(TORQUEBALANCING_STATEACTIVE_THRESHOLD)) {
-                rightConstraintIsActive = true;
-                m_centroidalForceMatrix.block<3, 3>(0, 6).setIdentity();
-                m_centroidalForceMatrix.block<3, 3>(3, 9).setIdentity();
-                math::skewSymmentricMatrixFrom3DVector(m_rightFootPosition.head<3>() - m_centerOfMassPosition, m_centroidalForceMatrix.block<3, 3>(3, 6));
-                m_centroidalForceMatrix.rightCols(6) *= rightFootConstraint->second.continuousValue();
-            }
+        void TorqueBalancingController::computeStateWithWBI(ControllerState &state)
+        {
+            //update kinematic quantities
+            m_robot.forwardKinematics(state.jointPositions.data(), m_world2BaseFrame, m_centerOfMassLinkID, m_rotoTranslationVector.data());
+            state.centerOfMassPosition = m_rotoTranslationVector.head<3>();
 
-            m_desiredCentroidalMomentum.head<3>() = mass * desiredCOMAcceleration;
-            m_desiredCentroidalMomentum.tail<3>() = -m_centroidalMomentumGain * m_centroidalMomentum.tail<3>();
-
-            //Eigen 3.3 will allow to set a threashold directly on the decomposition
-            //thus allowing the method solve to work "properly".
-            //Becaues it is not stable yet we use the explicit computation of the SVD
-            //            m_svdDecompositionOfCentroidalForceMatrix.compute(m_centroidalForceMatrix).solve(m_desiredCentroidalMomentum - m_gravityForce);
-            m_buffers.esaVector = m_desiredCentroidalMomentum - m_gravityForce;
-            if (leftConstraintIsActive ^ rightConstraintIsActive) {
-                m_desiredFeetForces.setZero();
-                //substitute the pseudoinverse with its inverse
-                m_luDecompositionOfCentroidalMatrix.compute(m_centroidalForceMatrix.block<6, 6>(0, leftConstraintIsActive ? 0 : 6));
-                m_desiredFeetForces.segment(leftConstraintIsActive ? 0 : 6, 6) = m_luDecompositionOfCentroidalMatrix.solve(m_buffers.esaVector);
-                m_nullSpaceOfCentroidalForceMatrix.setZero();
+            //update dynamic quantities
+            m_robot.computeMassMatrix(state.jointPositions.data(), m_world2BaseFrame, state.massMatrix.data());
+            m_robot.computeCentroidalMomentum(state.jointPositions.data(), m_world2BaseFrame, m_jointVelocities.data(), m_baseVelocity.data(), state.centroidalMomentum.data());
+
+            //update contacts (all the contacts in one variable).
+            //Kinematics of the contacts are computed only for the active ones
+            for (std::size_t contact = 0; contact < m_contactsConstraint.size(); contact++) {
+                double activation = state.contactsActivation(contact);
+                if (activation <= 0) {
+                    state.contactsJacobian.middleRows<6>(6 * contact).setZero();
+                    state.contactsDJacobianDq.segment<6>(6 * contact).setZero();
+                    continue;
+                }
 
-            } else {
-                math::pseudoInverse(m_centroidalForceMatrix, m_svdDecompositionOfCentroidalForceMatrix,
-                                    m_pseudoInverseOfCentroidalForceMatrix, PseudoInverseTolerance);
-                m_desiredFeetForces.noalias() = m_pseudoInverseOfCentroidalForceMatrix * m_buffers.esaVector;
+                int linkID = m_contactsLinkID[contact];
+                m_jacobianTemporary.setZero();
+                m_robot.computeJacobian(state.jointPositions.data(), m_world2BaseFrame, linkID, m_jacobianTemporary.data());
+                state.contactsJacobian.middleRows<6>(6 * contact) = activation * m_jacobianTemporary;
 
-                //TODO: change the following line by using the null space basis obtained by the pseudoinverse method
-                m_nullSpaceOfCentroidalForceMatrix.setIdentity();
-                m_nullSpaceOfCentroidalForceMatrix -= m_pseudoInverseOfCentroidalForceMatrix * m_centroidalForceMatrix;
+                m_robot.computeDJdq(state.jointPositions.data(), m_world2BaseFrame, m_jointVelocities.data(), m_baseVelocity.data(), linkID, state.contactsDJacobianDq.segment<6>(6 * contact).data());
+                state.contactsDJacobianDq.segment<6>(6 * contact) *= activation;
+
+                //orientation is needed by the contact constraints (wbi::Rotation is stored row-major)
+                m_robot.computeH(state.jointPositions.data(), m_world2BaseFrame, linkID, m_contactFrame);
+                state.contactsPosition.col(contact) = Eigen::Map<const Eigen::Vector3d>(m_contactFrame.p);
+                state.contactsOrientation.middleCols<3>(3 * contact) = Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor> >(m_contactFrame.R.data);
             }
-            desiredContactForces = m_desiredFeetForces;
-#if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
-            Eigen::internal::set_is_malloc_allowed(true);
-#endif
+
+            //Compute bias forces
+            m_robot.computeGeneralizedBiasForces(state.jointPositions.data(), m_world2BaseFrame, m_jointVelocities.data(), m_baseVelocity.data(), m_gravityUnitVector, state.generalizedBiasForces.data());
+            m_robot.computeGeneralizedBiasForces(state.jointPositions.data(), m_world2BaseFrame, m_jointsZeroVector.data(), m_esaZeroVector.data(), m_gravityUnitVector, state.gravityBiasTorques.data());
         }
 
-        void TorqueBalancingController::computeTorques(const Eigen::Ref<Eigen::VectorXd>& desiredContactForces, Eigen::Ref<Eigen::VectorXd> torques)
+        bool TorqueBalancingController::checkDynamicsModel()
         {
-            using namespace Eigen;
+            yarp::os::LockGuard guard(dynamic_cast<yarpWbi::yarpWholeBodyInterface*>(&m_robot)->getInterfaceMutex());
+            //current configuration of the robot, with all the contacts active and non zero velocities.
+            //Velocities are needed to compare the velocity representation, the centroidal momentum and dJdq
+            ControllerState wbiState(m_actuatedDOFs, m_contactsLinkName.size());
+            wbiState.contactsActivation.setOnes();
+            bool result = m_robot.getEstimates(wbi::ESTIMATE_JOINT_POS, wbiState.jointPositions.data());
+            result = result && m_robot.getEstimates(wbi::ESTIMATE_BASE_POS, m_world2BaseFrameSerialization.data());
+            if (!result) {
+                yError("Could not read the state of the robot to check the dynamics model.");
+                return false;
+            }
+            wbi::frameFromSerialization(m_world2BaseFrameSerialization.data(), m_world2BaseFrame);
+            m_jointVelocities = Eigen::VectorXd::LinSpaced(m_actuatedDOFs, -0.5, 0.5);
+            m_baseVelocity << 0.1, -0.2, 0.15, 0.3, -0.1, 0.2;
 
-#if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
-            Eigen::internal::set_is_malloc_allowed(false);
-#endif
+            ControllerState modelState = wbiState;
+            computeStateWithWBI(wbiState);
+            result = computeStateWithModel(modelState);
+            m_jointVelocities.setZero();
+            m_baseVelocity.setZero();
+            if (!result) {
+                yError("Could not compute the state of the robot with the dynamics model.");
+                return false;
+            }
 
-            //Names are taken from "math" from brevity
-            MatrixXd JcMInv = m_contactsJacobian * m_massMatrix.inverse(); //to become instance (?)
-            MatrixXd JcMInvJct = JcMInv * m_contactsJacobian.transpose(); //to become instance (?)
-            MatrixXd JcMInvTorqueSelector = JcMInv * m_torquesSelector; //to become instance (?)
-            MatrixXd jointProjectedBaseAccelerations = m_massMatrix.block(6, 0, m_actuatedDOFs, 6) * m_massMatrix.topLeftCorner<6, 6>().inverse();
-
-            math::dampedPseudoInverse(JcMInvTorqueSelector, m_svdDecompositionOfJcMInvSt, m_pseudoInverseOfJcMInvSt,
-                                      PseudoInverseTolerance,
-                                      JcMInvSPseudoInverseDampingTerm);
-            math::pseudoInverse(JcMInvTorqueSelector, m_svdDecompositionOfJcMInvSt,
-                                m_pseudoInverseOfJcMInvSt, PseudoInverseTolerance);
-            //TODO: change the following line by using the null space basis obtained by the pseudoinverse method
-            MatrixXd JcNullSpaceProjector = MatrixXd::Identity(m_actuatedDOFs, m_actuatedDOFs) - m_pseudoInverseOfJcMInvSt * JcMInvTorqueSelector;
-
-            MatrixXd mult_f_tau0 =  jointProjectedBaseAccelerations * m_contactsJacobian.leftCols(6).transpose() - m_contactsJacobian.rightCols(m_actuatedDOFs).transpose();
-
-            VectorXd  torques0 =  m_gravityBiasTorques.tail(m_actuatedDOFs) - m_impedanceGains.asDiagonal() * (m_jointPositions - m_desiredJointsConfiguration) - jointProjectedBaseAccelerations * m_generalizedBiasForces.head<6>();
-
-            MatrixXd mult_f_tau = -m_pseudoInverseOfJcMInvSt * JcMInvJct + JcNullSpaceProjector * mult_f_tau0;
-
-            VectorXd n_tau = m_pseudoInverseOfJcMInvSt * (JcMInv * m_generalizedBiasForces - m_contactsDJacobianDq) + JcNullSpaceProjector * torques0;
-
-            //TODO: change the following line by using the null space basis obtained by the pseudoinverse method
-//            MatrixXd forceMatrixNullSpaceProjector = MatrixXd::Identity(12, 12) - m_pseudoInverseOfCentroidalForceMatrix * m_centroidalForceMatrix;
-
-            MatrixXd mat = mult_f_tau * m_nullSpaceOfCentroidalForceMatrix;
-
-            math::pseudoInverse(mult_f_tau * m_nullSpaceOfCentroidalForceMatrix, m_svdDecompositionOfTauN0_f,m_pseudoInverseOfTauN0_f, PseudoInverseTolerance, Eigen::ComputeFullV|Eigen::ComputeFullU);
-
-            torques = (MatrixXd::Identity(n_tau.size(), n_tau.size()) -mult_f_tau * m_nullSpaceOfCentroidalForceMatrix * m_pseudoInverseOfTauN0_f) * (n_tau + mult_f_tau * desiredContactForces);
-
-//            m_buffers.totalDoFsLDLTDecomposition.compute(m_massMatrix);
-//            Eigen::internal::solve_retval<LDLT<MatrixXd::PlainObject>, MatrixXd> var =
-//            m_buffers.totalDoFsLDLTDecomposition.solve(m_buffers.totalDoFsIdentity);
-//            m_buffers.totalDoFsTimesTotalDoFs = var.rhs();
-//
-//            m_buffers.twelveTimesTotalDoFs.noalias() = m_contactsJacobian * m_buffers.totalDoFsTimesTotalDoFs;
-//            m_buffers.twelveTimesTwelve.noalias() = m_buffers.twelveTimesTotalDoFs * m_contactsJacobian.transpose();
-//            m_buffers.sixTimesSix.noalias() = m_massMatrix.topLeftCorner<6, 6>().inverse();
-//            m_buffers.twelveTimesDoFs.noalias() = m_buffers.twelveTimesTotalDoFs * m_torquesSelector;
-//            m_buffers.dofsTimesSix.noalias() = m_massMatrix.block(6, 0, m_actuatedDOFs, 6) * m_buffers.sixTimesSix; //* m_massMatrix.topLeftCorner<6, 6>().inverse();
-//
-//            math::dampedPseudoInverse(m_buffers.twelveTimesDoFs, m_svdDecompositionOfJcMInvSt, m_pseudoInverseOfJcMInvSt,
-//                                      PseudoInverseTolerance,
-//                                      JcMInvSPseudoInverseDampingTerm);
-//            math::pseudoInverse(m_buffers.twelveTimesDoFs, m_svdDecompositionOfJcMInvSt,
-//                                m_pseudoInverseOfJcMInvSt, PseudoInverseTolerance);
-//            //TODO: change the following line by using the null space basis obtained by the pseudoinverse method
-//
-//            m_nullSpaceProjectorOfJcMInvSt.setIdentity();
-//            m_nullSpaceProjectorOfJcMInvSt/*.noalias()*/ -= m_pseudoInverseOfJcMInvSt * m_buffers.twelveTimesDoFs;
-//
-//
-//            MatrixXd mult_f_tau0 =  m_buffers.dofsTimesSix * m_contactsJacobian.leftCols(6).transpose() - m_contactsJacobian.rightCols(m_actuatedDOFs).transpose();
-//
-//            m_buffers.jointsVector =  m_gravityBiasTorques.tail(m_actuatedDOFs) - m_impedanceGains.asDiagonal() * (m_jointPositions - m_desiredJointsConfiguration) - m_buffers.dofsTimesSix * m_generalizedBiasForces.head<6>();
-//
-//            MatrixXd mult_f_tau = -m_pseudoInverseOfJcMInvSt * m_buffers.twelveTimesTwelve + m_nullSpaceProjectorOfJcMInvSt * mult_f_tau0;
-//
-//            m_buffers.jointsVector2 = m_pseudoInverseOfJcMInvSt * m_buffers.twelveTimesTotalDoFs * m_generalizedBiasForces;
-//            m_buffers.jointsVector2 -= m_pseudoInverseOfJcMInvSt * m_contactsDJacobianDq;
-//            m_buffers.jointsVector2 += m_nullSpaceProjectorOfJcMInvSt * m_buffers.jointsVector;
-//
-//            math::pseudoInverse(mult_f_tau * m_nullSpaceOfCentroidalForceMatrix, m_svdDecompositionOfTauN0_f,m_pseudoInverseOfTauN0_f, PseudoInverseTolerance, Eigen::ComputeFullV|Eigen::ComputeFullU);
-//
-//            m_buffers.dofsTimesDoFs.setIdentity();
-//
-//            torques = (m_buffers.dofsTimesDoFs - mult_f_tau * m_nullSpaceOfCentroidalForceMatrix * m_pseudoInverseOfTauN0_f) * (m_buffers.jointsVector2 + mult_f_tau * desiredContactForces);
-
-            //apply saturation
-            //TODO: this must be checked: valgrind says it contains a jump on an unitialized variable
-            //TODO: check isinf or isnan
-            torques = torques.array().min(m_torqueSaturationLimit.array()).max(-m_torqueSaturationLimit.array());
-#if defined(DEBUG) && defined(EIGEN_RUNTIME_NO_MALLOC)
-            Eigen::internal::set_is_malloc_allowed(true);
-#endif
+            //mass matrix and contacts poses depend on the base link,
+            //centroidal momentum, bias forces and dJdq also on the velocity representation
+            result = isEqualToWBIQuantity("Center of mass position", modelState.centerOfMassPosition, wbiState.centerOfMassPosition);
+            result = isEqualToWBIQuantity("Mass matrix", modelState.massMatrix, wbiState.massMatrix) && result;
+            result = isEqualToWBIQuantity("Centroidal momentum", modelState.centroidalMomentum, wbiState.centroidalMomentum) && result;
+            result = isEqualToWBIQuantity("Generalized bias forces", modelState.generalizedBiasForces, wbiState.generalizedBiasForces) && result;
+            result = isEqualToWBIQuantity("Gravity bias torques", modelState.gravityBiasTorques, wbiState.gravityBiasTorques) && result;
+            result = isEqualToWBIQuantity("Contacts jacobian", modelState.contactsJacobian, wbiState.contactsJacobian) && result;
+            result = isEqualToWBIQuantity("Contacts dJdq", modelState.contactsDJacobianDq, wbiState.contactsDJacobianDq) && result;
+            result = isEqualToWBIQuantity("Contacts position", modelState.contactsPosition, wbiState.contactsPosition) && result;
+            result = isEqualToWBIQuantity("Contacts orientation", modelState.contactsOrientation, wbiState.contactsOrientation) && result;
+            return result;
         }
 
         void TorqueBalancingController::writeTorques()
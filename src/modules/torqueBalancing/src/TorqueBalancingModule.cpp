@@ -333,6 +333,63 @@ namespace codyco {
             m_controller->setDelegate(this);
             m_controller->setCheckJointLimits(checkJointLimits);
 
+            //Contact forces QP (optional)
+            //Structure is: group CONTACT_FORCES_QP with keys
+            //              enabled, friction, cone_sides, cop_min (x y), cop_max (x y),
+            //              fz_min, fz_max, regularization, max_iterations
+            Bottle &contactForcesQPGroup = rf.findGroup("CONTACT_FORCES_QP");
+            if (!contactForcesQPGroup.isNull() && contactForcesQPGroup.check("enabled", falseValue).asBool()) {
+                ContactForcesQPParameters qpParameters;
+                qpParameters.frictionCoefficient = contactForcesQPGroup.check("friction", Value(qpParameters.frictionCoefficient)).asDouble();
+                qpParameters.frictionConeSides = contactForcesQPGroup.check("cone_sides", Value(qpParameters.frictionConeSides)).asInt();
+                qpParameters.minimumNormalForce = contactForcesQPGroup.check("fz_min", Value(qpParameters.minimumNormalForce)).asDouble();
+                if (contactForcesQPGroup.check("fz_max")) {
+                    qpParameters.maximumNormalForce = contactForcesQPGroup.find("fz_max").asDouble();
+                }
+                qpParameters.regularization = contactForcesQPGroup.check("regularization", Value(qpParameters.regularization)).asDouble();
+                qpParameters.maximumIterations = contactForcesQPGroup.check("max_iterations", Value(qpParameters.maximumIterations)).asInt();
+                Bottle *copBounds = contactForcesQPGroup.find("cop_min").asList();
+                if (copBounds && copBounds->size() == 2) {
+                    qpParameters.minimumCenterOfPressure << copBounds->get(0).asDouble(), copBounds->get(1).asDouble();
+                }
+                copBounds = contactForcesQPGroup.find("cop_max").asList();
+                if (copBounds && copBounds->size() == 2) {
+                    qpParameters.maximumCenterOfPressure << copBounds->get(0).asDouble(), copBounds->get(1).asDouble();
+                }
+
+                if (!m_controller->setContactForcesQPParameters(qpParameters)) {
+                    yError("Invalid parameters for the contact forces QP.");
+                    return false;
+                }
+                yInfo() << "Contact forces QP is ENABLED";
+            }
+
+            //Fused computation of the robot state (optional)
+            //The URDF model is the one of the wbi configuration ("urdf" or "urdf_file").
+            //It is enabled at the start of the controller only if it is consistent with the wbi
+            if (rf.check("fused_dynamics", falseValue, "Looking for fused dynamics option").asBool()) {
+                std::string urdfFile;
+                if (wbiProperties.check("urdf")) {
+                    urdfFile = wbiProperties.find("urdf").asString();
+                } else if (wbiProperties.check("urdf_file")) {
+                    urdfFile = wbiProperties.find("urdf_file").asString();
+                } else {
+                    yError("fused_dynamics requires the urdf model in the wbi configuration file.");
+                    return false;
+                }
+                std::vector<std::string> jointsName;
+                for (int i = 0; i < iCubMainJoints.size(); i++) {
+                    wbi::ID jointID;
+                    iCubMainJoints.indexToID(i, jointID);
+                    jointsName.push_back(jointID.toString());
+                }
+                std::string baseLink = rf.check("fused_dynamics_base_link", Value("root_link"), "Looking for the floating base link of the wbi").asString();
+                if (!m_controller->setDynamicsModel(rf.findFileByName(urdfFile), jointsName, baseLink)) {
+                    yError("Could not load the dynamics model from %s with base link %s.", urdfFile.c_str(), baseLink.c_str());
+                    return false;
+                }
+            }
+
             //link controller and references variables to param helper manager
             if (!m_paramHelperManager->linkVariables()
                 || !m_paramHelperManager->linkMonitoredVariables()
@@ -362,7 +419,23 @@ namespace codyco {
                 constraintsLinkName.push_back("l_sole");
                 constraintsLinkName.push_back("r_sole");
             }
-            if (!m_controller->setInitialConstraintSet(constraintsLinkName)) {
+
+            //Additional contacts, inactive at start (they can be activated with activateConstraints)
+            std::vector<std::string> inactiveConstraintsLinkName;
+            if (rf.check("additional_constraint_links", "Checking additional rigid constraints")) {
+                Bottle &constraints = rf.findGroup("additional_constraint_links");
+                if (constraints.size() == 2) {
+                    Bottle *list = constraints.get(1).asList();
+                    if (list) {
+                        for (int i = 0; i < list->size(); i++) {
+                            Value &linkName = list->get(i);
+                            if (linkName.isString())
+                                inactiveConstraintsLinkName.push_back(linkName.asString());
+                        }
+                    }
+                }
+            }
+            if (!m_controller->setInitialConstraintSet(constraintsLinkName, inactiveConstraintsLinkName)) {
                 yError("Could not set initial dynamic constraints.");
                 return false;
             }
@@ -534,18 +607,26 @@ namespace codyco {
             //expecting size >= 2
             if (read.size() < 2) return;
 
-            std::string command = read.get(0).asString();
-            if (command.compare(ACTIVATE_CONTACT) == 0) {
-                for (int i = 1; i < read.size(); i++) {
-                    m_controller->addDynamicConstraint(read.get(i).asString());
-                }
-            }
+            changeConstraintsState(read);
+        }
 
-            if (command.compare(DEACTIVATE_CONTACT) == 0) {
-                for (int i = 1; i < read.size(); i++) {
-                    m_controller->removeDynamicConstraint(read.get(i).asString());
+        bool TorqueBalancingModule::changeConstraintsState(const yarp::os::Bottle &command)
+        {
+            if (command.size() < 2 || !m_controller) return false;
+            std::string commandName = command.get(0).asString();
+            bool activate = commandName.compare(ACTIVATE_CONTACT) == 0;
+            if (!activate && commandName.compare(DEACTIVATE_CONTACT) != 0) return false;
+
+            bool result = true;
+            for (int i = 1; i < command.size(); i++) {
+                std::string frameName = command.get(i).asString();
+                bool changed = activate ? m_controller->addDynamicConstraint(frameName) : m_controller->removeDynamicConstraint(frameName);
+                if (!changed) {
+                    yWarning("Constraint %s is not in the contacts set", frameName.c_str());
                 }
+                result = result && changed;
             }
+            return result;
         }
 
         double TorqueBalancingModule::getPeriod()
@@ -561,6 +642,9 @@ namespace codyco {
                     if (cmd == "torque_gains_switch") {
                         if (!switchToTorqueGainsWithKey(command.get(1).asString()))
                             reply.addString(("Failed to switch to " + command.get(1).asString()).c_str());
+                    } else if (cmd == ACTIVATE_CONTACT || cmd == DEACTIVATE_CONTACT) {
+                        if (!changeConstraintsState(command))
+                            reply.addString((std::string("Failed to execute ") + command.toString().c_str()).c_str());
                     }
                 } else {
                     reply.addString((std::string("Command ") + command.toString().c_str() + " not recognized.").c_str());
@@ -0,0 +1,162 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+/**
+ * Random states and reference implementation of the torque balancing controller
+ * (implementation before the introduction of ControllerCore, with the explicit inverse of the mass matrix),
+ * shared by the test and the benchmark of ControllerCore.
+ */
+
+#ifndef CONTROLLERCOREREFERENCE_H
+#define CONTROLLERCOREREFERENCE_H
+
+#include "ControllerCore.h"
+#include "config.h"
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Eigen/LU>
+#include <Eigen/SVD>
+
+namespace codyco {
+    namespace torquebalancing {
+
+        /**
+         * Fills the state with a random positive definite mass matrix and random quantities.
+         * The first two contacts are the feet, the third one (if any) is a hand whose
+         * contact frame is not aligned with the world frame.
+         * The Jacobians are multiplied by the given activations of the contacts.
+         */
+        inline void randomState(const Eigen::VectorXd& contactsActivation, ControllerState& state)
+        {
+            int totalDOFs = state.massMatrix.rows();
+
+            //symmetric and positive definite mass matrix
+            Eigen::MatrixXd randomMatrix = Eigen::MatrixXd::Random(totalDOFs, totalDOFs);
+            state.massMatrix = randomMatrix * randomMatrix.transpose() + totalDOFs * Eigen::MatrixXd::Identity(totalDOFs, totalDOFs);
+            state.massMatrix(0, 0) = state.massMatrix(1, 1) = state.massMatrix(2, 2) = 30.0;
+
+            state.jointPositions.setRandom();
+            state.centerOfMassPosition << 0.0, 0.0, 0.5;
+            state.contactsPosition.col(0) << 0.0, 0.07, 0.0;
+            state.contactsPosition.col(1) << 0.0, -0.07, 0.0;
+            if (state.contactsPosition.cols() > 2) {
+                state.contactsPosition.col(2) << 0.3, 0.2, 0.6;
+                state.contactsOrientation.middleCols<3>(6) = Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitX()).toRotationMatrix();
+            }
+
+            state.generalizedBiasForces.setRandom();
+            state.gravityBiasTorques.setRandom();
+            state.centroidalMomentum.setRandom();
+            state.contactsJacobian.setRandom();
+            state.contactsDJacobianDq.setRandom();
+
+            state.contactsActivation = contactsActivation;
+            for (int contact = 0; contact < contactsActivation.size(); contact++) {
+                state.contactsJacobian.middleRows<6>(6 * contact) *= contactsActivation(contact);
+                state.contactsDJacobianDq.segment<6>(6 * contact) *= contactsActivation(contact);
+            }
+        }
+
+        inline Eigen::MatrixXd referencePseudoInverse(const Eigen::MatrixXd& matrix)
+        {
+            Eigen::JacobiSVD<Eigen::MatrixXd> svd(matrix, Eigen::ComputeFullU | Eigen::ComputeFullV);
+            Eigen::VectorXd singularValuesInverse = svd.singularValues();
+            for (int i = 0; i < singularValuesInverse.size(); i++) {
+                singularValuesInverse(i) = singularValuesInverse(i) > PseudoInverseTolerance ? 1.0 / singularValuesInverse(i) : 0.0;
+            }
+            int size = singularValuesInverse.size();
+            return svd.matrixV().leftCols(size) * singularValuesInverse.asDiagonal() * svd.matrixU().leftCols(size).adjoint();
+        }
+
+        /**
+         * Contact forces and null space of the centroidal force matrix.
+         * If regularization is positive the forces are the solution of the contact forces QP without constraints
+         */
+        inline void referenceContactForces(const ControllerState& state,
+                                           const Eigen::Vector3d& desiredCOMAcceleration,
+                                           double centroidalMomentumGain,
+                                           Eigen::VectorXd& desiredContactForces,
+                                           Eigen::MatrixXd& nullSpaceOfCentroidalForceMatrix,
+                                           double regularization = 0)
+        {
+            int contacts = state.contactsActivation.size();
+            double mass = state.massMatrix(0, 0);
+
+            Eigen::MatrixXd centroidalForceMatrix = Eigen::MatrixXd::Zero(6, 6 * contacts);
+            int activeContacts = 0;
+            for (int contact = 0; contact < contacts; contact++) {
+                double activation = state.contactsActivation(contact);
+                if (activation <= 0) continue;
+                activeContacts++;
+                Eigen::Vector3d r = state.contactsPosition.col(contact) - state.centerOfMassPosition;
+                centroidalForceMatrix.block<3, 3>(0, 6 * contact).setIdentity();
+                centroidalForceMatrix.block<3, 3>(3, 6 * contact + 3).setIdentity();
+                centroidalForceMatrix.block<3, 3>(3, 6 * contact) << 0, -r(2), r(1), r(2), 0, -r(0), -r(1), r(0), 0;
+                centroidalForceMatrix.middleCols<6>(6 * contact) *= activation;
+            }
+
+            Eigen::Matrix<double, 6, 1> centroidalMomentumError;
+            centroidalMomentumError.head<3>() = mass * desiredCOMAcceleration;
+            centroidalMomentumError.tail<3>() = -centroidalMomentumGain * state.centroidalMomentum.tail<3>();
+            centroidalMomentumError(2) += mass * 9.81;
+
+            Eigen::MatrixXd pseudoInverseOfCentroidalForceMatrix = referencePseudoInverse(centroidalForceMatrix);
+            if (regularization > 0) {
+                //(A^T A + regularization I)^-1 A^T = A^T (A A^T + regularization I)^-1
+                Eigen::Matrix<double, 6, 6> regularizedMatrix = centroidalForceMatrix * centroidalForceMatrix.transpose() + regularization * Eigen::Matrix<double, 6, 6>::Identity();
+                desiredContactForces = centroidalForceMatrix.transpose() * regularizedMatrix.inverse() * centroidalMomentumError;
+            } else {
+                desiredContactForces = pseudoInverseOfCentroidalForceMatrix * centroidalMomentumError;
+            }
+            if (activeContacts > 1) {
+                nullSpaceOfCentroidalForceMatrix = Eigen::MatrixXd::Identity(6 * contacts, 6 * contacts) - pseudoInverseOfCentroidalForceMatrix * centroidalForceMatrix;
+            } else {
+                nullSpaceOfCentroidalForceMatrix = Eigen::MatrixXd::Zero(6 * contacts, 6 * contacts);
+            }
+        }
+
+        /**
+         * Torques computed with the explicit inverse of the mass matrix
+         */
+        inline Eigen::VectorXd referenceTorques(const ControllerState& state,
+                                                const Eigen::MatrixXd& nullSpaceOfCentroidalForceMatrix,
+                                                const Eigen::VectorXd& desiredJointsConfiguration,
+                                                const Eigen::VectorXd& impedanceGains,
+                                                const Eigen::VectorXd& desiredContactForces)
+        {
+            using namespace Eigen;
+            int actuatedDOFs = state.jointPositions.size();
+            MatrixXd contactsJacobian = state.contactsJacobian;
+
+            MatrixXd JcMInv = contactsJacobian * state.massMatrix.inverse();
+            MatrixXd JcMInvJct = JcMInv * contactsJacobian.transpose();
+            MatrixXd JcMInvTorqueSelector = JcMInv.rightCols(actuatedDOFs);
+            MatrixXd jointProjectedBaseAccelerations = state.massMatrix.block(6, 0, actuatedDOFs, 6) * state.massMatrix.topLeftCorner<6, 6>().inverse();
+            MatrixXd pseudoInverseOfJcMInvSt = referencePseudoInverse(JcMInvTorqueSelector);
+            MatrixXd JcNullSpaceProjector = MatrixXd::Identity(actuatedDOFs, actuatedDOFs) - pseudoInverseOfJcMInvSt * JcMInvTorqueSelector;
+
+            MatrixXd mult_f_tau0 = jointProjectedBaseAccelerations * contactsJacobian.leftCols(6).transpose() - contactsJacobian.rightCols(actuatedDOFs).transpose();
+            VectorXd torques0 = state.gravityBiasTorques.tail(actuatedDOFs) - impedanceGains.asDiagonal() * (state.jointPositions - desiredJointsConfiguration) - jointProjectedBaseAccelerations * state.generalizedBiasForces.head<6>();
+            MatrixXd mult_f_tau = -pseudoInverseOfJcMInvSt * JcMInvJct + JcNullSpaceProjector * mult_f_tau0;
+            VectorXd n_tau = pseudoInverseOfJcMInvSt * (JcMInv * state.generalizedBiasForces - state.contactsDJacobianDq) + JcNullSpaceProjector * torques0;
+            MatrixXd pseudoInverseOfTauN0_f = referencePseudoInverse(mult_f_tau * nullSpaceOfCentroidalForceMatrix);
+
+            return (MatrixXd::Identity(actuatedDOFs, actuatedDOFs) - mult_f_tau * nullSpaceOfCentroidalForceMatrix * pseudoInverseOfTauN0_f) * (n_tau + mult_f_tau * desiredContactForces);
+        }
+    }
+}
+
+#endif /* end of include guard: CONTROLLERCOREREFERENCE_H */
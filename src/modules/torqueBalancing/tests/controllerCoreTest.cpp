@@ -0,0 +1,236 @@
+/**
+ * Copyright (C) 2017 CoDyCo
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+/**
+ * Test of the cycle of the torque balancing controller (ControllerCore).
+ *
+ * The test is compiled with EIGEN_RUNTIME_NO_MALLOC and without NDEBUG, and the cycle is run
+ * on random states (with all the combinations of active contacts) with the Eigen heap allocations forbidden:
+ * if the cycle allocates memory an Eigen assertion aborts the test.
+ * The contact forces and the torques are compared with the ones of the reference formulas
+ * of the controller, computed with the explicit inverses of the mass matrix, and the torques
+ * computed with the two null space projector methods (NullSpaceProjectorMethodSingularVectors and
+ * NullSpaceProjectorMethodPseudoInverse) are checked to be equal.
+ * The contact forces of the QP must satisfy the friction cone, the center of pressure and the normal force
+ * bounds in the contact frames, and they must be equal to the unconstrained ones when the bounds are not active.
+ */
+
+#include "ControllerCore.h"
+#include "PseudoInverse.h"
+#include "config.h"
+#include "controllerCoreReference.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#ifdef NDEBUG
+#error "The test must be compiled without NDEBUG, otherwise the heap allocations are not checked"
+#endif
+
+using namespace codyco::torquebalancing;
+
+const int actuatedDOFs = 25;
+const int contacts = 3;
+const int nrOfStates = 16;
+const double tolerance = 1e-6;
+
+/**
+ * Returns true if the two matrices are equal up to the tolerance (relative to the largest element)
+ */
+bool checkEqual(const char * what, int state, const Eigen::MatrixXd& value, const Eigen::MatrixXd& expected)
+{
+    double error = (value - expected).cwiseAbs().maxCoeff();
+    double scale = std::max(1.0, expected.cwiseAbs().maxCoeff());
+    if (!(error <= tolerance * scale)) {
+        fprintf(stderr, "State %d: error %g on the %s greater than the tolerance %g\n", state, error, what, tolerance * scale);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Returns true if the forces of the active contacts, expressed in the contact frames, satisfy
+ * the (linearized) friction cone, the center of pressure and the normal force bounds of the QP
+ */
+bool checkContactForcesConstraints(int state, const ControllerState& controllerState,
+                                   const Eigen::VectorXd& contactForces,
+                                   const ContactForcesQPParameters& parameters)
+{
+    double scale = std::max(1.0, contactForces.cwiseAbs().maxCoeff());
+    double sideAngle = 2 * M_PI / parameters.frictionConeSides;
+    bool ok = true;
+    for (int contact = 0; contact < contacts; contact++) {
+        if (controllerState.contactsActivation(contact) <= 0) continue;
+        Eigen::Matrix3d orientation = controllerState.contactsOrientation.middleCols<3>(3 * contact);
+        Eigen::Vector3d force = orientation.transpose() * contactForces.segment<3>(6 * contact);
+        Eigen::Vector3d torque = orientation.transpose() * contactForces.segment<3>(6 * contact + 3);
+
+        double maximumTangentialForce = parameters.frictionCoefficient * std::cos(sideAngle / 2) * force(2);
+        for (int side = 0; side < parameters.frictionConeSides; side++) {
+            double tangentialForce = std::cos(side * sideAngle) * force(0) + std::sin(side * sideAngle) * force(1);
+            if (tangentialForce > maximumTangentialForce + tolerance * scale) {
+                fprintf(stderr, "State %d: the force of the contact %d is outside the friction cone\n", state, contact);
+                ok = false;
+            }
+        }
+        //CoP_x = -tau_y / f_z, CoP_y = tau_x / f_z
+        if (-torque(1) > parameters.maximumCenterOfPressure(0) * force(2) + tolerance * scale
+            || -torque(1) < parameters.minimumCenterOfPressure(0) * force(2) - tolerance * scale
+            || torque(0) > parameters.maximumCenterOfPressure(1) * force(2) + tolerance * scale
+            || torque(0) < parameters.minimumCenterOfPressure(1) * force(2) - tolerance * scale) {
+            fprintf(stderr, "State %d: the center of pressure of the contact %d is outside the bounds\n", state, contact);
+            ok = false;
+        }
+        if (force(2) < parameters.minimumNormalForce - tolerance * scale
+            || force(2) > parameters.maximumNormalForce + tolerance * scale) {
+            fprintf(stderr, "State %d: the normal force %g of the contact %d is outside the bounds\n", state, force(2), contact);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/**
+ * Checks the projectors computed from the singular vectors against the ones computed
+ * from the explicit pseudo inverse, on a rank deficient matrix
+ */
+bool checkNullSpaceProjectors(int sample)
+{
+    const int rows = 12, cols = actuatedDOFs, rank = 9;
+    Eigen::MatrixXd matrix = Eigen::MatrixXd::Random(rows, rank) * Eigen::MatrixXd::Random(rank, cols);
+    Eigen::VectorXd vector = Eigen::VectorXd::Random(rows);
+
+    PseudoInverse pseudoInverse(rows, cols);
+    pseudoInverse.compute(matrix, PseudoInverseTolerance);
+    if (pseudoInverse.rank() != rank) {
+        fprintf(stderr, "Sample %d: rank %d instead of %d\n", sample, pseudoInverse.rank(), rank);
+        return false;
+    }
+
+    Eigen::MatrixXd projector(cols, cols);
+    pseudoInverse.computeNullSpaceProjector(projector);
+    Eigen::MatrixXd expectedProjector = Eigen::MatrixXd::Identity(cols, cols) - pseudoInverse.pseudoInverse() * matrix;
+    bool ok = checkEqual("null space projector", sample, projector, expectedProjector);
+
+    Eigen::VectorXd expectedProjection = vector - matrix * (pseudoInverse.pseudoInverse() * vector);
+    pseudoInverse.projectOnLeftNullSpace(vector);
+    ok = checkEqual("projection on the left null space", sample, vector, expectedProjection) && ok;
+    return ok;
+}
+
+int main()
+{
+    std::srand(0);
+    std::vector<ControllerState, Eigen::aligned_allocator<ControllerState> > states(nrOfStates, ControllerState(actuatedDOFs, contacts));
+    //all the combinations of active contacts (none included), with partially active contacts
+    Eigen::VectorXd contactsActivation(contacts);
+    for (int i = 0; i < nrOfStates; i++) {
+        for (int contact = 0; contact < contacts; contact++) {
+            contactsActivation(contact) = ((i >> contact) & 1) ? (i < 8 ? 1.0 : 0.5) : 0.0;
+        }
+        randomState(contactsActivation, states[i]);
+    }
+
+    Eigen::Vector3d desiredCOMAcceleration(0.1, 0.0, -0.1);
+    double centroidalMomentumGain = 1.0;
+    Eigen::VectorXd desiredJointsConfiguration = Eigen::VectorXd::Zero(actuatedDOFs);
+    Eigen::VectorXd impedanceGains = Eigen::VectorXd::Constant(actuatedDOFs, 10.0);
+    Eigen::VectorXd torqueSaturationLimit = Eigen::VectorXd::Constant(actuatedDOFs, 1e6);
+
+    ControllerCore core(actuatedDOFs, contacts);
+    ControllerCore pseudoInverseCore(actuatedDOFs, contacts);
+    pseudoInverseCore.setNullSpaceProjectorMethod(NullSpaceProjectorMethodPseudoInverse);
+    ControllerCore qpCore(actuatedDOFs, contacts);
+    if (!qpCore.setContactForcesQPParameters(ContactForcesQPParameters())) {
+        fprintf(stderr, "The default parameters of the contact forces QP are not valid\n");
+        return EXIT_FAILURE;
+    }
+    //bounds that are never active: the QP must give the unconstrained (regularized) forces
+    ContactForcesQPParameters wideBoundsParameters;
+    wideBoundsParameters.frictionCoefficient = 1e3;
+    wideBoundsParameters.minimumCenterOfPressure.setConstant(-1e3);
+    wideBoundsParameters.maximumCenterOfPressure.setConstant(1e3);
+    wideBoundsParameters.minimumNormalForce = 0;
+    ControllerCore wideBoundsQPCore(actuatedDOFs, contacts);
+    if (!wideBoundsQPCore.setContactForcesQPParameters(wideBoundsParameters)) {
+        fprintf(stderr, "The wide bounds parameters of the contact forces QP are not valid\n");
+        return EXIT_FAILURE;
+    }
+
+    std::vector<Eigen::VectorXd> contactForces(nrOfStates, Eigen::VectorXd::Zero(6 * contacts));
+    std::vector<Eigen::VectorXd> torques(nrOfStates, Eigen::VectorXd::Zero(actuatedDOFs));
+    std::vector<Eigen::VectorXd> pseudoInverseTorques(nrOfStates, Eigen::VectorXd::Zero(actuatedDOFs));
+    Eigen::VectorXd pseudoInverseContactForces = Eigen::VectorXd::Zero(6 * contacts);
+    std::vector<Eigen::VectorXd> qpContactForces(nrOfStates, Eigen::VectorXd::Zero(6 * contacts));
+    std::vector<Eigen::VectorXd> qpTorques(nrOfStates, Eigen::VectorXd::Zero(actuatedDOFs));
+    std::vector<ActiveSetQPSolverStatus> qpStatus(nrOfStates, ActiveSetQPSolverStatusOptimal);
+    std::vector<Eigen::VectorXd> wideBoundsQPContactForces(nrOfStates, Eigen::VectorXd::Zero(6 * contacts));
+    std::vector<ActiveSetQPSolverStatus> wideBoundsQPStatus(nrOfStates, ActiveSetQPSolverStatusOptimal);
+
+    //the cycle aborts if it allocates memory
+    Eigen::internal::set_is_malloc_allowed(false);
+    for (int i = 0; i < nrOfStates; i++) {
+        core.computeContactForces(states[i], desiredCOMAcceleration, centroidalMomentumGain, contactForces[i]);
+        if (!core.computeTorques(states[i], desiredJointsConfiguration, impedanceGains, torqueSaturationLimit, contactForces[i], torques[i])) {
+            Eigen::internal::set_is_malloc_allowed(true);
+            fprintf(stderr, "State %d: mass matrix is not positive definite\n", i);
+            return EXIT_FAILURE;
+        }
+        pseudoInverseCore.computeContactForces(states[i], desiredCOMAcceleration, centroidalMomentumGain, pseudoInverseContactForces);
+        pseudoInverseCore.computeTorques(states[i], desiredJointsConfiguration, impedanceGains, torqueSaturationLimit, pseudoInverseContactForces, pseudoInverseTorques[i]);
+        qpCore.computeContactForces(states[i], desiredCOMAcceleration, centroidalMomentumGain, qpContactForces[i]);
+        qpStatus[i] = qpCore.contactForcesQPStatus();
+        if (!qpCore.computeTorques(states[i], desiredJointsConfiguration, impedanceGains, torqueSaturationLimit, qpContactForces[i], qpTorques[i])) {
+            Eigen::internal::set_is_malloc_allowed(true);
+            fprintf(stderr, "State %d: mass matrix is not positive definite\n", i);
+            return EXIT_FAILURE;
+        }
+        wideBoundsQPCore.computeContactForces(states[i], desiredCOMAcceleration, centroidalMomentumGain, wideBoundsQPContactForces[i]);
+        wideBoundsQPStatus[i] = wideBoundsQPCore.contactForcesQPStatus();
+    }
+    Eigen::internal::set_is_malloc_allowed(true);
+
+    bool ok = true;
+    for (int i = 0; i < nrOfStates; i++) {
+        Eigen::VectorXd expectedContactForces;
+        Eigen::MatrixXd nullSpaceOfCentroidalForceMatrix;
+        referenceContactForces(states[i], desiredCOMAcceleration, centroidalMomentumGain, expectedContactForces, nullSpaceOfCentroidalForceMatrix);
+        ok = checkEqual("contact forces", i, contactForces[i], expectedContactForces) && ok;
+
+        Eigen::VectorXd expectedTorques = referenceTorques(states[i], nullSpaceOfCentroidalForceMatrix, desiredJointsConfiguration, impedanceGains, expectedContactForces);
+        ok = checkEqual("torques", i, torques[i], expectedTorques) && ok;
+        ok = checkEqual("torques with the pseudo inverse projectors", i, pseudoInverseTorques[i], torques[i]) && ok;
+        ok = checkNullSpaceProjectors(i) && ok;
+
+        //the QP is solved only if there are active contacts
+        if ((states[i].contactsActivation.array() <= 0).all()) continue;
+        if (qpStatus[i] != ActiveSetQPSolverStatusOptimal && qpStatus[i] != ActiveSetQPSolverStatusMaximumIterationsReached) {
+            fprintf(stderr, "State %d: contact forces QP status %d\n", i, qpStatus[i]);
+            ok = false;
+        }
+        ok = checkContactForcesConstraints(i, states[i], qpContactForces[i], qpCore.contactForcesQPParameters()) && ok;
+        if (wideBoundsQPStatus[i] != ActiveSetQPSolverStatusOptimal) {
+            fprintf(stderr, "State %d: wide bounds contact forces QP status %d\n", i, wideBoundsQPStatus[i]);
+            ok = false;
+        }
+        Eigen::VectorXd unconstrainedContactForces;
+        referenceContactForces(states[i], desiredCOMAcceleration, centroidalMomentumGain, unconstrainedContactForces, nullSpaceOfCentroidalForceMatrix, wideBoundsParameters.regularization);
+        ok = checkEqual("contact forces of the QP without active bounds", i, wideBoundsQPContactForces[i], unconstrainedContactForces) && ok;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -343,28 +343,33 @@ void ExternalWrenchesAndTorquesEstimator::readSkinContacts()
             return;
         }
 
-        //Probably source of crazy inefficiencies, here just to reach a working state as soon as possible \todo TODO
-        map<BodyPart, skinContactList> contactsPerBp = scl->splitPerBodyPart();
+        // Count the contacts of each body part, without splitting the list
+        int nrOfContactsPerBp[BODY_PART_SIZE] = {0};
+        for(skinContactList::iterator c=scl->begin(); c!=scl->end(); c++)
+        {
+            if( c->getBodyPart() >= 0 && c->getBodyPart() < BODY_PART_SIZE )
+            {
+                nrOfContactsPerBp[c->getBodyPart()]++;
+            }
+        }
 
         skinContacts.clear();
 
         // if there are more than 1 contact and less than 10 taxels are active then suppose zero moment
-        for(map<BodyPart,skinContactList>::iterator it=contactsPerBp.begin(); it!=contactsPerBp.end(); it++)
+        for(skinContactList::iterator c=scl->begin(); c!=scl->end(); c++)
         {
-            for(skinContactList::iterator c=it->second.begin(); c!=it->second.end(); c++)
+            bool multipleContactsInBp = c->getBodyPart() < 0 || c->getBodyPart() >= BODY_PART_SIZE ||
+                                        nrOfContactsPerBp[c->getBodyPart()] > 1;
+            if( c->getActiveTaxels()<10 && multipleContactsInBp )
             {
-                if( c->getActiveTaxels()<10 && it->second.size()>1)
-                {
-                    c->fixMoment();
-                }
-
-                //Insert a contact in skinContacts only if the number of taxel is greater than ActiveTaxels
-                if( (int)c->getActiveTaxels() > min_taxel )
-                {
-                    skinContacts.insert(skinContacts.end(),*c);
-                }
+                c->fixMoment();
             }
 
+            //Insert a contact in skinContacts only if the number of taxel is greater than ActiveTaxels
+            if( (int)c->getActiveTaxels() > min_taxel )
+            {
+                skinContacts.insert(skinContacts.end(),*c);
+            }
         }
 
     }